@@ -362,6 +362,60 @@ static inline void aout_RestartRequest(audio_output_t *aout, unsigned mode)
     aout->event.restart_request(aout, mode);
 }
 
+/* Ring buffer for pull model audio outputs */
+
+/**
+ * Lock-free ring buffer between the audio output thread, which plays and
+ * flushes (the producer), and a realtime callback pulling the samples (the
+ * consumer). Reading never blocks, allocates nor takes a lock.
+ */
+typedef struct aout_ring aout_ring_t;
+
+/**
+ * Creates a ring buffer for a linear PCM format.
+ * \param duration minimum buffer duration
+ */
+VLC_API aout_ring_t *aout_RingNew(const audio_sample_format_t *,
+                                  mtime_t duration) VLC_USED;
+VLC_API void aout_RingDelete(aout_ring_t *);
+
+/**
+ * Queues a block of samples and releases it (producer side).
+ * \return the number of frames dropped for lack of space
+ */
+VLC_API size_t aout_RingPlay(aout_ring_t *, block_t *);
+
+/**
+ * Discards the queued frames (producer side). The frames played afterwards
+ * are kept.
+ */
+VLC_API void aout_RingFlush(aout_ring_t *);
+
+/**
+ * Pauses or resumes the consumer: while paused, it reads silence and the
+ * queued frames are kept.
+ */
+VLC_API void aout_RingPause(aout_ring_t *, bool paused);
+
+/**
+ * \return the number of queued frames (any thread)
+ */
+VLC_API size_t aout_RingCount(aout_ring_t *);
+
+/**
+ * Reads interleaved frames (consumer side). Missing frames are filled with
+ * silence.
+ * \return the number of frames read from the buffer
+ */
+VLC_API size_t aout_RingRead(aout_ring_t *, void *buf, size_t frames);
+
+/**
+ * Reads frames into one buffer per channel (consumer side), as with
+ * aout_RingRead().
+ */
+VLC_API size_t aout_RingReadPlanar(aout_ring_t *, void *const *planes,
+                                   size_t frames);
+
 /* Audio output filters */
 
 typedef struct
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * vlc_bench.h: helper for the benchmark programs
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_BENCH_H
+#define VLC_BENCH_H 1
+
+/* XXX Only for the benchmark programs, which make check does not run XXX */
+
+/**
+ * Calls a function again and again, for at least the given duration.
+ *
+ * \param run function to time
+ * \param opaque data passed to run
+ * \param duration how long to call it for
+ * \return the number of calls per microsecond
+ */
+static inline double vlc_bench_Run(void (*run)(void *), void *opaque,
+                                   mtime_t duration)
+{
+    uint64_t count = 0;
+    mtime_t start = mdate(), elapsed;
+
+    do
+    {
+        run(opaque);
+        count++;
+        elapsed = mdate() - start;
+    }
+    while (elapsed < duration);
+
+    return (double)count / elapsed;
+}
+
+#endif /* VLC_BENCH_H */
@@ -156,6 +156,8 @@ struct decoder_t
 
     /* Audio output callbacks */
     int             (*pf_aout_format_update)( decoder_t * );
+    /* XXX use decoder_NewAudioBuffer (NULL to allocate from the heap) */
+    block_t        *(*pf_aout_buffer_new)( decoder_t *, size_t );
 
     /* SPU output callbacks
      * XXX use decoder_NewSubpicture */
@@ -386,6 +388,10 @@ static inline int decoder_UpdateAudioFormat( decoder_t *dec )
  * This function will return a new audio buffer usable by a decoder as an
  * output buffer. It must be released with block_Release() or returned it to
  * the caller as a decoder_QueueAudio parameter.
+ *
+ * The buffer may be recycled from the previous ones released by the audio
+ * output, so decoders should get all their output buffers from here once
+ * the audio format is set, rather than from block_Alloc().
  */
 VLC_API block_t * decoder_NewAudioBuffer( decoder_t *, int i_nb_samples ) VLC_USED;
 
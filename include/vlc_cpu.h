@@ -83,8 +83,10 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __SSE4_1__
 #  define vlc_CPU_SSE4_1() (1)
+#  define VLC_SSE4_1
 # else
 #  define vlc_CPU_SSE4_1() ((vlc_CPU() & VLC_CPU_SSE4_1) != 0)
+#  define VLC_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
 # endif
 
 # ifdef __SSE4_2__
@@ -107,8 +109,10 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __AVX2__
 #  define vlc_CPU_AVX2() (1)
+#  define VLC_AVX2
 # else
 #  define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
+#  define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
 # endif
 
 # ifdef __3dNOW__
@@ -26,6 +26,7 @@
 #define VLC_FILTER_H 1
 
 #include <vlc_es.h>
+#include <vlc_block.h>
 
 /**
  * \defgroup filter Filters
@@ -52,6 +53,10 @@ typedef struct filter_owner_t
         {
             subpicture_t * (*buffer_new)( filter_t * );
         } sub;
+        struct
+        {
+            block_t * (*buffer_new)( filter_t *, size_t );
+        } audio;
     };
 } filter_owner_t;
 
@@ -168,6 +173,24 @@ static inline picture_t *filter_NewPicture( filter_t *p_filter )
     return pic;
 }
 
+/**
+ * This function will return a new block usable by p_filter as an output
+ * audio buffer, of at least the given size. The owner of the filter may
+ * recycle the buffers, so audio filters which cannot work in place should
+ * use it rather than block_Alloc().
+ *
+ * \param p_filter filter_t object
+ * \param i_size payload size in bytes
+ * \return new block on success or NULL on failure
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter,
+                                              size_t i_size )
+{
+    if( p_filter->owner.audio.buffer_new != NULL )
+        return p_filter->owner.audio.buffer_new( p_filter, i_size );
+    return block_Alloc( i_size );
+}
+
 /**
  * Flush a filter
  *
@@ -278,6 +301,55 @@ VLC_API int filter_Blend( filter_t *, picture_t *p_dst, int i_dst_x, int i_dst_y
  */
 VLC_API void filter_DeleteBlend( filter_t * );
 
+/**
+ * Slice-parallel processing for CPU video filters.
+ *
+ * The picture is split in horizontal bands, each processed by the filter
+ * callback on a pool of threads. Bands of a plane don't overlap, but a
+ * callback may read source lines outside its band (neighbourhood kernels).
+ */
+typedef struct filter_slices_t filter_slices_t;
+
+/**
+ * Processes one band out of \p slices.
+ * Use filter_GetSliceLines() to get the lines of a plane for that band.
+ */
+typedef void (*filter_slice_cb)( void *opaque, unsigned slice, unsigned slices );
+
+/**
+ * It creates a pool of threads for filter_RunSlices.
+ *
+ * \param threads maximum number of threads, 0 for the number of CPUs
+ * \return the pool or NULL on error (filter_RunSlices then runs serially)
+ */
+VLC_API filter_slices_t * filter_NewSlices( vlc_object_t *, unsigned threads ) VLC_USED;
+#define filter_NewSlices( a, b ) filter_NewSlices( VLC_OBJECT( a ), b )
+
+/**
+ * It runs \p cb for every band and waits for all of them.
+ *
+ * The calling thread processes bands too.
+ *
+ * \param slices number of bands, 0 for one per thread
+ */
+VLC_API void filter_RunSlices( filter_slices_t *, filter_slice_cb cb,
+                               void *opaque, unsigned slices );
+
+/**
+ * It destroys a pool created by filter_NewSlices.
+ */
+VLC_API void filter_DeleteSlices( filter_slices_t * );
+
+/**
+ * It returns the [first, end) lines of a \p lines high plane for a band.
+ */
+static inline void filter_GetSliceLines( int lines, unsigned slice,
+                                         unsigned slices, int *first, int *end )
+{
+    *first = (int64_t)lines * slice / slices;
+    *end = (int64_t)lines * (slice + 1) / slices;
+}
+
 /**
  * Create a picture_t *(*)( filter_t *, picture_t * ) compatible wrapper
  * using a void (*)( filter_t *, picture_t *, picture_t * ) function
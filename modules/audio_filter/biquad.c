@@ -0,0 +1,648 @@
+/*****************************************************************************
+ * biquad.c : multichannel biquad filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "biquad.h"
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define BIQUAD_SIMD_SSE2
+# define BIQUAD_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BIQUAD_SIMD_NEON
+#endif
+
+/*
+ * The frames are deinterleaved by chunks, so that each channel has a lane of
+ * the vectors (padded to a whole number of vectors). All the sections are run
+ * for each frame in turn: the sections of a bank are independent, and the CPU
+ * overlaps the sections of a series across frames, which hides the latency
+ * of the recursion. The output history of a section is also the input
+ * history of the next one in a series.
+ *
+ * A tiny constant is added to the output of every section, so that the
+ * history never decays into denormal numbers (which are very slow on most
+ * CPUs) after the input falls silent. Its effect on the output is far below
+ * the resolution of any sample format.
+ */
+#define BIQUAD_LANES 4
+#define BIQUAD_CHUNK 256
+#define BIQUAD_BIAS  1e-20f
+
+typedef void (*biquad_cascade_t)(biquad_t *, float *buf, size_t frames);
+typedef void (*biquad_bank_t)(biquad_t *, float *buf, size_t frames,
+                              float dry);
+
+struct biquad_t
+{
+    unsigned channels;
+    unsigned sections;
+    unsigned lanes;    /* channels, rounded up to a whole vector */
+
+    float *coeffs;     /* [sections][b0, b1, b2, a1, a2][BIQUAD_LANES] */
+    float *gains;      /* [sections][BIQUAD_LANES] */
+    float *history;    /* [input, sections][n-1, n-2][lanes] */
+    float *buf;        /* [BIQUAD_CHUNK][lanes] */
+
+    biquad_cascade_t cascade;
+    biquad_bank_t bank;
+};
+
+#define COEFF(b, s, i) ((b)->coeffs + ((s) * 5 + (i)) * BIQUAD_LANES)
+
+/*****************************************************************************
+ * C reference
+ *
+ * This does the same operations in the same order as the vector versions.
+ *****************************************************************************/
+static inline float Section_C(const float *k, float x, float x1, float x2,
+                              float y1, float y2)
+{
+    float y = k[0 * BIQUAD_LANES] * x;
+
+    y += k[1 * BIQUAD_LANES] * x1;
+    y += k[2 * BIQUAD_LANES] * x2;
+    y += BIQUAD_BIAS;
+    y -= k[4 * BIQUAD_LANES] * y2;
+    y -= k[3 * BIQUAD_LANES] * y1; /* last, as it waits for the last output */
+    return y;
+}
+
+static void Cascade_C(biquad_t *b, float *buf, size_t n)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs;
+    float *history = b->history;
+
+    for (unsigned c = 0; c < b->channels; c++)
+    {
+        float *in = history + c;
+        float in1 = in[0], in2 = in[lanes];
+
+        for (size_t i = 0; i < n; i++)
+        {
+            float x = buf[i * lanes + c], x1 = in1, x2 = in2;
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            in2 = in1;
+            in1 = x;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const float y1 = h[0], y2 = h[lanes];
+                const float y = Section_C(k, x, x1, x2, y1, y2);
+
+                h[0] = y;
+                h[lanes] = y1;
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                x = y; x1 = y1; x2 = y2;
+            }
+            buf[i * lanes + c] = x;
+        }
+        in[0] = in1;
+        in[lanes] = in2;
+    }
+}
+
+static void Bank_C(biquad_t *b, float *buf, size_t n, float dry)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs, *gains = b->gains;
+    float *history = b->history;
+
+    for (unsigned c = 0; c < b->channels; c++)
+    {
+        float *in = history + c;
+        float x1 = in[0], x2 = in[lanes];
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const float x = buf[i * lanes + c];
+            float acc = dry * x;
+
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const float y1 = h[0], y2 = h[lanes];
+                const float y = Section_C(k, x, x1, x2, y1, y2);
+
+                h[0] = y;
+                h[lanes] = y1;
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                acc += gains[s * BIQUAD_LANES] * y;
+            }
+            buf[i * lanes + c] = acc;
+            x2 = x1;
+            x1 = x;
+        }
+        in[0] = x1;
+        in[lanes] = x2;
+    }
+}
+
+/*****************************************************************************
+ * SSE2
+ *****************************************************************************/
+#ifdef BIQUAD_SIMD_SSE2
+BIQUAD_SSE2
+static inline __m128 Section_SSE2(const float *k, __m128 x, __m128 x1,
+                                  __m128 x2, __m128 y1, __m128 y2)
+{
+    __m128 y = _mm_mul_ps(_mm_loadu_ps(k + 0 * BIQUAD_LANES), x);
+
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(k + 1 * BIQUAD_LANES), x1));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(k + 2 * BIQUAD_LANES), x2));
+    y = _mm_add_ps(y, _mm_set1_ps(BIQUAD_BIAS));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_loadu_ps(k + 4 * BIQUAD_LANES), y2));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_loadu_ps(k + 3 * BIQUAD_LANES), y1));
+    return y;
+}
+
+BIQUAD_SSE2
+static void Cascade_SSE2(biquad_t *b, float *buf, size_t n)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs;
+    float *history = b->history;
+
+    for (unsigned c = 0; c < lanes; c += BIQUAD_LANES)
+    {
+        float *in = history + c;
+        __m128 in1 = _mm_loadu_ps(in), in2 = _mm_loadu_ps(in + lanes);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            __m128 x = _mm_loadu_ps(buf + i * lanes + c), x1 = in1, x2 = in2;
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            in2 = in1;
+            in1 = x;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const __m128 y1 = _mm_loadu_ps(h);
+                const __m128 y2 = _mm_loadu_ps(h + lanes);
+                const __m128 y = Section_SSE2(k, x, x1, x2, y1, y2);
+
+                _mm_storeu_ps(h, y);
+                _mm_storeu_ps(h + lanes, y1);
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                x = y; x1 = y1; x2 = y2;
+            }
+            _mm_storeu_ps(buf + i * lanes + c, x);
+        }
+        _mm_storeu_ps(in, in1);
+        _mm_storeu_ps(in + lanes, in2);
+    }
+}
+
+BIQUAD_SSE2
+static void Bank_SSE2(biquad_t *b, float *buf, size_t n, float dry)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs, *gains = b->gains;
+    float *history = b->history;
+    const __m128 d = _mm_set1_ps(dry);
+
+    for (unsigned c = 0; c < lanes; c += BIQUAD_LANES)
+    {
+        float *in = history + c;
+        __m128 x1 = _mm_loadu_ps(in), x2 = _mm_loadu_ps(in + lanes);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const __m128 x = _mm_loadu_ps(buf + i * lanes + c);
+            __m128 acc = _mm_mul_ps(d, x);
+
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const __m128 y1 = _mm_loadu_ps(h);
+                const __m128 y2 = _mm_loadu_ps(h + lanes);
+                const __m128 y = Section_SSE2(k, x, x1, x2, y1, y2);
+
+                _mm_storeu_ps(h, y);
+                _mm_storeu_ps(h + lanes, y1);
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(gains
+                                                  + s * BIQUAD_LANES), y));
+            }
+            _mm_storeu_ps(buf + i * lanes + c, acc);
+            x2 = x1;
+            x1 = x;
+        }
+        _mm_storeu_ps(in, x1);
+        _mm_storeu_ps(in + lanes, x2);
+    }
+}
+#endif
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef BIQUAD_SIMD_NEON
+static inline float32x4_t Section_NEON(const float *k, float32x4_t x,
+                                       float32x4_t x1, float32x4_t x2,
+                                       float32x4_t y1, float32x4_t y2)
+{
+    float32x4_t y = vmulq_f32(vld1q_f32(k + 0 * BIQUAD_LANES), x);
+
+    y = vaddq_f32(y, vmulq_f32(vld1q_f32(k + 1 * BIQUAD_LANES), x1));
+    y = vaddq_f32(y, vmulq_f32(vld1q_f32(k + 2 * BIQUAD_LANES), x2));
+    y = vaddq_f32(y, vdupq_n_f32(BIQUAD_BIAS));
+    y = vsubq_f32(y, vmulq_f32(vld1q_f32(k + 4 * BIQUAD_LANES), y2));
+    y = vsubq_f32(y, vmulq_f32(vld1q_f32(k + 3 * BIQUAD_LANES), y1));
+    return y;
+}
+
+static void Cascade_NEON(biquad_t *b, float *buf, size_t n)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs;
+    float *history = b->history;
+
+    for (unsigned c = 0; c < lanes; c += BIQUAD_LANES)
+    {
+        float *in = history + c;
+        float32x4_t in1 = vld1q_f32(in), in2 = vld1q_f32(in + lanes);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            float32x4_t x = vld1q_f32(buf + i * lanes + c), x1 = in1, x2 = in2;
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            in2 = in1;
+            in1 = x;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const float32x4_t y1 = vld1q_f32(h);
+                const float32x4_t y2 = vld1q_f32(h + lanes);
+                const float32x4_t y = Section_NEON(k, x, x1, x2, y1, y2);
+
+                vst1q_f32(h, y);
+                vst1q_f32(h + lanes, y1);
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                x = y; x1 = y1; x2 = y2;
+            }
+            vst1q_f32(buf + i * lanes + c, x);
+        }
+        vst1q_f32(in, in1);
+        vst1q_f32(in + lanes, in2);
+    }
+}
+
+static void Bank_NEON(biquad_t *b, float *buf, size_t n, float dry)
+{
+    const unsigned lanes = b->lanes, sections = b->sections;
+    const float *coeffs = b->coeffs, *gains = b->gains;
+    float *history = b->history;
+    const float32x4_t d = vdupq_n_f32(dry);
+
+    for (unsigned c = 0; c < lanes; c += BIQUAD_LANES)
+    {
+        float *in = history + c;
+        float32x4_t x1 = vld1q_f32(in), x2 = vld1q_f32(in + lanes);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const float32x4_t x = vld1q_f32(buf + i * lanes + c);
+            float32x4_t acc = vmulq_f32(d, x);
+
+            const float *k = coeffs;
+            float *h = in + 2 * lanes;
+
+            for (unsigned s = 0; s < sections; s++)
+            {
+                const float32x4_t y1 = vld1q_f32(h);
+                const float32x4_t y2 = vld1q_f32(h + lanes);
+                const float32x4_t y = Section_NEON(k, x, x1, x2, y1, y2);
+
+                vst1q_f32(h, y);
+                vst1q_f32(h + lanes, y1);
+                k += 5 * BIQUAD_LANES;
+                h += 2 * lanes;
+                acc = vaddq_f32(acc, vmulq_f32(vld1q_f32(gains
+                                               + s * BIQUAD_LANES), y));
+            }
+            vst1q_f32(buf + i * lanes + c, acc);
+            x2 = x1;
+            x1 = x;
+        }
+        vst1q_f32(in, x1);
+        vst1q_f32(in + lanes, x2);
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Common
+ *****************************************************************************/
+int biquad_SetISA(biquad_t *b, enum biquad_isa isa)
+{
+    switch (isa)
+    {
+        case BIQUAD_ISA_C:
+            b->cascade = Cascade_C;
+            b->bank = Bank_C;
+            return VLC_SUCCESS;
+#ifdef BIQUAD_SIMD_SSE2
+        case BIQUAD_ISA_SSE2:
+            if (!vlc_CPU_SSE2())
+                break;
+            b->cascade = Cascade_SSE2;
+            b->bank = Bank_SSE2;
+            return VLC_SUCCESS;
+#endif
+#ifdef BIQUAD_SIMD_NEON
+        case BIQUAD_ISA_NEON:
+            if (!vlc_CPU_ARM64_NEON())
+                break;
+            b->cascade = Cascade_NEON;
+            b->bank = Bank_NEON;
+            return VLC_SUCCESS;
+#endif
+        default:
+            break;
+    }
+    return VLC_EGENERIC;
+}
+
+biquad_t *biquad_New(unsigned i_channels, unsigned i_sections)
+{
+    if (i_channels == 0 || i_sections == 0)
+        return NULL;
+
+    biquad_t *b = malloc(sizeof (*b));
+    if (unlikely(b == NULL))
+        return NULL;
+
+    const unsigned lanes = (i_channels + BIQUAD_LANES - 1)
+                         & ~(BIQUAD_LANES - 1);
+
+    b->channels = i_channels;
+    b->sections = i_sections;
+    b->lanes = lanes;
+    b->coeffs = calloc(i_sections * 5 * BIQUAD_LANES, sizeof (float));
+    b->gains = calloc(i_sections * BIQUAD_LANES, sizeof (float));
+    b->history = calloc((i_sections + 1) * 2 * lanes, sizeof (float));
+    b->buf = calloc(BIQUAD_CHUNK * lanes, sizeof (float));
+    if (unlikely(b->coeffs == NULL || b->gains == NULL || b->history == NULL
+              || b->buf == NULL))
+    {
+        biquad_Delete(b);
+        return NULL;
+    }
+
+    static const float pass[5] = { 1.f, 0.f, 0.f, 0.f, 0.f };
+    for (unsigned s = 0; s < i_sections; s++)
+        biquad_Set(b, s, pass);
+
+    if (biquad_SetISA(b, BIQUAD_ISA_NEON)
+     && biquad_SetISA(b, BIQUAD_ISA_SSE2))
+        biquad_SetISA(b, BIQUAD_ISA_C);
+    return b;
+}
+
+void biquad_Delete(biquad_t *b)
+{
+    free(b->coeffs);
+    free(b->gains);
+    free(b->history);
+    free(b->buf);
+    free(b);
+}
+
+void biquad_Set(biquad_t *b, unsigned i_section, const float p_coeffs[5])
+{
+    for (unsigned i = 0; i < 5; i++)
+        for (unsigned l = 0; l < BIQUAD_LANES; l++)
+            COEFF(b, i_section, i)[l] = p_coeffs[i];
+}
+
+void biquad_Reset(biquad_t *b)
+{
+    memset(b->history, 0, (b->sections + 1) * 2 * b->lanes * sizeof (float));
+}
+
+static void Run(biquad_t *b, float *out, const float *in, size_t frames,
+                bool bank, float dry)
+{
+    const unsigned channels = b->channels, lanes = b->lanes;
+
+    if (channels == lanes)
+    {   /* Already laid out as vectors: filter in place */
+        if (out != in)
+            memcpy(out, in, frames * channels * sizeof (float));
+
+        for (size_t done = 0; done < frames; done += BIQUAD_CHUNK)
+        {
+            size_t n = __MIN(frames - done, BIQUAD_CHUNK);
+
+            if (bank)
+                b->bank(b, out + done * lanes, n, dry);
+            else
+                b->cascade(b, out + done * lanes, n);
+        }
+        return;
+    }
+
+    for (size_t done = 0; done < frames; done += BIQUAD_CHUNK)
+    {
+        size_t n = __MIN(frames - done, BIQUAD_CHUNK);
+        const float *src = in + done * channels;
+        float *dst = out + done * channels;
+
+        /* The padding lanes are never written but by the filters */
+        for (size_t i = 0; i < n; i++)
+            for (unsigned c = 0; c < channels; c++)
+                b->buf[i * lanes + c] = src[i * channels + c];
+
+        if (bank)
+            b->bank(b, b->buf, n, dry);
+        else
+            b->cascade(b, b->buf, n);
+
+        for (size_t i = 0; i < n; i++)
+            for (unsigned c = 0; c < channels; c++)
+                dst[i * channels + c] = b->buf[i * lanes + c];
+    }
+}
+
+void biquad_Process(biquad_t *b, float *p_out, const float *p_in,
+                    size_t i_frames)
+{
+    Run(b, p_out, p_in, i_frames, false, 0.f);
+}
+
+void biquad_ProcessBank(biquad_t *b, float *p_out, const float *p_in,
+                        size_t i_frames, float f_dry, const float *p_gains)
+{
+    for (unsigned s = 0; s < b->sections; s++)
+        for (unsigned l = 0; l < BIQUAD_LANES; l++)
+            b->gains[s * BIQUAD_LANES + l] = p_gains[s];
+
+    Run(b, p_out, p_in, i_frames, true, f_dry);
+}
+
+/*
+ * Calculate direct form IIR coefficients for peaking EQ
+ * coeffs[0] = b0
+ * coeffs[1] = b1
+ * coeffs[2] = b2
+ * coeffs[3] = a1
+ * coeffs[4] = a2
+ *
+ * Equations taken from RBJ audio EQ cookbook
+ * (http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt)
+ */
+void biquad_PeakCoeffs( float f0, float Q, float gainDB, float Fs,
+                        float *coeffs )
+{
+    float A;
+    float w0;
+    float alpha;
+    float b0, b1, b2;
+    float a0, a1, a2;
+
+    // Provide sane limits to avoid overflow
+    if (Q < 0.1f) Q = 0.1f;
+    if (Q > 100) Q = 100;
+    if (f0 > Fs/2*0.95f) f0 = Fs/2*0.95f;
+    if (gainDB < -40) gainDB = -40;
+    if (gainDB > 40) gainDB = 40;
+
+    A = powf(10, gainDB/40);
+    w0 = 2*((float)M_PI)*f0/Fs;
+    alpha = sinf(w0)/(2*Q);
+
+    b0 = 1 + alpha*A;
+    b1 = -2*cosf(w0);
+    b2 = 1 - alpha*A;
+    a0 = 1 + alpha/A;
+    a1 = -2*cosf(w0);
+    a2 = 1 - alpha/A;
+
+    // Store values to coeffs and normalize by 1/a0
+    coeffs[0] = b0/a0;
+    coeffs[1] = b1/a0;
+    coeffs[2] = b2/a0;
+    coeffs[3] = a1/a0;
+    coeffs[4] = a2/a0;
+}
+
+/*
+ * Calculate direct form IIR coefficients for low/high shelf EQ
+ * coeffs[0] = b0
+ * coeffs[1] = b1
+ * coeffs[2] = b2
+ * coeffs[3] = a1
+ * coeffs[4] = a2
+ *
+ * Equations taken from RBJ audio EQ cookbook
+ * (http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt)
+ */
+void biquad_ShelfCoeffs( float f0, float slope, float gainDB, int high,
+                         float Fs, float *coeffs )
+{
+    float A;
+    float w0;
+    float alpha;
+    float b0, b1, b2;
+    float a0, a1, a2;
+
+    // Provide sane limits to avoid overflow
+    if (f0 > Fs/2*0.95f) f0 = Fs/2*0.95f;
+    if (gainDB < -40) gainDB = -40;
+    if (gainDB > 40) gainDB = 40;
+
+    A = powf(10, gainDB/40);
+    w0 = 2*3.141593f*f0/Fs;
+    alpha = sinf(w0)/2 * sqrtf( (A + 1/A)*(1/slope - 1) + 2 );
+
+    if (high)
+    {
+        b0 =    A*( (A+1) + (A-1)*cosf(w0) + 2*sqrtf(A)*alpha );
+        b1 = -2*A*( (A-1) + (A+1)*cosf(w0) );
+        b2 =    A*( (A+1) + (A-1)*cosf(w0) - 2*sqrtf(A)*alpha );
+        a0 =        (A+1) - (A-1)*cosf(w0) + 2*sqrtf(A)*alpha;
+        a1 =    2*( (A-1) - (A+1)*cosf(w0) );
+        a2 =        (A+1) - (A-1)*cosf(w0) - 2*sqrtf(A)*alpha;
+    }
+    else
+    {
+        b0 =    A*( (A+1) - (A-1)*cosf(w0) + 2*sqrtf(A)*alpha );
+        b1 =  2*A*( (A-1) - (A+1)*cosf(w0));
+        b2 =    A*( (A+1) - (A-1)*cosf(w0) - 2*sqrtf(A)*alpha );
+        a0 =        (A+1) + (A-1)*cosf(w0) + 2*sqrtf(A)*alpha;
+        a1 =   -2*( (A-1) + (A+1)*cosf(w0));
+        a2 =        (A+1) + (A-1)*cosf(w0) - 2*sqrtf(A)*alpha;
+    }
+    // Store values to coeffs and normalize by 1/a0
+    coeffs[0] = b0/a0;
+    coeffs[1] = b1/a0;
+    coeffs[2] = b2/a0;
+    coeffs[3] = a1/a0;
+    coeffs[4] = a2/a0;
+}
+
+/*
+ * Calculate direct form IIR coefficients for a low pass filter
+ * (same layout and source as above)
+ */
+void biquad_LowPassCoeffs( float f0, float Q, float Fs, float *coeffs )
+{
+    if (f0 > Fs/2*0.95f) f0 = Fs/2*0.95f;
+
+    float w0 = 2*((float)M_PI)*f0/Fs;
+    float alpha = sinf(w0)/(2*Q);
+    float a0 = 1 + alpha;
+
+    coeffs[0] = (1 - cosf(w0))/2/a0;
+    coeffs[1] = (1 - cosf(w0))/a0;
+    coeffs[2] = (1 - cosf(w0))/2/a0;
+    coeffs[3] = -2*cosf(w0)/a0;
+    coeffs[4] = (1 - alpha)/a0;
+}
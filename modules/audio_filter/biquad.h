@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * biquad.h : multichannel biquad filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_BIQUAD_H_
+#define VLC_AUDIO_BIQUAD_H_
+
+enum biquad_isa
+{
+    BIQUAD_ISA_C,    /* reference */
+    BIQUAD_ISA_SSE2,
+    BIQUAD_ISA_NEON,
+    BIQUAD_ISA_COUNT
+};
+
+typedef struct biquad_t biquad_t;
+
+/* Creates a set of i_sections biquad filters (all passing through until set)
+ * for i_channels interleaved float channels. The channels are processed in
+ * parallel, in the vector lanes of the best instruction set of the CPU. */
+biquad_t *biquad_New(unsigned i_channels, unsigned i_sections);
+void biquad_Delete(biquad_t *);
+
+/* Selects another instruction set, mostly for testing */
+int biquad_SetISA(biquad_t *, enum biquad_isa);
+
+/* Sets the coefficients of a section: b0, b1, b2, a1 and a2, normalized by
+ * a0 (direct form 1, y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2) */
+void biquad_Set(biquad_t *, unsigned i_section, const float p_coeffs[5]);
+
+/* Clears the history, as if only silence had been processed */
+void biquad_Reset(biquad_t *);
+
+/* Runs the sections in series. p_out may be equal to p_in. */
+void biquad_Process(biquad_t *, float *p_out, const float *p_in,
+                    size_t i_frames);
+
+/* Runs the sections in parallel, and mixes their outputs with the given
+ * gains, to the input with the f_dry gain. p_out may be equal to p_in. */
+void biquad_ProcessBank(biquad_t *, float *p_out, const float *p_in,
+                        size_t i_frames, float f_dry, const float *p_gains);
+
+/* Coefficients from the RBJ audio EQ cookbook */
+void biquad_PeakCoeffs(float f0, float Q, float gainDB, float Fs,
+                       float *coeffs);
+void biquad_ShelfCoeffs(float f0, float slope, float gainDB, int high,
+                        float Fs, float *coeffs);
+void biquad_LowPassCoeffs(float f0, float Q, float Fs, float *coeffs);
+
+#endif
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * biquad_bench.c : benchmark of the biquad filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Prints the throughput of a 10 bands equalizer for each instruction set.
+ * biquad_test.c checks their output.
+ *
+ * Usage: audio_biquad_bench [frames] (default 1048576)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_bench.h>
+
+#include "biquad.h"
+
+#define RATE 48000
+#define BANDS 10
+
+static const char *const isa_names[BIQUAD_ISA_COUNT] = {
+    "C", "SSE2", "NEON",
+};
+
+static const float freqs[BANDS] = {
+    60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000,
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static void Fill(float *buf, size_t n, unsigned seed)
+{
+    for (size_t i = 0; i < n; i++)
+        buf[i] = (float)(rnd(&seed) & 0x7fff) / 0x4000 - 1.f;
+}
+
+static biquad_t *NewEq(unsigned channels, enum biquad_isa isa)
+{
+    biquad_t *b = biquad_New(channels, BANDS);
+
+    if (b == NULL)
+        return NULL;
+    if (biquad_SetISA(b, isa))
+    {
+        biquad_Delete(b);
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < BANDS; i++)
+    {
+        float coeffs[5];
+
+        biquad_PeakCoeffs(freqs[i], 1.4f, (float)i - 4.f, RATE, coeffs);
+        biquad_Set(b, i, coeffs);
+    }
+    return b;
+}
+
+struct bench
+{
+    biquad_t *b;
+    float *buf;
+    size_t frames;
+};
+
+static void BenchRun(void *opaque)
+{
+    static const float gains[BANDS];
+    struct bench *bench = opaque;
+
+    biquad_ProcessBank(bench->b, bench->buf, bench->buf, bench->frames, 1.f,
+                       gains);
+}
+
+static double Bench(enum biquad_isa isa, unsigned channels, float *buf,
+                    size_t frames)
+{
+    struct bench bench = { NewEq(channels, isa), buf, frames };
+
+    if (bench.b == NULL)
+        return 0.;
+
+    double speed = (double)frames
+                 * vlc_bench_Run(BenchRun, &bench, CLOCK_FREQ / 5);
+    biquad_Delete(bench.b);
+    return speed;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t frames = 1 << 20;
+
+    if (argc > 1)
+        frames = strtoul(argv[1], NULL, 0);
+    if (frames == 0)
+        return 1;
+
+    float *buf = malloc(frames * 8 * sizeof (float));
+    if (buf == NULL)
+        return 1;
+
+    static const unsigned layouts[] = { 2, 6, 8 };
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++)
+    {
+        printf("%u channels, %d bands, Mframes/s:", layouts[i], BANDS);
+        for (int isa = 0; isa < BIQUAD_ISA_COUNT; isa++)
+        {
+            Fill(buf, frames * layouts[i], 1);
+            double speed = Bench(isa, layouts[i], buf, frames);
+            if (speed > 0.)
+                printf(" %8.1f (%s)", speed, isa_names[isa]);
+        }
+        printf("\n");
+    }
+
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * biquad_test.c : check of the biquad filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the vector filters of this CPU give the same output as the C
+ * reference, in series and in parallel, for 1 to 9 channels and buffers of
+ * irregular sizes, that a peaking filter has the expected gain, and that the
+ * output never becomes denormal after silence.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+
+#include "biquad.h"
+
+#define RATE 48000
+#define BANDS 10
+
+static const char *const isa_names[BIQUAD_ISA_COUNT] = {
+    "C", "SSE2", "NEON",
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static biquad_t *NewEq(unsigned channels, enum biquad_isa isa)
+{
+    static const float freqs[BANDS] = {
+        60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000,
+    };
+    biquad_t *b = biquad_New(channels, BANDS);
+
+    assert(b != NULL);
+    if (biquad_SetISA(b, isa))
+    {
+        biquad_Delete(b);
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < BANDS; i++)
+    {
+        float coeffs[5];
+
+        biquad_PeakCoeffs(freqs[i], 1.4f, (float)i - 4.f, RATE, coeffs);
+        biquad_Set(b, i, coeffs);
+    }
+    return b;
+}
+
+static void Run(biquad_t *b, float *out, const float *in, size_t frames,
+                unsigned channels, bool bank, unsigned seed)
+{
+    static const float gains[BANDS] = {
+        .5f, -.3f, .2f, 1.f, -1.f, .7f, .1f, 0.f, .4f, -.2f,
+    };
+
+    for (size_t done = 0; done < frames;)
+    {
+        size_t n = __MIN(1 + rnd(&seed) % 700, frames - done);
+        const size_t offset = done * channels;
+
+        if (bank)
+            biquad_ProcessBank(b, out + offset, in + offset, n, .25f, gains);
+        else
+            biquad_Process(b, out + offset, in + offset, n);
+        done += n;
+    }
+}
+
+static void test_isa(enum biquad_isa isa, unsigned channels, bool bank)
+{
+    const size_t frames = 5000, samples = frames * channels;
+    float *in = malloc(samples * sizeof (float));
+    float *a = malloc(samples * sizeof (float));
+    float *b = malloc(samples * sizeof (float));
+    biquad_t *ref = NewEq(channels, BIQUAD_ISA_C);
+    biquad_t *simd = NewEq(channels, isa);
+
+    assert(in != NULL && a != NULL && b != NULL);
+    assert(ref != NULL && simd != NULL);
+    printf("%s, %u channels, %s\n", isa_names[isa], channels,
+           bank ? "bank" : "cascade");
+
+    unsigned seed = channels;
+    for (size_t i = 0; i < samples; i++)
+        in[i] = (float)(rnd(&seed) & 0x7fff) / 0x4000 - 1.f;
+
+    Run(ref, a, in, frames, channels, bank, 1);
+    /* in place, with other buffer sizes */
+    memcpy(b, in, samples * sizeof (float));
+    Run(simd, b, b, frames, channels, bank, 2);
+
+    for (size_t i = 0; i < samples; i++)
+        assert(fabsf(a[i] - b[i]) <= 1e-5f * (1.f + fabsf(a[i])));
+
+    biquad_Delete(ref);
+    biquad_Delete(simd);
+    free(in);
+    free(a);
+    free(b);
+}
+
+/* A peaking filter must have its gain at its center frequency, and the
+ * output must not become denormal once the input falls silent */
+static void test_response(enum biquad_isa isa)
+{
+    const size_t frames = RATE;
+    float *buf = malloc(frames * sizeof (float));
+    biquad_t *b = biquad_New(1, 1);
+    float coeffs[5];
+
+    assert(buf != NULL && b != NULL);
+    assert(biquad_SetISA(b, isa) == 0);
+
+    biquad_PeakCoeffs(1000.f, 2.f, 6.f, RATE, coeffs);
+    biquad_Set(b, 0, coeffs);
+    for (size_t i = 0; i < frames; i++)
+        buf[i] = sinf(2.f * (float)M_PI * 1000.f * i / RATE);
+    biquad_Process(b, buf, buf, frames);
+
+    float peak = 0.f;
+    for (size_t i = frames / 2; i < frames; i++)
+        peak = __MAX(peak, fabsf(buf[i]));
+    printf("%s: gain %.2f dB\n", isa_names[isa], 20.f * log10f(peak));
+    assert(fabsf(20.f * log10f(peak) - 6.f) <= .1f);
+
+    for (unsigned pass = 0; pass < 20; pass++)
+    {
+        memset(buf, 0, frames * sizeof (float));
+        biquad_Process(b, buf, buf, frames);
+    }
+    for (size_t i = 0; i < frames; i++)
+        assert(buf[i] == 0.f || fpclassify(buf[i]) == FP_NORMAL);
+
+    biquad_Delete(b);
+    free(buf);
+}
+
+int main(void)
+{
+    for (int isa = 0; isa < BIQUAD_ISA_COUNT; isa++)
+    {
+        biquad_t *b = biquad_New(1, 1);
+        assert(b != NULL);
+
+        bool available = !biquad_SetISA(b, isa);
+        biquad_Delete(b);
+        if (!available)
+            continue;
+
+        test_response(isa);
+        if (isa == BIQUAD_ISA_C)
+            continue;
+        for (unsigned channels = 1; channels <= 9; channels++)
+        {
+            test_isa(isa, channels, false);
+            test_isa(isa, channels, true);
+        }
+    }
+    return 0;
+}
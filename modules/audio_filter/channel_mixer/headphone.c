@@ -39,12 +39,15 @@
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "../convolver.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static int  OpenFilter ( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 static block_t *Convert( filter_t *, block_t * );
+static void Flush( filter_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -72,6 +75,14 @@ static block_t *Convert( filter_t *, block_t * );
      "Dolby Surround encoded streams won't be decoded before being " \
      "processed by this filter. Enabling this setting is not recommended.")
 
+#define HEADPHONE_IR_TEXT N_("Impulse responses")
+#define HEADPHONE_IR_LONGTEXT N_( \
+     "WAV file of measured head related impulse responses, used instead " \
+     "of the physical model. It holds pairs of left and right ear responses " \
+     "for the front left, front right, center, LFE, rear left, rear right, " \
+     "rear center, side left and side right speakers, in that order. " \
+     "Speakers missing from the file use the physical model.")
+
 vlc_module_begin ()
     set_description( N_("Headphone virtual spatialization effect") )
     set_shortname( N_("Headphone effect") )
@@ -85,6 +96,8 @@ vlc_module_begin ()
               HEADPHONE_COMPENSATE_LONGTEXT, true )
     add_bool( "headphone-dolby", false, HEADPHONE_DOLBY_TEXT,
               HEADPHONE_DOLBY_LONGTEXT, true )
+    add_loadfile( "headphone-ir", NULL, HEADPHONE_IR_TEXT,
+                  HEADPHONE_IR_LONGTEXT, true )
 
     set_capability( "audio filter", 0 )
     set_callbacks( OpenFilter, CloseFilter )
@@ -103,12 +116,29 @@ struct atomic_operation_t
     double d_amplitude_factor;
 };
 
+struct atomic_operations_t
+{
+    unsigned int i_nb_atomic_operations;
+    struct atomic_operation_t * p_atomic_operations;
+};
+
 struct filter_sys_t
 {
+    /* Physical model, applied directly */
+    struct atomic_operations_t ops;
     size_t i_overflow_buffer_size;/* in bytes */
     float * p_overflow_buffer;
-    unsigned int i_nb_atomic_operations;
-    struct atomic_operation_t * p_atomic_operations;
+
+    /* Measured responses, through the convolver */
+    convolver_t * p_conv;
+};
+
+/* Order of the speakers in the impulse responses file (WAVE order) */
+static const uint32_t pi_ir_chan_order[] =
+{
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+    AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT, AOUT_CHAN_REARCENTER,
+    AOUT_CHAN_MIDDLELEFT, AOUT_CHAN_MIDDLERIGHT,
 };
 
 /*****************************************************************************
@@ -129,7 +159,7 @@ struct filter_sys_t
  *
  *          x-axis
  *  */
-static void ComputeChannelOperations( struct filter_sys_t * p_data
+static void ComputeChannelOperations( struct atomic_operations_t * p_data
         , unsigned int i_rate, unsigned int i_next_atomic_operation
         , int i_source_channel_offset, double d_x, double d_z
         , double d_compensation_length, double d_channel_amplitude_factor )
@@ -143,8 +173,8 @@ static void ComputeChannelOperations( struct filter_sys_t * p_data
     p_data->p_atomic_operations[i_next_atomic_operation]
         .i_dest_channel_offset = 0;/* left */
     p_data->p_atomic_operations[i_next_atomic_operation]
-        .i_delay = (int)( sqrt( (-0.1-d_x)*(-0.1-d_x) + (0-d_z)*(0-d_z) )
-                          / d_c * i_rate - d_compensation_delay );
+        .i_delay = __MAX( (int)( sqrt( (-0.1-d_x)*(-0.1-d_x) + (0-d_z)*(0-d_z) )
+                                 / d_c * i_rate - d_compensation_delay ), 0 );
     if( d_x < 0 )
     {
         p_data->p_atomic_operations[i_next_atomic_operation]
@@ -167,8 +197,8 @@ static void ComputeChannelOperations( struct filter_sys_t * p_data
     p_data->p_atomic_operations[i_next_atomic_operation + 1]
         .i_dest_channel_offset = 1;/* right */
     p_data->p_atomic_operations[i_next_atomic_operation + 1]
-        .i_delay = (int)( sqrt( (0.1-d_x)*(0.1-d_x) + (0-d_z)*(0-d_z) )
-                          / d_c * i_rate - d_compensation_delay );
+        .i_delay = __MAX( (int)( sqrt( (0.1-d_x)*(0.1-d_x) + (0-d_z)*(0-d_z) )
+                                 / d_c * i_rate - d_compensation_delay ), 0 );
     if( d_x < 0 )
     {
         p_data->p_atomic_operations[i_next_atomic_operation + 1]
@@ -186,7 +216,8 @@ static void ComputeChannelOperations( struct filter_sys_t * p_data
     }
 }
 
-static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
+static int ComputeOperations( vlc_object_t *p_this
+        , struct atomic_operations_t * p_data
         , unsigned int i_nb_channels, uint32_t i_physical_channels
         , unsigned int i_rate )
 {
@@ -196,7 +227,6 @@ static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
     double d_min = 0;
     unsigned int i_next_atomic_operation;
     int i_source_channel_offset;
-    unsigned int i;
 
     if( var_InheritBool( p_this, "headphone-compensate" ) )
     {
@@ -304,27 +334,153 @@ static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
         i_source_channel_offset++;
     }
 
-    /* Initialize the overflow buffer
-     * we need it because the process induce a delay in the samples */
+    return 0;
+}
+
+/*****************************************************************************
+ * InitOverflow: initializes the overflow buffer of the physical model
+ * we need it because the process induce a delay in the samples
+ *****************************************************************************/
+static int InitOverflow( struct filter_sys_t * p_data )
+{
+    const struct atomic_operations_t *p_ops = &p_data->ops;
+
     p_data->i_overflow_buffer_size = 0;
-    for( i = 0 ; i < p_data->i_nb_atomic_operations ; i++ )
+    for( unsigned int i = 0 ; i < p_ops->i_nb_atomic_operations ; i++ )
     {
         if( p_data->i_overflow_buffer_size
-                < p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float) )
+                < p_ops->p_atomic_operations[i].i_delay * 2 * sizeof (float) )
         {
             p_data->i_overflow_buffer_size
-                = p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float);
+                = p_ops->p_atomic_operations[i].i_delay * 2 * sizeof (float);
         }
     }
     p_data->p_overflow_buffer = malloc( p_data->i_overflow_buffer_size );
     if( p_data->p_overflow_buffer == NULL )
+        return -1;
+    memset( p_data->p_overflow_buffer, 0 , p_data->i_overflow_buffer_size );
+    return 0;
+}
+
+/*****************************************************************************
+ * Init: computes the atomic operations, then either applies them directly,
+ * or, with measured responses, builds the impulse responses of every
+ * channel to each ear and the convolver
+ *****************************************************************************/
+static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
+        , unsigned int i_nb_channels, uint32_t i_physical_channels
+        , unsigned int i_rate )
+{
+    struct atomic_operations_t ops;
+    float * p_file_ir = NULL;
+    unsigned int i_file_channels = 0;
+    size_t i_file_frames = 0;
+    size_t i_frames;
+    unsigned int i;
+
+    if( ComputeOperations( p_this, &ops, i_nb_channels, i_physical_channels,
+                           i_rate ) < 0 )
+        return -1;
+
+    char *psz_ir = var_InheritString( p_this, "headphone-ir" );
+    if( psz_ir == NULL )
     {
-        free( p_data->p_atomic_operations );
+        /* The convolver would add a block of latency for sparse responses */
+        p_data->ops = ops;
+        if( InitOverflow( p_data ) < 0 )
+        {
+            free( ops.p_atomic_operations );
+            return -1;
+        }
+        return 0;
+    }
+
+    p_file_ir = convolver_LoadWav( p_this, psz_ir, i_rate,
+                                   &i_file_channels, &i_file_frames );
+    free( psz_ir );
+    if( p_file_ir == NULL )
+    {
+        free( ops.p_atomic_operations );
         return -1;
     }
-    memset( p_data->p_overflow_buffer, 0 , p_data->i_overflow_buffer_size );
+    i_frames = i_file_frames;
+
+    for( i = 0 ; i < ops.i_nb_atomic_operations ; i++ )
+        if( i_frames <= ops.p_atomic_operations[i].i_delay )
+            i_frames = ops.p_atomic_operations[i].i_delay + 1;
+    i_frames = __MIN( i_frames, CONVOLVER_MAX_FRAMES );
+
+    float * p_ir = malloc( i_frames * 2 * sizeof (float) );
+    p_data->p_conv = convolver_New( 0, i_nb_channels, 2, i_frames );
+    if( p_ir == NULL || p_data->p_conv == NULL )
+        goto error;
+
+    /* Input channels are in VLC order, and have the same offsets as the
+     * atomic operations */
+    unsigned int i_source_channel_offset = 0;
+    for( i = 0 ; pi_vlc_chan_order_wg4[i] ; i++ )
+    {
+        const uint32_t i_chan = pi_vlc_chan_order_wg4[i];
+        if( !( i_physical_channels & i_chan ) )
+            continue;
+
+        /* Position of the speaker in the file, if any */
+        unsigned int i_pair = 0;
+        while( i_pair < ARRAY_SIZE(pi_ir_chan_order)
+            && pi_ir_chan_order[i_pair] != i_chan )
+            i_pair++;
+
+        if( 2 * i_pair + 1 < i_file_channels )
+        {
+            const float *p_src = p_file_ir + 2 * i_pair;
+            const size_t i_len = __MIN( i_file_frames, i_frames );
+
+            convolver_SetResponse( p_data->p_conv, i_source_channel_offset, 0,
+                                   p_src, i_len, i_file_channels );
+            convolver_SetResponse( p_data->p_conv, i_source_channel_offset, 1,
+                                   p_src + 1, i_len, i_file_channels );
+        }
+        else
+        {
+            /* Each atomic operation is a delayed and scaled impulse */
+            size_t i_len = 1;
 
+            memset( p_ir, 0, i_frames * 2 * sizeof (float) );
+            for( unsigned int j = 0 ; j < ops.i_nb_atomic_operations ; j++ )
+            {
+                const struct atomic_operation_t *p_op =
+                    &ops.p_atomic_operations[j];
+
+                if( p_op->i_source_channel_offset !=
+                        (int)i_source_channel_offset
+                 || p_op->i_delay >= i_frames )
+                    continue;
+                p_ir[p_op->i_delay * 2 + p_op->i_dest_channel_offset]
+                    += p_op->d_amplitude_factor;
+                i_len = __MAX( i_len, p_op->i_delay + 1 );
+            }
+            convolver_SetResponse( p_data->p_conv, i_source_channel_offset, 0,
+                                   p_ir, i_len, 2 );
+            convolver_SetResponse( p_data->p_conv, i_source_channel_offset, 1,
+                                   p_ir + 1, i_len, 2 );
+        }
+        i_source_channel_offset++;
+    }
+
+    msg_Dbg( p_this, "%zu frames of impulse responses, %u frames of latency",
+             i_frames, convolver_GetLatency( p_data->p_conv ) );
+    free( p_ir );
+    free( p_file_ir );
+    free( ops.p_atomic_operations );
     return 0;
+
+error:
+    if( p_data->p_conv != NULL )
+        convolver_Delete( p_data->p_conv );
+    free( p_ir );
+    free( p_file_ir );
+    free( ops.p_atomic_operations );
+    return -1;
 }
 
 /*****************************************************************************
@@ -387,16 +543,16 @@ static void DoWork( filter_t * p_filter,
     }
 
     /* apply the atomic operations */
-    for( i = 0; i < p_sys->i_nb_atomic_operations; i++ )
+    for( i = 0; i < p_sys->ops.i_nb_atomic_operations; i++ )
     {
         /* shorter variable names */
         i_source_channel_offset
-            = p_sys->p_atomic_operations[i].i_source_channel_offset;
+            = p_sys->ops.p_atomic_operations[i].i_source_channel_offset;
         i_dest_channel_offset
-            = p_sys->p_atomic_operations[i].i_dest_channel_offset;
-        i_delay = p_sys->p_atomic_operations[i].i_delay;
+            = p_sys->ops.p_atomic_operations[i].i_dest_channel_offset;
+        i_delay = p_sys->ops.p_atomic_operations[i].i_delay;
         d_amplitude_factor
-            = p_sys->p_atomic_operations[i].d_amplitude_factor;
+            = p_sys->ops.p_atomic_operations[i].d_amplitude_factor;
 
         if( p_out_buf->i_nb_samples > i_delay )
         {
@@ -450,14 +606,31 @@ static int OpenFilter( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* Request a specific format if not already compatible */
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
+    p_filter->fmt_out.audio.i_rate = p_filter->fmt_in.audio.i_rate;
+    p_filter->fmt_in.audio.i_chan_mode =
+                                   p_filter->fmt_out.audio.i_chan_mode;
+    if( p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
+     && (p_filter->fmt_in.audio.i_chan_mode & AOUT_CHANMODE_DOLBYSTEREO)
+     && !var_InheritBool( p_filter, "headphone-dolby" ) )
+    {
+        p_filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_0;
+    }
+
+    aout_FormatPrepare(&p_filter->fmt_in.audio);
+    aout_FormatPrepare(&p_filter->fmt_out.audio);
+
     /* Allocate the memory needed to store the module's structure */
     p_sys = p_filter->p_sys = malloc( sizeof(struct filter_sys_t) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
+    p_sys->ops.i_nb_atomic_operations = 0;
+    p_sys->ops.p_atomic_operations = NULL;
     p_sys->i_overflow_buffer_size = 0;
     p_sys->p_overflow_buffer = NULL;
-    p_sys->i_nb_atomic_operations = 0;
-    p_sys->p_atomic_operations = NULL;
+    p_sys->p_conv = NULL;
 
     if( Init( VLC_OBJECT(p_filter), p_sys
                 , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
@@ -468,22 +641,8 @@ static int OpenFilter( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Request a specific format if not already compatible */
-    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
-    p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
-    p_filter->fmt_out.audio.i_rate = p_filter->fmt_in.audio.i_rate;
-    p_filter->fmt_in.audio.i_chan_mode =
-                                   p_filter->fmt_out.audio.i_chan_mode;
-    if( p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
-     && (p_filter->fmt_in.audio.i_chan_mode & AOUT_CHANMODE_DOLBYSTEREO)
-     && !var_InheritBool( p_filter, "headphone-dolby" ) )
-    {
-        p_filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_0;
-    }
     p_filter->pf_audio_filter = Convert;
-
-    aout_FormatPrepare(&p_filter->fmt_in.audio);
-    aout_FormatPrepare(&p_filter->fmt_out.audio);
+    p_filter->pf_flush = Flush;
 
     return VLC_SUCCESS;
 }
@@ -495,9 +654,23 @@ static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
-    free( p_filter->p_sys->p_overflow_buffer );
-    free( p_filter->p_sys->p_atomic_operations );
-    free( p_filter->p_sys );
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_conv != NULL )
+        convolver_Delete( p_sys->p_conv );
+    free( p_sys->p_overflow_buffer );
+    free( p_sys->ops.p_atomic_operations );
+    free( p_sys );
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_conv != NULL )
+        convolver_Reset( p_sys->p_conv );
+    else
+        memset( p_sys->p_overflow_buffer, 0, p_sys->i_overflow_buffer_size );
 }
 
 static block_t *Convert( filter_t *p_filter, block_t *p_block )
@@ -526,7 +699,23 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    filter_sys_t *p_sys = p_filter->p_sys;
+    if( p_sys->p_conv != NULL )
+    {
+        convolver_Process( p_sys->p_conv, (const float *)p_block->p_buffer,
+                           (float *)p_out->p_buffer, p_block->i_nb_samples );
+
+        /* The output is late by a block of the convolver */
+        const mtime_t i_latency = CLOCK_FREQ
+            * convolver_GetLatency( p_sys->p_conv )
+            / p_filter->fmt_in.audio.i_rate;
+        if( p_out->i_pts > VLC_TS_INVALID )
+            p_out->i_pts -= i_latency;
+        if( p_out->i_dts > VLC_TS_INVALID )
+            p_out->i_dts -= i_latency;
+    }
+    else
+        DoWork( p_filter, p_block, p_out );
 
     block_Release( p_block );
     return p_out;
@@ -0,0 +1,1179 @@
+/*****************************************************************************
+ * pcm_simd.c : PCM sample format conversion and volume kernels
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <limits.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_block.h>
+#include <vlc_fourcc.h>
+#include <vlc_aout_volume.h>
+
+#include "pcm_simd.h"
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define PCM_SIMD_SSE2
+# define PCM_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define PCM_SIMD_AVX2
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define PCM_SIMD_NEON
+#endif
+
+/*****************************************************************************
+ * C reference
+ *
+ * These must give exactly the same output as the vector versions, which only
+ * leave the end of the buffers to them.
+ *****************************************************************************/
+
+/*** from U8 ***/
+static void U8toS16(void *restrict dst_, const void *src_, size_t n)
+{
+    const uint8_t *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) << 8) - 0x8000;
+}
+
+static void U8toFl32(void *restrict dst_, const void *src_, size_t n)
+{
+    const uint8_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((float)((*src++) - 128)) / 128.f;
+}
+
+static void U8toS32(void *restrict dst_, const void *src_, size_t n)
+{
+    const uint8_t *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) - 128) * (1 << 24);
+}
+
+static void U8toFl64(void *restrict dst_, const void *src_, size_t n)
+{
+    const uint8_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((double)((*src++) - 128)) / 128.;
+}
+
+/*** from S16N ***/
+static void S16toU8(void *dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) + 32768) >> 8;
+}
+
+static void S16toFl32(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+    {   /* This is Walken's trick based on IEEE float format. */
+        union { float f; int32_t i; } u;
+        u.i = *src++ + 0x43c00000;
+        *dst++ = u.f - 384.f;
+    }
+}
+
+static void S16toS32(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = *src++ * (1 << 16);
+}
+
+static void S16toFl64(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (double)*src++ / 32768.;
+}
+
+/*** from FL32 ***/
+static void Fl32toU8(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 128.f;
+        if (s >= 127.f)
+            *(dst++) = 255;
+        else
+        if (s <= -128.f)
+            *(dst++) = 0;
+        else
+            *(dst++) = lroundf(s) + 128;
+    }
+}
+
+static void Fl32toS16(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {   /* This is Walken's trick based on IEEE float format. */
+        union { float f; int32_t i; } u;
+        u.f = *src++ + 384.f;
+        if (u.i > 0x43c07fff)
+            *dst++ = 32767;
+        else if (u.i < 0x43bf8000)
+            *dst++ = -32768;
+        else
+            *dst++ = u.i - 0x43c00000;
+    }
+}
+
+static void Fl32toS32(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 2147483648.f;
+        if (s >= 2147483647.f)
+            *(dst++) = 2147483647;
+        else
+        if (s <= -2147483648.f)
+            *(dst++) = -2147483648;
+        else
+            *(dst++) = lroundf(s);
+    }
+}
+
+static void Fl32toFl64(void *restrict dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *(dst++) = *(src++);
+}
+
+/*** from S32N ***/
+static void S32toU8(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) >> 24) + 128;
+}
+
+static void S32toS16(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (*src++) >> 16;
+}
+
+static void S32toFl32(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (float)(*src++) / 2147483648.f;
+}
+
+static void S32toFl64(void *restrict dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (double)(*src++) / 2147483648.;
+}
+
+/*** from FL64 ***/
+static void Fl64toU8(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 128.;
+        if (s >= 127.f)
+            *(dst++) = 255;
+        else
+        if (s <= -128.f)
+            *(dst++) = 0;
+        else
+            *(dst++) = lround(s) + 128;
+    }
+}
+
+static void Fl64toS16(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        const double v = *src++ * 32768.;
+        if (v >= 32767.)
+            *dst++ = 32767;
+        else if (v < -32768.)
+            *dst++ = -32768;
+        else
+            *dst++ = lround(v);
+    }
+}
+
+static void Fl64toFl32(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *(dst++) = *(src++);
+}
+
+static void Fl64toS32(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 2147483648.;
+        if (s >= 2147483647.f)
+            *(dst++) = 2147483647;
+        else
+        if (s <= -2147483648.f)
+            *(dst++) = -2147483648;
+        else
+            *(dst++) = lround(s);
+    }
+}
+
+/*** volume ***/
+static void AmplifyFl32(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return; /* nothing to do */
+
+    float *p = (float *)block->p_buffer;
+    for (size_t i = block->i_buffer / sizeof (*p); i > 0; i--)
+        *(p++) *= volume;
+    (void) vol;
+}
+
+static void AmplifyFl64(audio_volume_t *vol, block_t *block, float volume)
+{
+    double *p = (double *)block->p_buffer;
+    double mult = volume;
+    if (mult == 1.)
+        return; /* nothing to do */
+
+    for (size_t i = block->i_buffer / sizeof (*p); i > 0; i--)
+        *(p++) *= mult;
+    (void) vol;
+}
+
+static void AmplifyS32(audio_volume_t *vol, block_t *block, float volume)
+{
+    int32_t *p = (int32_t *)block->p_buffer;
+
+    int_fast32_t mult = lroundf(volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
+    {
+        int_fast64_t s = (*p * (int_fast64_t)mult) >> INT64_C(24);
+        if (s > INT32_MAX)
+            s = INT32_MAX;
+        else
+        if (s < INT32_MIN)
+            s = INT32_MIN;
+        *(p++) = s;
+    }
+    (void) vol;
+}
+
+static void AmplifyS16Samples(int16_t *p, size_t n, int_fast32_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast32_t s = (*p * mult) >> 8;
+        if (s > INT16_MAX)
+            s = INT16_MAX;
+        else
+        if (s < INT16_MIN)
+            s = INT16_MIN;
+        *(p++) = s;
+    }
+}
+
+static void AmplifyS16(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    AmplifyS16Samples((int16_t *)block->p_buffer,
+                      block->i_buffer / sizeof (int16_t), mult);
+    (void) vol;
+}
+
+static void AmplifyU8(audio_volume_t *vol, block_t *block, float volume)
+{
+    uint8_t *p = (uint8_t *)block->p_buffer;
+
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
+    {
+        int_fast32_t s = (((int_fast8_t)(*p - 128)) * (int_fast32_t)mult) >> 8;
+        if (s > INT8_MAX)
+            s = INT8_MAX;
+        else
+        if (s < INT8_MIN)
+            s = INT8_MIN;
+        *(p++) = s + 128;
+    }
+    (void) vol;
+}
+
+/*****************************************************************************
+ * SSE2
+ *****************************************************************************/
+#ifdef PCM_SIMD_SSE2
+PCM_SSE2
+static void S16toFl32_SSE2(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    S16toFl32(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void Fl32toS16_SSE2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 max = _mm_set1_ps(32767.f), min = _mm_set1_ps(-32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+
+        a = _mm_min_ps(_mm_max_ps(a, min), max);
+        b = _mm_min_ps(_mm_max_ps(b, min), max);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    Fl32toS16(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void S32toFl32_SSE2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    S32toFl32(dst + i, src + i, n - i);
+}
+
+/* Rounds half away from zero like lroundf(), and saturates */
+PCM_SSE2
+static inline __m128i RoundS32_SSE2(__m128 s)
+{
+    const __m128 half = _mm_set1_ps(.5f);
+    const __m128 limit = _mm_set1_ps(2147483648.f);
+    const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    s = _mm_max_ps(s, _mm_set1_ps(-2147483648.f));
+
+    __m128i t = _mm_cvttps_epi32(s);
+    __m128 frac = _mm_sub_ps(s, _mm_cvtepi32_ps(t));
+    __m128i up = _mm_castps_si128(_mm_cmpge_ps(_mm_and_ps(frac, abs), half));
+    __m128i neg = _mm_srai_epi32(_mm_castps_si128(s), 31);
+    __m128i adj = _mm_and_si128(up, _mm_set1_epi32(1));
+
+    t = _mm_add_epi32(t, _mm_sub_epi32(_mm_xor_si128(adj, neg), neg));
+
+    __m128i over = _mm_castps_si128(_mm_cmpge_ps(s, limit));
+    return _mm_or_si128(_mm_andnot_si128(over, t),
+                        _mm_and_si128(over, _mm_set1_epi32(INT32_MAX)));
+}
+
+PCM_SSE2
+static void Fl32toS32_SSE2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    const __m128 scale = _mm_set1_ps(2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        _mm_storeu_si128((__m128i *)(dst + i), RoundS32_SSE2(s));
+    }
+    Fl32toS32(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void S16toS32_SSE2(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(zero, v));
+    }
+    S16toS32(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void S32toS16_SSE2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 4));
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packs_epi32(_mm_srai_epi32(a, 16),
+                                         _mm_srai_epi32(b, 16)));
+    }
+    S32toS16(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void Fl32toFl64_SSE2(void *restrict dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    Fl32toFl64(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void Fl64toFl32_SSE2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 a = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 b = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(a, b));
+    }
+    Fl64toFl32(dst + i, src + i, n - i);
+}
+
+PCM_SSE2
+static void AmplifyFl32_SSE2(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m128 mult = _mm_set1_ps(volume);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm_storeu_ps(p + i, _mm_mul_ps(_mm_loadu_ps(p + i), mult));
+        _mm_storeu_ps(p + i + 4, _mm_mul_ps(_mm_loadu_ps(p + i + 4), mult));
+    }
+    for (; i < n; i++)
+        p[i] *= volume;
+    (void) vol;
+}
+
+PCM_SSE2
+static void AmplifyFl64_SSE2(audio_volume_t *vol, block_t *block, float volume)
+{
+    const double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m128d vmult = _mm_set1_pd(mult);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_pd(p + i, _mm_mul_pd(_mm_loadu_pd(p + i), vmult));
+        _mm_storeu_pd(p + i + 2, _mm_mul_pd(_mm_loadu_pd(p + i + 2), vmult));
+    }
+    for (; i < n; i++)
+        p[i] *= mult;
+    (void) vol;
+}
+
+PCM_SSE2
+static void AmplifyS16_SSE2(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    /* The products are computed on 32 bits from 16-bit factors */
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const __m128i m = _mm_set1_epi16(mult);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i lo = _mm_mullo_epi16(v, m), hi = _mm_mulhi_epi16(v, m);
+            __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+            __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+            _mm_storeu_si128((__m128i *)(p + i), _mm_packs_epi32(a, b));
+        }
+    }
+    AmplifyS16Samples(p + i, n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef PCM_SIMD_AVX2
+VLC_AVX2
+static void S16toFl32_AVX2(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i + 8)));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    S16toFl32(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void Fl32toS16_AVX2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f), min = _mm256_set1_ps(-32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+
+        a = _mm256_min_ps(_mm256_max_ps(a, min), max);
+        b = _mm256_min_ps(_mm256_max_ps(b, min), max);
+
+        /* the packing works within 128-bit lanes */
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(a),
+                                       _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(v, 0xD8));
+    }
+    Fl32toS16(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void S32toFl32_AVX2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    S32toFl32(dst + i, src + i, n - i);
+}
+
+/* Rounds half away from zero like lroundf(), and saturates */
+VLC_AVX2
+static inline __m256i RoundS32_AVX2(__m256 s)
+{
+    const __m256 half = _mm256_set1_ps(.5f);
+    const __m256 limit = _mm256_set1_ps(2147483648.f);
+    const __m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    s = _mm256_max_ps(s, _mm256_set1_ps(-2147483648.f));
+
+    __m256i t = _mm256_cvttps_epi32(s);
+    __m256 frac = _mm256_sub_ps(s, _mm256_cvtepi32_ps(t));
+    __m256i up = _mm256_castps_si256(_mm256_cmp_ps(_mm256_and_ps(frac, abs),
+                                                   half, _CMP_GE_OQ));
+    __m256i neg = _mm256_srai_epi32(_mm256_castps_si256(s), 31);
+    __m256i adj = _mm256_and_si256(up, _mm256_set1_epi32(1));
+
+    t = _mm256_add_epi32(t, _mm256_sub_epi32(_mm256_xor_si256(adj, neg), neg));
+
+    __m256i over = _mm256_castps_si256(_mm256_cmp_ps(s, limit, _CMP_GE_OQ));
+    return _mm256_blendv_epi8(t, _mm256_set1_epi32(INT32_MAX), over);
+}
+
+VLC_AVX2
+static void Fl32toS32_AVX2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    const __m256 scale = _mm256_set1_ps(2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        _mm256_storeu_si256((__m256i *)(dst + i), RoundS32_AVX2(s));
+    }
+    Fl32toS32(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void S16toS32_AVX2(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i + 8)));
+
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi32(a, 16));
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), _mm256_slli_epi32(b, 16));
+    }
+    S16toS32(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void S32toS16_AVX2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i v = _mm256_packs_epi32(_mm256_srai_epi32(a, 16),
+                                       _mm256_srai_epi32(b, 16));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(v, 0xD8));
+    }
+    S32toS16(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void Fl32toFl64_AVX2(void *restrict dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+        _mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+    }
+    Fl32toFl64(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void Fl64toFl32_AVX2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i));
+        __m128 b = _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4));
+        _mm_storeu_ps(dst + i, a);
+        _mm_storeu_ps(dst + i + 4, b);
+    }
+    Fl64toFl32(dst + i, src + i, n - i);
+}
+
+VLC_AVX2
+static void AmplifyFl32_AVX2(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m256 mult = _mm256_set1_ps(volume);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm256_storeu_ps(p + i, _mm256_mul_ps(_mm256_loadu_ps(p + i), mult));
+        _mm256_storeu_ps(p + i + 8,
+                         _mm256_mul_ps(_mm256_loadu_ps(p + i + 8), mult));
+    }
+    for (; i < n; i++)
+        p[i] *= volume;
+    (void) vol;
+}
+
+VLC_AVX2
+static void AmplifyFl64_AVX2(audio_volume_t *vol, block_t *block, float volume)
+{
+    const double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m256d vmult = _mm256_set1_pd(mult);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_pd(p + i, _mm256_mul_pd(_mm256_loadu_pd(p + i), vmult));
+        _mm256_storeu_pd(p + i + 4,
+                         _mm256_mul_pd(_mm256_loadu_pd(p + i + 4), vmult));
+    }
+    for (; i < n; i++)
+        p[i] *= mult;
+    (void) vol;
+}
+
+VLC_AVX2
+static void AmplifyS16_AVX2(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    /* The products are computed on 32 bits from 16-bit factors. The
+     * unpacking and packing both work within 128-bit lanes. */
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const __m256i m = _mm256_set1_epi16(mult);
+
+        for (; i + 16 <= n; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            __m256i lo = _mm256_mullo_epi16(v, m);
+            __m256i hi = _mm256_mulhi_epi16(v, m);
+            __m256i a = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), 8);
+            __m256i b = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), 8);
+            _mm256_storeu_si256((__m256i *)(p + i), _mm256_packs_epi32(a, b));
+        }
+    }
+    AmplifyS16Samples(p + i, n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef PCM_SIMD_NEON
+static void S16toFl32_NEON(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t a = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t b = vcvtq_f32_s32(vmovl_high_s16(v));
+
+        vst1q_f32(dst + i, vmulq_n_f32(a, 1.f / 32768.f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(b, 1.f / 32768.f));
+    }
+    S16toFl32(dst + i, src + i, n - i);
+}
+
+static void Fl32toS16_NEON(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    size_t i = 0;
+
+    /* the conversions round to nearest even and saturate */
+    for (; i + 8 <= n; i += 8)
+    {
+        int32x4_t a = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i), 32768.f));
+        int32x4_t b = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i + 4), 32768.f));
+
+        vst1q_s16(dst + i, vqmovn_high_s32(vqmovn_s32(a), b));
+    }
+    Fl32toS16(dst + i, src + i, n - i);
+}
+
+static void S32toFl32_NEON(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)),
+                                       1.f / 2147483648.f));
+    S32toFl32(dst + i, src + i, n - i);
+}
+
+static void Fl32toS32_NEON(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    size_t i = 0;
+
+    /* the conversion rounds half away from zero and saturates */
+    for (; i + 4 <= n; i += 4)
+        vst1q_s32(dst + i, vcvtaq_s32_f32(vmulq_n_f32(vld1q_f32(src + i),
+                                                      2147483648.f)));
+    Fl32toS32(dst + i, src + i, n - i);
+}
+
+static void S16toS32_NEON(void *restrict dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(src + i);
+        vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(v), 16));
+        vst1q_s32(dst + i + 4, vshll_high_n_s16(v, 16));
+    }
+    S16toS32(dst + i, src + i, n - i);
+}
+
+static void S32toS16_NEON(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x4_t a = vshrn_n_s32(vld1q_s32(src + i), 16);
+        vst1q_s16(dst + i, vshrn_high_n_s32(a, vld1q_s32(src + i + 4), 16));
+    }
+    S32toS16(dst + i, src + i, n - i);
+}
+
+static void Fl32toFl64_NEON(void *restrict dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t v = vld1q_f32(src + i);
+        vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(dst + i + 2, vcvt_high_f64_f32(v));
+    }
+    Fl32toFl64(dst + i, src + i, n - i);
+}
+
+static void Fl64toFl32_NEON(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x2_t a = vcvt_f32_f64(vld1q_f64(src + i));
+        vst1q_f32(dst + i, vcvt_high_f32_f64(a, vld1q_f64(src + i + 2)));
+    }
+    Fl64toFl32(dst + i, src + i, n - i);
+}
+
+static void AmplifyFl32_NEON(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        vst1q_f32(p + i, vmulq_n_f32(vld1q_f32(p + i), volume));
+        vst1q_f32(p + i + 4, vmulq_n_f32(vld1q_f32(p + i + 4), volume));
+    }
+    for (; i < n; i++)
+        p[i] *= volume;
+    (void) vol;
+}
+
+static void AmplifyFl64_NEON(audio_volume_t *vol, block_t *block, float volume)
+{
+    const double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f64(p + i, vmulq_n_f64(vld1q_f64(p + i), mult));
+        vst1q_f64(p + i + 2, vmulq_n_f64(vld1q_f64(p + i + 2), mult));
+    }
+    for (; i < n; i++)
+        p[i] *= mult;
+    (void) vol;
+}
+
+static void AmplifyS16_NEON(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    /* The products are computed on 32 bits from 16-bit factors */
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const int16x8_t m = vdupq_n_s16(mult);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            int16x8_t v = vld1q_s16(p + i);
+            int16x4_t a = vqshrn_n_s32(vmull_s16(vget_low_s16(v),
+                                                 vget_low_s16(m)), 8);
+            vst1q_s16(p + i, vqshrn_high_n_s32(a, vmull_high_s16(v, m), 8));
+        }
+    }
+    AmplifyS16Samples(p + i, n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * Dispatch
+ *****************************************************************************/
+struct pcm_simd_convert
+{
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    pcm_simd_convert_t convert[PCM_SIMD_ISA_COUNT];
+};
+
+#ifdef PCM_SIMD_SSE2
+# define SSE2(f) [PCM_SIMD_ISA_SSE2] = f##_SSE2,
+#else
+# define SSE2(f)
+#endif
+#ifdef PCM_SIMD_AVX2
+# define AVX2(f) [PCM_SIMD_ISA_AVX2] = f##_AVX2,
+#else
+# define AVX2(f)
+#endif
+#ifdef PCM_SIMD_NEON
+# define NEON(f) [PCM_SIMD_ISA_NEON] = f##_NEON,
+#else
+# define NEON(f)
+#endif
+#define C(f)    { [PCM_SIMD_ISA_C] = f }
+#define SIMD(f) { [PCM_SIMD_ISA_C] = f, SSE2(f) AVX2(f) NEON(f) }
+
+static const struct pcm_simd_convert converts[] = {
+    { VLC_CODEC_U8,   VLC_CODEC_S16N, C(U8toS16)       },
+    { VLC_CODEC_U8,   VLC_CODEC_FL32, C(U8toFl32)      },
+    { VLC_CODEC_U8,   VLC_CODEC_S32N, C(U8toS32)       },
+    { VLC_CODEC_U8,   VLC_CODEC_FL64, C(U8toFl64)      },
+
+    { VLC_CODEC_S16N, VLC_CODEC_U8,   C(S16toU8)       },
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, SIMD(S16toFl32)  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, SIMD(S16toS32)   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL64, C(S16toFl64)     },
+
+    { VLC_CODEC_FL32, VLC_CODEC_U8,   C(Fl32toU8)      },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, SIMD(Fl32toS16)  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, SIMD(Fl32toS32)  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, SIMD(Fl32toFl64) },
+
+    { VLC_CODEC_S32N, VLC_CODEC_U8,   C(S32toU8)       },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, SIMD(S32toS16)   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, SIMD(S32toFl32)  },
+    { VLC_CODEC_S32N, VLC_CODEC_FL64, C(S32toFl64)     },
+
+    { VLC_CODEC_FL64, VLC_CODEC_U8,   C(Fl64toU8)      },
+    { VLC_CODEC_FL64, VLC_CODEC_S16N, C(Fl64toS16)     },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, SIMD(Fl64toFl32) },
+    { VLC_CODEC_FL64, VLC_CODEC_S32N, C(Fl64toS32)     },
+};
+
+static const struct
+{
+    vlc_fourcc_t format;
+    pcm_simd_amplify_t amplify[PCM_SIMD_ISA_COUNT];
+} amplifies[] = {
+    { VLC_CODEC_U8,   C(AmplifyU8)      },
+    { VLC_CODEC_S16N, SIMD(AmplifyS16)  },
+    { VLC_CODEC_S32N, C(AmplifyS32)     },
+    { VLC_CODEC_FL32, SIMD(AmplifyFl32) },
+    { VLC_CODEC_FL64, SIMD(AmplifyFl64) },
+};
+
+static bool IsAvailable(enum pcm_simd_isa isa)
+{
+    switch (isa)
+    {
+        case PCM_SIMD_ISA_C:
+            return true;
+#ifdef PCM_SIMD_SSE2
+        case PCM_SIMD_ISA_SSE2:
+            return vlc_CPU_SSE2();
+#endif
+#ifdef PCM_SIMD_AVX2
+        case PCM_SIMD_ISA_AVX2:
+            return vlc_CPU_AVX2();
+#endif
+#ifdef PCM_SIMD_NEON
+        case PCM_SIMD_ISA_NEON:
+            return vlc_CPU_ARM64_NEON();
+#endif
+        default:
+            return false;
+    }
+}
+
+enum pcm_simd_isa pcm_simd_GetISA(void)
+{
+    if (IsAvailable(PCM_SIMD_ISA_AVX2))
+        return PCM_SIMD_ISA_AVX2;
+    if (IsAvailable(PCM_SIMD_ISA_SSE2))
+        return PCM_SIMD_ISA_SSE2;
+    if (IsAvailable(PCM_SIMD_ISA_NEON))
+        return PCM_SIMD_ISA_NEON;
+    return PCM_SIMD_ISA_C;
+}
+
+pcm_simd_convert_t pcm_simd_GetConvert(vlc_fourcc_t src, vlc_fourcc_t dst,
+                                       enum pcm_simd_isa isa)
+{
+    if (!IsAvailable(isa))
+        return NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(converts); i++)
+        if (converts[i].src == src && converts[i].dst == dst)
+            return converts[i].convert[isa] != NULL
+                 ? converts[i].convert[isa]
+                 : converts[i].convert[PCM_SIMD_ISA_C];
+    return NULL;
+}
+
+pcm_simd_amplify_t pcm_simd_GetAmplify(vlc_fourcc_t format,
+                                       enum pcm_simd_isa isa)
+{
+    if (!IsAvailable(isa))
+        return NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(amplifies); i++)
+        if (amplifies[i].format == format)
+            return amplifies[i].amplify[isa] != NULL
+                 ? amplifies[i].amplify[isa]
+                 : amplifies[i].amplify[PCM_SIMD_ISA_C];
+    return NULL;
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * pcm_simd.h : PCM sample format conversion and volume kernels
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_PCM_SIMD_H_
+#define VLC_AUDIO_PCM_SIMD_H_
+
+#include <vlc_aout_volume.h>
+
+enum pcm_simd_isa
+{
+    PCM_SIMD_ISA_C,    /* reference, also used for the end of buffers */
+    PCM_SIMD_ISA_SSE2,
+    PCM_SIMD_ISA_AVX2,
+    PCM_SIMD_ISA_NEON,
+    PCM_SIMD_ISA_COUNT
+};
+
+/* Converts samples from U8, S16N, S32N, FL32 or FL64 to another of these
+ * formats. dst may be equal to src if the output samples are not larger than
+ * the input ones. */
+typedef void (*pcm_simd_convert_t)(void *dst, const void *src, size_t samples);
+
+/* Same as audio_volume_t.amplify, for U8, S16N, S32N, FL32 or FL64 */
+typedef void (*pcm_simd_amplify_t)(audio_volume_t *, block_t *, float);
+
+/* Returns the best instruction set available on this CPU */
+enum pcm_simd_isa pcm_simd_GetISA(void);
+
+/* Return NULL if the instruction set is not available on this CPU or was not
+ * compiled in, or if the format is not handled. Otherwise, the C reference is
+ * returned for the formats without a vector implementation. */
+pcm_simd_convert_t pcm_simd_GetConvert(vlc_fourcc_t src, vlc_fourcc_t dst,
+                                       enum pcm_simd_isa);
+pcm_simd_amplify_t pcm_simd_GetAmplify(vlc_fourcc_t, enum pcm_simd_isa);
+
+#endif
@@ -0,0 +1,218 @@
+/*****************************************************************************
+ * pcm_simd_bench.c : benchmark of the PCM conversion kernels
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Prints the throughput of every format pair and of the software volume for
+ * each instruction set. pcm_simd_test.c checks their output.
+ *
+ * Usage: audio_pcm_simd_bench [samples] (default 1048576)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_aout.h>
+#include <vlc_bench.h>
+
+#include "pcm_simd.h"
+
+static const vlc_fourcc_t formats[] = {
+    VLC_CODEC_U8, VLC_CODEC_S16N, VLC_CODEC_S32N, VLC_CODEC_FL32,
+    VLC_CODEC_FL64,
+};
+
+static const char *const isa_names[PCM_SIMD_ISA_COUNT] = {
+    "C", "SSE2", "AVX2", "NEON",
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+/* Fills the buffer with random samples, some of them out of range or on the
+ * rounding and clipping edges of the other formats */
+static void Fill(void *buf, vlc_fourcc_t format, size_t n)
+{
+    unsigned seed = 1;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned r = rnd(&seed);
+        double v = (double)(r & 0x7fff) / 0x4000 - 1.; /* [-1, 1) */
+
+        switch (rnd(&seed) % 8)
+        {
+            case 0: v *= 1.25; break;                          /* clipping */
+            case 1: v = ((int)(v * 32768.) + .5) / 32768.; break;  /* S16 tie */
+            case 2: v = ((int)(v * 256.) + .5) / 2147483648.; break; /* S32 tie */
+            case 3: v = (r & 1) ? 1. : -1.; break;
+        }
+
+        switch (format)
+        {
+            case VLC_CODEC_U8:
+                ((uint8_t *)buf)[i] = r;
+                break;
+            case VLC_CODEC_S16N:
+                ((int16_t *)buf)[i] = r;
+                break;
+            case VLC_CODEC_S32N:
+                ((int32_t *)buf)[i] = (r << 16) ^ rnd(&seed);
+                break;
+            case VLC_CODEC_FL32:
+                ((float *)buf)[i] = v;
+                break;
+            case VLC_CODEC_FL64:
+                ((double *)buf)[i] = v;
+                break;
+        }
+    }
+}
+
+struct bench_convert
+{
+    pcm_simd_convert_t convert;
+    void *dst;
+    const void *src;
+    size_t n;
+};
+
+static void BenchConvertRun(void *opaque)
+{
+    struct bench_convert *b = opaque;
+
+    b->convert(b->dst, b->src, b->n);
+}
+
+static double BenchConvert(pcm_simd_convert_t convert, void *dst,
+                           const void *src, size_t n)
+{
+    struct bench_convert b = { convert, dst, src, n };
+
+    return (double)n * vlc_bench_Run(BenchConvertRun, &b, CLOCK_FREQ / 10);
+}
+
+struct bench_amplify
+{
+    pcm_simd_amplify_t amplify;
+    block_t *block;
+    unsigned count;
+};
+
+static void BenchAmplifyRun(void *opaque)
+{
+    struct bench_amplify *b = opaque;
+
+    /* alternate so that the samples stay in range */
+    b->amplify(NULL, b->block, (b->count++ & 1) ? 2.f : .5f);
+}
+
+static double BenchAmplify(pcm_simd_amplify_t amplify, block_t *block,
+                           size_t n)
+{
+    struct bench_amplify b = { amplify, block, 0 };
+
+    return (double)n * vlc_bench_Run(BenchAmplifyRun, &b, CLOCK_FREQ / 10);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = 1 << 20;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 0);
+    if (n == 0)
+        return 1;
+
+    void *src = malloc(n * sizeof (double));
+    void *dst = malloc(n * sizeof (double));
+    if (src == NULL || dst == NULL)
+        return 1;
+
+    printf("%zu samples, Msamples/s for", n);
+    for (int isa = 0; isa < PCM_SIMD_ISA_COUNT; isa++)
+        if (pcm_simd_GetConvert(VLC_CODEC_S16N, VLC_CODEC_FL32, isa) != NULL)
+            printf(" %s", isa_names[isa]);
+    printf("\n");
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(formats); j++)
+        {
+            if (i == j)
+                continue;
+
+            const vlc_fourcc_t sf = formats[i], df = formats[j];
+            pcm_simd_convert_t ref = pcm_simd_GetConvert(sf, df,
+                                                         PCM_SIMD_ISA_C);
+            if (ref == NULL)
+                continue;
+
+            Fill(src, sf, n);
+            printf("%4.4s->%4.4s:", (const char *)&sf, (const char *)&df);
+            printf(" %8.1f", BenchConvert(ref, dst, src, n));
+
+            for (int isa = PCM_SIMD_ISA_C + 1; isa < PCM_SIMD_ISA_COUNT; isa++)
+            {
+                pcm_simd_convert_t simd = pcm_simd_GetConvert(sf, df, isa);
+                if (simd == NULL || simd == ref)
+                    continue;
+                printf(" %8.1f (%s)", BenchConvert(simd, dst, src, n),
+                       isa_names[isa]);
+            }
+            printf("\n");
+        }
+
+    block_t *block = block_Alloc(n * sizeof (double));
+    if (block == NULL)
+        return 1;
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        const vlc_fourcc_t format = formats[i];
+        pcm_simd_amplify_t ref = pcm_simd_GetAmplify(format, PCM_SIMD_ISA_C);
+
+        block->i_buffer = n * aout_BitsPerSample(format) / 8;
+        Fill(block->p_buffer, format, n);
+        printf("%4.4s volume:", (const char *)&format);
+        printf(" %8.1f", BenchAmplify(ref, block, n));
+
+        for (int isa = PCM_SIMD_ISA_C + 1; isa < PCM_SIMD_ISA_COUNT; isa++)
+        {
+            pcm_simd_amplify_t simd = pcm_simd_GetAmplify(format, isa);
+            if (simd == NULL || simd == ref)
+                continue;
+            printf(" %8.1f (%s)", BenchAmplify(simd, block, n),
+                   isa_names[isa]);
+        }
+        printf("\n");
+    }
+
+    block_Release(block);
+    free(src);
+    free(dst);
+    return 0;
+}
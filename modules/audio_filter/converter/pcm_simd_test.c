@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * pcm_simd_test.c : check of the PCM conversion kernels
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the vector conversion and volume kernels of this CPU give the
+ * same output as the C reference, out of place and in place, on random and
+ * edge samples (with a count that is not a multiple of the vector size).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_aout.h>
+
+#include "pcm_simd.h"
+
+static const vlc_fourcc_t formats[] = {
+    VLC_CODEC_U8, VLC_CODEC_S16N, VLC_CODEC_S32N, VLC_CODEC_FL32,
+    VLC_CODEC_FL64,
+};
+
+static const char *const isa_names[PCM_SIMD_ISA_COUNT] = {
+    "C", "SSE2", "AVX2", "NEON",
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+/* Fills the buffer with random samples, some of them out of range or on the
+ * rounding and clipping edges of the other formats */
+static void Fill(void *buf, vlc_fourcc_t format, size_t n)
+{
+    unsigned seed = 1;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned r = rnd(&seed);
+        double v = (double)(r & 0x7fff) / 0x4000 - 1.; /* [-1, 1) */
+
+        switch (rnd(&seed) % 8)
+        {
+            case 0: v *= 1.25; break;                          /* clipping */
+            case 1: v = ((int)(v * 32768.) + .5) / 32768.; break;  /* S16 tie */
+            case 2: v = ((int)(v * 256.) + .5) / 2147483648.; break; /* S32 tie */
+            case 3: v = (r & 1) ? 1. : -1.; break;
+        }
+
+        switch (format)
+        {
+            case VLC_CODEC_U8:
+                ((uint8_t *)buf)[i] = r;
+                break;
+            case VLC_CODEC_S16N:
+                ((int16_t *)buf)[i] = r;
+                break;
+            case VLC_CODEC_S32N:
+                ((int32_t *)buf)[i] = (r << 16) ^ rnd(&seed);
+                break;
+            case VLC_CODEC_FL32:
+                ((float *)buf)[i] = v;
+                break;
+            case VLC_CODEC_FL64:
+                ((double *)buf)[i] = v;
+                break;
+        }
+    }
+}
+
+static void test_convert(vlc_fourcc_t src_fmt, vlc_fourcc_t dst_fmt,
+                         pcm_simd_convert_t ref, pcm_simd_convert_t simd,
+                         const char *isa)
+{
+    const size_t n = 4099;
+    const size_t src_size = aout_BitsPerSample(src_fmt) / 8;
+    const size_t dst_size = aout_BitsPerSample(dst_fmt) / 8;
+    uint8_t *src = malloc(n * src_size);
+    uint8_t *a = malloc(n * __MAX(src_size, dst_size));
+    uint8_t *b = malloc(n * __MAX(src_size, dst_size));
+
+    assert(src != NULL && a != NULL && b != NULL);
+    printf("%4.4s->%4.4s (%s)\n", (const char *)&src_fmt,
+           (const char *)&dst_fmt, isa);
+
+    Fill(src, src_fmt, n);
+    ref(a, src, n);
+    simd(b, src, n);
+    assert(memcmp(a, b, n * dst_size) == 0);
+
+    /* The filter converts in place when the samples do not grow */
+    if (dst_size <= src_size)
+    {
+        memcpy(b, src, n * src_size);
+        simd(b, b, n);
+        assert(memcmp(a, b, n * dst_size) == 0);
+    }
+
+    free(src);
+    free(a);
+    free(b);
+}
+
+static void test_amplify(vlc_fourcc_t format, pcm_simd_amplify_t ref,
+                         pcm_simd_amplify_t simd, const char *isa)
+{
+    static const float volumes[] = { 0.f, .3f, .5f, 1.f, 1.7f, 4.f, 200.f };
+    const size_t n = 4099;
+    const size_t size = aout_BitsPerSample(format) / 8;
+    block_t *a = block_Alloc(n * size);
+    block_t *b = block_Alloc(n * size);
+
+    assert(a != NULL && b != NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(volumes); i++)
+    {
+        printf("%4.4s volume %.1f (%s)\n", (const char *)&format, volumes[i],
+               isa);
+        Fill(a->p_buffer, format, n);
+        memcpy(b->p_buffer, a->p_buffer, n * size);
+        ref(NULL, a, volumes[i]);
+        simd(NULL, b, volumes[i]);
+        assert(memcmp(a->p_buffer, b->p_buffer, n * size) == 0);
+    }
+
+    block_Release(a);
+    block_Release(b);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(formats); j++)
+        {
+            if (i == j)
+                continue;
+
+            const vlc_fourcc_t sf = formats[i], df = formats[j];
+            pcm_simd_convert_t ref = pcm_simd_GetConvert(sf, df,
+                                                         PCM_SIMD_ISA_C);
+            assert(ref != NULL);
+
+            for (int isa = PCM_SIMD_ISA_C + 1; isa < PCM_SIMD_ISA_COUNT; isa++)
+            {
+                pcm_simd_convert_t simd = pcm_simd_GetConvert(sf, df, isa);
+                if (simd != NULL && simd != ref)
+                    test_convert(sf, df, ref, simd, isa_names[isa]);
+            }
+        }
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        const vlc_fourcc_t format = formats[i];
+        pcm_simd_amplify_t ref = pcm_simd_GetAmplify(format, PCM_SIMD_ISA_C);
+
+        for (int isa = PCM_SIMD_ISA_C + 1; isa < PCM_SIMD_ISA_COUNT; isa++)
+        {
+            pcm_simd_amplify_t simd = pcm_simd_GetAmplify(format, isa);
+            if (simd != NULL && simd != ref)
+                test_amplify(format, ref, simd, isa_names[isa]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,619 @@
+/*****************************************************************************
+ * convolver.c : uniformly partitioned FFT convolution
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The impulse responses are cut in partitions of B frames. Every B input
+ * frames, the last 2B frames of each input are transformed (overlap-save),
+ * and the spectrum is pushed in a frequency domain delay line. The spectrum
+ * of each output is then the sum of the products of the delay line with the
+ * partitions of the responses, so that a block costs one forward transform
+ * per input, one inverse transform per output and B complex multiplications
+ * per non-silent partition, whatever the length of the responses.
+ *
+ * The spectra are stored as split real and imaginary parts of B bins, with
+ * the real Nyquist bin in the imaginary part of the (real) DC bin.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include "convolver.h"
+
+struct convolver_t
+{
+    unsigned i_block;   /* B, frames per partition and FFT bins */
+    unsigned i_inputs;
+    unsigned i_outputs;
+    unsigned i_parts;   /* partitions of the longest response */
+    unsigned i_pos;     /* frames of the current block */
+    unsigned i_head;    /* delay line slot of the last input spectrum */
+
+    float *p_twiddle;   /* e^(-2i.pi.k/B), k < B/2 */
+    float *p_post;      /* e^(-i.pi.k/B), k < B */
+    unsigned *p_bitrev;
+    float *p_work;      /* B complex values */
+    float *p_scratch;   /* 2B real samples */
+    float *p_acc;       /* output spectrum */
+
+    float *p_in;        /* last 2B frames of each input */
+    float *p_out;       /* B frames of each output */
+    float *p_fdl;       /* input spectra, i_parts per input */
+    float *p_resp;      /* response spectra, i_parts per input and output */
+    bool *p_used;       /* whether a response partition is not silent */
+};
+
+/*****************************************************************************
+ * Fast Fourier transforms
+ *****************************************************************************/
+
+/* In place complex transform of B points (the inverse is not scaled) */
+static void FFT(const convolver_t *p_conv, float *z, bool b_inverse)
+{
+    const unsigned n = p_conv->i_block;
+    const float sign = b_inverse ? -1.f : 1.f;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned j = p_conv->p_bitrev[i];
+        if (i < j)
+        {
+            float t;
+            t = z[2 * i]; z[2 * i] = z[2 * j]; z[2 * j] = t;
+            t = z[2 * i + 1]; z[2 * i + 1] = z[2 * j + 1]; z[2 * j + 1] = t;
+        }
+    }
+
+    for (unsigned len = 2; len <= n; len <<= 1)
+    {
+        const unsigned half = len / 2, step = n / len;
+
+        for (unsigned i = 0; i < n; i += len)
+            for (unsigned j = 0; j < half; j++)
+            {
+                const float wr = p_conv->p_twiddle[2 * j * step];
+                const float wi = sign * p_conv->p_twiddle[2 * j * step + 1];
+                float *u = z + 2 * (i + j), *v = u + 2 * half;
+                const float vr = v[0] * wr - v[1] * wi;
+                const float vi = v[0] * wi + v[1] * wr;
+
+                v[0] = u[0] - vr; v[1] = u[1] - vi;
+                u[0] += vr;       u[1] += vi;
+            }
+    }
+}
+
+/* Transforms 2B real samples into B packed bins, scaled by 2 */
+static void ForwardReal(const convolver_t *p_conv, const float *x,
+                        float *re, float *im)
+{
+    const unsigned n = p_conv->i_block;
+    float *z = p_conv->p_work;
+
+    /* The even and odd samples are the real and imaginary parts */
+    memcpy(z, x, 2 * n * sizeof (float));
+    FFT(p_conv, z, false);
+
+    re[0] = 2.f * (z[0] + z[1]);
+    im[0] = 2.f * (z[0] - z[1]);
+
+    for (unsigned k = 1; k < n; k++)
+    {
+        const float ar = z[2 * k], ai = z[2 * k + 1];
+        const float br = z[2 * (n - k)], bi = -z[2 * (n - k) + 1];
+        const float dr = ar - br, di = ai - bi;
+        const float c = p_conv->p_post[2 * k], s = p_conv->p_post[2 * k + 1];
+
+        re[k] = ar + br + c * di + s * dr;
+        im[k] = ai + bi + s * di - c * dr;
+    }
+}
+
+/* Transforms B packed bins back into 2B real samples, scaled by 2B */
+static void InverseReal(const convolver_t *p_conv, const float *re,
+                        const float *im, float *x)
+{
+    const unsigned n = p_conv->i_block;
+    float *z = p_conv->p_work;
+
+    z[0] = re[0] + im[0];
+    z[1] = re[0] - im[0];
+
+    for (unsigned k = 1; k < n; k++)
+    {
+        const float ar = re[k], ai = im[k];
+        const float br = re[n - k], bi = -im[n - k];
+        const float dr = ar - br, di = ai - bi;
+        const float c = p_conv->p_post[2 * k], s = -p_conv->p_post[2 * k + 1];
+        /* (a + b) + i.(a - b).conj(W^k) */
+        const float or_ = dr * c - di * s, oi = dr * s + di * c;
+
+        z[2 * k] = ar + br - oi;
+        z[2 * k + 1] = ai + bi + or_;
+    }
+
+    FFT(p_conv, z, true);
+    memcpy(x, z, 2 * n * sizeof (float));
+}
+
+/* acc += x.h, on packed spectra */
+static void MultiplyAdd(float *restrict acc_re, float *restrict acc_im,
+                        const float *restrict x_re, const float *restrict x_im,
+                        const float *restrict h_re, const float *restrict h_im,
+                        unsigned n)
+{
+    const float dc = acc_re[0] + x_re[0] * h_re[0];
+    const float nyquist = acc_im[0] + x_im[0] * h_im[0];
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        acc_re[k] += x_re[k] * h_re[k] - x_im[k] * h_im[k];
+        acc_im[k] += x_re[k] * h_im[k] + x_im[k] * h_re[k];
+    }
+    acc_re[0] = dc;
+    acc_im[0] = nyquist;
+}
+
+/*****************************************************************************
+ * Convolver
+ *****************************************************************************/
+
+convolver_t *convolver_New(unsigned i_block, unsigned i_inputs,
+                           unsigned i_outputs, size_t i_max_frames)
+{
+    if (i_block == 0)
+    {
+        i_block = 256;
+        while (i_block < 2048 && i_max_frames > 64 * i_block)
+            i_block *= 2;
+    }
+
+    if (i_block < 4 || (i_block & (i_block - 1)) || i_inputs == 0
+     || i_outputs == 0 || i_max_frames == 0
+     || i_max_frames > CONVOLVER_MAX_FRAMES)
+        return NULL;
+
+    convolver_t *p_conv = calloc(1, sizeof (*p_conv));
+    if (unlikely(p_conv == NULL))
+        return NULL;
+
+    const unsigned n = i_block;
+    const unsigned parts = (i_max_frames + n - 1) / n;
+    const size_t spectrum = 2 * n;
+
+    p_conv->i_block = n;
+    p_conv->i_inputs = i_inputs;
+    p_conv->i_outputs = i_outputs;
+    p_conv->i_parts = parts;
+
+    p_conv->p_twiddle = vlc_alloc(n, sizeof (float));
+    p_conv->p_post = vlc_alloc(2 * n, sizeof (float));
+    p_conv->p_bitrev = vlc_alloc(n, sizeof (unsigned));
+    p_conv->p_work = vlc_alloc(2 * n, sizeof (float));
+    p_conv->p_scratch = vlc_alloc(2 * n, sizeof (float));
+    p_conv->p_acc = vlc_alloc(spectrum, sizeof (float));
+    p_conv->p_in = calloc(i_inputs * 2 * n, sizeof (float));
+    p_conv->p_out = calloc(i_outputs * n, sizeof (float));
+    p_conv->p_fdl = calloc(i_inputs * parts * spectrum, sizeof (float));
+    p_conv->p_resp = vlc_alloc(i_inputs * i_outputs * parts * spectrum,
+                               sizeof (float));
+    p_conv->p_used = calloc(i_inputs * i_outputs * parts, sizeof (bool));
+
+    if (unlikely(p_conv->p_twiddle == NULL || p_conv->p_post == NULL
+              || p_conv->p_bitrev == NULL || p_conv->p_work == NULL
+              || p_conv->p_scratch == NULL || p_conv->p_acc == NULL
+              || p_conv->p_in == NULL || p_conv->p_out == NULL
+              || p_conv->p_fdl == NULL || p_conv->p_resp == NULL
+              || p_conv->p_used == NULL))
+    {
+        convolver_Delete(p_conv);
+        return NULL;
+    }
+
+    for (unsigned k = 0; k < n / 2; k++)
+    {
+        p_conv->p_twiddle[2 * k] = cos(2. * M_PI * k / n);
+        p_conv->p_twiddle[2 * k + 1] = -sin(2. * M_PI * k / n);
+    }
+    for (unsigned k = 0; k < n; k++)
+    {
+        p_conv->p_post[2 * k] = cos(M_PI * k / n);
+        p_conv->p_post[2 * k + 1] = -sin(M_PI * k / n);
+    }
+
+    unsigned bits = 0;
+    while ((1u << bits) < n)
+        bits++;
+    for (unsigned i = 0; i < n; i++)
+    {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; b++)
+            if (i & (1u << b))
+                r |= 1u << (bits - 1 - b);
+        p_conv->p_bitrev[i] = r;
+    }
+
+    return p_conv;
+}
+
+void convolver_Delete(convolver_t *p_conv)
+{
+    free(p_conv->p_twiddle);
+    free(p_conv->p_post);
+    free(p_conv->p_bitrev);
+    free(p_conv->p_work);
+    free(p_conv->p_scratch);
+    free(p_conv->p_acc);
+    free(p_conv->p_in);
+    free(p_conv->p_out);
+    free(p_conv->p_fdl);
+    free(p_conv->p_resp);
+    free(p_conv->p_used);
+    free(p_conv);
+}
+
+int convolver_SetResponse(convolver_t *p_conv, unsigned i_input,
+                          unsigned i_output, const float *p_ir,
+                          size_t i_frames, size_t i_stride)
+{
+    const unsigned n = p_conv->i_block;
+    const unsigned pair = i_input * p_conv->i_outputs + i_output;
+    /* Undo the scaling of the transforms (2 and 2 forward, 2B inverse) */
+    const float scale = 1.f / (8 * n);
+
+    if (i_input >= p_conv->i_inputs || i_output >= p_conv->i_outputs)
+        return VLC_EGENERIC;
+    if (i_frames > (size_t)p_conv->i_parts * n)
+        return VLC_EGENERIC;
+
+    for (unsigned p = 0; p < p_conv->i_parts; p++)
+    {
+        float *p_re = p_conv->p_resp + ((size_t)pair * p_conv->i_parts + p)
+                                       * 2 * n;
+        float *p_im = p_re + n;
+        bool *pb_used = &p_conv->p_used[pair * p_conv->i_parts + p];
+        float *x = p_conv->p_scratch;
+
+        *pb_used = false;
+        for (unsigned i = 0; i < n; i++)
+        {
+            const size_t frame = (size_t)p * n + i;
+
+            x[i] = frame < i_frames ? p_ir[frame * i_stride] : 0.f;
+            if (x[i] != 0.f)
+                *pb_used = true;
+        }
+        if (!*pb_used)
+            continue;
+        memset(x + n, 0, n * sizeof (float));
+
+        ForwardReal(p_conv, x, p_re, p_im);
+        for (unsigned k = 0; k < 2 * n; k++)
+            p_re[k] *= scale;
+    }
+    return VLC_SUCCESS;
+}
+
+static void ProcessBlock(convolver_t *p_conv)
+{
+    const unsigned n = p_conv->i_block;
+    const unsigned parts = p_conv->i_parts;
+
+    p_conv->i_head = (p_conv->i_head + 1) % parts;
+
+    for (unsigned c = 0; c < p_conv->i_inputs; c++)
+    {
+        float *p_in = p_conv->p_in + c * 2 * n;
+        float *p_re = p_conv->p_fdl + ((size_t)c * parts + p_conv->i_head)
+                                      * 2 * n;
+
+        ForwardReal(p_conv, p_in, p_re, p_re + n);
+        memcpy(p_in, p_in + n, n * sizeof (float));
+    }
+
+    for (unsigned o = 0; o < p_conv->i_outputs; o++)
+    {
+        float *p_out = p_conv->p_out + o * n;
+        float *acc = p_conv->p_acc;
+        bool b_silent = true;
+
+        memset(acc, 0, 2 * n * sizeof (float));
+        for (unsigned c = 0; c < p_conv->i_inputs; c++)
+        {
+            const unsigned pair = c * p_conv->i_outputs + o;
+            const float *p_fdl = p_conv->p_fdl + (size_t)c * parts * 2 * n;
+            const float *p_resp = p_conv->p_resp
+                                + (size_t)pair * parts * 2 * n;
+
+            for (unsigned p = 0; p < parts; p++)
+            {
+                if (!p_conv->p_used[pair * parts + p])
+                    continue;
+
+                const unsigned slot = (p_conv->i_head + parts - p) % parts;
+                const float *x = p_fdl + (size_t)slot * 2 * n;
+                const float *h = p_resp + (size_t)p * 2 * n;
+
+                MultiplyAdd(acc, acc + n, x, x + n, h, h + n, n);
+                b_silent = false;
+            }
+        }
+
+        if (b_silent)
+        {
+            memset(p_out, 0, n * sizeof (float));
+            continue;
+        }
+        /* Only the second half is free of circular aliasing */
+        InverseReal(p_conv, acc, acc + n, p_conv->p_scratch);
+        memcpy(p_out, p_conv->p_scratch + n, n * sizeof (float));
+    }
+}
+
+void convolver_Process(convolver_t *p_conv, const float *p_in, float *p_out,
+                       size_t i_frames)
+{
+    const unsigned n = p_conv->i_block;
+    const unsigned i_inputs = p_conv->i_inputs;
+    const unsigned i_outputs = p_conv->i_outputs;
+
+    while (i_frames > 0)
+    {
+        const unsigned pos = p_conv->i_pos;
+        const unsigned count = __MIN(i_frames, n - pos);
+
+        for (unsigned c = 0; c < i_inputs; c++)
+        {
+            float *p_dst = p_conv->p_in + c * 2 * n + n + pos;
+            for (unsigned i = 0; i < count; i++)
+                p_dst[i] = p_in[i * i_inputs + c];
+        }
+        for (unsigned o = 0; o < i_outputs; o++)
+        {
+            const float *p_src = p_conv->p_out + o * n + pos;
+            for (unsigned i = 0; i < count; i++)
+                p_out[i * i_outputs + o] = p_src[i];
+        }
+
+        p_in += count * i_inputs;
+        p_out += count * i_outputs;
+        i_frames -= count;
+        p_conv->i_pos += count;
+
+        if (p_conv->i_pos == n)
+        {
+            ProcessBlock(p_conv);
+            p_conv->i_pos = 0;
+        }
+    }
+}
+
+void convolver_Reset(convolver_t *p_conv)
+{
+    const unsigned n = p_conv->i_block;
+
+    memset(p_conv->p_in, 0, p_conv->i_inputs * 2 * n * sizeof (float));
+    memset(p_conv->p_out, 0, p_conv->i_outputs * n * sizeof (float));
+    memset(p_conv->p_fdl, 0,
+           (size_t)p_conv->i_inputs * p_conv->i_parts * 2 * n * sizeof (float));
+    p_conv->i_pos = 0;
+    p_conv->i_head = 0;
+}
+
+unsigned convolver_GetLatency(const convolver_t *p_conv)
+{
+    return p_conv->i_block;
+}
+
+/*****************************************************************************
+ * Impulse response files
+ *****************************************************************************/
+
+/* Band limited interpolation of the responses, only done once at load */
+static float *Resample(const float *p_in, size_t i_in, unsigned i_channels,
+                       unsigned i_in_rate, unsigned i_out_rate,
+                       size_t *pi_out)
+{
+    const double ratio = (double)i_in_rate / i_out_rate;
+    const double cutoff = ratio > 1. ? 1. / ratio : 1.;
+    const double half = 16. / cutoff; /* window half width, in input frames */
+    size_t i_out = ((uint64_t)i_in * i_out_rate + i_in_rate - 1) / i_in_rate;
+
+    if (i_out > CONVOLVER_MAX_FRAMES)
+        i_out = CONVOLVER_MAX_FRAMES;
+
+    float *p_out = vlc_alloc(i_out * i_channels, sizeof (float));
+    if (unlikely(p_out == NULL))
+        return NULL;
+
+    for (size_t i = 0; i < i_out; i++)
+    {
+        const double t = i * ratio;
+        const ssize_t first = ceil(t - half), last = floor(t + half);
+
+        for (unsigned c = 0; c < i_channels; c++)
+        {
+            double sum = 0.;
+
+            for (ssize_t k = __MAX(first, 0);
+                 k <= last && (size_t)k < i_in; k++)
+            {
+                const double x = t - k;
+                const double sinc = x != 0.
+                    ? sin(M_PI * cutoff * x) / (M_PI * x) : cutoff;
+                const double window = .5 + .5 * cos(M_PI * x / half);
+
+                sum += p_in[k * i_channels + c] * sinc * window;
+            }
+            /* keep the gain: there are 1/ratio output taps per input one */
+            p_out[i * i_channels + c] = sum * ratio;
+        }
+    }
+    *pi_out = i_out;
+    return p_out;
+}
+
+float *convolver_LoadWav(vlc_object_t *p_obj, const char *psz_path,
+                         unsigned i_rate, unsigned *pi_channels,
+                         size_t *pi_frames)
+{
+    FILE *p_file = vlc_fopen(psz_path, "rb");
+    if (p_file == NULL)
+    {
+        msg_Err(p_obj, "cannot open impulse response %s: %s", psz_path,
+                vlc_strerror_c(errno));
+        return NULL;
+    }
+
+    uint8_t hdr[40];
+    unsigned i_channels = 0, i_file_rate = 0, i_bits = 0;
+    bool b_float = false;
+    float *p_samples = NULL;
+    size_t i_frames = 0;
+
+    if (fread(hdr, 1, 12, p_file) != 12 || memcmp(hdr, "RIFF", 4)
+     || memcmp(hdr + 8, "WAVE", 4))
+        goto error;
+
+    for (;;)
+    {
+        if (fread(hdr, 1, 8, p_file) != 8)
+            goto error;
+
+        const uint32_t i_size = GetDWLE(hdr + 4);
+
+        if (!memcmp(hdr, "fmt ", 4))
+        {
+            if (i_size < 16 || i_size > sizeof (hdr)
+             || fread(hdr, 1, i_size, p_file) != i_size)
+                goto error;
+
+            uint16_t i_tag = GetWLE(hdr);
+            i_channels = GetWLE(hdr + 2);
+            i_file_rate = GetDWLE(hdr + 4);
+            i_bits = GetWLE(hdr + 14);
+            if (i_tag == 0xFFFE /* WAVE_FORMAT_EXTENSIBLE */ && i_size >= 26)
+                i_tag = GetWLE(hdr + 24); /* first bytes of the sub-format */
+            if (i_tag != 1 /* PCM */ && i_tag != 3 /* IEEE float */)
+                goto error;
+            b_float = i_tag == 3;
+            if ((i_size & 1) && fseek(p_file, 1, SEEK_CUR))
+                goto error;
+        }
+        else if (!memcmp(hdr, "data", 4))
+        {
+            if (i_channels == 0 || i_channels > 64 || i_file_rate == 0
+             || (b_float ? i_bits != 32 && i_bits != 64
+                         : i_bits != 16 && i_bits != 24 && i_bits != 32))
+                goto error;
+
+            const unsigned i_bytes = i_bits / 8;
+            i_frames = i_size / (i_bytes * i_channels);
+            /* Do not read more than needed after resampling */
+            const size_t i_max = (uint64_t)CONVOLVER_MAX_FRAMES
+                               * i_file_rate / i_rate + 1;
+            if (i_frames > i_max)
+            {
+                msg_Warn(p_obj, "impulse response truncated to %zu frames",
+                         i_max);
+                i_frames = i_max;
+            }
+            if (i_frames == 0)
+                goto error;
+
+            uint8_t *p_raw = vlc_alloc(i_frames * i_channels, i_bytes);
+            p_samples = vlc_alloc(i_frames * i_channels, sizeof (float));
+            if (p_raw == NULL || p_samples == NULL
+             || fread(p_raw, i_bytes * i_channels, i_frames, p_file)
+                    != i_frames)
+            {
+                free(p_raw);
+                goto error;
+            }
+
+            for (size_t i = 0; i < i_frames * i_channels; i++)
+            {
+                const uint8_t *p = p_raw + i * i_bytes;
+                float v;
+
+                if (b_float && i_bytes == 4)
+                {
+                    union { uint32_t u; float f; } u = { .u = GetDWLE(p) };
+                    v = u.f;
+                }
+                else if (b_float)
+                {
+                    union { uint64_t u; double d; } u = { .u = GetQWLE(p) };
+                    v = u.d;
+                }
+                else if (i_bytes == 2)
+                    v = (int16_t)GetWLE(p) / 32768.f;
+                else if (i_bytes == 3)
+                    v = (int32_t)((uint32_t)GetWLE(p) << 8
+                                | (uint32_t)p[2] << 24) / 2147483648.f;
+                else
+                    v = (int32_t)GetDWLE(p) / 2147483648.f;
+                p_samples[i] = v;
+            }
+            free(p_raw);
+            break;
+        }
+        else if (fseek(p_file, i_size + (i_size & 1), SEEK_CUR))
+            goto error;
+    }
+    fclose(p_file);
+
+    if (i_file_rate != i_rate)
+    {
+        size_t i_out;
+        float *p_out = Resample(p_samples, i_frames, i_channels, i_file_rate,
+                                i_rate, &i_out);
+        free(p_samples);
+        if (p_out == NULL)
+            return NULL;
+        msg_Dbg(p_obj, "impulse response resampled from %u to %u Hz",
+                i_file_rate, i_rate);
+        p_samples = p_out;
+        i_frames = i_out;
+    }
+    else if (i_frames > CONVOLVER_MAX_FRAMES)
+        i_frames = CONVOLVER_MAX_FRAMES;
+
+    msg_Dbg(p_obj, "loaded impulse response %s: %u channels, %zu frames",
+            psz_path, i_channels, i_frames);
+    *pi_channels = i_channels;
+    *pi_frames = i_frames;
+    return p_samples;
+
+error:
+    msg_Err(p_obj, "unsupported impulse response file %s", psz_path);
+    free(p_samples);
+    fclose(p_file);
+    return NULL;
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * convolver.h : uniformly partitioned FFT convolution
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_CONVOLVER_H_
+#define VLC_AUDIO_CONVOLVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest impulse response, in frames, so that the cost stays bounded */
+#define CONVOLVER_MAX_FRAMES 65536
+
+typedef struct convolver_t convolver_t;
+
+/* Creates a convolver mixing i_inputs interleaved channels into i_outputs
+ * interleaved channels, through impulse responses of up to i_max_frames
+ * frames. The responses are cut in partitions of i_block frames (a power of
+ * two), which is also the latency of the output. If i_block is 0, the
+ * smallest power of two from 256 that keeps 64 partitions at most is used,
+ * trading latency for a bounded cost. All responses are empty (silent) until
+ * set. */
+convolver_t *convolver_New(unsigned i_block, unsigned i_inputs,
+                           unsigned i_outputs, size_t i_max_frames);
+void convolver_Delete(convolver_t *);
+
+/* Sets the impulse response from an input to an output channel. The samples
+ * are read with the given stride, so that one interleaved buffer can hold
+ * the responses to several outputs. */
+int convolver_SetResponse(convolver_t *, unsigned i_input, unsigned i_output,
+                          const float *p_ir, size_t i_frames, size_t i_stride);
+
+/* Convolves i_frames interleaved frames. The output is delayed by the block
+ * size, and overwrites p_out, which may not alias p_in. */
+void convolver_Process(convolver_t *, const float *p_in, float *p_out,
+                       size_t i_frames);
+
+/* Clears the history, as if only silence had been processed */
+void convolver_Reset(convolver_t *);
+
+unsigned convolver_GetLatency(const convolver_t *);
+
+/* Loads the impulse responses of a WAV file (integer or float PCM) as
+ * interleaved floats, resampled to i_rate and cut to CONVOLVER_MAX_FRAMES.
+ * Returns NULL on error, otherwise the buffer to free(). */
+float *convolver_LoadWav(vlc_object_t *, const char *psz_path,
+                         unsigned i_rate, unsigned *pi_channels,
+                         size_t *pi_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * convolver_bench.c : benchmark of the partitioned convolution
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Prints how fast a 7.1 to binaural rendering runs with responses of
+ * increasing lengths. convolver_test.c checks its output.
+ *
+ * Usage: audio_convolver_bench [block size] (default 256)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_bench.h>
+
+#include "convolver.h"
+
+#define RATE 48000
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static float RandomSample(unsigned *seed)
+{
+    return (float)(rnd(seed) & 0x7fff) / 0x4000 - 1.f;
+}
+
+/* Exponentially decaying noise, like a room response */
+static void FillResponse(float *ir, size_t frames, size_t stride,
+                         unsigned *seed)
+{
+    for (size_t i = 0; i < frames; i++)
+        ir[i * stride] = RandomSample(seed) * expf(-4.f * i / frames);
+}
+
+struct bench
+{
+    convolver_t *conv;
+    const float *in;
+    float *out;
+    size_t frames;
+};
+
+static void BenchRun(void *opaque)
+{
+    struct bench *b = opaque;
+
+    convolver_Process(b->conv, b->in, b->out, b->frames);
+}
+
+static double Bench(unsigned block, size_t ir_frames)
+{
+    const unsigned inputs = 8, outputs = 2;
+    const size_t frames = 1024;
+    convolver_t *conv = convolver_New(block, inputs, outputs, ir_frames);
+    float *ir = malloc(ir_frames * sizeof (float));
+    float *in = malloc(frames * inputs * sizeof (float));
+    float *out = malloc(frames * outputs * sizeof (float));
+    unsigned seed = 1;
+    double speed = 0.;
+
+    if (conv == NULL || ir == NULL || in == NULL || out == NULL)
+        goto end;
+
+    for (unsigned c = 0; c < inputs; c++)
+        for (unsigned o = 0; o < outputs; o++)
+        {
+            FillResponse(ir, ir_frames, 1, &seed);
+            convolver_SetResponse(conv, c, o, ir, ir_frames, 1);
+        }
+    for (size_t i = 0; i < frames * inputs; i++)
+        in[i] = RandomSample(&seed);
+
+    struct bench b = { conv, in, out, frames };
+    speed = (double)frames * CLOCK_FREQ / RATE
+          * vlc_bench_Run(BenchRun, &b, CLOCK_FREQ / 5);
+end:
+    if (conv != NULL)
+        convolver_Delete(conv);
+    free(ir);
+    free(in);
+    free(out);
+    return speed;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t lengths[] = { 512, 4800, 48000, 65536 };
+    unsigned block = 256;
+
+    if (argc > 1)
+        block = strtoul(argv[1], NULL, 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(lengths); i++)
+        printf("7.1 -> binaural, block %u, response %5zu: %7.1fx realtime\n",
+               block, lengths[i], Bench(block, lengths[i]));
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * convolver_test.c : check of the partitioned convolution
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the output of the convolver against a direct convolution, for
+ * several block sizes and response lengths, with input buffers of irregular
+ * sizes. Then loads responses from WAV files at other rates, which must keep
+ * their length in time and their DC gain once resampled.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include "convolver.h"
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static float RandomSample(unsigned *seed)
+{
+    return (float)(rnd(seed) & 0x7fff) / 0x4000 - 1.f;
+}
+
+/* Exponentially decaying noise, like a room response */
+static void FillResponse(float *ir, size_t frames, size_t stride,
+                         unsigned *seed)
+{
+    for (size_t i = 0; i < frames; i++)
+        ir[i * stride] = RandomSample(seed) * expf(-4.f * i / frames);
+}
+
+static void test_convolver(unsigned block, unsigned inputs, unsigned outputs,
+                           size_t ir_frames)
+{
+    const size_t frames = 4 * ir_frames + 3 * block + 17;
+    float *ir = malloc(inputs * outputs * ir_frames * sizeof (float));
+    float *in = malloc(frames * inputs * sizeof (float));
+    float *out = malloc(frames * outputs * sizeof (float));
+    convolver_t *conv = convolver_New(block, inputs, outputs, ir_frames);
+    unsigned seed = block + ir_frames;
+
+    assert(ir != NULL && in != NULL && out != NULL && conv != NULL);
+
+    /* Responses interleaved per input, one channel per output */
+    for (unsigned c = 0; c < inputs; c++)
+        for (unsigned o = 0; o < outputs; o++)
+        {
+            float *p = ir + c * outputs * ir_frames + o;
+
+            FillResponse(p, ir_frames, outputs, &seed);
+            assert(convolver_SetResponse(conv, c, o, p, ir_frames,
+                                         outputs) == 0);
+        }
+    if (inputs > 1 && outputs > 1) /* leave one pair silent */
+        convolver_SetResponse(conv, 1, 1, ir, 0, outputs);
+
+    for (size_t i = 0; i < frames * inputs; i++)
+        in[i] = RandomSample(&seed);
+
+    for (size_t done = 0; done < frames; )
+    {
+        size_t count = 1 + rnd(&seed) % (3 * block);
+
+        count = __MIN(count, frames - done);
+
+        convolver_Process(conv, in + done * inputs, out + done * outputs,
+                          count);
+        done += count;
+    }
+
+    const unsigned latency = convolver_GetLatency(conv);
+    double err = 0., ref = 0.;
+
+    for (size_t t = latency; t < frames; t++)
+        for (unsigned o = 0; o < outputs; o++)
+        {
+            double y = 0.;
+
+            for (unsigned c = 0; c < inputs; c++)
+            {
+                if (c == 1 && o == 1 && outputs > 1)
+                    continue;
+
+                const float *h = ir + c * outputs * ir_frames + o;
+                const size_t n = t - latency;
+
+                for (size_t k = 0; k < ir_frames && k <= n; k++)
+                    y += h[k * outputs] * in[(n - k) * inputs + c];
+            }
+            err += (y - out[t * outputs + o]) * (y - out[t * outputs + o]);
+            ref += y * y;
+        }
+
+    const double snr = 10. * log10(ref / err);
+    printf("block %4u, %u -> %u, response %6zu: %5.1f dB\n", block, inputs,
+           outputs, ir_frames, snr);
+    assert(snr > 100.);
+
+    /* After a reset, the output must only depend on the new input */
+    convolver_Reset(conv);
+    memset(in, 0, frames * inputs * sizeof (float));
+    convolver_Process(conv, in, out, frames);
+    for (size_t i = 0; i < frames * outputs; i++)
+        assert(out[i] == 0.f);
+
+    convolver_Delete(conv);
+    free(ir);
+    free(in);
+    free(out);
+}
+
+/* Writes a 16-bit PCM WAV file of a decaying response per channel, and the
+ * sum of the samples of each channel, as they will be read, to sums */
+static void WriteWav(FILE *file, unsigned rate, unsigned channels,
+                     size_t frames, double *sums)
+{
+    uint8_t hdr[44];
+
+    memcpy(hdr, "RIFF", 4);
+    SetDWLE(hdr + 4, 36 + frames * channels * 2);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    SetDWLE(hdr + 16, 16);
+    SetWLE(hdr + 20, 1 /* PCM */);
+    SetWLE(hdr + 22, channels);
+    SetDWLE(hdr + 24, rate);
+    SetDWLE(hdr + 28, rate * channels * 2);
+    SetWLE(hdr + 32, channels * 2);
+    SetWLE(hdr + 34, 16);
+    memcpy(hdr + 36, "data", 4);
+    SetDWLE(hdr + 40, frames * channels * 2);
+    assert(fwrite(hdr, sizeof (hdr), 1, file) == 1);
+
+    for (unsigned c = 0; c < channels; c++)
+        sums[c] = 0.;
+
+    for (size_t i = 0; i < frames; i++)
+        for (unsigned c = 0; c < channels; c++)
+        {
+            /* opposite signs and different decays per channel */
+            const float v = (c & 1 ? -.5f : .8f)
+                          * expf(-(float)i / (300.f * (c + 1)));
+            const int16_t s = lroundf(v * 32767.f);
+            uint8_t buf[2];
+
+            SetWLE(buf, s);
+            assert(fwrite(buf, sizeof (buf), 1, file) == 1);
+            sums[c] += s / 32768.;
+        }
+}
+
+static void test_load_wav(unsigned file_rate, unsigned rate)
+{
+    const unsigned channels = 2;
+    const size_t frames = 4096;
+    char path[] = "/tmp/vlc_convolver_XXXXXX";
+    double sums[2];
+
+    int fd = vlc_mkstemp(path);
+    assert(fd != -1);
+    FILE *file = fdopen(fd, "wb");
+    assert(file != NULL);
+    WriteWav(file, file_rate, channels, frames, sums);
+    assert(fclose(file) == 0);
+
+    unsigned loaded_channels;
+    size_t loaded_frames;
+    /* without an object, nothing is logged */
+    float *ir = convolver_LoadWav(NULL, path, rate, &loaded_channels,
+                                  &loaded_frames);
+    unlink(path);
+    assert(ir != NULL);
+
+    const size_t expected = ((uint64_t)frames * rate + file_rate - 1)
+                          / file_rate;
+
+    printf("response %u Hz -> %u Hz: %zu -> %zu frames, DC gain", file_rate,
+           rate, frames, loaded_frames);
+    assert(loaded_channels == channels);
+    assert(loaded_frames == expected);
+
+    for (unsigned c = 0; c < channels; c++)
+    {
+        double sum = 0.;
+
+        for (size_t i = 0; i < loaded_frames; i++)
+            sum += ir[i * channels + c];
+        printf(" %.4f", sum / sums[c]);
+        assert(fabs(sum / sums[c] - 1.) < .01);
+    }
+    printf("\n");
+    free(ir);
+}
+
+int main(void)
+{
+    static const size_t lengths[] = { 1, 100, 1000, 5000 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(lengths); i++)
+    {
+        test_convolver(64, 1, 1, lengths[i]);
+        test_convolver(64, 3, 2, lengths[i]);
+        test_convolver(256, 3, 2, lengths[i]);
+    }
+
+    test_load_wav(48000, 48000);
+    test_load_wav(44100, 48000);
+    test_load_wav(96000, 48000);
+    return 0;
+}
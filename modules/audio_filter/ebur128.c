@@ -0,0 +1,415 @@
+/*****************************************************************************
+ * ebur128.c : EBU R128 loudness meter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+
+#include "biquad.h"
+#include "ebur128.h"
+
+/*
+ * ITU-R BS.1770-4 loudness, with the EBU Tech 3341 and 3342 windows:
+ *
+ * The channels are K-weighted (a high shelf then a high pass), squared,
+ * weighted and summed, and accumulated over blocks of 100 ms. The momentary
+ * and short-term loudness are the mean of the last 4 and 30 blocks.
+ *
+ * The integrated loudness and the loudness range are gated, first at -70
+ * LUFS, then relative to the mean of what passed the first gate. Rather than
+ * keeping every measurement of the program, they are counted in histograms
+ * of 0.1 LU bins, so that the memory and the cost stay constant; the gates
+ * are thus rounded to the bin.
+ *
+ * The true peak is found by interpolating each channel at 4 times the rate,
+ * with a windowed sinc of 12 taps per phase.
+ */
+#define BLOCKS_PER_SECOND  10
+#define MOMENTARY_BLOCKS   4
+#define SHORT_TERM_BLOCKS  30
+
+#define GATE_ABSOLUTE      (-70.f)
+#define GATE_INTEGRATED    (-10.f)
+#define GATE_RANGE         (-20.f)
+
+#define HIST_STEP          .1f
+#define HIST_BINS          1000    /* -70 to +30 LUFS */
+
+#define TP_PHASES          4
+#define TP_TAPS            12
+#define TP_DELAY           EBUR128_PEAK_DELAY /* of the phase 0 */
+
+#define CHUNK              256
+
+struct histogram
+{
+    unsigned count[HIST_BINS];
+    double energy[HIST_BINS];
+};
+
+struct ebur128_t
+{
+    unsigned channels;
+    float *weights;
+    biquad_t *kweight;
+    float *buf;                         /* [CHUNK][channels] */
+
+    unsigned block_frames;
+    unsigned block_left;                /* frames until the end of block */
+    double block_energy;                /* sum of the current block */
+    double blocks[SHORT_TERM_BLOCKS];   /* sums of the last blocks */
+    unsigned block_pos;
+    unsigned block_count;
+
+    double momentary;                   /* mean square, 0 if unknown */
+    double short_term;
+
+    struct histogram integrated;        /* of the momentary loudness */
+    float integrated_lufs;              /* gated, updated on each block */
+    struct histogram range;             /* of the short-term loudness */
+
+    float tp_coeffs[TP_PHASES - 1][TP_TAPS];
+    float *tp_history;                  /* [channels][2 * TP_TAPS] */
+    unsigned tp_pos;
+    float tp_max;
+};
+
+static float Loudness(double energy)
+{
+    if (energy <= 0.)
+        return -INFINITY;
+    return -.691f + 10.f * log10f(energy);
+}
+
+static void HistogramAdd(struct histogram *h, double energy)
+{
+    const float lufs = Loudness(energy);
+
+    if (!(lufs >= GATE_ABSOLUTE))
+        return;
+
+    unsigned bin = (lufs - GATE_ABSOLUTE) / HIST_STEP;
+    if (bin >= HIST_BINS)
+        bin = HIST_BINS - 1;
+    h->count[bin]++;
+    h->energy[bin] += energy;
+}
+
+/* First bin above the relative gate, or HIST_BINS if empty */
+static unsigned HistogramGate(const struct histogram *h, float gate)
+{
+    double energy = 0.;
+    size_t count = 0;
+
+    for (unsigned i = 0; i < HIST_BINS; i++)
+    {
+        count += h->count[i];
+        energy += h->energy[i];
+    }
+    if (count == 0)
+        return HIST_BINS;
+
+    float threshold = Loudness(energy / count) + gate;
+    float bin = ceilf((threshold - GATE_ABSOLUTE) / HIST_STEP);
+    return bin > 0.f ? (unsigned)bin : 0;
+}
+
+static void TruePeakInit(ebur128_t *m)
+{
+    for (unsigned p = 1; p < TP_PHASES; p++)
+    {
+        float *h = m->tp_coeffs[p - 1];
+        float sum = 0.f;
+
+        /* Interpolates at TP_DELAY - p / TP_PHASES frames ago */
+        for (unsigned j = 0; j < TP_TAPS; j++)
+        {
+            const float t = (float)j - TP_DELAY + (float)p / TP_PHASES;
+            const float a = (float)M_PI * t;
+            const float w = (float)M_PI * t / (TP_TAPS / 2 + .5f);
+
+            /* windowed sinc (Blackman) */
+            h[j] = sinf(a) / a * (.42f + .5f * cosf(w) + .08f * cosf(2.f * w));
+            sum += h[j];
+        }
+        for (unsigned j = 0; j < TP_TAPS; j++)
+            h[j] /= sum;
+    }
+}
+
+static void TruePeak(ebur128_t *m, const float *in, size_t n, float *peaks)
+{
+    const unsigned channels = m->channels;
+    float max = m->tp_max;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        float peak = 0.f;
+        unsigned pos = m->tp_pos;
+
+        for (unsigned c = 0; c < channels; c++)
+        {
+            /* Each history is stored twice, so that the last TP_TAPS
+             * samples are contiguous, from the newest to the oldest */
+            float *h = m->tp_history + c * 2 * TP_TAPS + pos;
+
+            h[0] = h[TP_TAPS] = in[i * channels + c];
+            peak = __MAX(peak, fabsf(h[TP_DELAY]));
+
+            for (unsigned p = 0; p < TP_PHASES - 1; p++)
+            {
+                const float *k = m->tp_coeffs[p];
+                float y = 0.f;
+
+                for (unsigned j = 0; j < TP_TAPS; j++)
+                    y += k[j] * h[j];
+                peak = __MAX(peak, fabsf(y));
+            }
+        }
+        m->tp_pos = pos > 0 ? pos - 1 : TP_TAPS - 1;
+
+        if (peaks != NULL)
+            peaks[i] = peak;
+        max = __MAX(max, peak);
+    }
+    m->tp_max = max;
+}
+
+/* Loudness of the bins above the relative gate */
+static float Integrated(const struct histogram *h)
+{
+    const unsigned gate = HistogramGate(h, GATE_INTEGRATED);
+    double energy = 0.;
+    size_t count = 0;
+
+    for (unsigned i = gate; i < HIST_BINS; i++)
+    {
+        count += h->count[i];
+        energy += h->energy[i];
+    }
+    return count > 0 ? Loudness(energy / count) : -INFINITY;
+}
+
+static void EndBlock(ebur128_t *m)
+{
+    m->blocks[m->block_pos] = m->block_energy;
+    m->block_pos = (m->block_pos + 1) % SHORT_TERM_BLOCKS;
+    if (m->block_count < SHORT_TERM_BLOCKS)
+        m->block_count++;
+    m->block_energy = 0.;
+    m->block_left = m->block_frames;
+
+    double sum = 0.;
+    for (unsigned i = 1; i <= m->block_count; i++)
+    {
+        sum += m->blocks[(m->block_pos + SHORT_TERM_BLOCKS - i)
+                         % SHORT_TERM_BLOCKS];
+
+        if (i == MOMENTARY_BLOCKS)
+        {
+            m->momentary = sum / (MOMENTARY_BLOCKS * m->block_frames);
+            HistogramAdd(&m->integrated, m->momentary);
+            m->integrated_lufs = Integrated(&m->integrated);
+        }
+    }
+
+    if (m->block_count == SHORT_TERM_BLOCKS)
+    {
+        m->short_term = sum / (SHORT_TERM_BLOCKS * m->block_frames);
+        HistogramAdd(&m->range, m->short_term);
+    }
+}
+
+ebur128_t *ebur128_New(unsigned i_rate, unsigned i_channels,
+                       const float *p_weights)
+{
+    if (i_rate < BLOCKS_PER_SECOND || i_channels == 0)
+        return NULL;
+
+    ebur128_t *m = calloc(1, sizeof (*m));
+    if (unlikely(m == NULL))
+        return NULL;
+
+    m->channels = i_channels;
+    m->weights = vlc_alloc(i_channels, sizeof (float));
+    m->kweight = biquad_New(i_channels, 2);
+    m->buf = vlc_alloc(CHUNK * i_channels, sizeof (float));
+    m->tp_history = calloc(i_channels * 2 * TP_TAPS, sizeof (float));
+    if (unlikely(m->weights == NULL || m->kweight == NULL || m->buf == NULL
+              || m->tp_history == NULL))
+    {
+        ebur128_Delete(m);
+        return NULL;
+    }
+
+    for (unsigned c = 0; c < i_channels; c++)
+        m->weights[c] = p_weights != NULL ? p_weights[c] : 1.f;
+
+    /* K-weighting, for any rate: the high shelf of the head, then the
+     * RLB high pass (as derived from the 48 kHz coefficients of BS.1770) */
+    const double Fs = i_rate;
+    double K, Q, a0;
+    float coeffs[5];
+
+    K = tan(M_PI * 1681.974450955533 / Fs);
+    Q = 0.7071752369554196;
+    a0 = 1. + K / Q + K * K;
+
+    const double Vh = pow(10., 3.999843853973347 / 20.);
+    const double Vb = pow(Vh, 0.4996667741545416);
+
+    coeffs[0] = (Vh + Vb * K / Q + K * K) / a0;
+    coeffs[1] = 2. * (K * K - Vh) / a0;
+    coeffs[2] = (Vh - Vb * K / Q + K * K) / a0;
+    coeffs[3] = 2. * (K * K - 1.) / a0;
+    coeffs[4] = (1. - K / Q + K * K) / a0;
+    biquad_Set(m->kweight, 0, coeffs);
+
+    K = tan(M_PI * 38.13547087602444 / Fs);
+    Q = 0.5003270373238773;
+    a0 = 1. + K / Q + K * K;
+
+    coeffs[0] = 1.f;
+    coeffs[1] = -2.f;
+    coeffs[2] = 1.f;
+    coeffs[3] = 2. * (K * K - 1.) / a0;
+    coeffs[4] = (1. - K / Q + K * K) / a0;
+    biquad_Set(m->kweight, 1, coeffs);
+
+    m->block_frames = (i_rate + BLOCKS_PER_SECOND / 2) / BLOCKS_PER_SECOND;
+    m->block_left = m->block_frames;
+    m->integrated_lufs = -INFINITY;
+    TruePeakInit(m);
+    return m;
+}
+
+void ebur128_Delete(ebur128_t *m)
+{
+    if (m->kweight != NULL)
+        biquad_Delete(m->kweight);
+    free(m->weights);
+    free(m->buf);
+    free(m->tp_history);
+    free(m);
+}
+
+void ebur128_Process(ebur128_t *m, const float *p_in, size_t i_frames,
+                     float *p_peaks)
+{
+    const unsigned channels = m->channels;
+
+    while (i_frames > 0)
+    {
+        const size_t n = __MIN(__MIN(i_frames, CHUNK), m->block_left);
+        double energy = 0.;
+
+        biquad_Process(m->kweight, m->buf, p_in, n);
+        for (unsigned c = 0; c < channels; c++)
+        {
+            const float w = m->weights[c];
+            float sum = 0.f;
+
+            if (w == 0.f)
+                continue;
+            for (size_t i = 0; i < n; i++)
+            {
+                const float y = m->buf[i * channels + c];
+                sum += y * y;
+            }
+            energy += w * sum;
+        }
+        m->block_energy += energy;
+
+        TruePeak(m, p_in, n, p_peaks);
+
+        m->block_left -= n;
+        if (m->block_left == 0)
+            EndBlock(m);
+
+        p_in += n * channels;
+        if (p_peaks != NULL)
+            p_peaks += n;
+        i_frames -= n;
+    }
+}
+
+void ebur128_Flush(ebur128_t *m)
+{
+    biquad_Reset(m->kweight);
+    memset(m->tp_history, 0, m->channels * 2 * TP_TAPS * sizeof (float));
+    m->block_energy = 0.;
+    m->block_left = m->block_frames;
+    m->block_count = 0;
+    m->momentary = 0.;
+    m->short_term = 0.;
+}
+
+float ebur128_Momentary(const ebur128_t *m)
+{
+    return Loudness(m->momentary);
+}
+
+float ebur128_ShortTerm(const ebur128_t *m)
+{
+    return Loudness(m->short_term);
+}
+
+float ebur128_Integrated(const ebur128_t *m)
+{
+    return m->integrated_lufs;
+}
+
+float ebur128_Range(const ebur128_t *m)
+{
+    const struct histogram *h = &m->range;
+    const unsigned gate = HistogramGate(h, GATE_RANGE);
+    size_t count = 0;
+
+    for (unsigned i = gate; i < HIST_BINS; i++)
+        count += h->count[i];
+    if (count == 0)
+        return 0.f;
+
+    /* 10th and 95th percentiles */
+    const size_t low = (count - 1) * 10 / 100, high = (count - 1) * 95 / 100;
+    unsigned low_bin = gate, high_bin = gate;
+    size_t seen = 0;
+
+    for (unsigned i = gate; i < HIST_BINS; i++)
+    {
+        if (seen <= low)
+            low_bin = i;
+        if (seen <= high)
+            high_bin = i;
+        seen += h->count[i];
+    }
+    return (high_bin - low_bin) * HIST_STEP;
+}
+
+float ebur128_TruePeak(const ebur128_t *m)
+{
+    return m->tp_max > 0.f ? 20.f * log10f(m->tp_max) : -INFINITY;
+}
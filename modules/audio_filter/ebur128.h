@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * ebur128.h : EBU R128 loudness meter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_EBUR128_H_
+#define VLC_AUDIO_EBUR128_H_
+
+#define EBUR128_PEAK_DELAY 6
+
+typedef struct ebur128_t ebur128_t;
+
+/* Creates a meter for i_channels interleaved float channels. p_weights gives
+ * the weight of each channel in the sum (ITU-R BS.1770: 1 for the front
+ * channels, 1.41 for the surround channels, 0 to skip the LFE), or NULL to
+ * weigh all channels equally. */
+ebur128_t *ebur128_New(unsigned i_rate, unsigned i_channels,
+                       const float *p_weights);
+void ebur128_Delete(ebur128_t *);
+
+/* Measures i_frames interleaved frames. If p_peaks is not NULL, it receives
+ * the true peak (linear, largest of all channels) of each frame, from
+ * EBUR128_PEAK_DELAY frames before (the interpolation needs the next ones). */
+void ebur128_Process(ebur128_t *, const float *p_in, size_t i_frames,
+                     float *p_peaks);
+
+/* Clears the signal history (after a discontinuity), but keeps the
+ * integrated measurements */
+void ebur128_Flush(ebur128_t *);
+
+/* Loudness in LUFS over the last 400 ms, over the last 3 s, and over the
+ * whole (gated) program; -INFINITY until enough signal was measured. They
+ * are updated at the end of each 100 ms block, and cheap to read. */
+float ebur128_Momentary(const ebur128_t *);
+float ebur128_ShortTerm(const ebur128_t *);
+float ebur128_Integrated(const ebur128_t *);
+
+/* Loudness range (EBU Tech 3342) in LU, 0 until measured */
+float ebur128_Range(const ebur128_t *);
+
+/* Largest true peak of the program, in dBTP */
+float ebur128_TruePeak(const ebur128_t *);
+
+#endif
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * ebur128_bench.c : benchmark of the loudness meter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Prints the throughput of the loudness meter, true peak included.
+ * ebur128_test.c checks its measurements.
+ *
+ * Usage: audio_ebur128_bench [frames] (default 1048576)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_bench.h>
+
+#include "ebur128.h"
+
+#define RATE 48000
+
+struct bench
+{
+    ebur128_t *m;
+    const float *buf;
+    size_t frames;
+    float *peaks;
+};
+
+static void BenchRun(void *opaque)
+{
+    struct bench *b = opaque;
+
+    ebur128_Process(b->m, b->buf, b->frames, b->peaks);
+}
+
+static double Bench(unsigned channels, const float *buf, size_t frames)
+{
+    struct bench b = {
+        ebur128_New(RATE, channels, NULL), buf, frames,
+        malloc(frames * sizeof (float)),
+    };
+    double speed = 0.;
+
+    if (b.m != NULL && b.peaks != NULL)
+        speed = (double)frames * vlc_bench_Run(BenchRun, &b, CLOCK_FREQ / 5);
+
+    if (b.m != NULL)
+        ebur128_Delete(b.m);
+    free(b.peaks);
+    return speed;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t frames = 1 << 20;
+
+    if (argc > 1)
+        frames = strtoul(argv[1], NULL, 0);
+    if (frames == 0)
+        return 1;
+
+    float *buf = malloc(frames * 6 * sizeof (float));
+    if (buf == NULL)
+        return 1;
+
+    unsigned seed = 1;
+    for (size_t i = 0; i < frames * 6; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (float)((seed >> 16) & 0x7fff) / 0x4000 - 1.f;
+    }
+
+    static const unsigned layouts[] = { 2, 6 };
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++)
+        printf("%u channels: %.1f Mframes/s\n", layouts[i],
+               Bench(layouts[i], buf, frames));
+
+    free(buf);
+    return 0;
+}
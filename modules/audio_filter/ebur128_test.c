@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * ebur128_test.c : check of the loudness meter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the meter against the synthetic cases of EBU Tech 3341 (loudness,
+ * gating and true peak) and 3342 (loudness range).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <vlc_common.h>
+
+#include "ebur128.h"
+
+#define RATE 48000
+
+/* Feeds a stereo 1 kHz sine, of the given level in dBFS */
+static void Sine(ebur128_t *m, float dbfs, float seconds)
+{
+    const float amp = powf(10.f, dbfs / 20.f);
+    const size_t frames = seconds * RATE;
+    float buf[2 * 480];
+
+    for (size_t done = 0; done < frames; done += 480)
+    {
+        const size_t n = __MIN(frames - done, 480);
+
+        for (size_t i = 0; i < n; i++)
+            buf[2 * i] = buf[2 * i + 1] =
+                amp * sinf(2.f * (float)M_PI * ((done + i) % 48) / 48.f);
+        ebur128_Process(m, buf, n, NULL);
+    }
+}
+
+static void Expect(const char *name, float value, float expected, float low,
+                   float high)
+{
+    printf("%s: %.2f (%.1f expected)\n", name, value, expected);
+    assert(value >= expected + low && value <= expected + high);
+}
+
+static void test_loudness(void)
+{
+    static const struct
+    {
+        float levels[5];
+        float seconds[5];
+        float integrated;
+    } cases[] = {
+        { { -23.f }, { 20.f }, -23.f },
+        { { -33.f }, { 20.f }, -33.f },
+        { { -36.f, -23.f, -36.f }, { 10.f, 60.f, 10.f }, -23.f },
+        { { -72.f, -36.f, -23.f, -36.f, -72.f },
+          { 10.f, 10.f, 60.f, 10.f, 10.f }, -23.f },
+        { { -26.f, -20.f, -26.f }, { 20.f, 20.1f, 20.f }, -23.f },
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++)
+    {
+        ebur128_t *m = ebur128_New(RATE, 2, NULL);
+        assert(m != NULL);
+
+        for (size_t j = 0; j < 5 && cases[i].seconds[j] > 0.f; j++)
+            Sine(m, cases[i].levels[j], cases[i].seconds[j]);
+        Expect("integrated", ebur128_Integrated(m), cases[i].integrated,
+               -.1f, .1f);
+        if (i < 2)
+        {
+            Expect("momentary", ebur128_Momentary(m), cases[i].integrated,
+                   -.1f, .1f);
+            Expect("short-term", ebur128_ShortTerm(m), cases[i].integrated,
+                   -.1f, .1f);
+        }
+        ebur128_Delete(m);
+    }
+}
+
+static void test_range(void)
+{
+    static const struct
+    {
+        float levels[2];
+        float range;
+    } cases[] = {
+        { { -20.f, -30.f }, 10.f },
+        { { -20.f, -15.f }, 5.f },
+        { { -40.f, -20.f }, 20.f },
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++)
+    {
+        ebur128_t *m = ebur128_New(RATE, 2, NULL);
+        assert(m != NULL);
+
+        Sine(m, cases[i].levels[0], 20.f);
+        Sine(m, cases[i].levels[1], 20.f);
+        Expect("range", ebur128_Range(m), cases[i].range, -1.f, 1.f);
+        ebur128_Delete(m);
+    }
+}
+
+/* A sine at a quarter of the rate, sampled 45 degrees off its peaks (faded
+ * in, as the interpolation would overshoot on a step) */
+static void test_true_peak(void)
+{
+    ebur128_t *m = ebur128_New(RATE, 1, NULL);
+    float buf[RATE];
+
+    assert(m != NULL);
+
+    for (size_t i = 0; i < RATE; i++)
+        buf[i] = cosf((float)M_PI / 2.f * i + (float)M_PI / 4.f);
+    for (size_t i = 0; i < RATE / 100; i++)
+        buf[i] *= .5f - .5f * cosf((float)M_PI * i / (RATE / 100));
+    ebur128_Process(m, buf, RATE, NULL);
+
+    Expect("true peak", ebur128_TruePeak(m), 0.f, -.4f, .2f);
+    ebur128_Delete(m);
+}
+
+int main(void)
+{
+    test_loudness();
+    test_range();
+    test_true_peak();
+    return 0;
+}
@@ -39,9 +39,9 @@
 #include <vlc_filter.h>
 
 #include "equalizer_presets.h"
+#include "biquad.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -105,31 +105,27 @@ struct filter_sys_t
 {
     /* Filter static config */
     int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
 
     /* Filter dyn config */
     float *f_amp;   /* Per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    /* Filter banks (band pass filters) */
+    biquad_t *p_eq;
 
-    /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    /* Second filter banks */
+    biquad_t *p_eq2;
 
     vlc_mutex_t lock;
 };
 
 static block_t *DoWork( filter_t *, block_t * );
+static void Flush( filter_t * );
 
 #define EQZ_IN_FACTOR (0.25f)
 static int  EqzInit( filter_t *, int );
-static void EqzFilter( filter_t *, float *, float *, int, int );
+static void EqzFilter( filter_t *, float *, float *, int );
 static void EqzClean( filter_t * );
 
 static int PresetCallback ( vlc_object_t *, char const *, vlc_value_t,
@@ -167,6 +163,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_flush = Flush;
 
     return VLC_SUCCESS;
 }
@@ -192,11 +189,18 @@ static void Close( vlc_object_t *p_this )
 static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
     EqzFilter( p_filter, (float*)p_in_buf->p_buffer,
-               (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
-               aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
+               (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples );
     return p_in_buf;
 }
 
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    biquad_Reset( p_sys->p_eq );
+    biquad_Reset( p_sys->p_eq2 );
+}
+
 /*****************************************************************************
  * Equalizer stuff
  *****************************************************************************/
@@ -281,7 +285,8 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
+    unsigned i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = p_filter->obj.parent;
     int i_ret = VLC_ENOMEM;
@@ -291,17 +296,21 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 
     /* Create the static filter config */
     p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
+    p_sys->p_eq  = biquad_New( i_channels, p_sys->i_band );
+    p_sys->p_eq2 = biquad_New( i_channels, p_sys->i_band );
+    if( !p_sys->p_eq || !p_sys->p_eq2 )
         goto error;
 
     for( i = 0; i < p_sys->i_band; i++ )
     {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
+        /* y = alpha * (x - x2) + gamma * y1 - beta * y2 */
+        const float coeffs[5] = {
+            cfg.band[i].f_alpha, 0.0f, -cfg.band[i].f_alpha,
+            -cfg.band[i].f_gamma, cfg.band[i].f_beta,
+        };
+
+        biquad_Set( p_sys->p_eq, i, coeffs );
+        biquad_Set( p_sys->p_eq2, i, coeffs );
     }
 
     /* Filter dyn config */
@@ -316,23 +325,6 @@ static int EqzInit( filter_t *p_filter, int i_rate )
         p_sys->f_amp[i] = 0.0f;
     }
 
-    /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
-
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
@@ -375,76 +367,48 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
                  cfg.band[i].f_frequency, p_sys->f_amp[i],
-                 p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
+                 cfg.band[i].f_alpha, cfg.band[i].f_beta,
+                 cfg.band[i].f_gamma );
     }
     return VLC_SUCCESS;
 
 error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
+    if( p_sys->p_eq )
+        biquad_Delete( p_sys->p_eq );
+    if( p_sys->p_eq2 )
+        biquad_Delete( p_sys->p_eq2 );
     return i_ret;
 }
 
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
-                       int i_samples, int i_channels )
+                       int i_samples )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    float f_amp[EQZ_BANDS_MAX];
+    int j;
 
+    /* The source PCM is added to the filtered PCM, and the global gain is
+     * folded into the gains of the last pass. */
     vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
+    if( p_sys->b_2eqz )
     {
-        for( ch = 0; ch < i_channels; ch++ )
-        {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
-
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
-        }
+        const float f_gamp = p_sys->f_gamp * p_sys->f_gamp;
+
+        for( j = 0; j < p_sys->i_band; j++ )
+            f_amp[j] = f_gamp * p_sys->f_amp[j];
+
+        biquad_ProcessBank( p_sys->p_eq, out, in, i_samples,
+                            EQZ_IN_FACTOR, p_sys->f_amp );
+        biquad_ProcessBank( p_sys->p_eq2, out, out, i_samples,
+                            f_gamp * EQZ_IN_FACTOR, f_amp );
+    }
+    else
+    {
+        for( j = 0; j < p_sys->i_band; j++ )
+            f_amp[j] = p_sys->f_gamp * p_sys->f_amp[j];
 
-        in  += i_channels;
-        out += i_channels;
+        biquad_ProcessBank( p_sys->p_eq, out, in, i_samples,
+                            p_sys->f_gamp * EQZ_IN_FACTOR, f_amp );
     }
     vlc_mutex_unlock( &p_sys->lock );
 }
@@ -459,9 +423,8 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
+    biquad_Delete( p_sys->p_eq );
+    biquad_Delete( p_sys->p_eq2 );
 
     free( p_sys->f_amp );
 }
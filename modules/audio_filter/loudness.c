@@ -0,0 +1,463 @@
+/*****************************************************************************
+ * loudness.c : EBU R128 loudness normalizer
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_plugin.h>
+
+#include "ebur128.h"
+
+static int Open(vlc_object_t *);
+static void Close(vlc_object_t *);
+
+#define TARGET_TEXT N_("Target loudness")
+#define TARGET_LONGTEXT N_("Loudness to normalize the programs to, in LUFS. " \
+    "EBU R128 recommends -23 LUFS.")
+#define MAX_GAIN_TEXT N_("Maximum gain")
+#define MAX_GAIN_LONGTEXT N_("Largest amplification of quiet programs, " \
+    "in dB.")
+#define CEILING_TEXT N_("True peak ceiling")
+#define CEILING_LONGTEXT N_("Largest true peak of the output, in dBTP. " \
+    "Louder peaks are attenuated by a look-ahead limiter.")
+#define NORMALIZE_TEXT N_("Normalize")
+#define NORMALIZE_LONGTEXT N_("Adjust the gain to reach the target " \
+    "loudness. Otherwise, the loudness is only measured.")
+
+vlc_module_begin()
+    set_shortname(N_("Loudness"))
+    set_description(N_("EBU R128 loudness normalizer"))
+    set_category(CAT_AUDIO)
+    set_subcategory(SUBCAT_AUDIO_AFILTER)
+
+    add_float_with_range("loudness-target", -23., -70., 0.,
+                         TARGET_TEXT, TARGET_LONGTEXT, false)
+    add_float_with_range("loudness-max-gain", 12., 0., 40.,
+                         MAX_GAIN_TEXT, MAX_GAIN_LONGTEXT, true)
+    add_float_with_range("loudness-ceiling", -1., -20., 0.,
+                         CEILING_TEXT, CEILING_LONGTEXT, true)
+    add_bool("loudness-normalize", true, NORMALIZE_TEXT, NORMALIZE_LONGTEXT,
+             true)
+
+    set_capability("audio filter", 0)
+    set_callbacks(Open, Close)
+vlc_module_end()
+
+/*
+ * The gain rides the short-term loudness towards the target, slowly so that
+ * it does not pump, and is frozen while the program is quiet (below the
+ * gates of the integrated loudness), so that pauses are not amplified.
+ *
+ * The limiter delays the output, so that it sees the true peaks coming. The
+ * gain that each peak needs is spread over the look-ahead by taking the
+ * minimum over the window, then averaging over the window: the average of
+ * the minima is below the gain needed by any frame of the window. The gain
+ * is then released exponentially.
+ *
+ * The timestamps are moved back by the delay, and the delayed samples are
+ * pushed out when draining.
+ */
+#define CHUNK              256
+#define LOOKAHEAD          (CLOCK_FREQ / 200)  /* 5 ms */
+#define RELEASE            (CLOCK_FREQ / 10)   /* 100 ms */
+#define GAIN_RISE          1.f                 /* dB per second */
+#define GAIN_FALL          3.f
+#define GATE_ABSOLUTE      (-70.f)
+#define GATE_RELATIVE      (-10.f)             /* of the integrated */
+#define STATS_PERIOD       (CLOCK_FREQ / 10)
+
+static const char *const stats_names[] = {
+    "loudness-momentary", "loudness-short-term", "loudness-integrated",
+    "loudness-range", "loudness-true-peak", "loudness-gain",
+};
+
+struct filter_sys_t
+{
+    ebur128_t *meter;
+    unsigned channels;
+    unsigned rate;
+    bool normalize;
+
+    /* gain riding */
+    float target;
+    float max_gain;
+    float gain_db;
+
+    /* limiter */
+    float ceiling;
+    unsigned window;        /* look-ahead, in frames */
+    float *delay;           /* [delay_frames][channels] */
+    unsigned delay_frames;
+    unsigned delay_pos;
+    float *min_value;       /* sliding minimum queue, [window] */
+    uint64_t *min_time;
+    unsigned min_head;
+    unsigned min_count;
+    uint64_t time;
+    float *box;             /* last minima, [window] */
+    unsigned box_pos;
+    double box_sum;
+    float release;
+    float release_coeff;
+    mtime_t latency;
+    mtime_t end;            /* of the last output, to drain after it */
+
+    unsigned stats_left;
+};
+
+static void GetWeights(const audio_format_t *fmt, float *weights)
+{
+    const bool sides = (fmt->i_physical_channels & AOUT_CHANS_MIDDLE) != 0;
+    unsigned c = 0;
+
+    /* ITU-R BS.1770: +1.5 dB for the surround channels (around 110°) */
+    for (const uint32_t *chan = pi_vlc_chan_order_wg4; *chan != 0; chan++)
+    {
+        if (!(fmt->i_physical_channels & *chan))
+            continue;
+
+        switch (*chan)
+        {
+            case AOUT_CHAN_LFE:
+                weights[c] = 0.f;
+                break;
+            case AOUT_CHAN_MIDDLELEFT:
+            case AOUT_CHAN_MIDDLERIGHT:
+                weights[c] = 1.41f;
+                break;
+            case AOUT_CHAN_REARLEFT:
+            case AOUT_CHAN_REARRIGHT:
+                weights[c] = sides ? 1.f : 1.41f;
+                break;
+            default:
+                weights[c] = 1.f;
+                break;
+        }
+        c++;
+    }
+}
+
+static void ResetLimiter(filter_sys_t *sys)
+{
+    memset(sys->delay, 0,
+           sys->delay_frames * sys->channels * sizeof (*sys->delay));
+    sys->delay_pos = 0;
+    sys->min_head = 0;
+    sys->min_count = 0;
+    sys->time = 0;
+    for (unsigned i = 0; i < sys->window; i++)
+        sys->box[i] = 1.f;
+    sys->box_pos = 0;
+    sys->box_sum = sys->window;
+    sys->release = 1.f;
+    sys->end = VLC_TS_INVALID;
+}
+
+/* Minimum of the last window values: the queue keeps the values that may
+ * still become the minimum, in increasing order */
+static float SlidingMin(filter_sys_t *sys, float value)
+{
+    const unsigned window = sys->window;
+
+    if (sys->min_count > 0
+     && sys->min_time[sys->min_head] + window <= sys->time)
+    {
+        sys->min_head = (sys->min_head + 1) % window;
+        sys->min_count--;
+    }
+    while (sys->min_count > 0)
+    {
+        unsigned back = (sys->min_head + sys->min_count - 1) % window;
+
+        if (sys->min_value[back] < value)
+            break;
+        sys->min_count--;
+    }
+
+    unsigned back = (sys->min_head + sys->min_count) % window;
+    sys->min_value[back] = value;
+    sys->min_time[back] = sys->time++;
+    sys->min_count++;
+    return sys->min_value[sys->min_head];
+}
+
+static void RideGain(filter_sys_t *sys, size_t frames)
+{
+    float lufs = ebur128_ShortTerm(sys->meter);
+    if (lufs == -INFINITY)
+        lufs = ebur128_Momentary(sys->meter);
+
+    const float integrated = ebur128_Integrated(sys->meter);
+    if (!(lufs > GATE_ABSOLUTE) || lufs < integrated + GATE_RELATIVE)
+        return;
+
+    const float target = __MIN(sys->target - lufs, sys->max_gain);
+    const float seconds = (float)frames / sys->rate;
+
+    if (target > sys->gain_db)
+        sys->gain_db = __MIN(sys->gain_db + GAIN_RISE * seconds, target);
+    else
+        sys->gain_db = __MAX(sys->gain_db - GAIN_FALL * seconds, target);
+}
+
+static void Normalize(filter_sys_t *sys, float *spl, const float *peaks,
+                      size_t frames)
+{
+    const unsigned channels = sys->channels, window = sys->window;
+    const float from = powf(10.f, sys->gain_db / 20.f);
+
+    RideGain(sys, frames);
+
+    const float to = powf(10.f, sys->gain_db / 20.f);
+    const float step = (to - from) / frames;
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        const float ride = from + step * (i + 1);
+        const float peak = peaks[i] * ride;
+        const float min = SlidingMin(sys, peak > sys->ceiling
+                                          ? sys->ceiling / peak : 1.f);
+
+        sys->box_sum += min - sys->box[sys->box_pos];
+        sys->box[sys->box_pos] = min;
+        if (++sys->box_pos == window)
+        {   /* Do not let the rounding errors pile up */
+            sys->box_pos = 0;
+            sys->box_sum = 0.;
+            for (unsigned j = 0; j < window; j++)
+                sys->box_sum += sys->box[j];
+        }
+
+        const float gain = sys->box_sum / window;
+        if (gain < sys->release)
+            sys->release = gain;
+        else
+            sys->release += (gain - sys->release) * sys->release_coeff;
+
+        float *delayed = sys->delay + sys->delay_pos * channels;
+        for (unsigned c = 0; c < channels; c++)
+        {
+            const float x = spl[c];
+
+            spl[c] = delayed[c] * sys->release;
+            delayed[c] = x * ride;
+        }
+        spl += channels;
+        if (++sys->delay_pos == sys->delay_frames)
+            sys->delay_pos = 0;
+    }
+}
+
+static void UpdateStats(filter_t *filter)
+{
+    filter_sys_t *sys = filter->p_sys;
+    vlc_object_t *parent = filter->obj.parent;
+    const ebur128_t *meter = sys->meter;
+
+    var_SetFloat(parent, "loudness-momentary", ebur128_Momentary(meter));
+    var_SetFloat(parent, "loudness-short-term", ebur128_ShortTerm(meter));
+    var_SetFloat(parent, "loudness-integrated", ebur128_Integrated(meter));
+    var_SetFloat(parent, "loudness-range", ebur128_Range(meter));
+    var_SetFloat(parent, "loudness-true-peak", ebur128_TruePeak(meter));
+    var_SetFloat(parent, "loudness-gain", sys->normalize ? sys->gain_db : 0.f);
+}
+
+static block_t *Process(filter_t *filter, block_t *block)
+{
+    filter_sys_t *sys = filter->p_sys;
+    float *spl = (float *)block->p_buffer;
+    float peaks[CHUNK];
+
+    for (size_t done = 0; done < block->i_nb_samples;)
+    {
+        const size_t n = __MIN(block->i_nb_samples - done, CHUNK);
+
+        if (sys->normalize)
+        {
+            ebur128_Process(sys->meter, spl, n, peaks);
+            Normalize(sys, spl, peaks, n);
+        }
+        else
+            ebur128_Process(sys->meter, spl, n, NULL);
+
+        spl += n * sys->channels;
+        done += n;
+    }
+
+    if (sys->normalize)
+    {
+        if (block->i_pts > VLC_TS_INVALID)
+        {
+            block->i_pts -= sys->latency;
+            sys->end = block->i_pts + block->i_length;
+        }
+        if (block->i_dts > VLC_TS_INVALID)
+            block->i_dts -= sys->latency;
+    }
+
+    if (sys->stats_left > block->i_nb_samples)
+        sys->stats_left -= block->i_nb_samples;
+    else
+    {
+        sys->stats_left = sys->rate * STATS_PERIOD / CLOCK_FREQ;
+        UpdateStats(filter);
+    }
+    return block;
+}
+
+static block_t *Drain(filter_t *filter)
+{
+    filter_sys_t *sys = filter->p_sys;
+
+    if (sys->end == VLC_TS_INVALID)
+        return NULL;
+
+    /* Push the delayed samples out with silence, no peak is coming */
+    const size_t frames = sys->delay_frames;
+    block_t *block = filter_NewAudioBuffer(filter,
+                                     frames * sys->channels * sizeof (float));
+    if (likely(block != NULL))
+    {
+        static const float peaks[CHUNK];
+        float *spl = (float *)block->p_buffer;
+
+        memset(spl, 0, block->i_buffer);
+        for (size_t done = 0; done < frames;)
+        {
+            const size_t n = __MIN(frames - done, CHUNK);
+
+            Normalize(sys, spl, peaks, n);
+            spl += n * sys->channels;
+            done += n;
+        }
+        block->i_nb_samples = frames;
+        block->i_pts = block->i_dts = sys->end;
+        block->i_length = sys->latency;
+    }
+    ResetLimiter(sys);
+    return block;
+}
+
+static void Flush(filter_t *filter)
+{
+    filter_sys_t *sys = filter->p_sys;
+
+    ebur128_Flush(sys->meter);
+    if (sys->normalize)
+        ResetLimiter(sys);
+}
+
+static void Release(filter_sys_t *sys)
+{
+    ebur128_Delete(sys->meter);
+    free(sys->delay);
+    free(sys->min_value);
+    free(sys->min_time);
+    free(sys->box);
+    free(sys);
+}
+
+static int Open(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    audio_format_t *fmt = &filter->fmt_in.audio;
+    const unsigned channels = aout_FormatNbChannels(fmt);
+
+    if (channels == 0 || fmt->i_rate == 0)
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = calloc(1, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    float weights[AOUT_CHAN_MAX];
+
+    GetWeights(fmt, weights);
+    sys->meter = ebur128_New(fmt->i_rate, channels, weights);
+    if (sys->meter == NULL)
+    {
+        free(sys);
+        return VLC_EGENERIC;
+    }
+
+    sys->channels = channels;
+    sys->rate = fmt->i_rate;
+    sys->normalize = var_InheritBool(obj, "loudness-normalize");
+    sys->target = var_InheritFloat(obj, "loudness-target");
+    sys->max_gain = var_InheritFloat(obj, "loudness-max-gain");
+    sys->ceiling = powf(10.f, var_InheritFloat(obj, "loudness-ceiling") / 20.f);
+
+    if (sys->normalize)
+    {
+        sys->window = __MAX(fmt->i_rate * LOOKAHEAD / CLOCK_FREQ, 1);
+        sys->delay_frames = sys->window - 1 + EBUR128_PEAK_DELAY;
+        sys->delay = vlc_alloc(sys->delay_frames * channels, sizeof (float));
+        sys->min_value = vlc_alloc(sys->window, sizeof (float));
+        sys->min_time = vlc_alloc(sys->window, sizeof (uint64_t));
+        sys->box = vlc_alloc(sys->window, sizeof (float));
+        if (unlikely(sys->delay == NULL || sys->min_value == NULL
+                  || sys->min_time == NULL || sys->box == NULL))
+        {
+            Release(sys);
+            return VLC_ENOMEM;
+        }
+        sys->release_coeff = 1.f - expf(-(float)CLOCK_FREQ
+                                        / (RELEASE * fmt->i_rate));
+        sys->latency = CLOCK_FREQ * sys->delay_frames / fmt->i_rate;
+        ResetLimiter(sys);
+
+        msg_Dbg(filter, "normalizing to %.1f LUFS, %.1f dBTP, %u ms latency",
+                sys->target, 20.f * log10f(sys->ceiling),
+                sys->delay_frames * 1000 / fmt->i_rate);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(stats_names); i++)
+    {
+        var_Create(obj->obj.parent, stats_names[i], VLC_VAR_FLOAT);
+        var_SetFloat(obj->obj.parent, stats_names[i], -INFINITY);
+    }
+
+    filter->p_sys = sys;
+    fmt->i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare(fmt);
+    filter->fmt_out.audio = *fmt;
+    filter->pf_audio_filter = Process;
+    if (sys->normalize)
+        filter->pf_audio_drain = Drain;
+    filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    for (size_t i = 0; i < ARRAY_SIZE(stats_names); i++)
+        var_Destroy(obj->obj.parent, stats_names[i]);
+    Release(filter->p_sys);
+}
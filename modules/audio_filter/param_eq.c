@@ -37,16 +37,15 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
+#include "biquad.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
-static void CalcPeakEQCoeffs( float, float, float, float, float * );
-static void CalcShelfEQCoeffs( float, float, float, int, float, float * );
-static void ProcessEQ( const float *, float *, float *, unsigned, unsigned,
-                       const float *, unsigned );
 static block_t *DoWork( filter_t *, block_t * );
+static void Flush( filter_t * );
 
 vlc_module_begin ()
     set_description( N_("Parametric Equalizer") )
@@ -91,10 +90,8 @@ struct filter_sys_t
     float   f_f2, f_Q2, f_gain2;
     float   f_f3, f_Q3, f_gain3;
     float   f_highf, f_highgain;
-    /* Filter computed coeffs */
-    float   coeffs[5*5];
-    /* State */
-    float  *p_state;
+    /* Filters */
+    biquad_t *p_eq;
 };
 
 
@@ -107,15 +104,24 @@ static int Open( vlc_object_t *p_this )
 {
     filter_t     *p_filter = (filter_t *)p_this;
     unsigned     i_samplerate;
+    float        coeffs[5];
 
     /* Allocate structure */
     filter_sys_t *p_sys = p_filter->p_sys = malloc( sizeof( *p_sys ) );
     if( !p_sys )
         return VLC_EGENERIC;
 
+    p_sys->p_eq = biquad_New( p_filter->fmt_in.audio.i_channels, 5 );
+    if( !p_sys->p_eq )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_flush = Flush;
 
     p_sys->f_lowf = var_InheritFloat( p_this, "param-eq-lowf");
     p_sys->f_lowgain = var_InheritFloat( p_this, "param-eq-lowgain");
@@ -136,18 +142,21 @@ static int Open( vlc_object_t *p_this )
  
 
     i_samplerate = p_filter->fmt_in.audio.i_rate;
-    CalcPeakEQCoeffs(p_sys->f_f1, p_sys->f_Q1, p_sys->f_gain1,
-                     i_samplerate, p_sys->coeffs+0*5);
-    CalcPeakEQCoeffs(p_sys->f_f2, p_sys->f_Q2, p_sys->f_gain2,
-                     i_samplerate, p_sys->coeffs+1*5);
-    CalcPeakEQCoeffs(p_sys->f_f3, p_sys->f_Q3, p_sys->f_gain3,
-                     i_samplerate, p_sys->coeffs+2*5);
-    CalcShelfEQCoeffs(p_sys->f_lowf, 1, p_sys->f_lowgain, 0,
-                      i_samplerate, p_sys->coeffs+3*5);
-    CalcShelfEQCoeffs(p_sys->f_highf, 1, p_sys->f_highgain, 0,
-                      i_samplerate, p_sys->coeffs+4*5);
-    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
-                                     sizeof(float) );
+    biquad_PeakCoeffs( p_sys->f_f1, p_sys->f_Q1, p_sys->f_gain1,
+                       i_samplerate, coeffs );
+    biquad_Set( p_sys->p_eq, 0, coeffs );
+    biquad_PeakCoeffs( p_sys->f_f2, p_sys->f_Q2, p_sys->f_gain2,
+                       i_samplerate, coeffs );
+    biquad_Set( p_sys->p_eq, 1, coeffs );
+    biquad_PeakCoeffs( p_sys->f_f3, p_sys->f_Q3, p_sys->f_gain3,
+                       i_samplerate, coeffs );
+    biquad_Set( p_sys->p_eq, 2, coeffs );
+    biquad_ShelfCoeffs( p_sys->f_lowf, 1, p_sys->f_lowgain, 0,
+                        i_samplerate, coeffs );
+    biquad_Set( p_sys->p_eq, 3, coeffs );
+    biquad_ShelfCoeffs( p_sys->f_highf, 1, p_sys->f_highgain, 0,
+                        i_samplerate, coeffs );
+    biquad_Set( p_sys->p_eq, 4, coeffs );
 
     return VLC_SUCCESS;
 }
@@ -155,7 +164,7 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    free( p_filter->p_sys->p_state );
+    biquad_Delete( p_filter->p_sys->p_eq );
     free( p_filter->p_sys );
 }
 
@@ -166,157 +175,12 @@ static void Close( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
-               p_filter->p_sys->p_state,
-               p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
-               p_filter->p_sys->coeffs, 5 );
+    biquad_Process( p_filter->p_sys->p_eq, (float*)p_in_buf->p_buffer,
+                    (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples );
     return p_in_buf;
 }
 
-/*
- * Calculate direct form IIR coefficients for peaking EQ
- * coeffs[0] = b0
- * coeffs[1] = b1
- * coeffs[2] = b2
- * coeffs[3] = a1
- * coeffs[4] = a2
- *
- * Equations taken from RBJ audio EQ cookbook
- * (http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt)
- */
-static void CalcPeakEQCoeffs( float f0, float Q, float gainDB, float Fs,
-                              float *coeffs )
+static void Flush( filter_t *p_filter )
 {
-    float A;
-    float w0;
-    float alpha;
-    float b0, b1, b2;
-    float a0, a1, a2;
-
-    // Provide sane limits to avoid overflow
-    if (Q < 0.1f) Q = 0.1f;
-    if (Q > 100) Q = 100;
-    if (f0 > Fs/2*0.95f) f0 = Fs/2*0.95f;
-    if (gainDB < -40) gainDB = -40;
-    if (gainDB > 40) gainDB = 40;
- 
-    A = powf(10, gainDB/40);
-    w0 = 2*((float)M_PI)*f0/Fs;
-    alpha = sinf(w0)/(2*Q);
- 
-    b0 = 1 + alpha*A;
-    b1 = -2*cosf(w0);
-    b2 = 1 - alpha*A;
-    a0 = 1 + alpha/A;
-    a1 = -2*cosf(w0);
-    a2 = 1 - alpha/A;
- 
-    // Store values to coeffs and normalize by 1/a0
-    coeffs[0] = b0/a0;
-    coeffs[1] = b1/a0;
-    coeffs[2] = b2/a0;
-    coeffs[3] = a1/a0;
-    coeffs[4] = a2/a0;
+    biquad_Reset( p_filter->p_sys->p_eq );
 }
-
-/*
- * Calculate direct form IIR coefficients for low/high shelf EQ
- * coeffs[0] = b0
- * coeffs[1] = b1
- * coeffs[2] = b2
- * coeffs[3] = a1
- * coeffs[4] = a2
- *
- * Equations taken from RBJ audio EQ cookbook
- * (http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt)
- */
-static void CalcShelfEQCoeffs( float f0, float slope, float gainDB, int high,
-                               float Fs, float *coeffs )
-{
-    float A;
-    float w0;
-    float alpha;
-    float b0, b1, b2;
-    float a0, a1, a2;
-
-    // Provide sane limits to avoid overflow
-    if (f0 > Fs/2*0.95f) f0 = Fs/2*0.95f;
-    if (gainDB < -40) gainDB = -40;
-    if (gainDB > 40) gainDB = 40;
-
-    A = powf(10, gainDB/40);
-    w0 = 2*3.141593f*f0/Fs;
-    alpha = sinf(w0)/2 * sqrtf( (A + 1/A)*(1/slope - 1) + 2 );
-
-    if (high)
-    {
-        b0 =    A*( (A+1) + (A-1)*cosf(w0) + 2*sqrtf(A)*alpha );
-        b1 = -2*A*( (A-1) + (A+1)*cosf(w0) );
-        b2 =    A*( (A+1) + (A-1)*cosf(w0) - 2*sqrtf(A)*alpha );
-        a0 =        (A+1) - (A-1)*cosf(w0) + 2*sqrtf(A)*alpha;
-        a1 =    2*( (A-1) - (A+1)*cosf(w0) );
-        a2 =        (A+1) - (A-1)*cosf(w0) - 2*sqrtf(A)*alpha;
-    }
-    else
-    {
-        b0 =    A*( (A+1) - (A-1)*cosf(w0) + 2*sqrtf(A)*alpha );
-        b1 =  2*A*( (A-1) - (A+1)*cosf(w0));
-        b2 =    A*( (A+1) - (A-1)*cosf(w0) - 2*sqrtf(A)*alpha );
-        a0 =        (A+1) + (A-1)*cosf(w0) + 2*sqrtf(A)*alpha;
-        a1 =   -2*( (A-1) + (A+1)*cosf(w0));
-        a2 =        (A+1) + (A-1)*cosf(w0) - 2*sqrtf(A)*alpha;
-    }
-    // Store values to coeffs and normalize by 1/a0
-    coeffs[0] = b0/a0;
-    coeffs[1] = b1/a0;
-    coeffs[2] = b2/a0;
-    coeffs[3] = a1/a0;
-    coeffs[4] = a2/a0;
-}
-
-/*
-  src is assumed to be interleaved
-  dest is assumed to be interleaved
-  size of state is 4*channels*eqCount
-  samples is not premultiplied by channels
-  size of coeffs is 5*eqCount
-*/
-void ProcessEQ( const float *src, float *dest, float *state,
-                unsigned channels, unsigned samples, const float *coeffs,
-                unsigned eqCount )
-{
-    unsigned i, chn, eq;
-    float   b0, b1, b2, a1, a2;
-    float   x, y = 0;
-    const float *src1 = src;
-    float *dest1 = dest;
-
-    for (i = 0; i < samples; i++)
-    {
-        float *state1 = state;
-        for (chn = 0; chn < channels; chn++)
-        {
-            const float *coeffs1 = coeffs;
-            x = *src1++;
-            /* Direct form 1 IIRs */
-            for (eq = 0; eq < eqCount; eq++)
-            {
-                b0 = coeffs1[0];
-                b1 = coeffs1[1];
-                b2 = coeffs1[2];
-                a1 = coeffs1[3];
-                a2 = coeffs1[4];
-                coeffs1 += 5;
-                y = x*b0 + state1[0]*b1 + state1[1]*b2 - state1[2]*a1 - state1[3]*a2;
-                state1[1] = state1[0];
-                state1[0] = x;
-                state1[3] = state1[2];
-                state1[2] = y;
-                x = y;
-                state1 += 4;
-            }
-            *dest1++ = y;
-        }
-    }
-}
-
@@ -1,7 +1,7 @@
 /*****************************************************************************
  * bandlimited.c : band-limited interpolation resampler
  *****************************************************************************
- * Copyright (C) 2002, 2006 VLC authors and VideoLAN
+ * Copyright (C) 2002, 2006, 2018 VLC authors and VideoLAN
  * $Id$
  *
  * Authors: Gildas Bazin <gbazin@netcourrier.com>
@@ -24,12 +24,16 @@
 /*****************************************************************************
  * Preamble:
  *
- * This implementation of the band-limited interpolationis based on the
+ * This implementation of the band-limited interpolation is based on the
  * following paper:
  * http://ccrma-www.stanford.edu/~jos/resample/resample.html
  *
- * It uses a Kaiser-windowed sinc-function low-pass filter and the width of the
- * filter is 13 samples.
+ * The Kaiser-windowed sinc low-pass filter is precomputed as a bank of
+ * BL_PHASES polyphase filters of BL_TAPS taps. The position of each output
+ * sample within the input is kept in 32.32 fixed point, so the ratio can be
+ * changed on every buffer (the audio output does so to correct the drift),
+ * and the coefficients for a position are linearly interpolated between the
+ * two closest phases.
  *
  *****************************************************************************/
 
@@ -37,44 +41,77 @@
 # include "config.h"
 #endif
 
+#include <math.h>
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
 
-#include <assert.h>
-
-#include "bandlimited.h"
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <xmmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 
 /* audio filter */
-static int  OpenFilter ( vlc_object_t * );
+static int  OpenConverter( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 static block_t *Resample( filter_t *, block_t * );
-
-static void ResampleFloat( filter_t *p_filter,
-                           block_t **pp_out_buf,  size_t *pi_out,
-                           float **pp_in,
-                           int i_in, int i_in_end,
-                           double d_factor, bool b_factor_old,
-                           int i_nb_channels, int i_bytes_per_frame );
+static block_t *Drain( filter_t * );
+static void Flush( filter_t * );
+
+/* Filter length, in input samples; a multiple of 8 for the vector kernels */
+#define BL_TAPS       48
+#define BL_HALF       (BL_TAPS / 2)
+/* Number of filter phases between two input samples (power of 2) */
+#define BL_PHASES_LOG 7
+#define BL_PHASES     (1 << BL_PHASES_LOG)
+#define BL_FRAC_SHIFT (32 - BL_PHASES_LOG)
+/* Kaiser window shape, about 80 dB of stop band attenuation */
+#define BL_BETA       8.
+/* Cut-off frequency, relative to the lowest Nyquist frequency */
+#define BL_CUTOFF     .90
+/* Relative cut-off change for which the filter bank is computed again */
+#define BL_CUTOFF_TOLERANCE .02
+
+#define BL_ONE        (UINT64_C(1) << 32)
+
+typedef void (*bl_filter_fn)( float *restrict out, const float *in,
+                              size_t stride, unsigned channels,
+                              const float *bank, const float *delta,
+                              float w );
 
 /*****************************************************************************
  * Local structures
  *****************************************************************************/
 struct filter_sys_t
 {
-    int32_t *p_buf;                        /* this filter introduces a delay */
-    size_t i_buf_size;
-
-    double d_old_factor;
-    size_t i_old_wing;
-
-    unsigned int i_remainder;                /* remainder of previous sample */
+    /* Polyphase filter bank: for each phase, BL_TAPS coefficients and their
+     * differences with the next phase */
+    float *p_bank;
+    float *p_delta;
+    double d_cutoff;
+    bl_filter_fn pf_filter;
+
+    /* Planar input history, this filter introduces a delay */
+    float *p_hist;
+    size_t i_hist_size;                    /* per channel, in samples */
+    size_t i_hist;                         /* per channel, in samples */
+
+    uint64_t i_pos;              /* next output position within the history */
     bool b_first;
 
     date_t end_date;
@@ -88,209 +125,424 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_AUDIO_RESAMPLER )
     set_description( N_("Audio filter for band-limited interpolation resampling") )
     set_capability( "audio converter", 20 )
-    set_callbacks( OpenFilter, CloseFilter )
+    set_callbacks( OpenConverter, CloseFilter )
 
     add_submodule()
     set_capability( "audio resampler", 20 )
-    set_callbacks( OpenFilter, CloseFilter )
+    set_callbacks( OpenResampler, CloseFilter )
 vlc_module_end ()
 
 /*****************************************************************************
- * Resample: convert a buffer
+ * Filter bank
  *****************************************************************************/
-static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
+/* Zeroth order modified Bessel function of the first kind */
+static double BesselI0( double x )
 {
-    if( !p_in_buf || !p_in_buf->i_nb_samples )
+    double sum = 1., term = 1.;
+
+    for( int k = 1; k < 64 && term > sum * 1e-12; k++ )
     {
-        if( p_in_buf )
-            block_Release( p_in_buf );
-        return NULL;
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
     }
+    return sum;
+}
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-    unsigned int i_out_rate = p_filter->fmt_out.audio.i_rate;
-    int i_nb_channels = p_filter->fmt_in.audio.i_channels;
+/* Impulse response at x input samples from the center */
+static double Impulse( double x, double cutoff )
+{
+    const double r = x / BL_HALF;
 
-    /* Check if we really need to run the resampler */
-    if( i_out_rate == p_filter->fmt_in.audio.i_rate )
+    if( r <= -1. || r >= 1. )
+        return 0.;
+
+    double sinc = cutoff;
+    if( x != 0. )
+        sinc = sin( M_PI * cutoff * x ) / (M_PI * x);
+    return sinc * BesselI0( BL_BETA * sqrt( 1. - r * r ) ) / BesselI0( BL_BETA );
+}
+
+/* Computes the coefficients of a phase, normalized to unity gain */
+static void ComputePhase( float *coefs, double frac, double cutoff )
+{
+    double sum = 0.;
+    double h[BL_TAPS];
+
+    /* Tap k is applied to the input sample at BL_HALF - 1 - k + frac
+     * samples from the output position */
+    for( unsigned k = 0; k < BL_TAPS; k++ )
     {
-        if( !(p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) &&
-            p_sys->i_old_wing )
-        {
-            /* output the whole thing with the samples from last time */
-            p_in_buf = block_Realloc( p_in_buf,
-                p_sys->i_old_wing * p_filter->fmt_in.audio.i_bytes_per_frame,
-                p_in_buf->i_buffer );
-            if( !p_in_buf )
-                return NULL;
-            memcpy( p_in_buf->p_buffer, p_sys->p_buf +
-                    i_nb_channels * p_sys->i_old_wing,
-                    p_sys->i_old_wing *
-                    p_filter->fmt_in.audio.i_bytes_per_frame );
-
-            p_in_buf->i_nb_samples += p_sys->i_old_wing;
-
-            p_in_buf->i_pts = date_Get( &p_sys->end_date );
-            p_in_buf->i_length =
-                date_Increment( &p_sys->end_date,
-                                p_in_buf->i_nb_samples ) - p_in_buf->i_pts;
-        }
-        p_sys->i_old_wing = 0;
-        p_sys->b_first = true;
-        return p_in_buf;
+        h[k] = Impulse( BL_HALF - 1 - (double)k + frac, cutoff );
+        sum += h[k];
     }
+    for( unsigned k = 0; k < BL_TAPS; k++ )
+        coefs[k] = h[k] / sum;
+}
+
+static void ComputeBank( filter_sys_t *p_sys, double cutoff )
+{
+    float next[BL_TAPS];
 
-    unsigned i_bytes_per_frame = p_filter->fmt_out.audio.i_channels *
-                                 p_filter->fmt_out.audio.i_bitspersample / 8;
-    size_t i_out_size = i_bytes_per_frame * ( 1 + ( p_in_buf->i_nb_samples *
-              p_filter->fmt_out.audio.i_rate / p_filter->fmt_in.audio.i_rate) )
-            + p_filter->p_sys->i_buf_size;
-    block_t *p_out_buf = block_Alloc( i_out_size );
-    if( !p_out_buf )
+    ComputePhase( p_sys->p_bank, 0., cutoff );
+    for( unsigned p = 0; p < BL_PHASES; p++ )
     {
-        block_Release( p_in_buf );
-        return NULL;
+        float *coefs = p_sys->p_bank + p * BL_TAPS;
+        float *delta = p_sys->p_delta + p * BL_TAPS;
+
+        ComputePhase( next, (double)(p + 1) / BL_PHASES, cutoff );
+        for( unsigned k = 0; k < BL_TAPS; k++ )
+            delta[k] = next[k] - coefs[k];
+        if( p + 1 < BL_PHASES )
+            memcpy( coefs + BL_TAPS, next, sizeof (next) );
     }
+    p_sys->d_cutoff = cutoff;
+}
 
-    if( (p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) || p_sys->b_first )
+/*****************************************************************************
+ * Filter kernels: computes one output frame from BL_TAPS input samples per
+ * channel, with the coefficients bank + w * delta
+ *****************************************************************************/
+static void Filter_C( float *restrict out, const float *in, size_t stride,
+                      unsigned channels, const float *bank,
+                      const float *delta, float w )
+{
+    float coefs[BL_TAPS];
+
+    for( unsigned k = 0; k < BL_TAPS; k++ )
+        coefs[k] = bank[k] + w * delta[k];
+
+    for( unsigned c = 0; c < channels; c++, in += stride )
     {
-        /* Continuity in sound samples has been broken, we'd better reset
-         * everything. */
-        p_out_buf->i_flags |= BLOCK_FLAG_DISCONTINUITY;
-        p_sys->i_remainder = 0;
-        date_Init( &p_sys->end_date, i_out_rate, 1 );
-        date_Set( &p_sys->end_date, p_in_buf->i_pts );
-        p_sys->d_old_factor = 1;
-        p_sys->i_old_wing   = 0;
-        p_sys->b_first = false;
+        float sum = 0.f;
+
+        for( unsigned k = 0; k < BL_TAPS; k++ )
+            sum += coefs[k] * in[k];
+        out[c] = sum;
     }
+}
 
-    size_t i_in_nb = p_in_buf->i_nb_samples;
-    size_t i_in, i_out = 0;
-    double d_factor, d_scale_factor, d_old_scale_factor;
-    size_t i_filter_wing;
+#if defined(HAVE_SSE2_INTRINSICS)
+VLC_SSE
+static void Filter_SSE( float *restrict out, const float *in, size_t stride,
+                        unsigned channels, const float *bank,
+                        const float *delta, float w )
+{
+    __m128 coefs[BL_TAPS / 4];
+    const __m128 vw = _mm_set1_ps( w );
 
-#if 0
-    msg_Err( p_filter, "old rate: %i, old factor: %f, old wing: %i, i_in: %i",
-             p_sys->i_old_rate, p_sys->d_old_factor,
-             p_sys->i_old_wing, i_in_nb );
+    for( unsigned k = 0; k < BL_TAPS / 4; k++ )
+        coefs[k] = _mm_add_ps( _mm_load_ps( bank + 4 * k ),
+                               _mm_mul_ps( vw, _mm_load_ps( delta + 4 * k ) ) );
+
+    for( unsigned c = 0; c < channels; c++, in += stride )
+    {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+
+        for( unsigned k = 0; k < BL_TAPS / 4; k += 2 )
+        {
+            acc0 = _mm_add_ps( acc0, _mm_mul_ps( coefs[k],
+                                   _mm_loadu_ps( in + 4 * k ) ) );
+            acc1 = _mm_add_ps( acc1, _mm_mul_ps( coefs[k + 1],
+                                   _mm_loadu_ps( in + 4 * k + 4 ) ) );
+        }
+        acc0 = _mm_add_ps( acc0, acc1 );
+        acc0 = _mm_add_ps( acc0, _mm_movehl_ps( acc0, acc0 ) );
+        acc0 = _mm_add_ss( acc0, _mm_shuffle_ps( acc0, acc0, 1 ) );
+        _mm_store_ss( out + c, acc0 );
+    }
+}
 #endif
 
-    /* Same format in and out... */
-    assert( p_filter->fmt_in.audio.i_bytes_per_frame == i_bytes_per_frame );
-
-    /* Prepare the source buffer */
-    if( p_sys->i_old_wing )
-    {   /* Copy all our samples in p_in_buf */
-        /* Normally, there should be enough room for the old wing in the
-         * buffer head room. Otherwise, we need to copy memory anyway. */
-        p_in_buf = block_Realloc( p_in_buf,
-                                  p_sys->i_old_wing * 2 * i_bytes_per_frame,
-                                  p_in_buf->i_buffer );
-        if( unlikely(p_in_buf == NULL) )
-            return NULL;
-        memcpy( p_in_buf->p_buffer, p_sys->p_buf,
-                p_sys->i_old_wing * 2 * i_bytes_per_frame );
+#if defined(HAVE_AVX2_INTRINSICS)
+VLC_AVX2
+static void Filter_AVX2( float *restrict out, const float *in, size_t stride,
+                         unsigned channels, const float *bank,
+                         const float *delta, float w )
+{
+    __m256 coefs[BL_TAPS / 8];
+    const __m256 vw = _mm256_set1_ps( w );
+
+    for( unsigned k = 0; k < BL_TAPS / 8; k++ )
+        coefs[k] = _mm256_add_ps( _mm256_load_ps( bank + 8 * k ),
+                        _mm256_mul_ps( vw, _mm256_load_ps( delta + 8 * k ) ) );
+
+    for( unsigned c = 0; c < channels; c++, in += stride )
+    {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+
+        for( unsigned k = 0; k < BL_TAPS / 8; k += 2 )
+        {
+            acc0 = _mm256_add_ps( acc0, _mm256_mul_ps( coefs[k],
+                                      _mm256_loadu_ps( in + 8 * k ) ) );
+            acc1 = _mm256_add_ps( acc1, _mm256_mul_ps( coefs[k + 1],
+                                      _mm256_loadu_ps( in + 8 * k + 8 ) ) );
+        }
+        acc0 = _mm256_add_ps( acc0, acc1 );
+
+        __m128 sum = _mm_add_ps( _mm256_castps256_ps128( acc0 ),
+                                 _mm256_extractf128_ps( acc0, 1 ) );
+        sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+        sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+        _mm_store_ss( out + c, sum );
     }
-    i_in_nb += (p_sys->i_old_wing * 2);
-    float *p_in = (float *)p_in_buf->p_buffer;
-    const float *p_in_orig = p_in;
-
-    /* Make sure the output buffer is reset */
-    memset( p_out_buf->p_buffer, 0, p_out_buf->i_buffer );
-
-    /* Calculate the new length of the filter wing */
-    d_factor = (double)i_out_rate / p_filter->fmt_in.audio.i_rate;
-    i_filter_wing = ((SMALL_FILTER_NMULT+1)/2.0) * __MAX(1.0,1.0/d_factor) + 1;
-
-    /* Account for increased filter gain when using factors less than 1 */
-    d_old_scale_factor = SMALL_FILTER_SCALE *
-        p_sys->d_old_factor + 0.5;
-    d_scale_factor = SMALL_FILTER_SCALE * d_factor + 0.5;
-
-    /* Apply the old rate until we have enough samples for the new one */
-    i_in = p_sys->i_old_wing;
-    p_in += p_sys->i_old_wing * i_nb_channels;
-
-    size_t i_old_in_end = 0;
-    if( p_sys->i_old_wing <= i_in_nb )
-        i_old_in_end = __MIN( i_filter_wing, i_in_nb - p_sys->i_old_wing );
-
-    ResampleFloat( p_filter,
-                   &p_out_buf, &i_out, &p_in,
-                   i_in, i_old_in_end,
-                   p_sys->d_old_factor, true,
-                   i_nb_channels, i_bytes_per_frame );
-    i_in = __MAX( i_in, i_old_in_end );
-
-    /* Apply the new rate for the rest of the samples */
-    if( i_in < i_in_nb - i_filter_wing )
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+static void Filter_NEON( float *restrict out, const float *in, size_t stride,
+                         unsigned channels, const float *bank,
+                         const float *delta, float w )
+{
+    float32x4_t coefs[BL_TAPS / 4];
+
+    for( unsigned k = 0; k < BL_TAPS / 4; k++ )
+        coefs[k] = vfmaq_n_f32( vld1q_f32( bank + 4 * k ),
+                                vld1q_f32( delta + 4 * k ), w );
+
+    for( unsigned c = 0; c < channels; c++, in += stride )
     {
-        p_sys->d_old_factor = d_factor;
-        p_sys->i_old_wing   = i_filter_wing;
+        float32x4_t acc0 = vdupq_n_f32( 0.f ), acc1 = vdupq_n_f32( 0.f );
+
+        for( unsigned k = 0; k < BL_TAPS / 4; k += 2 )
+        {
+            acc0 = vfmaq_f32( acc0, coefs[k], vld1q_f32( in + 4 * k ) );
+            acc1 = vfmaq_f32( acc1, coefs[k + 1], vld1q_f32( in + 4 * k + 4 ) );
+        }
+        out[c] = vaddvq_f32( vaddq_f32( acc0, acc1 ) );
     }
-    if( p_out_buf )
+}
+#endif
+
+static bl_filter_fn GetFilter( void )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX2() )
+        return Filter_AVX2;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE() )
+        return Filter_SSE;
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    if( vlc_CPU_ARM64_NEON() )
+        return Filter_NEON;
+#endif
+    return Filter_C;
+}
+
+/*****************************************************************************
+ * Resampling
+ *****************************************************************************/
+/* Empties the history, so that the next output is the next input sample */
+static void Reset( filter_sys_t *p_sys, unsigned i_nb_channels )
+{
+    for( unsigned c = 0; c < i_nb_channels; c++ )
+        memset( p_sys->p_hist + c * p_sys->i_hist_size, 0,
+                (BL_HALF - 1) * sizeof (float) );
+    p_sys->i_hist = BL_HALF - 1;
+    p_sys->i_pos = (uint64_t)(BL_HALF - 1) << 32;
+}
+
+/* Appends interleaved samples (or silence if p_in is NULL) to the history */
+static int Append( filter_sys_t *p_sys, unsigned i_nb_channels,
+                   const float *p_in, size_t i_in )
+{
+    if( p_sys->i_hist + i_in > p_sys->i_hist_size )
     {
-        ResampleFloat( p_filter,
-                       &p_out_buf, &i_out, &p_in,
-                       i_in, i_in_nb - i_filter_wing,
-                       d_factor, false,
-                       i_nb_channels, i_bytes_per_frame );
-
-        /* Finalize aout buffer */
-        p_out_buf->i_nb_samples = i_out;
-        p_out_buf->i_dts =
-        p_out_buf->i_pts = date_Get( &p_sys->end_date );
-        p_out_buf->i_length = date_Increment( &p_sys->end_date,
-                                      p_out_buf->i_nb_samples ) - p_out_buf->i_pts;
-
-        p_out_buf->i_buffer = p_out_buf->i_nb_samples *
-            i_nb_channels * sizeof(int32_t);
+        size_t i_size = 2 * (p_sys->i_hist + i_in);
+        float *p_hist = malloc( i_size * i_nb_channels * sizeof (float) );
+        if( unlikely(p_hist == NULL) )
+            return VLC_ENOMEM;
+
+        for( unsigned c = 0; c < i_nb_channels && p_sys->i_hist > 0; c++ )
+            memcpy( p_hist + c * i_size,
+                    p_sys->p_hist + c * p_sys->i_hist_size,
+                    p_sys->i_hist * sizeof (float) );
+        free( p_sys->p_hist );
+        p_sys->p_hist = p_hist;
+        p_sys->i_hist_size = i_size;
     }
 
-    /* Buffer i_filter_wing * 2 samples for next time */
-    if( p_sys->i_old_wing )
+    for( unsigned c = 0; c < i_nb_channels; c++ )
     {
-        size_t newsize = p_sys->i_old_wing * 2 * i_bytes_per_frame;
-        if( newsize > p_sys->i_buf_size )
+        float *p_dst = p_sys->p_hist + c * p_sys->i_hist_size + p_sys->i_hist;
+
+        if( p_in == NULL )
+            memset( p_dst, 0, i_in * sizeof (float) );
+        else
+            for( size_t i = 0; i < i_in; i++ )
+                p_dst[i] = p_in[i * i_nb_channels + c];
+    }
+    p_sys->i_hist += i_in;
+    return VLC_SUCCESS;
+}
+
+/* Outputs all the frames for which the history holds enough samples */
+static block_t *Process( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_nb_channels = p_filter->fmt_in.audio.i_channels;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const uint64_t i_step = ((uint64_t)i_in_rate << 32) / i_out_rate;
+
+    /* The audio output changes the input rate to correct the drift */
+    const double d_cutoff = BL_CUTOFF * __MIN( 1., (double)i_out_rate / i_in_rate );
+    if( fabs( d_cutoff - p_sys->d_cutoff ) > BL_CUTOFF_TOLERANCE * d_cutoff )
+        ComputeBank( p_sys, d_cutoff );
+
+    /* Without resampling, copy the samples, but only once on a whole sample:
+     * dropping the fractional delay left by a drift correction would make
+     * the output jump */
+    const bool b_copy = i_step == BL_ONE && (p_sys->i_pos & (BL_ONE - 1)) == 0;
+
+    if( p_sys->i_hist <= BL_HALF )
+        return NULL;
+
+    const uint64_t i_end = (uint64_t)(p_sys->i_hist - BL_HALF) << 32;
+    if( p_sys->i_pos >= i_end )
+        return NULL;
+
+    const size_t i_out = (i_end - p_sys->i_pos + i_step - 1) / i_step;
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter,
+                               i_out * p_filter->fmt_out.audio.i_bytes_per_frame );
+    if( unlikely(p_out_buf == NULL) )
+        return NULL;
+
+    float *p_out = (float *)p_out_buf->p_buffer;
+    uint64_t i_pos = p_sys->i_pos;
+
+    for( size_t i = 0; i < i_out; i++, p_out += i_nb_channels )
+    {
+        const size_t i_index = i_pos >> 32;
+
+        if( b_copy )
+        {
+            for( unsigned c = 0; c < i_nb_channels; c++ )
+                p_out[c] = p_sys->p_hist[c * p_sys->i_hist_size + i_index];
+        }
+        else
         {
-            free( p_sys->p_buf );
-            p_sys->p_buf = malloc( newsize );
-            if( p_sys->p_buf != NULL )
-                p_sys->i_buf_size = newsize;
-            else
-            {
-                p_sys->i_buf_size = p_sys->i_old_wing = 0; /* oops! */
-                block_Release( p_in_buf );
-                return p_out_buf;
-            }
+            const uint32_t i_frac = i_pos;
+            const unsigned i_phase = i_frac >> BL_FRAC_SHIFT;
+            const float w = (i_frac & ((1 << BL_FRAC_SHIFT) - 1))
+                          * (1.f / (1 << BL_FRAC_SHIFT));
+
+            p_sys->pf_filter( p_out,
+                              p_sys->p_hist + i_index - (BL_HALF - 1),
+                              p_sys->i_hist_size, i_nb_channels,
+                              p_sys->p_bank + i_phase * BL_TAPS,
+                              p_sys->p_delta + i_phase * BL_TAPS, w );
         }
-        memcpy( p_sys->p_buf,
-                p_in_orig + (i_in_nb - 2 * p_sys->i_old_wing) *
-                i_nb_channels, (2 * p_sys->i_old_wing) *
-                p_filter->fmt_in.audio.i_bytes_per_frame );
+        i_pos += i_step;
     }
 
-#if 0
-    msg_Err( p_filter, "p_out size: %i, nb bytes out: %i", p_out_buf->i_buffer,
-             i_out * p_filter->fmt_in.audio.i_bytes_per_frame );
-#endif
+    /* Drop the samples which are not needed anymore. Above a ratio of about
+     * BL_TAPS, the next position may be past the history: it is all dropped,
+     * and the position keeps the samples still to be skipped. */
+    const size_t i_drop = __MIN( (i_pos >> 32) - (BL_HALF - 1),
+                                 p_sys->i_hist );
+    for( unsigned c = 0; c < i_nb_channels; c++ )
+    {
+        float *p_hist = p_sys->p_hist + c * p_sys->i_hist_size;
+        memmove( p_hist, p_hist + i_drop,
+                 (p_sys->i_hist - i_drop) * sizeof (float) );
+    }
+    p_sys->i_hist -= i_drop;
+    p_sys->i_pos = i_pos - ((uint64_t)i_drop << 32);
+
+    p_out_buf->i_nb_samples = i_out;
+    p_out_buf->i_dts =
+    p_out_buf->i_pts = date_Get( &p_sys->end_date );
+    p_out_buf->i_length = date_Increment( &p_sys->end_date,
+                                  p_out_buf->i_nb_samples ) - p_out_buf->i_pts;
+    return p_out_buf;
+}
+
+/*****************************************************************************
+ * Resample: convert a buffer
+ *****************************************************************************/
+static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
+{
+    if( !p_in_buf || !p_in_buf->i_nb_samples )
+    {
+        if( p_in_buf )
+            block_Release( p_in_buf );
+        return NULL;
+    }
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_nb_channels = p_filter->fmt_in.audio.i_channels;
+    bool b_discontinuity = false;
+
+    if( (p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) || p_sys->b_first )
+    {
+        /* Continuity in sound samples has been broken, we'd better reset
+         * everything. */
+        Reset( p_sys, i_nb_channels );
+        date_Init( &p_sys->end_date, p_filter->fmt_out.audio.i_rate, 1 );
+        date_Set( &p_sys->end_date, p_in_buf->i_pts );
+        p_sys->b_first = false;
+        b_discontinuity = true;
+    }
 
+    int i_ret = Append( p_sys, i_nb_channels,
+                        (const float *)p_in_buf->p_buffer,
+                        p_in_buf->i_nb_samples );
     block_Release( p_in_buf );
+    if( unlikely(i_ret != VLC_SUCCESS) )
+        return NULL;
+
+    block_t *p_out_buf = Process( p_filter );
+    if( p_out_buf != NULL && b_discontinuity )
+        p_out_buf->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+    return p_out_buf;
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_first )
+        return NULL;
+
+    /* Push the last samples out of the filter */
+    if( Append( p_sys, p_filter->fmt_in.audio.i_channels, NULL, BL_HALF ) )
+        return NULL;
+
+    block_t *p_out_buf = Process( p_filter );
+    p_sys->b_first = true;
     return p_out_buf;
 }
 
+static void Flush( filter_t *p_filter )
+{
+    p_filter->p_sys->b_first = true;
+}
+
+/*****************************************************************************
+ * OpenConverter:
+ *****************************************************************************/
+static int OpenConverter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
 /*****************************************************************************
- * OpenFilter:
+ * OpenResampler: the input rate may be changed between buffers
  *****************************************************************************/
-static int OpenFilter( vlc_object_t *p_this )
+static int OpenResampler( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
     unsigned int i_out_rate  = p_filter->fmt_out.audio.i_rate;
 
-    if ( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate
-      || p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format
+    if ( p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format
       || p_filter->fmt_in.audio.i_channels != p_filter->fmt_out.audio.i_channels
       || p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 )
     {
@@ -302,12 +554,32 @@ static int OpenFilter( vlc_object_t *p_this )
     if( p_sys == NULL )
         return VLC_ENOMEM;
 
-    p_sys->p_buf = NULL;
-    p_sys->i_buf_size = 0;
+    /* The vector kernels load the coefficients from aligned memory */
+    p_sys->p_bank = aligned_alloc( 32, 2 * BL_PHASES * BL_TAPS * sizeof (float) );
+    if( p_sys->p_bank == NULL )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->p_delta = p_sys->p_bank + BL_PHASES * BL_TAPS;
+    ComputeBank( p_sys, BL_CUTOFF * __MIN( 1., (double)i_out_rate /
+                                           p_filter->fmt_in.audio.i_rate ) );
+    p_sys->pf_filter = GetFilter();
+
+    p_sys->p_hist = NULL;
+    p_sys->i_hist_size = 0;
+    p_sys->i_hist = 0;
+    if( Append( p_sys, p_filter->fmt_in.audio.i_channels, NULL, BL_HALF ) )
+    {
+        aligned_free( p_sys->p_bank );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
 
-    p_sys->i_old_wing = 0;
     p_sys->b_first = true;
     p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
 
     msg_Dbg( p_this, "%4.4s/%iKHz/%i->%4.4s/%iKHz/%i",
              (char *)&p_filter->fmt_in.i_codec,
@@ -329,218 +601,7 @@ static int OpenFilter( vlc_object_t *p_this )
 static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    free( p_filter->p_sys->p_buf );
+    aligned_free( p_filter->p_sys->p_bank );
+    free( p_filter->p_sys->p_hist );
     free( p_filter->p_sys );
 }
-
-static void FilterFloatUP( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                            float *p_out, uint32_t ui_remainder,
-                            uint32_t ui_output_rate, int16_t Inc, int i_nb_channels )
-{
-    const float *Hp, *Hdp, *End;
-    float t, temp;
-    uint32_t ui_linear_remainder;
-    int i;
-
-    Hp = &Imp[(ui_remainder<<Nhc)/ui_output_rate];
-    Hdp = &ImpD[(ui_remainder<<Nhc)/ui_output_rate];
-
-    End = &Imp[Nwing];
-
-    ui_linear_remainder = (ui_remainder<<Nhc) -
-                            (ui_remainder<<Nhc)/ui_output_rate*ui_output_rate;
-
-    if (Inc == 1)               /* If doing right wing...              */
-    {                           /* ...drop extra coeff, so when Ph is  */
-        End--;                  /*    0.5, we don't do too many mult's */
-        if (ui_remainder == 0)  /* If the phase is zero...           */
-        {                       /* ...then we've already skipped the */
-            Hp += Npc;          /*    first sample, so we must also  */
-            Hdp += Npc;         /*    skip ahead in Imp[] and ImpD[] */
-        }
-    }
-
-    while (Hp < End) {
-        t = *Hp;                /* Get filter coeff */
-                                /* t is now interp'd filter coeff */
-        t += *Hdp * ui_linear_remainder / ui_output_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
-        Hdp += Npc;             /* Filter coeff differences step */
-        Hp += Npc;              /* Filter coeff step */
-        p_in += (Inc * i_nb_channels); /* Input signal step */
-    }
-}
-
-static void FilterFloatUD( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                           float *p_out, uint32_t ui_remainder,
-                           uint32_t ui_output_rate, uint32_t ui_input_rate,
-                           int16_t Inc, int i_nb_channels )
-{
-    const float *Hp, *Hdp, *End;
-    float t, temp;
-    uint32_t ui_linear_remainder;
-    int i, ui_counter = 0;
-
-    Hp = Imp + (ui_remainder<<Nhc) / ui_input_rate;
-    Hdp = ImpD  + (ui_remainder<<Nhc) / ui_input_rate;
-
-    End = &Imp[Nwing];
-
-    if (Inc == 1)               /* If doing right wing...              */
-    {                           /* ...drop extra coeff, so when Ph is  */
-        End--;                  /*    0.5, we don't do too many mult's */
-        if (ui_remainder == 0)  /* If the phase is zero...           */
-        {                       /* ...then we've already skipped the */
-            Hp = Imp +          /* first sample, so we must also  */
-                  (ui_output_rate << Nhc) / ui_input_rate;
-            Hdp = ImpD +        /* skip ahead in Imp[] and ImpD[] */
-                  (ui_output_rate << Nhc) / ui_input_rate;
-            ui_counter++;
-        }
-    }
-
-    while (Hp < End) {
-        t = *Hp;                /* Get filter coeff */
-                                /* t is now interp'd filter coeff */
-        ui_linear_remainder =
-          ((ui_output_rate * ui_counter + ui_remainder)<< Nhc) -
-          ((ui_output_rate * ui_counter + ui_remainder)<< Nhc) /
-          ui_input_rate * ui_input_rate;
-        t += *Hdp * ui_linear_remainder / ui_input_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
-
-        ui_counter++;
-
-        /* Filter coeff step */
-        Hp = Imp + ((ui_output_rate * ui_counter + ui_remainder)<< Nhc)
-                    / ui_input_rate;
-        /* Filter coeff differences step */
-        Hdp = ImpD + ((ui_output_rate * ui_counter + ui_remainder)<< Nhc)
-                     / ui_input_rate;
-
-        p_in += (Inc * i_nb_channels); /* Input signal step */
-    }
-}
-
-static int ReallocBuffer( block_t **pp_out_buf,
-                          float **pp_out, size_t i_out,
-                          int i_nb_channels, int i_bytes_per_frame )
-{
-    if( i_out < (*pp_out_buf)->i_buffer/i_bytes_per_frame )
-        return VLC_SUCCESS;
-
-    /* It may happen when the wing size changes */
-    const unsigned i_extra_frame = 256;
-    *pp_out_buf = block_Realloc( *pp_out_buf, 0,
-                                 (*pp_out_buf)->i_buffer +
-                                    i_extra_frame * i_bytes_per_frame );
-    if( !*pp_out_buf )
-        return VLC_EGENERIC;
-
-    *pp_out = (float*)(*pp_out_buf)->p_buffer + i_out * i_nb_channels;
-    memset( *pp_out, 0, i_extra_frame * i_bytes_per_frame );
-    return VLC_SUCCESS;
-}
-
-static void ResampleFloat( filter_t *p_filter,
-                           block_t **pp_out_buf,  size_t *pi_out,
-                           float **pp_in,
-                           int i_in, int i_in_end,
-                           double d_factor, bool b_factor_old,
-                           int i_nb_channels, int i_bytes_per_frame )
-{
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    float *p_in = *pp_in;
-    size_t i_out = *pi_out;
-    float *p_out = (float*)(*pp_out_buf)->p_buffer + i_out * i_nb_channels;
-
-    for( ; i_in < i_in_end; i_in++ )
-    {
-        if( b_factor_old && d_factor == 1 )
-        {
-            if( ReallocBuffer( pp_out_buf, &p_out,
-                               i_out, i_nb_channels, i_bytes_per_frame ) )
-                return;
-            /* Just copy the samples */
-            memcpy( p_out, p_in, i_bytes_per_frame );
-            p_in += i_nb_channels;
-            p_out += i_nb_channels;
-            i_out++;
-            continue;
-        }
-
-        while( p_sys->i_remainder < p_filter->fmt_out.audio.i_rate )
-        {
-            if( ReallocBuffer( pp_out_buf, &p_out,
-                               i_out, i_nb_channels, i_bytes_per_frame ) )
-                return;
-
-            if( d_factor >= 1 )
-            {
-                /* FilterFloatUP() is faster if we can use it */
-
-                /* Perform left-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               1, i_nb_channels );
-
-#if 0
-                /* Normalize for unity filter gain */
-                for( i = 0; i < i_nb_channels; i++ )
-                {
-                    *(p_out+i) *= d_old_scale_factor;
-                }
-#endif
-            }
-            else
-            {
-                /* Perform left-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               1, i_nb_channels );
-            }
-
-            p_out += i_nb_channels;
-            i_out++;
-
-            p_sys->i_remainder += p_filter->fmt_in.audio.i_rate;
-        }
-
-        p_in += i_nb_channels;
-        p_sys->i_remainder -= p_filter->fmt_out.audio.i_rate;
-    }
-
-    *pp_in  = p_in;
-    *pi_out = i_out;
-}
-
-
@@ -99,7 +99,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 
     if( p_filter->fmt_out.audio.i_rate > p_filter->fmt_in.audio.i_rate )
     {
-        p_out_buf = block_Alloc( i_out_nb * framesize );
+        p_out_buf = filter_NewAudioBuffer( p_filter, i_out_nb * framesize );
         if( !p_out_buf )
             goto out;
     }
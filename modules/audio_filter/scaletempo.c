@@ -32,12 +32,24 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_atomic.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define SCALETEMPO_SIMD_SSE2
+# define SCALETEMPO_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define SCALETEMPO_SIMD_NEON
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -90,6 +102,12 @@ vlc_module_end ()
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
  * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
  *
+ * To keep that cost down, the search first tries one offset every 125
+ * microseconds, then refines around the best one, and the dot products are
+ * vectorised.
+ * The cost per output stride does not depend on the playback rate: at high
+ * rates, the skipped input is never copied.
+ *
  * NOTE:
  * sample: a single audio sample for one channel
  * frame: a single set of samples, one for each channel
@@ -126,9 +144,12 @@ struct filter_sys_t
     void     *table_blend;
     void    (*output_overlap)( filter_t *p_filter, void *p_out_buf, unsigned bytes_off );
     /* best overlap */
+    unsigned  frames_overlap;
     unsigned  frames_search;
-    void     *buf_pre_corr;
-    void     *table_window;
+    unsigned  frames_search_step;
+    float    *buf_pre_corr;
+    float    *table_window;
+    float   (*dot)( const float *, const float *, unsigned );
     unsigned(*best_overlap_offset)( filter_t *p_filter );
 #ifdef PITCH_SHIFTER
     /* pitch */
@@ -137,38 +158,114 @@ struct filter_sys_t
 #endif
 };
 
+/*****************************************************************************
+ * dot: cross correlation of interleaved samples
+ *****************************************************************************/
+static float dot_c( const float *a, const float *b, unsigned n )
+{
+    float sum = 0;
+    for( unsigned i = 0; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+
+#ifdef SCALETEMPO_SIMD_SSE2
+SCALETEMPO_SSE2
+static float dot_sse2( const float *a, const float *b, unsigned n )
+{
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    __m128 s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    /* independent sums, to hide the latency of the additions */
+    for( ; i + 16 <= n; i += 16 ) {
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ),
+                                         _mm_loadu_ps( b + i + 4 ) ) );
+        s2 = _mm_add_ps( s2, _mm_mul_ps( _mm_loadu_ps( a + i + 8 ),
+                                         _mm_loadu_ps( b + i + 8 ) ) );
+        s3 = _mm_add_ps( s3, _mm_mul_ps( _mm_loadu_ps( a + i + 12 ),
+                                         _mm_loadu_ps( b + i + 12 ) ) );
+    }
+    for( ; i + 4 <= n; i += 4 )
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+
+    s0 = _mm_add_ps( _mm_add_ps( s0, s1 ), _mm_add_ps( s2, s3 ) );
+    s0 = _mm_add_ps( s0, _mm_movehl_ps( s0, s0 ) );
+    s0 = _mm_add_ss( s0, _mm_shuffle_ps( s0, s0, 1 ) );
+
+    float sum = _mm_cvtss_f32( s0 );
+    for( ; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
+#ifdef SCALETEMPO_SIMD_NEON
+static float dot_neon( const float *a, const float *b, unsigned n )
+{
+    float32x4_t s0 = vdupq_n_f32( 0.f ), s1 = s0, s2 = s0, s3 = s0;
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 ) {
+        s0 = vfmaq_f32( s0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+        s1 = vfmaq_f32( s1, vld1q_f32( a + i + 4 ), vld1q_f32( b + i + 4 ) );
+        s2 = vfmaq_f32( s2, vld1q_f32( a + i + 8 ), vld1q_f32( b + i + 8 ) );
+        s3 = vfmaq_f32( s3, vld1q_f32( a + i + 12 ), vld1q_f32( b + i + 12 ) );
+    }
+    for( ; i + 4 <= n; i += 4 )
+        s0 = vfmaq_f32( s0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+
+    float sum = vaddvq_f32( vaddq_f32( vaddq_f32( s0, s1 ),
+                                       vaddq_f32( s2, s3 ) ) );
+    for( ; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
 static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
+    const unsigned channels = p->samples_per_frame;
+    const unsigned samples = p->samples_overlap - channels;
+    const unsigned step = p->frames_search_step;
+    const float *po = (const float *)p->buf_overlap + channels;
+    const float *ps = (const float *)p->buf_queue + channels;
+    float *ppc = p->buf_pre_corr;
     float best_corr = INT_MIN;
     unsigned best_off = 0;
-    unsigned i, off;
+    unsigned i, c, off;
 
-    pw  = p->table_window;
-    po  = p->buf_overlap;
-    po += p->samples_per_frame;
+    for( i = 0; i < p->frames_overlap - 1; i++ )
+        for( c = 0; c < channels; c++ )
+            *ppc++ = p->table_window[i] * *po++;
     ppc = p->buf_pre_corr;
-    for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-      *ppc++ = *pw++ * *po++;
+
+    for( off = 0; off < p->frames_search; off += step ) {
+        float corr = p->dot( ppc, ps + off * channels, samples );
+        if( corr > best_corr ) {
+            best_corr = corr;
+            best_off  = off;
+        }
     }
 
-    search_start = (float *)p->buf_queue + p->samples_per_frame;
-    for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
-      if( corr > best_corr ) {
-        best_corr = corr;
-        best_off  = off;
-      }
-      search_start += p->samples_per_frame;
+    /* refine between the neighbouring coarse offsets */
+    const unsigned coarse = best_off;
+    const unsigned end = __MIN( coarse + step, p->frames_search );
+    for( off = coarse + 1 > step ? coarse + 1 - step : 0; off < end; off++ ) {
+        if( off == coarse )
+            continue;
+        float corr = p->dot( ppc, ps + off * channels, samples );
+        if( corr > best_corr ) {
+            best_corr = corr;
+            best_off  = off;
+        }
     }
 
     return best_off * p->bytes_per_frame;
@@ -342,6 +439,7 @@ static int reinit_buffers( filter_t *p_filter )
     }
 
     /* best overlap */
+    p->frames_overlap = frames_overlap;
     p->frames_search = ( frames_overlap <= 1 ) ? 0 : p->ms_search * p->sample_rate / 1000.0;
     if( p->frames_search < 1 )
     { /* if no search */
@@ -349,18 +447,24 @@ static int reinit_buffers( filter_t *p_filter )
     }
     else
     {
-        unsigned bytes_pre_corr = ( p->samples_overlap - p->samples_per_frame ) * 4; /* sizeof (int32|float) */
-        p->buf_pre_corr = malloc( bytes_pre_corr );
-        p->table_window = malloc( bytes_pre_corr );
+        p->frames_search_step = __MAX( p->sample_rate / 8000, 1 );
+        p->buf_pre_corr = vlc_alloc( p->samples_overlap - p->samples_per_frame,
+                                     sizeof (float) );
+        p->table_window = vlc_alloc( frames_overlap - 1, sizeof (float) );
         if( ! p->buf_pre_corr || ! p->table_window )
             return VLC_ENOMEM;
         float *pw = p->table_window;
         for( i = 1; i<frames_overlap; i++ )
-        {
-            float v = i * ( frames_overlap - i );
-            for( j = 0; j < p->samples_per_frame; j++ )
-                *pw++ = v;
-        }
+            *pw++ = i * ( frames_overlap - i );
+        p->dot = dot_c;
+#ifdef SCALETEMPO_SIMD_SSE2
+        if( vlc_CPU_SSE2() )
+            p->dot = dot_sse2;
+#endif
+#ifdef SCALETEMPO_SIMD_NEON
+        if( vlc_CPU_ARM64_NEON() )
+            p->dot = dot_neon;
+#endif
         p->best_overlap_offset = best_overlap_offset_float;
     }
 
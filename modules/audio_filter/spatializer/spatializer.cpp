@@ -43,7 +43,9 @@ using std::nothrow;
 #include <vlc_filter.h>
 
 #include "revmodel.hpp"
+#include "../convolver.h"
 #define SPAT_AMP 0.3
+#define CONV_CHUNK 1024 /* frames convolved at once */
 
 /*****************************************************************************
  * Module descriptor
@@ -67,6 +69,13 @@ static void Close( vlc_object_t * );
 #define DAMP_TEXT N_("Damp")
 #define DAMP_LONGTEXT NULL
 
+#define IR_TEXT N_("Room impulse response")
+#define IR_LONGTEXT N_("WAV file of a measured room response, used instead " \
+                       "of the reverberation model. It may have one channel, " \
+                       "one per side, or four for the left to left, left to " \
+                       "right, right to left and right to right responses. " \
+                       "Only the wet and dry settings apply then." )
+
 vlc_module_begin ()
     set_description( N_("Audio Spatializer") )
     set_shortname( N_("Spatializer" ) )
@@ -86,6 +95,7 @@ vlc_module_begin ()
                             DRY_TEXT,DRY_LONGTEXT, false )
     add_float_with_range( "spatializer-damp",  0.5,   0.,  1.,
                             DAMP_TEXT,DAMP_LONGTEXT, false )
+    add_loadfile( "spatializer-ir", NULL, IR_TEXT, IR_LONGTEXT, true )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -95,6 +105,11 @@ struct filter_sys_t
 {
     vlc_mutex_t lock;
     revmodel *p_reverbm;
+    /* Convolution with a measured response, instead of the model */
+    convolver_t *p_conv;
+    unsigned i_conv_channels;
+    float p_conv_in[2 * CONV_CHUNK];
+    float p_conv_out[2 * CONV_CHUNK];
 };
 
 #define DECLARECB(fn) static int fn (vlc_object_t *,char const *, \
@@ -124,6 +139,59 @@ static const callback_s callbacks[] = {
 enum { num_callbacks=sizeof(callbacks)/sizeof(callback_s) };
 
 static block_t *DoWork( filter_t *, block_t * );
+static void Flush( filter_t * );
+
+/*****************************************************************************
+ * OpenConvolver: load the room response of the left and right channels
+ *****************************************************************************/
+static int OpenConvolver( filter_t *p_filter, const char *psz_ir )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i_channels;
+    size_t i_frames;
+    float *p_ir = convolver_LoadWav( VLC_OBJECT(p_filter), psz_ir,
+                                     p_filter->fmt_in.audio.i_rate,
+                                     &i_channels, &i_frames );
+    if( p_ir == NULL )
+        return VLC_EGENERIC;
+    if( i_channels != 1 && i_channels != 2 && i_channels != 4 )
+    {
+        msg_Err( p_filter, "unsupported room response with %u channels",
+                 i_channels );
+        free( p_ir );
+        return VLC_EGENERIC;
+    }
+
+    const unsigned n = __MIN( aout_FormatNbChannels( &p_filter->fmt_in.audio ),
+                              2 );
+    p_sys->p_conv = convolver_New( 0, n, n, i_frames );
+    if( p_sys->p_conv == NULL )
+    {
+        free( p_ir );
+        return VLC_ENOMEM;
+    }
+    p_sys->i_conv_channels = n;
+
+    for( unsigned in = 0; in < n; in++ )
+        for( unsigned out = 0; out < n; out++ )
+        {
+            unsigned i_ir;
+
+            if( i_channels == 4 )
+                i_ir = 2 * in + out;
+            else if( in == out )
+                i_ir = i_channels == 2 ? in : 0;
+            else
+                continue;
+            convolver_SetResponse( p_sys->p_conv, in, out, p_ir + i_ir,
+                                   i_frames, i_channels );
+        }
+
+    msg_Dbg( p_filter, "room response of %zu frames, %u frames of latency",
+             i_frames, convolver_GetLatency( p_sys->p_conv ) );
+    free( p_ir );
+    return VLC_SUCCESS;
+}
 
 /*****************************************************************************
  * Open:
@@ -148,6 +216,23 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
     }
 
+    p_sys->p_conv = NULL;
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare(&p_filter->fmt_in.audio);
+
+    char *psz_ir = var_InheritString( p_filter, "spatializer-ir" );
+    if( psz_ir != NULL )
+    {
+        int i_ret = OpenConvolver( p_filter, psz_ir );
+        free( psz_ir );
+        if( i_ret != VLC_SUCCESS )
+        {
+            delete p_sys->p_reverbm;
+            free( p_sys );
+            return i_ret;
+        }
+    }
+
     vlc_mutex_init( &p_sys->lock );
 
     for(unsigned i=0;i<num_callbacks;++i)
@@ -159,10 +244,9 @@ static int Open( vlc_object_t *p_this )
                          callbacks[i].fp_callback, p_sys );
     }
 
-    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
-    aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_flush = Flush;
     return VLC_SUCCESS;
 }
 
@@ -182,6 +266,8 @@ static void Close( vlc_object_t *p_this )
                          callbacks[i].fp_callback, p_sys );
     }
 
+    if( p_sys->p_conv != NULL )
+        convolver_Delete( p_sys->p_conv );
     delete p_sys->p_reverbm;
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
@@ -211,14 +297,68 @@ static void SpatFilter( filter_t *p_filter, float *out, float *in,
     }
 }
 
+/* The reverberation is delayed by the latency of the convolver, which acts
+ * as a short pre-delay */
+static void ConvFilter( filter_t *p_filter, float *p_buf,
+                        unsigned i_samples, unsigned i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned n = p_sys->i_conv_channels;
+    float f_wet, f_dry;
+
+    vlc_mutex_lock( &p_sys->lock );
+    f_wet = p_sys->p_reverbm->getwet();
+    f_dry = p_sys->p_reverbm->getdry();
+    vlc_mutex_unlock( &p_sys->lock );
+
+    while( i_samples > 0 )
+    {
+        const unsigned i_count = __MIN( i_samples, CONV_CHUNK );
+
+        for( unsigned i = 0; i < i_count; i++ )
+            for( unsigned ch = 0; ch < n; ch++ )
+                p_sys->p_conv_in[i * n + ch] = p_buf[i * i_channels + ch];
+
+        convolver_Process( p_sys->p_conv, p_sys->p_conv_in,
+                           p_sys->p_conv_out, i_count );
+
+        for( unsigned i = 0; i < i_count; i++ )
+            for( unsigned ch = 0; ch < n; ch++ )
+                p_buf[i * i_channels + ch] =
+                    p_buf[i * i_channels + ch] * f_dry
+                  + p_sys->p_conv_out[i * n + ch] * f_wet;
+
+        p_buf += i_count * i_channels;
+        i_samples -= i_count;
+    }
+}
+
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    SpatFilter( p_filter, (float*)p_in_buf->p_buffer,
-               (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
-               aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
+    if( p_filter->p_sys->p_conv != NULL )
+        ConvFilter( p_filter, (float*)p_in_buf->p_buffer,
+                    p_in_buf->i_nb_samples,
+                    aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
+    else
+        SpatFilter( p_filter, (float*)p_in_buf->p_buffer,
+                   (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
+                   aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
     return p_in_buf;
 }
 
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_conv != NULL )
+        convolver_Reset( p_sys->p_conv );
+    else
+    {
+        vlc_mutex_locker locker( &p_sys->lock );
+        p_sys->p_reverbm->mute();
+    }
+}
+
 
 /*****************************************************************************
  * Variables callbacks
@@ -38,7 +38,6 @@
 #include <vlc_aout.h>
 
 #include <jack/jack.h>
-#include <jack/ringbuffer.h>
 
 #include <stdio.h>
 #include <unistd.h>                                      /* write(), close() */
@@ -53,7 +52,7 @@ typedef jack_default_audio_sample_t jack_sample_t;
  *****************************************************************************/
 struct aout_sys_t
 {
-    jack_ringbuffer_t *p_jack_ringbuffer;
+    aout_ring_t    *p_ring;
     jack_client_t  *p_jack_client;
     jack_port_t   **p_jack_ports;
     jack_sample_t **p_jack_buffers;
@@ -62,7 +61,6 @@ struct aout_sys_t
     jack_nframes_t latency;
     float soft_gain;
     bool soft_mute;
-    mtime_t paused; /**< Time when (last) paused */
 };
 
 /*****************************************************************************
@@ -125,7 +123,7 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
         return VLC_EGENERIC;
 
     p_sys->latency = 0;
-    p_sys->paused = VLC_TS_INVALID;
+    p_sys->p_ring = NULL;
 
     /* Connect to the JACK server */
     psz_name = var_InheritString( p_aout, "jack-name" );
@@ -180,21 +178,13 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
         goto error_out;
     }
 
-    const size_t buf_sz = AOUT_MAX_ADVANCE_TIME * fmt->i_rate *
-        fmt->i_bytes_per_frame / CLOCK_FREQ;
-    p_sys->p_jack_ringbuffer = jack_ringbuffer_create( buf_sz );
-
-    if( p_sys->p_jack_ringbuffer == NULL )
+    p_sys->p_ring = aout_RingNew( fmt, AOUT_MAX_ADVANCE_TIME );
+    if( p_sys->p_ring == NULL )
     {
         status = VLC_ENOMEM;
         goto error_out;
     }
 
-    if( jack_ringbuffer_mlock( p_sys->p_jack_ringbuffer ))
-    {
-        msg_Warn( p_aout, "failed to lock JACK ringbuffer in memory" );
-    }
-
     /* Create the output ports */
     for( i = 0; i < p_sys->i_channels; i++ )
     {
@@ -273,8 +263,8 @@ error_out:
             jack_deactivate( p_sys->p_jack_client );
             jack_client_close( p_sys->p_jack_client );
         }
-        if( p_sys->p_jack_ringbuffer )
-            jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+        if( p_sys->p_ring )
+            aout_RingDelete( p_sys->p_ring );
 
         free( p_sys->p_jack_ports );
         free( p_sys->p_jack_buffers );
@@ -286,30 +276,11 @@ error_out:
 static void Play (audio_output_t * p_aout, block_t * p_block)
 {
     struct aout_sys_t *p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
 
-    while (p_block->i_buffer > 0) {
-
-        /* move data to buffer */
-        const size_t write_space = jack_ringbuffer_write_space(rb);
-        const size_t bytes = p_block->i_buffer < write_space ?
-            p_block->i_buffer : write_space;
-
-        /* If our audio thread is not reading fast enough */
-        if( unlikely( bytes == 0 ) ) {
-            msg_Warn( p_aout, "%"PRIuPTR " frames of audio dropped",
-                    p_block->i_buffer /  bytes_per_frame );
-            break;
-        }
-
-        jack_ringbuffer_write( rb, (const char *) p_block->p_buffer, bytes );
-
-        p_block->p_buffer += bytes;
-        p_block->i_buffer -= bytes;
-    }
-
-    block_Release(p_block);
+    /* If our audio thread is not reading fast enough */
+    size_t dropped = aout_RingPlay( p_sys->p_ring, p_block );
+    if( unlikely( dropped > 0 ) )
+        msg_Warn( p_aout, "%zu frames of audio dropped", dropped );
 }
 
 /**
@@ -319,19 +290,13 @@ static void Pause(audio_output_t *aout, bool paused, mtime_t date)
 {
     aout_sys_t *sys = aout->sys;
 
-    if( paused ) {
-        sys->paused = date;
-    } else {
-        date -= sys->paused;
-        msg_Dbg(aout, "resuming after %"PRId64" us", date);
-        sys->paused = VLC_TS_INVALID;
-    }
+    aout_RingPause(sys->p_ring, paused);
+    (void) date;
 }
 
 static void Flush(audio_output_t *p_aout, bool wait)
 {
     struct aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
 
     /* Sleep if wait was requested */
     if( wait )
@@ -341,18 +306,15 @@ static void Flush(audio_output_t *p_aout, bool wait)
             msleep(delay);
     }
 
-    /* reset ringbuffer read and write pointers */
-    jack_ringbuffer_reset(rb);
+    /* The process callback discards the queued frames by itself */
+    aout_RingFlush( p_sys->p_ring );
 }
 
 static int TimeGet(audio_output_t *p_aout, mtime_t *delay)
 {
     struct aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
 
-    *delay = (p_sys->latency +
-            (jack_ringbuffer_read_space(rb) / bytes_per_frame)) *
+    *delay = (p_sys->latency + aout_RingCount( p_sys->p_ring )) *
         CLOCK_FREQ / p_sys->i_rate;
 
     return 0;
@@ -360,49 +322,25 @@ static int TimeGet(audio_output_t *p_aout, mtime_t *delay)
 
 /*****************************************************************************
  * Process: callback for JACK
+ *****************************************************************************
+ * This runs in the realtime thread of JACK: it must neither block nor
+ * allocate, and reads the samples from the lock-free ring of the output.
  *****************************************************************************/
 int Process( jack_nframes_t i_frames, void *p_arg )
 {
-    unsigned int i, j, frames_from_rb = 0;
-    size_t bytes_read = 0;
-    size_t frames_read;
     audio_output_t *p_aout = (audio_output_t*) p_arg;
     struct aout_sys_t *p_sys = p_aout->sys;
 
-    /* Get the next audio data buffer unless paused */
-
-    if( p_sys->paused == VLC_TS_INVALID )
-        frames_from_rb = i_frames;
-
     /* Get the JACK buffers to write to */
-    for( i = 0; i < p_sys->i_channels; i++ )
+    for( unsigned i = 0; i < p_sys->i_channels; i++ )
     {
         p_sys->p_jack_buffers[i] = jack_port_get_buffer( p_sys->p_jack_ports[i],
                                                          i_frames );
     }
 
-    /* Copy in the audio data */
-    for( j = 0; j < frames_from_rb; j++ )
-    {
-        for( i = 0; i < p_sys->i_channels; i++ )
-        {
-            jack_sample_t *p_dst = p_sys->p_jack_buffers[i] + j;
-            bytes_read += jack_ringbuffer_read( p_sys->p_jack_ringbuffer,
-                    (char *) p_dst, sizeof(jack_sample_t) );
-        }
-    }
-
-    /* Fill any remaining buffer with silence */
-    frames_read = (bytes_read / sizeof(jack_sample_t)) / p_sys->i_channels;
-    if( frames_read < i_frames )
-    {
-        for( i = 0; i < p_sys->i_channels; i++ )
-        {
-            memset( p_sys->p_jack_buffers[i] + frames_read, 0,
-                    sizeof( jack_sample_t ) * (i_frames - frames_read) );
-        }
-    }
-
+    /* Copy in the audio data, or silence if paused or late */
+    aout_RingReadPlanar( p_sys->p_ring, (void *const *)p_sys->p_jack_buffers,
+                         i_frames );
     return 0;
 }
 
@@ -454,7 +392,7 @@ static void Stop( audio_output_t *p_aout )
     }
     free( p_sys->p_jack_ports );
     free( p_sys->p_jack_buffers );
-    jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+    aout_RingDelete( p_sys->p_ring );
 }
 
 static int Open(vlc_object_t *obj)
@@ -482,7 +482,13 @@ static block_t * ConvertAVFrame( decoder_t *p_dec, AVFrame *frame )
     /* Interleave audio if required */
     if( av_sample_fmt_is_planar( ctx->sample_fmt ) )
     {
-        p_block = block_Alloc(frame->linesize[0] * ctx->channels);
+        /* The output format may have fewer channels than the frame if the
+         * layout was not understood */
+        if( p_sys->b_extract
+         || p_dec->fmt_out.audio.i_channels != (unsigned)ctx->channels )
+            p_block = block_Alloc(frame->linesize[0] * ctx->channels);
+        else
+            p_block = decoder_NewAudioBuffer( p_dec, frame->nb_samples );
         if ( likely(p_block) )
         {
             const void *planes[ctx->channels];
@@ -503,17 +509,14 @@ static block_t * ConvertAVFrame( decoder_t *p_dec, AVFrame *frame )
 
     if (p_sys->b_extract && p_block)
     {   /* TODO: do not drop channels... at least not here */
-        block_t *p_buffer = block_Alloc( p_dec->fmt_out.audio.i_bytes_per_frame
-                                         * p_block->i_nb_samples );
+        block_t *p_buffer = decoder_NewAudioBuffer( p_dec,
+                                                    p_block->i_nb_samples );
         if( likely(p_buffer) )
-        {
             aout_ChannelExtract( p_buffer->p_buffer,
                                  p_dec->fmt_out.audio.i_channels,
                                  p_block->p_buffer, ctx->channels,
                                  p_block->i_nb_samples, p_sys->pi_extraction,
                                  p_dec->fmt_out.audio.i_bitspersample );
-            p_buffer->i_nb_samples = p_block->i_nb_samples;
-        }
         block_Release( p_block );
         p_block = p_buffer;
     }
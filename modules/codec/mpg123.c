@@ -250,15 +250,23 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     while( true )
     {
         /* Fetch a new output block (if possible) */
-        if( !p_sys->p_out
-            || p_sys->p_out->i_buffer != mpg123_outblock( p_sys->p_handle ) )
+        const size_t i_outblock = mpg123_outblock( p_sys->p_handle );
+        if( !p_sys->p_out || p_sys->p_out->i_buffer < i_outblock )
         {
+            const unsigned i_frame_size = p_dec->fmt_out.audio.i_bytes_per_frame;
+
             if( p_sys->p_out )
                 block_Release( p_sys->p_out );
 
             /* Keep the output buffer for next calls in case it's not used (in case
              * of MPG123_NEED_MORE status) */
-            p_sys->p_out = block_Alloc( mpg123_outblock( p_sys->p_handle ) );
+            if( i_frame_size > 0 && p_dec->fmt_out.audio.i_frame_length > 0 )
+                /* Once the format is known, recycle the output buffers */
+                p_sys->p_out = decoder_NewAudioBuffer( p_dec,
+                    (i_outblock + i_frame_size - 1) / i_frame_size
+                    * p_dec->fmt_out.audio.i_frame_length );
+            else
+                p_sys->p_out = block_Alloc( i_outblock );
 
             if( unlikely( !p_sys->p_out ) )
                 return VLCDEC_SUCCESS;
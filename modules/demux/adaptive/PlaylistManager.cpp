@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
@@ -65,6 +66,8 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     failedupdates = 0;
     b_thread = false;
     b_buffering = false;
+    b_bufferized = false;
+    i_bufferizing = 0;
     nextPlaylistupdate = 0;
     demux.i_nzpcr = VLC_TS_INVALID;
     demux.i_firstpcr = VLC_TS_INVALID;
@@ -97,6 +100,9 @@ PlaylistManager::~PlaylistManager   ()
 void PlaylistManager::unsetPeriod()
 {
     std::vector<AbstractStream *>::iterator it;
+    /* stop all demuxing threads before tearing anything down */
+    for(it=streams.begin(); it!=streams.end(); ++it)
+        (*it)->stopBufferingThread();
     for(it=streams.begin(); it!=streams.end(); ++it)
         delete *it;
     streams.clear();
@@ -131,6 +137,10 @@ bool PlaylistManager::setupPeriod()
 
             streams.push_back(st);
 
+            /* Demux ahead on its own thread, or from the manager's one on failure */
+            if(!st->startBufferingThread(this))
+                msg_Warn(p_demux, "cannot start buffering thread, demuxing serially");
+
             /* Generate stream description */
             std::list<std::string> languages;
             if(!set->getLang().empty())
@@ -212,6 +222,7 @@ AbstractStream::buffering_status PlaylistManager::bufferize(mtime_t i_nzdeadline
                                                             unsigned i_min_buffering, unsigned i_extra_buffering)
 {
     AbstractStream::buffering_status i_return = AbstractStream::buffering_end;
+    unsigned i_async = 0;
 
     /* First reorder by status >> buffering level */
     std::vector<PrioritizedAbstractStream> prioritized_streams(streams.size());
@@ -230,12 +241,36 @@ AbstractStream::buffering_status PlaylistManager::bufferize(mtime_t i_nzdeadline
     for(it=prioritized_streams.begin(); it!=prioritized_streams.end(); ++it)
     {
         AbstractStream *st = (*it).st;
+        AbstractStream::buffering_status i_ret;
 
-        if (st->isDisabled() &&
-            (!st->isSelected() || !st->canActivate() || !reactivateStream(st)))
-                continue;
+        if(st->isBufferizing()) /* still demuxing on its own thread */
+        {
+            i_ret = (*it).status;
+            i_async++;
+        }
+        else
+        {
+            if (st->isDisabled())
+            {
+                if(!st->isSelected() || !st->canActivate())
+                    continue;
+                /* repositions the stream and can update the playlist */
+                waitStreamsBufferized();
+                if(!reactivateStream(st))
+                    continue;
+            }
+
+            if(st->bufferizeAsync(i_nzdeadline, i_min_buffering, i_extra_buffering))
+            {
+                i_ret = (*it).status;
+                i_async++;
+            }
+            else
+            {
+                i_ret = st->bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
+            }
+        }
 
-        AbstractStream::buffering_status i_ret = st->bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
         if(i_return != AbstractStream::buffering_ongoing) /* Buffering streams need to keep going */
         {
             if(i_ret > i_return)
@@ -243,9 +278,10 @@ AbstractStream::buffering_status PlaylistManager::bufferize(mtime_t i_nzdeadline
         }
 
         /* Bail out, will start again (high prio could be same starving stream) */
-        if( i_return == AbstractStream::buffering_lessthanmin )
+        if( i_return == AbstractStream::buffering_lessthanmin && !i_async )
             break;
     }
+    i_bufferizing = i_async;
 
     vlc_mutex_lock(&demux.lock);
     if(demux.i_nzpcr == VLC_TS_INVALID &&
@@ -402,6 +438,13 @@ mtime_t PlaylistManager::getCurrentPlaybackTime() const
     return demux.i_nzpcr;
 }
 
+void PlaylistManager::waitStreamsBufferized()
+{
+    std::vector<AbstractStream *>::const_iterator it;
+    for(it=streams.begin(); it!=streams.end(); ++it)
+        (*it)->waitBufferized();
+}
+
 void PlaylistManager::pruneLiveStream()
 {
     mtime_t minValidPos = 0;
@@ -632,6 +675,18 @@ void PlaylistManager::setBufferingRunState(bool b)
     b_buffering = b;
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
+
+    /* Streams can't be touched until their threads are done */
+    if(!b)
+        waitStreamsBufferized();
+}
+
+void PlaylistManager::bufferingDone(AbstractStream *)
+{
+    vlc_mutex_lock(&lock);
+    b_bufferized = true;
+    vlc_cond_signal(&waitcond);
+    vlc_mutex_unlock(&lock);
 }
 
 void PlaylistManager::Run()
@@ -650,6 +705,8 @@ void PlaylistManager::Run()
         if(needsUpdate())
         {
             int canc = vlc_savecancel();
+            /* playlist and segments lists are shared with streams threads */
+            waitStreamsBufferized();
             if(updatePlaylist())
                 scheduleNextUpdate();
             else
@@ -665,10 +722,12 @@ void PlaylistManager::Run()
         AbstractStream::buffering_status i_return = bufferize(i_nzpcr, i_min_buffering, i_extra_buffering);
         vlc_restorecancel( canc );
 
-        if(i_return != AbstractStream::buffering_lessthanmin)
+        if(i_return != AbstractStream::buffering_lessthanmin || i_bufferizing)
         {
             mtime_t i_deadline = mdate();
-            if(i_return == AbstractStream::buffering_ongoing)
+            if(i_return == AbstractStream::buffering_lessthanmin)
+                i_deadline += (CLOCK_FREQ / 100);
+            else if(i_return == AbstractStream::buffering_ongoing)
                 i_deadline += (CLOCK_FREQ / 100);
             else if(i_return == AbstractStream::buffering_full)
                 i_deadline += (CLOCK_FREQ / 10);
@@ -681,11 +740,13 @@ void PlaylistManager::Run()
             vlc_cond_signal(&demux.cond);
             vlc_mutex_unlock(&demux.lock);
 
+            /* streams threads wake us up when done, to dispatch again */
             mutex_cleanup_push(&lock);
-            while(b_buffering &&
+            while(b_buffering && !(b_bufferized && i_bufferizing) &&
                     vlc_cond_timedwait(&waitcond, &lock, i_deadline) == 0 &&
                     i_deadline > mdate());
             vlc_cleanup_pop();
+            b_bufferized = false;
         }
     }
     vlc_mutex_unlock(&lock);
@@ -775,6 +836,16 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::Hybrid:
+        {
+            HybridAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(VLC_OBJECT(p_demux));
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
         }
 
         default:
@@ -44,7 +44,7 @@ namespace adaptive
     using namespace logic;
     using namespace http;
 
-    class PlaylistManager
+    class PlaylistManager : public StreamBufferingListenerInterface
     {
         public:
             PlaylistManager( demux_t *,
@@ -65,6 +65,8 @@ namespace adaptive
             virtual bool updatePlaylist();
             virtual void scheduleNextUpdate();
 
+            virtual void bufferingDone(AbstractStream *); /* impl */
+
             /* static callbacks */
             static int control_callback(demux_t *, int, va_list);
             static int demux_callback(demux_t *);
@@ -83,6 +85,7 @@ namespace adaptive
             mtime_t getCurrentPlaybackTime() const;
 
             void pruneLiveStream();
+            void waitStreamsBufferized();
             virtual bool reactivateStream(AbstractStream *);
             bool setupPeriod();
             void unsetPeriod();
@@ -136,6 +139,8 @@ namespace adaptive
             bool         b_thread;
             vlc_cond_t   waitcond;
             bool         b_buffering;
+            bool         b_bufferized;
+            unsigned     i_bufferizing;
     };
 
 }
@@ -56,6 +56,12 @@ AbstractStream::AbstractStream(demux_t * demux_)
     fakeesout = NULL;
     last_buffer_status = buffering_lessthanmin;
     vlc_mutex_init(&lock);
+    worker.b_started = false;
+    worker.b_busy = false;
+    worker.b_stop = false;
+    worker.listener = NULL;
+    vlc_mutex_init(&worker.lock);
+    vlc_cond_init(&worker.cond);
 }
 
 bool AbstractStream::init(const StreamFormat &format_, SegmentTracker *tracker, AbstractConnectionManager *conn)
@@ -101,6 +107,8 @@ bool AbstractStream::init(const StreamFormat &format_, SegmentTracker *tracker,
 
 AbstractStream::~AbstractStream()
 {
+    stopBufferingThread();
+
     delete currentChunk;
     if(segmentTracker)
         segmentTracker->notifyBufferingState(false);
@@ -111,6 +119,8 @@ AbstractStream::~AbstractStream()
     delete fakeesout;
     delete commandsqueue;
 
+    vlc_cond_destroy(&worker.cond);
+    vlc_mutex_destroy(&worker.lock);
     vlc_mutex_destroy(&lock);
 }
 
@@ -286,7 +296,10 @@ bool AbstractStream::decodersDrained()
 
 AbstractStream::buffering_status AbstractStream::getLastBufferStatus() const
 {
-    return last_buffer_status;
+    vlc_mutex_lock(const_cast<vlc_mutex_t *>(&worker.lock));
+    buffering_status status = last_buffer_status;
+    vlc_mutex_unlock(const_cast<vlc_mutex_t *>(&worker.lock));
+    return status;
 }
 
 mtime_t AbstractStream::getDemuxedAmount() const
@@ -297,8 +310,115 @@ mtime_t AbstractStream::getDemuxedAmount() const
 AbstractStream::buffering_status AbstractStream::bufferize(mtime_t nz_deadline,
                                                            unsigned i_min_buffering, unsigned i_extra_buffering)
 {
-    last_buffer_status = doBufferize(nz_deadline, i_min_buffering, i_extra_buffering);
-    return last_buffer_status;
+    buffering_status status = doBufferize(nz_deadline, i_min_buffering, i_extra_buffering);
+    vlc_mutex_lock(&worker.lock);
+    last_buffer_status = status;
+    vlc_mutex_unlock(&worker.lock);
+    return status;
+}
+
+bool AbstractStream::startBufferingThread(StreamBufferingListenerInterface *listener)
+{
+    vlc_mutex_locker locker(&worker.lock);
+    if(worker.b_started)
+        return true;
+    worker.listener = listener;
+    worker.b_stop = false;
+    worker.b_busy = false;
+    worker.b_started = !vlc_clone(&worker.thread, bufferingThread,
+                                  static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
+    return worker.b_started;
+}
+
+void AbstractStream::stopBufferingThread()
+{
+    vlc_mutex_lock(&worker.lock);
+    if(!worker.b_started)
+    {
+        vlc_mutex_unlock(&worker.lock);
+        return;
+    }
+    worker.b_stop = true;
+    vlc_cond_broadcast(&worker.cond);
+    vlc_mutex_unlock(&worker.lock);
+
+    vlc_join(worker.thread, NULL);
+
+    vlc_mutex_lock(&worker.lock);
+    worker.b_started = false;
+    worker.b_busy = false;
+    vlc_mutex_unlock(&worker.lock);
+}
+
+bool AbstractStream::bufferizeAsync(mtime_t nz_deadline,
+                                    unsigned i_min_buffering, unsigned i_extra_buffering)
+{
+    vlc_mutex_locker locker(&worker.lock);
+    if(!worker.b_started)
+        return false;
+    if(!worker.b_busy) /* otherwise still running previous request */
+    {
+        worker.i_nzdeadline = nz_deadline;
+        worker.i_min_buffering = i_min_buffering;
+        worker.i_extra_buffering = i_extra_buffering;
+        worker.b_busy = true;
+        vlc_cond_broadcast(&worker.cond);
+    }
+    return true;
+}
+
+bool AbstractStream::isBufferizing() const
+{
+    vlc_mutex_lock(const_cast<vlc_mutex_t *>(&worker.lock));
+    bool b_busy = worker.b_busy;
+    vlc_mutex_unlock(const_cast<vlc_mutex_t *>(&worker.lock));
+    return b_busy;
+}
+
+void AbstractStream::waitBufferized()
+{
+    vlc_mutex_lock(&worker.lock);
+    while(worker.b_busy)
+        vlc_cond_wait(&worker.cond, &worker.lock);
+    vlc_mutex_unlock(&worker.lock);
+}
+
+void AbstractStream::bufferingRun()
+{
+    vlc_mutex_lock(&worker.lock);
+    for(;;)
+    {
+        while(!worker.b_busy && !worker.b_stop)
+            vlc_cond_wait(&worker.cond, &worker.lock);
+        if(worker.b_stop)
+            break;
+
+        const mtime_t i_nzdeadline = worker.i_nzdeadline;
+        const unsigned i_min_buffering = worker.i_min_buffering;
+        const unsigned i_extra_buffering = worker.i_extra_buffering;
+        vlc_mutex_unlock(&worker.lock);
+
+        bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
+
+        vlc_mutex_lock(&worker.lock);
+        worker.b_busy = false;
+        vlc_cond_broadcast(&worker.cond);
+        StreamBufferingListenerInterface *listener = worker.listener;
+        vlc_mutex_unlock(&worker.lock);
+
+        /* wake up the manager, which might dispatch again */
+        if(listener)
+            listener->bufferingDone(this);
+
+        vlc_mutex_lock(&worker.lock);
+    }
+    vlc_mutex_unlock(&worker.lock);
+}
+
+void * AbstractStream::bufferingThread(void *opaque)
+{
+    static_cast<AbstractStream *>(opaque)->bufferingRun();
+    return NULL;
 }
 
 AbstractStream::buffering_status AbstractStream::doBufferize(mtime_t nz_deadline,
@@ -49,6 +49,15 @@ namespace adaptive
     using namespace http;
     using namespace playlist;
 
+    class AbstractStream;
+
+    class StreamBufferingListenerInterface
+    {
+        public:
+            virtual ~StreamBufferingListenerInterface() {}
+            virtual void bufferingDone(AbstractStream *) = 0;
+    };
+
     class AbstractStream : public ChunksSource,
                            public ExtraFMTInfoInterface,
                            public SegmentTrackerListenerInterface,
@@ -85,6 +94,12 @@ namespace adaptive
         } buffering_status;
         buffering_status bufferize(mtime_t, unsigned, unsigned);
         buffering_status getLastBufferStatus() const;
+        /* Demux ahead: bufferize on the stream's own thread */
+        bool startBufferingThread(StreamBufferingListenerInterface *);
+        void stopBufferingThread();
+        bool bufferizeAsync(mtime_t, unsigned, unsigned);
+        bool isBufferizing() const;
+        void waitBufferized();
         mtime_t getDemuxedAmount() const;
         status dequeue(mtime_t, mtime_t *);
         bool decodersDrained();
@@ -138,6 +153,22 @@ namespace adaptive
         buffering_status last_buffer_status;
         bool dead;
         bool disabled;
+
+        static void * bufferingThread(void *);
+        void bufferingRun();
+        struct
+        {
+            vlc_thread_t thread;
+            vlc_mutex_t  lock;
+            vlc_cond_t   cond;
+            bool         b_started;
+            bool         b_busy;
+            bool         b_stop;
+            mtime_t      i_nzdeadline;
+            unsigned     i_min_buffering;
+            unsigned     i_extra_buffering;
+            StreamBufferingListenerInterface *listener;
+        } worker;
     };
 
     class AbstractStreamFactory
@@ -80,6 +80,7 @@ static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::Hybrid,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -89,6 +90,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -97,6 +99,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Hybrid Buffer/Throughput"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -268,6 +271,7 @@ static PlaylistManager * HandleDash(demux_t *p_demux,
                                     const std::string & playlisturl,
                                     AbstractAdaptationLogic::LogicType logic)
 {
+    IsoffMainParser::setupDOMParser(xmlParser);
     if(!xmlParser.reset(p_demux->s) || !xmlParser.parse(true))
     {
         msg_Err(p_demux, "Cannot parse MPD");
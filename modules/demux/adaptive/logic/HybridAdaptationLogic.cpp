@@ -0,0 +1,259 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+#include "Representationselectors.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../playlist/BasePeriod.h"
+#include "../tools/Debug.hpp"
+
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput / BOLA hybrid, per stream.
+ *
+ * While the buffer is low (startup, after seek or stall), the buffer level
+ * carries no information and we select on measured throughput. Once enough
+ * is buffered we switch to BOLA (http://arxiv.org/abs/1601.06748), which is
+ * stable but slow to ramp up, and cap its upswitches to what the network
+ * currently sustains (BOLA-O). Hysteresis avoids oscillating between modes.
+ */
+
+#define minimumBufferS      (CLOCK_FREQ * 6)  /* Qmin */
+#define bufferTargetS       (CLOCK_FREQ * 30) /* Qmax */
+#define bufferBasedEnterS   (CLOCK_FREQ * 10) /* throughput -> BOLA */
+#define bufferBasedLeaveS   (CLOCK_FREQ * 6)  /* BOLA -> throughput */
+#define throughputSafety    0.9
+
+HybridContext::HybridContext()
+    : buffer_based( false )
+    , buffering_min( minimumBufferS )
+    , buffering_level( 0 )
+    , buffering_target( bufferTargetS )
+    , last_download_rate( 0 )
+{ }
+
+HybridAdaptationLogic::HybridAdaptationLogic(vlc_object_t *p_obj_)
+    : AbstractAdaptationLogic()
+    , currentBps( 0 )
+    , usedBps( 0 )
+    , p_obj( p_obj_ )
+{
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+BaseRepresentation *
+HybridAdaptationLogic::getBufferBasedRepresentation(BaseAdaptationSet *adaptSet,
+                                                    RepresentationSelector &selector,
+                                                    const HybridContext &ctx)
+{
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    if(!lowest || !highest)
+        return lowest;
+
+    /* utilities relative to the lowest rendition: u = log(S/Smin) */
+    const float umin = getUtility(lowest);
+    const float umax = getUtility(highest) - umin;
+    const float Qmin = (float) ctx.buffering_min / CLOCK_FREQ;
+    const float Qmax = std::max((float) ctx.buffering_target / CLOCK_FREQ, Qmin + 1.0f);
+    const float Q = (float) ctx.buffering_level / CLOCK_FREQ;
+
+    const float gammaP = 1.0 + umax / (Qmax / Qmin - 1.0);
+    const float Vd = (Qmin - 1.0) / gammaP;
+
+    BaseRepresentation *ret = NULL;
+    BaseRepresentation *prev = NULL;
+    float argmax = 0;
+    for(BaseRepresentation *rep = lowest; rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        float arg = (Vd * (getUtility(rep) - umin + gammaP) - Q) / rep->getBandwidth();
+        if(ret == NULL || argmax <= arg)
+        {
+            ret = rep;
+            argmax = arg;
+        }
+        prev = rep;
+    }
+    return ret;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, HybridContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end() || currentBps == 0)
+    {
+        vlc_mutex_unlock(&lock);
+        return selector.lowest(adaptSet);
+    }
+    HybridContext ctxcopy = (*it).second;
+
+    const unsigned bps = getAvailableBw(currentBps, prevRep) * throughputSafety;
+
+    vlc_mutex_unlock(&lock);
+
+    BaseRepresentation *rep = selector.select(adaptSet, bps);
+    if(ctxcopy.buffer_based && prevRep)
+    {
+        BaseRepresentation *bbrep = getBufferBasedRepresentation(adaptSet, selector, ctxcopy);
+        /* Don't let BOLA climb above what we can download */
+        if(bbrep && rep &&
+           bbrep->getBandwidth() > prevRep->getBandwidth() &&
+           bbrep->getBandwidth() > rep->getBandwidth())
+        {
+            bbrep = (prevRep->getBandwidth() > rep->getBandwidth()) ? prevRep : rep;
+        }
+        if(bbrep)
+            rep = bbrep;
+    }
+
+    BwDebug( msg_Info(p_obj, "Stream %s %s buffering level %.2f%% rep %" PRIu64 " kBps avail %u kBps",
+             adaptSet->getID().str().c_str(), ctxcopy.buffer_based ? "bola" : "tput",
+             (float) 100 * ctxcopy.buffering_level / ctxcopy.buffering_target,
+             rep ? rep->getBandwidth() / 8000 : 0, bps / 8000); );
+
+    return rep;
+}
+
+float HybridAdaptationLogic::getUtility(const BaseRepresentation *rep)
+{
+    float ret;
+    std::map<uint64_t, float>::iterator it = utilities.find(rep->getBandwidth());
+    if(it == utilities.end())
+    {
+        ret = std::log((float)rep->getBandwidth());
+        utilities.insert(std::pair<uint64_t, float>(rep->getBandwidth(), ret));
+    }
+    else ret = (*it).second;
+    return ret;
+}
+
+unsigned HybridAdaptationLogic::getAvailableBw(unsigned i_bw, const BaseRepresentation *curRep) const
+{
+    unsigned i_remain = i_bw;
+    if(i_remain > usedBps)
+        i_remain -= usedBps;
+    else
+        i_remain = 0;
+    if(curRep)
+        i_remain += curRep->getBandwidth();
+    return i_remain > i_bw ? i_bw : i_remain;
+}
+
+unsigned HybridAdaptationLogic::getMaxCurrentBw() const
+{
+    unsigned i_max_bitrate = 0;
+    for(std::map<ID, HybridContext>::const_iterator it = streams.begin();
+                                                    it != streams.end(); ++it)
+        i_max_bitrate = std::max(i_max_bitrate, ((*it).second).last_download_rate);
+    return i_max_bitrate;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
+{
+    if(unlikely(time == 0))
+        return;
+    vlc_mutex_lock(&lock);
+    std::map<ID, HybridContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+    {
+        HybridContext &ctx = (*it).second;
+        ctx.last_download_rate = ctx.average.push(CLOCK_FREQ * dlsize * 8 / time);
+    }
+    currentBps = getMaxCurrentBw();
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::SWITCHING:
+        {
+            vlc_mutex_lock(&lock);
+            if(event.u.switching.prev)
+                usedBps -= event.u.switching.prev->getBandwidth();
+            if(event.u.switching.next)
+                usedBps += event.u.switching.next->getBandwidth();
+            BwDebug(msg_Info(p_obj, "New total bandwidth usage %u kBps", (usedBps / 8000)));
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                {
+                    HybridContext ctx;
+                    streams.insert(std::pair<ID, HybridContext>(id, ctx));
+                }
+            }
+            else
+            {
+                std::map<ID, HybridContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+            BwDebug(msg_Info(p_obj, "Stream %s is now known %sactive", id.str().c_str(),
+                         (event.u.buffering.enabled) ? "" : "in"));
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering_level.id;
+            vlc_mutex_lock(&lock);
+            HybridContext &ctx = streams[id];
+            ctx.buffering_level = event.u.buffering_level.current;
+            ctx.buffering_target = event.u.buffering_level.target;
+            if(!ctx.buffer_based && ctx.buffering_level >= bufferBasedEnterS)
+                ctx.buffer_based = true;
+            else if(ctx.buffer_based && ctx.buffering_level < bufferBasedLeaveS)
+                ctx.buffer_based = false;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
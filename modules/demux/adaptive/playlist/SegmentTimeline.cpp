@@ -43,42 +43,50 @@ SegmentTimeline::SegmentTimeline(uint64_t scale)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
 void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
-    {
-        if(!elements.empty() && !t)
-        {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
-        }
-        elements.push_back(element);
-    }
+    if(!elements.empty() && !t)
+        t = elements.back().end();
+    elements.push_back(Element(number, d, r, t));
+}
+
+std::vector<SegmentTimeline::Element>::const_iterator
+SegmentTimeline::findByNumber(uint64_t number) const
+{
+    /* last element starting at or before number */
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin(), elements.end(), number, Element::numberBefore);
+    return (it == elements.begin()) ? elements.end() : --it;
+}
+
+std::vector<SegmentTimeline::Element>::const_iterator
+SegmentTimeline::findByScaledTime(stime_t scaled) const
+{
+    /* last element starting at or before scaled */
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin(), elements.end(), scaled, Element::timeBefore);
+    return (it == elements.begin()) ? elements.end() : --it;
 }
 
 mtime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 {
     stime_t totalscaledtime = 0;
 
-    std::list<Element *>::const_reverse_iterator it;
+    std::vector<Element>::const_reverse_iterator it;
     for(it = elements.rbegin(); it != elements.rend(); ++it)
     {
-        const Element *el = *it;
+        const Element &el = *it;
 
-        if(number < el->number)
+        if(number < el.number)
         {
-            totalscaledtime += (el->d * (el->r + 1));
+            totalscaledtime += (el.d * (el.r + 1));
             break;
         }
-        else if(number <= el->number + el->r)
+        else if(number <= el.number + el.r)
         {
-            totalscaledtime += el->d * (el->number + el->r - number);
+            totalscaledtime += el.d * (el.number + el.r - number);
         }
         else break;
     }
@@ -88,66 +96,51 @@ mtime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    uint64_t prevnumber = 0;
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(it == elements.begin())
-        {
-            scaled -= el->t;
-            prevnumber = el->number;
-        }
-
-        for(uint64_t repeat = 1 + el->r; repeat; repeat--)
-        {
-            if(el->d >= scaled)
-                return prevnumber;
+    if(elements.empty())
+        return 0;
 
-            scaled -= el->d;
-            prevnumber++;
-        }
+    std::vector<Element>::const_iterator it = findByScaledTime(scaled);
+    if(it == elements.end()) /* << first of the list */
+        return elements.front().number;
 
-        /* might have been discontinuity */
-        prevnumber = el->number;
-    }
+    const Element &el = *it;
+    if(el.contains(scaled))
+        return el.number + (scaled - el.t) / el.d;
 
-    return prevnumber;
+    /* in a discontinuity gap, or >> any of the list */
+    return el.number + el.r;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    stime_t totalscaledtime = 0;
-    stime_t lastduration = 0;
-
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
+    if(elements.empty())
     {
-        const Element *el = *it;
-
-        /* set start time, or from discontinuity */
-        if(it == elements.begin() || el->t)
-        {
-            totalscaledtime = el->t;
-        }
-
-        lastduration = el->d;
-
-        if(number <= el->number)
-            break;
-
-        if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (number - el->number);
-            break;
-        }
-
-        totalscaledtime += (el->d * (el->r + 1));
+        *time = *duration = 0;
+        return true;
     }
 
-    *time = totalscaledtime;
-    *duration = lastduration;
+    std::vector<Element>::const_iterator it = findByNumber(number);
+    if(it == elements.end()) /* before first */
+    {
+        *time = elements.front().t;
+        *duration = elements.front().d;
+    }
+    else if(number <= (*it).number + (*it).r)
+    {
+        *time = (*it).t + (*it).d * (number - (*it).number);
+        *duration = (*it).d;
+    }
+    else if(it + 1 != elements.end()) /* in a numbering gap */
+    {
+        *time = (*(it + 1)).t;
+        *duration = (*(it + 1)).d;
+    }
+    else /* after last */
+    {
+        *time = (*it).end();
+        *duration = (*it).d;
+    }
     return true;
 }
 
@@ -163,15 +156,15 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    const Element &e = elements.back();
+    return e.number + e.r;
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
@@ -184,29 +177,27 @@ void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
 size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 {
     size_t prunednow = 0;
-    while(elements.size())
+
+    std::vector<Element>::iterator it;
+    for(it = elements.begin(); it != elements.end(); ++it)
     {
-        Element *el = elements.front();
-        if(el->number >= number)
+        Element &el = *it;
+        if(el.number >= number)
         {
             break;
         }
-        else if(el->number + el->r >= number)
+        else if(el.number + el.r >= number)
         {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
+            uint64_t count = number - el.number;
+            el.number += count;
+            el.t += count * el.d;
+            el.r -= count;
             prunednow += count;
             break;
         }
-        else
-        {
-            prunednow += el->r + 1;
-            elements.pop_front();
-            delete el;
-        }
+        else prunednow += el.r + 1;
     }
+    elements.erase(elements.begin(), it);
 
     return prunednow;
 }
@@ -215,53 +206,49 @@ void SegmentTimeline::mergeWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
         return;
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    elements.reserve(elements.size() + other.elements.size());
+
+    std::vector<Element>::const_iterator it;
+    for(it = other.elements.begin(); it != other.elements.end(); ++it)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
+        const Element &el = *it;
+        Element &last = elements.back();
 
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
+        if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
         {
-            const uint64_t count = (el->t - last->t) / last->d;
-            last->r = std::max(last->r, el->r + count);
-            delete el;
+            const uint64_t count = (el.t - last.t) / last.d;
+            last.r = std::max(last.r, el.r + count);
         }
-        else if(el->t < last->t)
+        else if(el.t < last.t)
         {
-            delete el;
+            continue;
         }
         else /* Did not exist in previous list */
         {
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            Element added = el;
+            added.number = last.number + last.r + 1;
+            elements.push_back(added);
         }
     }
+    other.elements.clear();
 }
 
 mtime_t SegmentTimeline::start() const
 {
     if(elements.empty())
         return 0;
-    return inheritTimescale().ToTime(elements.front()->t);
+    return inheritTimescale().ToTime(elements.front().t);
 }
 
 mtime_t SegmentTimeline::end() const
 {
     if(elements.empty())
         return 0;
-    const Element *last = elements.back();
-    stime_t scaled = last->t + last->d * (last->r + 1);
-    return inheritTimescale().ToTime(scaled);
+    return inheritTimescale().ToTime(elements.back().end());
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -270,9 +257,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
+    std::vector<Element>::const_iterator it;
     for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+        (*it).debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -285,11 +272,26 @@ SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, sti
 
 bool SegmentTimeline::Element::contains(stime_t time) const
 {
-    if(time >= t && time < t + (stime_t)(r + 1) * d)
+    if(time >= t && time < end())
         return true;
     return false;
 }
 
+stime_t SegmentTimeline::Element::end() const
+{
+    return t + (stime_t)(r + 1) * d;
+}
+
+bool SegmentTimeline::Element::numberBefore(uint64_t number, const Element &el)
+{
+    return number < el.number;
+}
+
+bool SegmentTimeline::Element::timeBefore(stime_t time, const Element &el)
+{
+    return time < el.t;
+}
+
 void SegmentTimeline::Element::debug(vlc_object_t *obj, int indent) const
 {
     std::stringstream ss;
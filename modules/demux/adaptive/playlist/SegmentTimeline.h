@@ -26,7 +26,7 @@
 
 #include "SegmentInfoCommon.h"
 #include <vlc_common.h>
-#include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,8 +34,6 @@ namespace adaptive
     {
         class SegmentTimeline : public TimescaleAble
         {
-            class Element;
-
             public:
                 SegmentTimeline(TimescaleAble *);
                 SegmentTimeline(uint64_t);
@@ -55,19 +53,27 @@ namespace adaptive
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t  end() const;
+                        static bool numberBefore(uint64_t, const Element &);
+                        static bool timeBefore(stime_t, const Element &);
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
                 };
+
+                /* Each element carries its absolute start time and first
+                   number, the prefix sums of the previous (r + 1) * d and
+                   (r + 1), so lookups are binary searches on either. */
+                std::vector<Element> elements;
+                std::vector<Element>::const_iterator findByNumber(uint64_t) const;
+                std::vector<Element>::const_iterator findByScaledTime(stime_t) const;
         };
     }
 }
@@ -0,0 +1,153 @@
+/*
+ * HLSReloadTest.cpp: HLS live playlist reload check
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Loads a live media playlist, then a reload of it sliding by two segments
+ * and adding two, one after a discontinuity, and checks that every segment
+ * has the expected sequence number and starts where the previous one ends.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+#include <vlc_common.h>
+#include <vlc_stream.h>
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BasePeriod.h"
+#include "../playlist/Segment.h"
+#include "../../hls/playlist/M3U8.hpp"
+#include "../../hls/playlist/Parser.hpp"
+#include "../../hls/playlist/Representation.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace adaptive::playlist;
+
+static const char playlist[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0,\n"
+    "s10.ts\n"
+    "#EXTINF:3.5,\n"
+    "s11.ts\n"
+    "#EXTINF:4.0,\n"
+    "s12.ts\n"
+    "#EXTINF:2.0,\n"
+    "s13.ts\n";
+
+static const char reload[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:12\n"
+    "#EXTINF:4.0,\n"
+    "s12.ts\n"
+    "#EXTINF:2.0,\n"
+    "s13.ts\n"
+    "#EXTINF:3.0,\n"
+    "s14.ts\n"
+    "#EXT-X-DISCONTINUITY\n"
+    "#EXTINF:4.0,\n"
+    "s15.ts\n";
+
+/* In the timescale of the parser (1/100 s) */
+static const stime_t durations[] = { 400, 350, 400, 200, 300, 400 };
+
+static stream_t *openString(vlc_object_t *obj, const char *psz)
+{
+    return vlc_stream_MemoryNew(obj, (uint8_t *) psz, strlen(psz), true);
+}
+
+static int check(vlc_object_t *obj)
+{
+    hls::playlist::M3U8Parser parser(NULL);
+    stream_t *s = openString(obj, playlist);
+    if(!s)
+        return 1;
+    hls::playlist::M3U8 *m3u8 = parser.parse(obj, s, "file:///live.m3u8");
+    vlc_stream_Delete(s);
+
+    if(!m3u8 || !m3u8->getFirstPeriod() ||
+       m3u8->getFirstPeriod()->getAdaptationSets().empty() ||
+       m3u8->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().empty())
+    {
+        fprintf(stderr, "cannot load the playlist\n");
+        delete m3u8;
+        return 1;
+    }
+
+    hls::playlist::Representation *rep = dynamic_cast<hls::playlist::Representation *>
+        (m3u8->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().front());
+    int ret = 1;
+    s = openString(obj, reload);
+    if(rep && s)
+    {
+        parser.appendSegmentsFromStream(obj, rep, s);
+
+        /* There must be no segment after the last one */
+        ret = rep->getSegment(SegmentInformation::INFOTYPE_MEDIA,
+                              10 + ARRAY_SIZE(durations)) != NULL;
+        if(ret)
+            fprintf(stderr, "unexpected segment after the reload\n");
+
+        stime_t start = 0;
+        for(size_t i = 0; !ret && i < ARRAY_SIZE(durations); i++)
+        {
+            const ISegment *seg = rep->getSegment(SegmentInformation::INFOTYPE_MEDIA,
+                                                  10 + i);
+            if(!seg)
+            {
+                fprintf(stderr, "segment #%zu missing\n", 10 + i);
+                ret = 1;
+            }
+            else if(seg->startTime.Get() != start ||
+                    seg->duration.Get() != durations[i])
+            {
+                fprintf(stderr, "segment #%zu: start %" PRId64 " duration %"
+                        PRId64 ", expected %" PRId64 " for %" PRId64 "\n",
+                        10 + i, seg->startTime.Get(), seg->duration.Get(),
+                        start, durations[i]);
+                ret = 1;
+            }
+            start += durations[i];
+        }
+    }
+    if(s)
+        vlc_stream_Delete(s);
+    delete m3u8;
+    return ret;
+}
+
+int main(void)
+{
+    const char *argv_vlc[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv_vlc), argv_vlc);
+    if(!vlc)
+        return 1;
+
+    int ret = check(VLC_OBJECT(vlc->p_libvlc_int));
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,461 @@
+/*
+ * LogicSimulator.cpp: offline adaptation logic simulator
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Replays a recorded bandwidth trace against the renditions of a local
+ * HLS master playlist, driving an adaptation logic exactly like the
+ * SegmentTracker and connection manager would, but on a virtual clock.
+ * The run is fully deterministic so that logics can be compared, and
+ * regressions caught, from one build to another.
+ *
+ * Trace format: one "<duration in seconds> <bandwidth in kbit/s>" step
+ * per line, '#' starts a comment. The trace is looped when exhausted.
+ *
+ * Without arguments, a built-in ladder and trace are simulated for every
+ * logic and sanity checked. Built with LOGIC_SIM_TEST, that check is all it
+ * does (make check).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+#include <vlc_common.h>
+#include <vlc_stream.h>
+
+#include "../logic/AbstractAdaptationLogic.h"
+#include "../logic/AlwaysBestAdaptationLogic.h"
+#include "../logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../logic/HybridAdaptationLogic.hpp"
+#include "../logic/NearOptimalAdaptationLogic.hpp"
+#include "../logic/PredictiveAdaptationLogic.hpp"
+#include "../logic/RateBasedAdaptationLogic.h"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BasePeriod.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../SegmentTracker.hpp"
+#include "../ID.hpp"
+#include "../../hls/playlist/M3U8.hpp"
+#include "../../hls/playlist/Parser.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+static const char builtin_manifest[] =
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=400000,RESOLUTION=416x234\n"
+    "v400.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=800000,RESOLUTION=640x360\n"
+    "v800.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=1500000,RESOLUTION=960x540\n"
+    "v1500.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=3000000,RESOLUTION=1280x720\n"
+    "v3000.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=6000000,RESOLUTION=1920x1080\n"
+    "v6000.m3u8\n";
+
+/* seconds, kbit/s: steady, drop, outage, recovery, fluctuation */
+static const char builtin_trace[] =
+    "30 5000\n"
+    "20 1200\n"
+    "4 0\n"
+    "20 2500\n"
+    "10 9000\n"
+    "10 700\n"
+    "10 4000\n"
+    "10 1800\n";
+
+struct TraceStep
+{
+    mtime_t  duration;
+    uint64_t bps;
+};
+
+class Trace
+{
+    public:
+        Trace() : total(0) {}
+
+        bool parse(const char *psz)
+        {
+            while(*psz)
+            {
+                const char *eol = strchr(psz, '\n');
+                std::string line = eol ? std::string(psz, eol - psz) : std::string(psz);
+                psz = eol ? eol + 1 : psz + line.size();
+
+                std::size_t comment = line.find('#');
+                if(comment != std::string::npos)
+                    line.erase(comment);
+
+                double d, kbps;
+                if(sscanf(line.c_str(), "%lf %lf", &d, &kbps) != 2)
+                    continue;
+                if(d <= 0 || kbps < 0)
+                    return false;
+                TraceStep step;
+                step.duration = d * CLOCK_FREQ;
+                step.bps = kbps * 1000;
+                steps.push_back(step);
+                total += step.duration;
+            }
+
+            for(std::size_t i=0; i<steps.size(); i++)
+                if(steps[i].bps)
+                    return true;
+            return false;
+        }
+
+        /* time needed to transfer bits starting at now */
+        mtime_t transferTime(mtime_t now, uint64_t bits) const
+        {
+            mtime_t t = now;
+            double remain = bits;
+            for(;;)
+            {
+                mtime_t offset = t % total;
+                std::size_t i = 0;
+                while(offset >= steps[i].duration)
+                    offset -= steps[i++].duration;
+                const mtime_t left = steps[i].duration - offset;
+                const double capacity = (double) steps[i].bps * left / CLOCK_FREQ;
+                if(capacity >= remain)
+                    return t - now + (mtime_t)(remain * CLOCK_FREQ / steps[i].bps) + 1;
+                remain -= capacity;
+                t += left;
+            }
+        }
+
+        mtime_t duration() const { return total; }
+
+    private:
+        std::vector<TraceStep> steps;
+        mtime_t total;
+};
+
+struct SimParams
+{
+    mtime_t  segment;
+    mtime_t  target;
+    mtime_t  minimum;
+    unsigned count;
+};
+
+struct SimResult
+{
+    uint64_t avgbps;
+    mtime_t  startup;
+    mtime_t  rebuffer;
+    unsigned stalls;
+    unsigned switches;
+};
+
+static AbstractAdaptationLogic *createLogic(vlc_object_t *obj, const std::string &name)
+{
+    if(name == "hybrid")
+        return new HybridAdaptationLogic(obj);
+    else if(name == "nearoptimal")
+        return new NearOptimalAdaptationLogic();
+    else if(name == "predictive")
+        return new PredictiveAdaptationLogic(obj);
+    else if(name == "rate")
+        return new RateBasedAdaptationLogic(obj);
+    else if(name == "lowest")
+        return new AlwaysLowestAdaptationLogic();
+    else if(name == "highest")
+        return new AlwaysBestAdaptationLogic();
+    return NULL;
+}
+
+static const char *const logics[] = {
+    "hybrid", "nearoptimal", "predictive", "rate", "lowest", "highest",
+};
+
+static SimResult simulate(AbstractAdaptationLogic *logic, BaseAdaptationSet *adaptSet,
+                          const Trace &trace, const SimParams &params)
+{
+    SimResult res = { 0, 0, 0, 0, 0 };
+    const ID &id = adaptSet->getID();
+    BaseRepresentation *prev = NULL;
+    mtime_t now = 0;
+    mtime_t buffer = 0;
+    bool playing = false;
+    bool started = false;
+    double bits = 0;
+
+    logic->trackerEvent(SegmentTrackerEvent(id, true));
+
+    for(unsigned i=0; i<params.count; i++)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(adaptSet, prev);
+        if(!rep)
+            break;
+        if(rep != prev)
+        {
+            logic->trackerEvent(SegmentTrackerEvent(prev, rep));
+            if(prev)
+                res.switches++;
+        }
+        logic->trackerEvent(SegmentTrackerEvent(id, params.segment));
+
+        const uint64_t size = rep->getBandwidth() * params.segment / CLOCK_FREQ;
+        const mtime_t dl = trace.transferTime(now, size);
+
+        /* playback drains the buffer while downloading */
+        if(playing)
+        {
+            if(buffer >= dl)
+            {
+                buffer -= dl;
+            }
+            else
+            {
+                res.rebuffer += dl - buffer;
+                res.stalls++;
+                buffer = 0;
+                playing = false;
+            }
+        }
+        else if(started)
+            res.rebuffer += dl;
+        else
+            res.startup += dl;
+        now += dl;
+
+        buffer += params.segment;
+        bits += (double) rep->getBandwidth() * params.segment / CLOCK_FREQ;
+        if(!playing && buffer >= params.minimum)
+            playing = started = true;
+
+        logic->updateDownloadRate(id, size / 8, dl);
+        logic->trackerEvent(SegmentTrackerEvent(id, params.minimum, buffer, params.target));
+
+        /* buffer full: wait for room for the next segment */
+        if(playing && buffer + params.segment > params.target)
+        {
+            const mtime_t idle = buffer + params.segment - params.target;
+            buffer -= idle;
+            now += idle;
+            logic->trackerEvent(SegmentTrackerEvent(id, params.minimum, buffer, params.target));
+        }
+
+        prev = rep;
+    }
+
+    logic->trackerEvent(SegmentTrackerEvent(prev, NULL));
+    logic->trackerEvent(SegmentTrackerEvent(id, false));
+
+    if(params.count)
+        res.avgbps = bits * CLOCK_FREQ / ((mtime_t) params.count * params.segment);
+    return res;
+}
+
+static char *readFile(const char *psz_path, size_t *pi_size)
+{
+    FILE *f = fopen(psz_path, "rb");
+    if(!f)
+        return NULL;
+    std::string data;
+    char buf[4096];
+    size_t i_read;
+    while((i_read = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.append(buf, i_read);
+    fclose(f);
+    char *p = (char *) malloc(data.size() + 1);
+    if(p)
+    {
+        memcpy(p, data.c_str(), data.size() + 1);
+        *pi_size = data.size();
+    }
+    return p;
+}
+
+static hls::playlist::M3U8 *loadManifest(vlc_object_t *obj, const char *psz_data, size_t i_data)
+{
+    stream_t *s = vlc_stream_MemoryNew(obj, (uint8_t *) psz_data, i_data, true);
+    if(!s)
+        return NULL;
+    hls::playlist::M3U8Parser parser(NULL);
+    hls::playlist::M3U8 *playlist = parser.parse(obj, s, "file:///sim.m3u8");
+    vlc_stream_Delete(s);
+    return playlist;
+}
+
+#ifndef LOGIC_SIM_TEST
+static void usage(const char *psz_name)
+{
+    fprintf(stderr, "Usage: %s [-m master.m3u8] [-t trace] [-l logic] "
+                    "[-s segment duration] [-b buffer target] [-n segments]\n"
+                    "  logics:", psz_name);
+    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+        fprintf(stderr, " %s", logics[i]);
+    fprintf(stderr, "\n");
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    const char *psz_manifest = NULL;
+    const char *psz_trace = NULL;
+    const char *psz_logic = NULL;
+    SimParams params;
+    params.segment = 4 * CLOCK_FREQ;
+    params.target = 30 * CLOCK_FREQ;
+    params.count = 0;
+
+#ifndef LOGIC_SIM_TEST
+    int c;
+    while((c = getopt(argc, argv, "m:t:l:s:b:n:h")) != -1)
+    {
+        switch(c)
+        {
+            case 'm': psz_manifest = optarg; break;
+            case 't': psz_trace = optarg; break;
+            case 'l': psz_logic = optarg; break;
+            case 's': params.segment = atof(optarg) * CLOCK_FREQ; break;
+            case 'b': params.target = atof(optarg) * CLOCK_FREQ; break;
+            case 'n': params.count = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if(params.segment <= 0 || params.target < params.segment)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+#else
+    VLC_UNUSED(argc); VLC_UNUSED(argv);
+#endif
+    params.minimum = params.segment;
+
+    const bool selftest = !psz_manifest && !psz_trace;
+
+    size_t i_manifest = sizeof(builtin_manifest) - 1;
+    char *psz_manifest_data = psz_manifest ? readFile(psz_manifest, &i_manifest)
+                                           : strdup(builtin_manifest);
+    size_t i_trace = sizeof(builtin_trace) - 1;
+    char *psz_trace_data = psz_trace ? readFile(psz_trace, &i_trace)
+                                     : strdup(builtin_trace);
+    if(!psz_manifest_data || !psz_trace_data)
+    {
+        fprintf(stderr, "cannot read %s\n", !psz_manifest_data ? psz_manifest : psz_trace);
+        free(psz_manifest_data);
+        free(psz_trace_data);
+        return 1;
+    }
+
+    Trace trace;
+    bool b_trace = trace.parse(psz_trace_data);
+    free(psz_trace_data);
+    if(!b_trace)
+    {
+        fprintf(stderr, "invalid or empty bandwidth trace\n");
+        free(psz_manifest_data);
+        return 1;
+    }
+    if(!params.count)
+        params.count = (trace.duration() + params.segment - 1) / params.segment;
+
+    const char *argv_vlc[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv_vlc), argv_vlc);
+    if(!vlc)
+    {
+        free(psz_manifest_data);
+        return 1;
+    }
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    int ret = 0;
+    hls::playlist::M3U8 *playlist = loadManifest(obj, psz_manifest_data, i_manifest);
+    BaseAdaptationSet *adaptSet = NULL;
+    if(playlist && playlist->getFirstPeriod() &&
+       !playlist->getFirstPeriod()->getAdaptationSets().empty())
+        adaptSet = playlist->getFirstPeriod()->getAdaptationSets().front();
+
+    if(!adaptSet || adaptSet->getRepresentations().empty())
+    {
+        fprintf(stderr, "no renditions in manifest\n");
+        ret = 1;
+    }
+    else
+    {
+        const std::vector<BaseRepresentation *> &reps = adaptSet->getRepresentations();
+        printf("%zu renditions %" PRIu64 "..%" PRIu64 " kbit/s, %u segments of %.1fs, buffer %.1fs\n",
+               reps.size(), reps.front()->getBandwidth() / 1000, reps.back()->getBandwidth() / 1000,
+               params.count, (double) params.segment / CLOCK_FREQ, (double) params.target / CLOCK_FREQ);
+        printf("%-12s %10s %10s %10s %7s %9s\n",
+               "logic", "avg kbit/s", "startup s", "rebuffer s", "stalls", "switches");
+
+        std::vector<SimResult> results;
+        for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+        {
+            if(psz_logic && strcmp(psz_logic, logics[i]))
+                continue;
+            AbstractAdaptationLogic *logic = createLogic(obj, logics[i]);
+            SimResult res = simulate(logic, adaptSet, trace, params);
+            delete logic;
+            results.push_back(res);
+
+            printf("%-12s %10" PRIu64 " %10.2f %10.2f %7u %9u\n", logics[i], res.avgbps / 1000,
+                   (double) res.startup / CLOCK_FREQ, (double) res.rebuffer / CLOCK_FREQ,
+                   res.stalls, res.switches);
+        }
+
+        if(selftest && !psz_logic)
+        {
+            /* results are in logics[] order, highest last */
+            const SimResult &highest = results.back();
+            for(size_t i=0; i<results.size(); i++)
+            {
+                const SimResult &res = results[i];
+                bool b_ok = res.avgbps >= reps.front()->getBandwidth() &&
+                            res.avgbps <= reps.back()->getBandwidth();
+                /* the built-in trace never drops below the lowest rendition
+                 * for longer than the buffer, and can't sustain the highest */
+                if(!strcmp(logics[i], "lowest"))
+                    b_ok &= (res.rebuffer == 0);
+                else if(strcmp(logics[i], "highest"))
+                    b_ok &= (res.rebuffer < highest.rebuffer);
+                if(!b_ok)
+                {
+                    fprintf(stderr, "%s: unexpected result\n", logics[i]);
+                    ret = 1;
+                }
+            }
+        }
+    }
+
+    delete playlist;
+    free(psz_manifest_data);
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,121 @@
+/*
+ * SegmentTimelineBench.cpp: SegmentTimeline lookups benchmark
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Times number <-> time lookups at random positions of a long synthetic
+ * timeline. SegmentTimelineTest.cpp checks their results.
+ *
+ * Usage: adaptive_timeline_bench [entries] (default 100000)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_bench.h>
+
+#include "../playlist/SegmentTimeline.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace adaptive::playlist;
+
+#define LOOKUPS 1000 /* per call, to make the call itself negligible */
+
+struct LookupBench
+{
+    const SegmentTimeline *timeline;
+    std::vector<uint64_t> numbers;
+    std::vector<stime_t> times;
+    unsigned seed;
+    uint64_t sum;
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7fff;
+}
+
+static size_t randomSegment(LookupBench *bench)
+{
+    return (rnd(&bench->seed) << 15 | rnd(&bench->seed)) % bench->numbers.size();
+}
+
+static void lookupNumber(void *opaque)
+{
+    LookupBench *bench = static_cast<LookupBench *>(opaque);
+    for(unsigned i = 0; i < LOOKUPS; i++)
+        bench->sum += bench->timeline->getElementNumberByScaledPlaybackTime(
+                        bench->times[randomSegment(bench)]);
+}
+
+static void lookupTime(void *opaque)
+{
+    LookupBench *bench = static_cast<LookupBench *>(opaque);
+    for(unsigned i = 0; i < LOOKUPS; i++)
+        bench->sum += bench->timeline->getScaledPlaybackTimeByElementNumber(
+                        bench->numbers[randomSegment(bench)]);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned entries = 100000;
+    if(argc > 1)
+        entries = atoi(argv[1]);
+    if(entries < 1)
+        return 1;
+
+    SegmentTimeline timeline((uint64_t) 1000);
+    LookupBench bench;
+    bench.timeline = &timeline;
+    bench.seed = 7;
+    bench.sum = 0;
+
+    /* varying durations and repeats, like a live stream timeline */
+    uint64_t number = 1;
+    stime_t t = 90000;
+    for(unsigned i = 0; i < entries; i++)
+    {
+        const stime_t d = 1800 + rnd(&bench.seed) % 400;
+        const uint64_t r = (rnd(&bench.seed) % 8 == 0) ? rnd(&bench.seed) % 5 : 0;
+        if(i == 0)
+            timeline.addElement(number, d, r, t);
+        else
+            timeline.addElement(number, d, r);
+        for(uint64_t j = 0; j <= r; j++)
+        {
+            bench.numbers.push_back(number++);
+            bench.times.push_back(t + d / 2);
+            t += d;
+        }
+    }
+
+    double rate = vlc_bench_Run(lookupNumber, &bench, CLOCK_FREQ / 5);
+    printf("%u entries, time -> number: %.1f ns/lookup\n", entries,
+           1000.0 / (rate * LOOKUPS));
+    rate = vlc_bench_Run(lookupTime, &bench, CLOCK_FREQ / 5);
+    printf("%u entries, number -> time: %.1f ns/lookup (%" PRIu64 ")\n",
+           entries, 1000.0 / (rate * LOOKUPS), bench.sum);
+    return 0;
+}
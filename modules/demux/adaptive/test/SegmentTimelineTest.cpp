@@ -0,0 +1,158 @@
+/*
+ * SegmentTimelineTest.cpp: SegmentTimeline lookups check
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Builds a synthetic timeline (varying durations, repeats and a few
+ * discontinuities), checks number <-> time lookups, pruning and merging
+ * against the expanded list of segments.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "../playlist/SegmentTimeline.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace adaptive::playlist;
+
+struct RefSegment
+{
+    uint64_t number;
+    stime_t  time;
+    stime_t  duration;
+};
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7fff;
+}
+
+/* Fills both the timeline and the expanded reference */
+static void generate(SegmentTimeline *timeline, std::vector<RefSegment> &ref,
+                     unsigned entries, uint64_t number, stime_t t)
+{
+    unsigned seed = 42;
+    for(unsigned i = 0; i < entries; i++)
+    {
+        const stime_t d = 1800 + rnd(&seed) % 400;
+        const uint64_t r = (rnd(&seed) % 8 == 0) ? rnd(&seed) % 5 : 0;
+        const bool gap = (i > 0 && rnd(&seed) % 1000 == 0);
+        if(gap)
+            t += 3 * d;
+        if(gap || i == 0)
+            timeline->addElement(number, d, r, t);
+        else
+            timeline->addElement(number, d, r);
+
+        for(uint64_t j = 0; j <= r; j++)
+        {
+            RefSegment seg = { number, t, d };
+            ref.push_back(seg);
+            number++;
+            t += d;
+        }
+    }
+}
+
+static int check(const SegmentTimeline &timeline, const std::vector<RefSegment> &ref)
+{
+    if(timeline.minElementNumber() != ref.front().number ||
+       timeline.maxElementNumber() != ref.back().number)
+    {
+        fprintf(stderr, "bad bounds %" PRIu64 "-%" PRIu64 "\n",
+                timeline.minElementNumber(), timeline.maxElementNumber());
+        return 1;
+    }
+
+    for(size_t i = 0; i < ref.size(); i++)
+    {
+        const RefSegment &seg = ref[i];
+        stime_t time, duration;
+        timeline.getScaledPlaybackTimeDurationBySegmentNumber(seg.number, &time, &duration);
+        if(time != seg.time || duration != seg.duration)
+        {
+            fprintf(stderr, "segment %" PRIu64 ": got %" PRId64 "/%" PRId64
+                    " expected %" PRId64 "/%" PRId64 "\n", seg.number,
+                    time, duration, seg.time, seg.duration);
+            return 1;
+        }
+
+        const stime_t probes[2] = { seg.time, seg.time + seg.duration - 1 };
+        for(int j = 0; j < 2; j++)
+        {
+            uint64_t number = timeline.getElementNumberByScaledPlaybackTime(probes[j]);
+            if(number != seg.number)
+            {
+                fprintf(stderr, "time %" PRId64 ": got #%" PRIu64 " expected #%" PRIu64 "\n",
+                        probes[j], number, seg.number);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    const unsigned entries = 100000;
+    SegmentTimeline timeline((uint64_t) 1000);
+    std::vector<RefSegment> ref;
+
+    mtime_t start = mdate();
+    generate(&timeline, ref, entries, 1, 90000);
+    printf("built %u entries (%zu segments) in %" PRId64 " us\n",
+           entries, ref.size(), mdate() - start);
+
+    if(check(timeline, ref))
+        return 1;
+
+    /* live window: prune the first half, then merge an overlapping update */
+    const size_t half = ref.size() / 2;
+    size_t pruned = timeline.pruneBySequenceNumber(ref[half].number);
+    if(pruned != half)
+    {
+        fprintf(stderr, "pruned %zu expected %zu\n", pruned, half);
+        return 1;
+    }
+    ref.erase(ref.begin(), ref.begin() + half);
+
+    SegmentTimeline update((uint64_t) 1000);
+    const RefSegment &last = ref.back();
+    update.addElement(0, last.duration, 0, last.time);
+    update.addElement(0, 2000, 9);
+    timeline.mergeWith(update);
+    for(int i = 0; i < 10; i++)
+    {
+        const RefSegment &prev = ref.back();
+        RefSegment seg = { prev.number + 1, prev.time + prev.duration, 2000 };
+        ref.push_back(seg);
+    }
+
+    if(check(timeline, ref))
+        return 1;
+
+    return 0;
+}
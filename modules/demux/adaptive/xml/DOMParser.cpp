@@ -77,6 +77,24 @@ bool    DOMParser::parse                    (bool b)
     return true;
 }
 
+void DOMParser::setChildrenHandler(const std::string &name,
+                                   const ChildrenHandler *handler)
+{
+    if(handler)
+        handlers[name] = handler;
+    else
+        handlers.erase(name);
+}
+
+const DOMParser::ChildrenHandler * DOMParser::getChildrenHandler(const Node *node) const
+{
+    if(handlers.empty())
+        return NULL;
+    std::map<std::string, const ChildrenHandler *>::const_iterator it =
+            handlers.find(node->getName());
+    return (it != handlers.end()) ? (*it).second : NULL;
+}
+
 bool DOMParser::reset(stream_t *s)
 {
     stream = s;
@@ -101,6 +119,16 @@ Node* DOMParser::processNode(bool b_strict)
             case XML_READER_STARTELEM:
             {
                 bool empty = xml_ReaderIsEmptyElement(vlc_reader);
+                const ChildrenHandler *handler = (!lifo.empty()) ?
+                                                 getChildrenHandler(lifo.top()) : NULL;
+                if(handler)
+                {
+                    handler->handleChild(lifo.top(), data, vlc_reader);
+                    if(!empty)
+                        skipElement();
+                    break;
+                }
+
                 Node *node = new (std::nothrow) Node();
                 if(node)
                 {
@@ -154,6 +182,26 @@ Node* DOMParser::processNode(bool b_strict)
     return node;
 }
 
+void DOMParser::skipElement()
+{
+    const char *data;
+    int type;
+    unsigned depth = 1;
+
+    while( depth && (type = xml_ReaderNextNode(vlc_reader, &data)) > 0 )
+    {
+        if(type == XML_READER_STARTELEM)
+        {
+            if(!xml_ReaderIsEmptyElement(vlc_reader))
+                depth++;
+        }
+        else if(type == XML_READER_ENDELEM)
+        {
+            depth--;
+        }
+    }
+}
+
 void    DOMParser::addAttributesToNode      (Node *node)
 {
     const char *attrValue;
@@ -30,6 +30,9 @@
 
 #include "Node.h"
 
+#include <map>
+#include <string>
+
 namespace adaptive
 {
     namespace xml
@@ -37,6 +40,18 @@ namespace adaptive
         class DOMParser
         {
             public:
+                /* Consumes the children of a registered element straight from
+                   the reader, so long lists (timelines, chunks) don't get one
+                   Node and attributes map per entry. Called once per child
+                   element, positioned on its start tag. */
+                class ChildrenHandler
+                {
+                    public:
+                        virtual ~ChildrenHandler() {}
+                        virtual void handleChild(Node *parent, const char *name,
+                                                 xml_reader_t *) const = 0;
+                };
+
                 DOMParser           ();
                 DOMParser           (stream_t *stream);
                 virtual ~DOMParser  ();
@@ -45,15 +60,20 @@ namespace adaptive
                 bool                reset       (stream_t *);
                 Node*               getRootNode ();
                 void                print       ();
+                void                setChildrenHandler(const std::string &,
+                                                       const ChildrenHandler *);
 
             private:
                 Node                *root;
                 stream_t            *stream;
 
                 xml_reader_t        *vlc_reader;
+                std::map<std::string, const ChildrenHandler *> handlers;
 
                 Node*   processNode             (bool);
                 void    addAttributesToNode     (Node *node);
+                void    skipElement             ();
+                const ChildrenHandler * getChildrenHandler(const Node *) const;
                 void    print                   (Node *node, int offset);
         };
     }
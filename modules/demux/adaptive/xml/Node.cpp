@@ -36,13 +36,15 @@ using namespace adaptive::xml;
 const std::string   Node::EmptyString = "";
 
 Node::Node() :
-    type( -1 )
+    type( -1 ),
+    data( NULL )
 {
 }
 Node::~Node ()
 {
     for(size_t i = 0; i < this->subNodes.size(); i++)
         delete(this->subNodes.at(i));
+    delete data;
 }
 
 const std::vector<Node*>&           Node::getSubNodes           () const
@@ -119,6 +121,17 @@ void Node::setType(int type)
     this->type = type;
 }
 
+NodeData * Node::getData() const
+{
+    return data;
+}
+
+void Node::setData(NodeData *data)
+{
+    delete this->data;
+    this->data = data;
+}
+
 std::vector<std::string> Node::toString(int indent) const
 {
     std::vector<std::string> ret;
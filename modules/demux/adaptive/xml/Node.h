@@ -33,6 +33,14 @@ namespace adaptive
 {
     namespace xml
     {
+        /* Compact payload built by a DOMParser::ChildrenHandler
+           in place of an element's subnodes */
+        class NodeData
+        {
+            public:
+                virtual ~NodeData() {}
+        };
+
         class Node
         {
             public:
@@ -53,6 +61,8 @@ namespace adaptive
                 int                                 getType() const;
                 void                                setType( int type );
                 std::vector<std::string>            toString(int) const;
+                NodeData *                          getData() const;
+                void                                setData( NodeData * );
 
             private:
                 static const std::string            EmptyString;
@@ -61,6 +71,7 @@ namespace adaptive
                 std::string                         name;
                 std::string                         text;
                 int                                 type;
+                NodeData                            *data;
 
         };
     }
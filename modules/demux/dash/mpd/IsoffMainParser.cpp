@@ -40,16 +40,90 @@
 #include "ProgramInformation.h"
 #include "DASHSegment.h"
 #include "../adaptive/xml/DOMHelper.h"
+#include "../adaptive/xml/DOMParser.h"
 #include "../adaptive/tools/Helper.h"
 #include "../adaptive/tools/Debug.hpp"
 #include "../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
+#include <vlc_xml.h>
 #include <cstdio>
+#include <cstring>
 
 using namespace dash::mpd;
 using namespace adaptive::xml;
 using namespace adaptive::playlist;
 
+namespace
+{
+    /* Live MPDs can carry thousands of <S> per timeline. We store them
+       as plain entries on the SegmentTimeline node instead of subnodes. */
+    class TimelineEntries : public NodeData
+    {
+        public:
+            struct Entry
+            {
+                stime_t  t;
+                stime_t  d;
+                uint64_t r;
+                bool     hasT;
+            };
+            std::vector<Entry> entries;
+    };
+
+    class TimelineHandler : public DOMParser::ChildrenHandler
+    {
+        public:
+            virtual void handleChild(Node *parent, const char *name,
+                                     xml_reader_t *reader) const
+            {
+                if(strcmp(name, "S"))
+                    return;
+
+                TimelineEntries *data = dynamic_cast<TimelineEntries *>(parent->getData());
+                if(!data)
+                {
+                    data = new (std::nothrow) TimelineEntries();
+                    if(!data)
+                        return;
+                    parent->setData(data);
+                }
+
+                TimelineEntries::Entry entry = { 0, 0, 0, false };
+                bool hasD = false;
+                const char *attrName, *attrValue;
+                while((attrName = xml_ReaderNextAttr(reader, &attrValue)) != NULL)
+                {
+                    if(!strcmp(attrName, "t"))
+                    {
+                        entry.t = strtoll(attrValue, NULL, 10);
+                        entry.hasT = true;
+                    }
+                    else if(!strcmp(attrName, "d"))
+                    {
+                        entry.d = strtoll(attrValue, NULL, 10);
+                        hasD = true;
+                    }
+                    else if(!strcmp(attrName, "r"))
+                    {
+                        /* negative (open ended) repeat is unsupported */
+                        if(attrValue[0] != '-')
+                            entry.r = strtoull(attrValue, NULL, 10);
+                    }
+                }
+
+                if(hasD) /* Mandatory */
+                    data->entries.push_back(entry);
+            }
+    };
+
+    const TimelineHandler timelineHandler;
+}
+
+void IsoffMainParser::setupDOMParser(DOMParser &parser)
+{
+    parser.setChildrenHandler("SegmentTimeline", &timelineHandler);
+}
+
 IsoffMainParser::IsoffMainParser    (Node *root_, vlc_object_t *p_object_,
                                      stream_t *stream, const std::string & streambaseurl_)
 {
@@ -451,6 +525,20 @@ void IsoffMainParser::parseTimeline(Node *node, MediaSegmentTemplate *templ)
     SegmentTimeline *timeline = new (std::nothrow) SegmentTimeline(templ);
     if(timeline)
     {
+        const TimelineEntries *data = dynamic_cast<TimelineEntries *>(node->getData());
+        if(data)
+        {
+            std::vector<TimelineEntries::Entry>::const_iterator it;
+            for(it = data->entries.begin(); it != data->entries.end(); ++it)
+            {
+                if((*it).hasT)
+                    timeline->addElement(number, (*it).d, (*it).r, (*it).t);
+                else
+                    timeline->addElement(number, (*it).d, (*it).r);
+                number += (1 + (*it).r);
+            }
+        }
+
         std::vector<Node *> elements = DOMHelper::getElementByTagName(node, "S", false);
         std::vector<Node *>::const_iterator it;
         for(it = elements.begin(); it != elements.end(); ++it)
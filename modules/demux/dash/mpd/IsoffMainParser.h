@@ -46,6 +46,7 @@ namespace adaptive
     namespace xml
     {
         class Node;
+        class DOMParser;
     }
 }
 
@@ -67,6 +68,7 @@ namespace dash
                                              stream_t *p_stream, const std::string &);
                 virtual ~IsoffMainParser    ();
                 MPD *   parse();
+                static void setupDOMParser(xml::DOMParser &);
 
             private:
                 mpd::Profile getProfile     () const;
@@ -39,6 +39,7 @@
 #include <sstream>
 #include <map>
 #include <cctype>
+#include <ctime>
 #include <algorithm>
 
 using namespace adaptive;
@@ -171,18 +172,24 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(p_obj, auth, rep->getPlaylistUrl().toString());
+    const time_t now = time(NULL);
+    std::string uri = rep->getPlaylistUrl().toString();
+
+    /* On live reloads, if the server allows, ask for a delta update
+     * (EXT-X-SKIP), which we can only do if our copy isn't older than
+     * half the skip boundary */
+    if(rep->b_loaded &&
+       rep->canSkipUntil > 0 && now - rep->lastUpdateTime < rep->canSkipUntil / 2)
+        uri.append((uri.find('?') == std::string::npos) ? "?" : "&").append("_HLS_skip=YES");
+
+    block_t *p_block = Retrieve::HTTP(p_obj, auth, uri);
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
         if(substream)
         {
-            std::list<Tag *> tagslist = parseEntries(substream);
+            appendSegmentsFromStream(p_obj, rep, substream);
             vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
         }
         block_Release(p_block);
         return true;
@@ -190,19 +197,35 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representati
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromStream(vlc_object_t *p_obj, Representation *rep,
+                                          stream_t *p_stream)
+{
+    /* On live reloads, we already know everything up to nextSequenceNumber */
+    const uint64_t firstneeded = rep->b_loaded ? rep->nextSequenceNumber : 0;
+
+    std::list<Tag *> tagslist = parseEntries(p_stream, firstneeded);
+    parseSegments(p_obj, rep, tagslist);
+    releaseTagsList(tagslist);
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
+    /* Reloads only carry segments following the ones we know,
+     * so pick up where the previous parsing stopped */
+    const bool b_reload = rep->b_loaded;
+
     rep->setTimescale(100);
     rep->b_loaded = true;
+    rep->lastUpdateTime = time(NULL);
 
     mtime_t totalduration = 0;
-    mtime_t nzStartTime = 0;
-    mtime_t absReferenceTime = VLC_TS_INVALID;
+    mtime_t nzStartTime = b_reload ? rep->nextStartTime : 0;
+    mtime_t absReferenceTime = b_reload ? rep->nextUTCTime : VLC_TS_INVALID;
     uint64_t sequenceNumber = 0;
     bool discontinuity = false;
-    std::size_t prevbyterangeoffset = 0;
+    std::size_t prevbyterangeoffset = b_reload ? rep->nextByteRangeOffset : 0;
     const SingleValueTag *ctx_byterange = NULL;
     SegmentEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
@@ -370,9 +393,33 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             case Tag::EXTXENDLIST:
                 rep->b_live = false;
                 break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                /* delta update: skipped segments are the ones we already have */
+                const Attribute *skipAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("SKIPPED-SEGMENTS");
+                if(skipAttr)
+                    sequenceNumber += skipAttr->decimal();
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const Attribute *skipAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("CAN-SKIP-UNTIL");
+                rep->canSkipUntil = skipAttr ? skipAttr->floatingPoint() : 0;
+            }
+            break;
         }
     }
 
+    if(!b_reload || sequenceNumber > rep->nextSequenceNumber)
+    {
+        rep->nextSequenceNumber = sequenceNumber;
+        rep->nextUTCTime = absReferenceTime;
+        rep->nextStartTime = nzStartTime;
+        rep->nextByteRangeOffset = prevbyterangeoffset;
+    }
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -532,14 +579,73 @@ M3U8 * M3U8Parser::parse(vlc_object_t *p_object, stream_t *p_stream, const std::
     return playlist;
 }
 
-std::list<Tag *> M3U8Parser::parseEntries(stream_t *stream)
+static bool isSegmentTag(const char *psz_line)
+{
+    static const char *const segmenttags[] = {
+        "#EXTINF:", "#EXT-X-BYTERANGE:", "#EXT-X-PROGRAM-DATE-TIME:",
+    };
+    for(size_t i=0; i<ARRAY_SIZE(segmenttags); i++)
+        if(!strncmp(psz_line, segmenttags[i], strlen(segmenttags[i])))
+            return true;
+    return !strcmp(psz_line, "#EXT-X-DISCONTINUITY");
+}
+
+std::list<Tag *> M3U8Parser::parseEntries(stream_t *stream, uint64_t firstneeded)
 {
     std::list<Tag *> entrieslist;
     Tag *lastTag = NULL;
     char *psz_line;
 
+    /* Segments below firstneeded are already known: their lines are only
+     * counted, and we resume with a media sequence number matching the
+     * first segment we do tokenise. Playlist wide tags are always kept. */
+    uint64_t sequence = 0;
+    bool b_skipped = false;
+
     while((psz_line = vlc_stream_ReadLine(stream)))
     {
+        if(sequence < firstneeded)
+        {
+            if(*psz_line == '#')
+            {
+                if(!strncmp(psz_line, "#EXT-X-MEDIA-SEQUENCE:", 22))
+                    sequence = strtoull(psz_line + 22, NULL, 10);
+                else if(!strncmp(psz_line, "#EXT-X-SKIP:", 12))
+                {
+                    AttributesTag skiptag(AttributesTag::EXTXSKIP, std::string(psz_line + 12));
+                    const Attribute *skipAttr = skiptag.getAttributeByName("SKIPPED-SEGMENTS");
+                    if(skipAttr)
+                        sequence += skipAttr->decimal();
+                    b_skipped = true;
+                    free(psz_line);
+                    continue;
+                }
+                else if(isSegmentTag(psz_line))
+                {
+                    b_skipped = true;
+                    free(psz_line);
+                    continue;
+                }
+            }
+            else if(*psz_line)
+            {
+                sequence++;
+                b_skipped = true;
+                free(psz_line);
+                continue;
+            }
+        }
+        else if(b_skipped)
+        {
+            std::ostringstream os;
+            os.imbue(std::locale("C"));
+            os << sequence;
+            Tag *tag = TagFactory::createTagByName("EXT-X-MEDIA-SEQUENCE", os.str());
+            if(tag)
+                entrieslist.push_back(tag);
+            b_skipped = false;
+        }
+
         if(*psz_line == '#')
         {
             if(!strncmp(psz_line, "#EXT", 4)) //tag
@@ -62,6 +62,7 @@ namespace hls
 
                 M3U8 *             parse  (vlc_object_t *p_obj, stream_t *p_stream, const std::string &);
                 bool appendSegmentsFromPlaylistURI(vlc_object_t *, Representation *);
+                void appendSegmentsFromStream(vlc_object_t *, Representation *, stream_t *);
 
             private:
                 Representation * createRepresentation(BaseAdaptationSet *, const AttributesTag *);
@@ -69,7 +70,7 @@ namespace hls
                                                  const AttributesTag *, const std::list<Tag *>&);
                 void parseSegments(vlc_object_t *, Representation *, const std::list<Tag *>&);
                 void setFormatFromExtension(Representation *rep, const std::string &);
-                std::list<Tag *> parseEntries(stream_t *);
+                std::list<Tag *> parseEntries(stream_t *, uint64_t = 0);
                 AuthStorage *auth;
         };
     }
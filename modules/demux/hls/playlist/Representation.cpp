@@ -46,6 +46,12 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     nextUpdateTime = 0;
     targetDuration = 0;
     streamFormat = StreamFormat::UNKNOWN;
+    nextSequenceNumber = 0;
+    nextUTCTime = VLC_TS_INVALID;
+    nextStartTime = 0;
+    nextByteRangeOffset = 0;
+    canSkipUntil = 0;
+    lastUpdateTime = 0;
 }
 
 Representation::~Representation ()
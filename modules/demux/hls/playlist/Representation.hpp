@@ -60,6 +60,14 @@ namespace hls
                 time_t nextUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+
+                /* Parser state carried across live reloads */
+                uint64_t nextSequenceNumber;
+                mtime_t nextUTCTime;
+                mtime_t nextStartTime;
+                std::size_t nextByteRangeOffset;
+                double canSkipUntil;
+                time_t lastUpdateTime;
         };
     }
 }
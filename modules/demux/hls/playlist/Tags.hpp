@@ -97,6 +97,8 @@ namespace hls
                     EXTXMAP,
                     EXTXMEDIA,
                     EXTXSTREAMINF,
+                    EXTXSKIP,
+                    EXTXSERVERCONTROL,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -748,7 +748,8 @@ int D3D11OpenConverter( vlc_object_t *obj )
     if (!p_sys)
         return VLC_ENOMEM;
 
-    if (CopyInitCache(&p_sys->cache, p_filter->fmt_in.video.i_width * pixel_bytes))
+    if (CopyInitCacheThreads(&p_sys->cache, obj,
+                             p_filter->fmt_in.video.i_width * pixel_bytes, 0))
         return VLC_ENOMEM;
 
     if (D3D11_Create(p_filter, &p_sys->hd3d) != VLC_SUCCESS)
@@ -339,7 +339,8 @@ int D3D9OpenConverter( vlc_object_t *obj )
     if (!p_sys)
          return VLC_ENOMEM;
 
-    if (CopyInitCache(&p_sys->cache, p_filter->fmt_in.video.i_width * pixel_bytes))
+    if (CopyInitCacheThreads(&p_sys->cache, obj,
+                             p_filter->fmt_in.video.i_width * pixel_bytes, 0))
     {
         free(p_sys);
         return VLC_ENOMEM;
@@ -373,8 +373,8 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
         filter_sys->dest_pics = NULL;
     }
 
-    if (CopyInitCache(&filter_sys->cache, filter->fmt_in.video.i_width
-                      * pixel_bytes))
+    if (CopyInitCacheThreads(&filter_sys->cache, obj,
+                             filter->fmt_in.video.i_width * pixel_bytes, 0))
     {
         if (is_upload)
         {
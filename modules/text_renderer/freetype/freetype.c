@@ -70,6 +70,7 @@
 #include "platform_fonts.h"
 #include "freetype.h"
 #include "text_layout.h"
+#include "text_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -1416,6 +1417,9 @@ static int Create( vlc_object_t *p_this )
 
     p_sys->i_scale = 100;
 
+    p_sys->p_glyph_cache = GlyphCacheNew( GLYPH_CACHE_MAX_BYTES );
+    p_sys->p_line_cache = LineCacheNew( LINE_CACHE_MAX_BYTES );
+
     /* default style to apply to uncomplete segmeents styles */
     p_sys->p_default_style = text_style_Create( STYLE_FULLY_SET );
     if(unlikely(!p_sys->p_default_style))
@@ -1534,6 +1538,19 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Caches */
+    text_cache_stats_t glyph_stats, line_stats;
+    GlyphCacheGetStats( p_sys->p_glyph_cache, &glyph_stats );
+    LineCacheGetStats( p_sys->p_line_cache, &line_stats );
+    msg_Dbg( p_filter, "glyph cache: %u hits, %u misses, %zu KiB",
+             glyph_stats.i_hits, glyph_stats.i_misses,
+             glyph_stats.i_bytes / 1024 );
+    msg_Dbg( p_filter, "line cache: %u hits, %u misses, %zu KiB",
+             line_stats.i_hits, line_stats.i_misses,
+             line_stats.i_bytes / 1024 );
+    LineCacheDelete( p_sys->p_line_cache );
+    GlyphCacheDelete( p_sys->p_glyph_cache );
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
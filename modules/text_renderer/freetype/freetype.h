@@ -73,6 +73,8 @@ typedef uint32_t uni_char_t;
  * It describes the freetype specific properties of an output thread.
  *****************************************************************************/
 typedef struct vlc_family_t vlc_family_t;
+typedef struct glyph_cache_t glyph_cache_t;
+typedef struct line_cache_t line_cache_t;
 struct filter_sys_t
 {
     FT_Library     p_library;       /* handle to library     */
@@ -113,6 +115,10 @@ struct filter_sys_t
 
     int               i_fallback_counter;
 
+    /** Rasterised glyphs and laid out lines, see text_cache.h */
+    glyph_cache_t    *p_glyph_cache;
+    line_cache_t     *p_line_cache;
+
     /* Current scaling of the text, default is 100 (%) */
     int               i_scale;
 
@@ -0,0 +1,551 @@
+/*****************************************************************************
+ * text_cache.c : Glyph and line layout caches
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph and line layout caches
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_text_style.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+#include "freetype.h"
+#include "text_layout.h"
+#include "text_cache.h"
+
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************/
+#define GLYPH_CACHE_BUCKETS 1024
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_entry_t *p_next;        /* in the same bucket */
+    glyph_cache_entry_t *p_newer;       /* least recently used list */
+    glyph_cache_entry_t *p_older;
+    glyph_cache_key_t    key;
+    FT_Glyph             p_glyph;
+    FT_Glyph             p_outline;
+    FT_Vector            advance;
+    size_t               i_bytes;
+};
+
+struct glyph_cache_t
+{
+    glyph_cache_entry_t *pp_buckets[GLYPH_CACHE_BUCKETS];
+    glyph_cache_entry_t *p_newest;
+    glyph_cache_entry_t *p_oldest;
+    size_t               i_bytes;
+    size_t               i_max_bytes;
+    unsigned             i_hits;
+    unsigned             i_misses;
+};
+
+static unsigned GlyphKeyHash( const glyph_cache_key_t *p_key )
+{
+    uintptr_t i_hash = (uintptr_t)p_key->p_face;
+
+    i_hash = i_hash * 31 + p_key->i_glyph_index;
+    i_hash = i_hash * 31 + p_key->i_style_flags;
+    i_hash = i_hash * 31 + p_key->i_outline_radius;
+    i_hash = i_hash * 31 + p_key->i_kind;
+    i_hash = i_hash * 31 + p_key->i_x;
+    i_hash = i_hash * 31 + p_key->i_y;
+    i_hash ^= i_hash >> 16;
+    return i_hash % GLYPH_CACHE_BUCKETS;
+}
+
+static bool GlyphKeyEquals( const glyph_cache_key_t *p_a,
+                            const glyph_cache_key_t *p_b )
+{
+    return p_a->p_face == p_b->p_face
+        && p_a->i_glyph_index == p_b->i_glyph_index
+        && p_a->i_style_flags == p_b->i_style_flags
+        && p_a->i_outline_radius == p_b->i_outline_radius
+        && p_a->i_kind == p_b->i_kind
+        && p_a->i_x == p_b->i_x
+        && p_a->i_y == p_b->i_y;
+}
+
+static size_t GlyphBytes( FT_Glyph p_glyph )
+{
+    if( !p_glyph )
+        return 0;
+
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)p_glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * abs( p_bitmap->pitch );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph)p_glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+static int CopyGlyph( FT_Glyph p_src, FT_Glyph *pp_dst )
+{
+    *pp_dst = NULL;
+    if( p_src && FT_Glyph_Copy( p_src, pp_dst ) )
+        return VLC_ENOMEM;
+    return VLC_SUCCESS;
+}
+
+static void GlyphCacheUnlink( glyph_cache_t *p_cache,
+                              glyph_cache_entry_t *p_entry )
+{
+    if( p_entry->p_newer )
+        p_entry->p_newer->p_older = p_entry->p_older;
+    else
+        p_cache->p_newest = p_entry->p_older;
+    if( p_entry->p_older )
+        p_entry->p_older->p_newer = p_entry->p_newer;
+    else
+        p_cache->p_oldest = p_entry->p_newer;
+}
+
+static void GlyphCacheLinkNewest( glyph_cache_t *p_cache,
+                                  glyph_cache_entry_t *p_entry )
+{
+    p_entry->p_newer = NULL;
+    p_entry->p_older = p_cache->p_newest;
+    if( p_cache->p_newest )
+        p_cache->p_newest->p_newer = p_entry;
+    else
+        p_cache->p_oldest = p_entry;
+    p_cache->p_newest = p_entry;
+}
+
+static void GlyphCacheEvictOldest( glyph_cache_t *p_cache )
+{
+    glyph_cache_entry_t *p_entry = p_cache->p_oldest;
+    glyph_cache_entry_t **pp = &p_cache->pp_buckets[GlyphKeyHash( &p_entry->key )];
+
+    while( *pp != p_entry )
+        pp = &(*pp)->p_next;
+    *pp = p_entry->p_next;
+
+    GlyphCacheUnlink( p_cache, p_entry );
+    p_cache->i_bytes -= p_entry->i_bytes;
+
+    FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    free( p_entry );
+}
+
+glyph_cache_t *GlyphCacheNew( size_t i_max_bytes )
+{
+    glyph_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( p_cache )
+        p_cache->i_max_bytes = i_max_bytes;
+    return p_cache;
+}
+
+void GlyphCacheDelete( glyph_cache_t *p_cache )
+{
+    if( !p_cache )
+        return;
+    while( p_cache->p_oldest )
+        GlyphCacheEvictOldest( p_cache );
+    free( p_cache );
+}
+
+int GlyphCacheGet( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                   FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                   FT_Vector *p_advance )
+{
+    if( !p_cache )
+        return VLC_EGENERIC;
+
+    glyph_cache_entry_t *p_entry = p_cache->pp_buckets[GlyphKeyHash( p_key )];
+    while( p_entry && !GlyphKeyEquals( &p_entry->key, p_key ) )
+        p_entry = p_entry->p_next;
+
+    if( !p_entry )
+    {
+        p_cache->i_misses++;
+        return VLC_EGENERIC;
+    }
+
+    if( CopyGlyph( p_entry->p_glyph, pp_glyph ) )
+        return VLC_ENOMEM;
+    if( pp_outline && CopyGlyph( p_entry->p_outline, pp_outline ) )
+    {
+        FT_Done_Glyph( *pp_glyph );
+        return VLC_ENOMEM;
+    }
+    if( p_advance )
+        *p_advance = p_entry->advance;
+
+    GlyphCacheUnlink( p_cache, p_entry );
+    GlyphCacheLinkNewest( p_cache, p_entry );
+    p_cache->i_hits++;
+    return VLC_SUCCESS;
+}
+
+void GlyphCachePut( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                    FT_Glyph p_glyph, FT_Glyph p_outline,
+                    const FT_Vector *p_advance )
+{
+    if( !p_cache || !p_glyph )
+        return;
+
+    const size_t i_bytes = sizeof( glyph_cache_entry_t )
+                         + GlyphBytes( p_glyph ) + GlyphBytes( p_outline );
+    if( i_bytes > p_cache->i_max_bytes / 4 )
+        return;
+
+    glyph_cache_entry_t *p_entry = malloc( sizeof( *p_entry ) );
+    if( !p_entry )
+        return;
+    if( CopyGlyph( p_glyph, &p_entry->p_glyph ) )
+    {
+        free( p_entry );
+        return;
+    }
+    if( CopyGlyph( p_outline, &p_entry->p_outline ) )
+    {
+        FT_Done_Glyph( p_entry->p_glyph );
+        free( p_entry );
+        return;
+    }
+    p_entry->key = *p_key;
+    p_entry->i_bytes = i_bytes;
+    if( p_advance )
+        p_entry->advance = *p_advance;
+    else
+        p_entry->advance.x = p_entry->advance.y = 0;
+
+    while( p_cache->p_oldest && p_cache->i_bytes + i_bytes > p_cache->i_max_bytes )
+        GlyphCacheEvictOldest( p_cache );
+
+    glyph_cache_entry_t **pp_bucket = &p_cache->pp_buckets[GlyphKeyHash( p_key )];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    GlyphCacheLinkNewest( p_cache, p_entry );
+    p_cache->i_bytes += i_bytes;
+}
+
+void GlyphCacheGetStats( const glyph_cache_t *p_cache,
+                         text_cache_stats_t *p_stats )
+{
+    memset( p_stats, 0, sizeof( *p_stats ) );
+    if( p_cache )
+    {
+        p_stats->i_hits = p_cache->i_hits;
+        p_stats->i_misses = p_cache->i_misses;
+        p_stats->i_bytes = p_cache->i_bytes;
+    }
+}
+
+/*****************************************************************************
+ * Line cache
+ *****************************************************************************/
+#define LINE_CACHE_ENTRIES 16
+
+typedef struct
+{
+    uint64_t     i_hash;            /* 0 if unused */
+    uni_char_t  *p_uchars;
+    size_t       i_count;
+    line_desc_t *p_lines;           /* without styles */
+    uint32_t    *pi_styles;         /* style index of every line character */
+    FT_BBox      bbox;
+    int          i_max_face_height;
+    size_t       i_bytes;
+    unsigned     i_last_use;
+} line_cache_entry_t;
+
+struct line_cache_t
+{
+    line_cache_entry_t entries[LINE_CACHE_ENTRIES];
+    size_t             i_bytes;
+    size_t             i_max_bytes;
+    unsigned           i_clock;
+    unsigned           i_hits;
+    unsigned           i_misses;
+};
+
+static void FreeCharGlyphs( line_character_t *p_ch )
+{
+    if( p_ch->p_glyph )
+        FT_Done_Glyph( (FT_Glyph)p_ch->p_glyph );
+    if( p_ch->p_outline )
+        FT_Done_Glyph( (FT_Glyph)p_ch->p_outline );
+    if( p_ch->p_shadow )
+        FT_Done_Glyph( (FT_Glyph)p_ch->p_shadow );
+}
+
+/**
+ * Deep copies lines. The characters get the styles pp_styles[pi_styles[]],
+ * or no style if pp_styles is NULL.
+ */
+static line_desc_t *CopyLines( const line_desc_t *p_src,
+                               text_style_t *const *pp_styles,
+                               const uint32_t *pi_styles,
+                               size_t *pi_bytes )
+{
+    line_desc_t *p_first = NULL;
+    line_desc_t **pp_last = &p_first;
+    size_t i_bytes = 0;
+
+    for( ; p_src; p_src = p_src->p_next )
+    {
+        line_desc_t *p_line = NewLine( __MAX( p_src->i_character_count, 1 ) );
+        if( !p_line )
+            goto error;
+
+        line_character_t *p_chars = p_line->p_character;
+        *p_line = *p_src;
+        p_line->p_next = NULL;
+        p_line->p_character = p_chars;
+        p_line->i_character_count = 0;
+        *pp_last = p_line;
+        pp_last = &p_line->p_next;
+        i_bytes += sizeof( *p_line );
+
+        for( int i = 0; i < p_src->i_character_count; i++ )
+        {
+            const line_character_t *p_src_ch = &p_src->p_character[i];
+            line_character_t *p_ch = &p_line->p_character[i];
+            FT_Glyph p_glyph, p_outline, p_shadow;
+
+            if( CopyGlyph( (FT_Glyph)p_src_ch->p_glyph, &p_glyph ) )
+                goto error;
+            if( CopyGlyph( (FT_Glyph)p_src_ch->p_outline, &p_outline ) )
+            {
+                FT_Done_Glyph( p_glyph );
+                goto error;
+            }
+            if( CopyGlyph( (FT_Glyph)p_src_ch->p_shadow, &p_shadow ) )
+            {
+                FT_Done_Glyph( p_glyph );
+                if( p_outline )
+                    FT_Done_Glyph( p_outline );
+                goto error;
+            }
+
+            *p_ch = *p_src_ch;
+            p_ch->p_glyph = (FT_BitmapGlyph)p_glyph;
+            p_ch->p_outline = (FT_BitmapGlyph)p_outline;
+            p_ch->p_shadow = (FT_BitmapGlyph)p_shadow;
+            p_ch->p_style = pp_styles ? pp_styles[*pi_styles++] : NULL;
+            p_ch->p_ruby = NULL;
+            p_line->i_character_count++;
+
+            i_bytes += sizeof( *p_ch ) + GlyphBytes( p_glyph )
+                     + GlyphBytes( p_outline ) + GlyphBytes( p_shadow );
+        }
+    }
+
+    if( pi_bytes )
+        *pi_bytes = i_bytes;
+    return p_first;
+
+error:
+    FreeLines( p_first );
+    return NULL;
+}
+
+static void LineCacheCleanEntry( line_cache_entry_t *p_entry )
+{
+    FreeLines( p_entry->p_lines );
+    free( p_entry->pi_styles );
+    free( p_entry->p_uchars );
+    p_entry->i_hash = 0;
+}
+
+line_cache_t *LineCacheNew( size_t i_max_bytes )
+{
+    line_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( p_cache )
+        p_cache->i_max_bytes = i_max_bytes;
+    return p_cache;
+}
+
+void LineCacheDelete( line_cache_t *p_cache )
+{
+    if( !p_cache )
+        return;
+    for( int i = 0; i < LINE_CACHE_ENTRIES; i++ )
+        if( p_cache->entries[i].i_hash )
+            LineCacheCleanEntry( &p_cache->entries[i] );
+    free( p_cache );
+}
+
+int LineCacheGet( line_cache_t *p_cache, uint64_t i_hash,
+                  const layout_text_block_t *p_textblock,
+                  line_desc_t **pp_lines, FT_BBox *p_bbox,
+                  int *pi_max_face_height )
+{
+    if( !p_cache )
+        return VLC_EGENERIC;
+
+    for( int i = 0; i < LINE_CACHE_ENTRIES; i++ )
+    {
+        line_cache_entry_t *p_entry = &p_cache->entries[i];
+
+        if( p_entry->i_hash != i_hash
+         || p_entry->i_count != p_textblock->i_count
+         || memcmp( p_entry->p_uchars, p_textblock->p_uchars,
+                    p_entry->i_count * sizeof( *p_entry->p_uchars ) ) )
+            continue;
+
+        line_desc_t *p_lines = CopyLines( p_entry->p_lines,
+                                          p_textblock->pp_styles,
+                                          p_entry->pi_styles, NULL );
+        if( !p_lines && p_entry->p_lines )
+            return VLC_ENOMEM;
+
+        p_entry->i_last_use = ++p_cache->i_clock;
+        p_cache->i_hits++;
+        *pp_lines = p_lines;
+        *p_bbox = p_entry->bbox;
+        *pi_max_face_height = p_entry->i_max_face_height;
+        return VLC_SUCCESS;
+    }
+
+    p_cache->i_misses++;
+    return VLC_EGENERIC;
+}
+
+void LineCachePut( line_cache_t *p_cache, uint64_t i_hash,
+                   const layout_text_block_t *p_textblock,
+                   const line_desc_t *p_lines, const FT_BBox *p_bbox,
+                   int i_max_face_height )
+{
+    if( !p_cache || p_textblock->pp_ruby )
+        return;
+
+    /* Lines reference the styles of the text block: remember their index */
+    size_t i_chars = 0;
+    for( const line_desc_t *p_line = p_lines; p_line; p_line = p_line->p_next )
+        i_chars += p_line->i_character_count;
+
+    uint32_t *pi_styles = vlc_alloc( __MAX( i_chars, 1 ), sizeof( *pi_styles ) );
+    if( !pi_styles )
+        return;
+
+    uint32_t *pi_style = pi_styles;
+    size_t i_index = 0;
+    for( const line_desc_t *p_line = p_lines; p_line; p_line = p_line->p_next )
+        for( int i = 0; i < p_line->i_character_count; i++ )
+        {
+            const text_style_t *p_style = p_line->p_character[i].p_style;
+            size_t j;
+
+            /* characters mostly follow the text order */
+            for( j = 0; j < p_textblock->i_count; j++ )
+            {
+                size_t k = ( i_index + j ) % p_textblock->i_count;
+                if( p_textblock->pp_styles[k] == p_style )
+                {
+                    i_index = k;
+                    break;
+                }
+            }
+            if( j == p_textblock->i_count )
+            {
+                free( pi_styles );
+                return;
+            }
+            *pi_style++ = i_index;
+        }
+
+    line_cache_entry_t entry;
+    entry.i_hash = i_hash;
+    entry.i_count = p_textblock->i_count;
+    entry.pi_styles = pi_styles;
+    entry.bbox = *p_bbox;
+    entry.i_max_face_height = i_max_face_height;
+    entry.p_uchars = vlc_alloc( entry.i_count, sizeof( *entry.p_uchars ) );
+    entry.p_lines = CopyLines( p_lines, NULL, NULL, &entry.i_bytes );
+    if( !entry.p_uchars || ( !entry.p_lines && p_lines ) )
+    {
+        free( entry.p_uchars );
+        FreeLines( entry.p_lines );
+        free( pi_styles );
+        return;
+    }
+    memcpy( entry.p_uchars, p_textblock->p_uchars,
+            entry.i_count * sizeof( *entry.p_uchars ) );
+    entry.i_bytes += entry.i_count * sizeof( *entry.p_uchars )
+                   + i_chars * sizeof( *pi_styles );
+
+    if( entry.i_bytes > p_cache->i_max_bytes / 2 )
+    {
+        LineCacheCleanEntry( &entry );
+        return;
+    }
+
+    /* Evict the least recently used entries until it fits */
+    line_cache_entry_t *p_slot;
+    for( ;; )
+    {
+        line_cache_entry_t *p_lru = NULL;
+        p_slot = NULL;
+        for( int i = 0; i < LINE_CACHE_ENTRIES; i++ )
+        {
+            line_cache_entry_t *p_entry = &p_cache->entries[i];
+            if( !p_entry->i_hash )
+                p_slot = p_entry;
+            else if( !p_lru || p_entry->i_last_use < p_lru->i_last_use )
+                p_lru = p_entry;
+        }
+        if( p_slot && p_cache->i_bytes + entry.i_bytes <= p_cache->i_max_bytes )
+            break;
+
+        p_cache->i_bytes -= p_lru->i_bytes;
+        LineCacheCleanEntry( p_lru );
+    }
+
+    entry.i_last_use = ++p_cache->i_clock;
+    *p_slot = entry;
+    p_cache->i_bytes += entry.i_bytes;
+}
+
+void LineCacheGetStats( const line_cache_t *p_cache,
+                        text_cache_stats_t *p_stats )
+{
+    memset( p_stats, 0, sizeof( *p_stats ) );
+    if( p_cache )
+    {
+        p_stats->i_hits = p_cache->i_hits;
+        p_stats->i_misses = p_cache->i_misses;
+        p_stats->i_bytes = p_cache->i_bytes;
+    }
+}
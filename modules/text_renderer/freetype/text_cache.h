@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * text_cache.h : Glyph and line layout caches
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph and line layout caches
+ *
+ * Subtitles repeat the same lines for many frames, and the same glyphs
+ * within and across lines. The glyph cache keeps the loaded (and stroked)
+ * outlines of each glyph and its rasterised bitmaps, the line cache keeps
+ * whole laid out text blocks. Both evict the least recently used entries
+ * above a memory limit. All the returned glyphs are copies owned by the
+ * caller.
+ */
+
+#ifndef VLC_FREETYPE_TEXT_CACHE_H
+#define VLC_FREETYPE_TEXT_CACHE_H
+
+#include "freetype.h"
+#include "text_layout.h"
+
+#define GLYPH_CACHE_MAX_BYTES   (8 << 20)
+#define LINE_CACHE_MAX_BYTES    (8 << 20)
+
+enum
+{
+    GLYPH_CACHE_OUTLINES,   /**< loaded glyph and outline, and advance */
+    GLYPH_CACHE_GLYPH,      /**< bitmaps */
+    GLYPH_CACHE_OUTLINE,
+    GLYPH_CACHE_SHADOW,
+};
+
+/**
+ * Identifies a glyph. Faces are loaded for a given size and are kept until
+ * the module is closed, so that the face also identifies the size.
+ */
+typedef struct
+{
+    FT_Face  p_face;
+    FT_UInt  i_glyph_index;
+    int      i_style_flags;     /**< STYLE_BOLD and STYLE_ITALIC */
+    FT_Fixed i_outline_radius;  /**< 0 without outline */
+    uint8_t  i_kind;            /**< GLYPH_CACHE_* */
+    uint8_t  i_x;               /**< 26.6 subpixel pen position of bitmaps */
+    uint8_t  i_y;
+} glyph_cache_key_t;
+
+typedef struct
+{
+    unsigned i_hits;
+    unsigned i_misses;
+    size_t   i_bytes;
+} text_cache_stats_t;
+
+glyph_cache_t *GlyphCacheNew( size_t i_max_bytes );
+void GlyphCacheDelete( glyph_cache_t * );
+
+/**
+ * Looks a glyph up.
+ *
+ * \param pp_glyph copy of the glyph [OUT]
+ * \param pp_outline copy of the outline, may be NULL for bitmaps [OUT]
+ * \param p_advance advance of the glyph, may be NULL for bitmaps [OUT]
+ * \return VLC_SUCCESS on hit
+ */
+int GlyphCacheGet( glyph_cache_t *, const glyph_cache_key_t *,
+                   FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                   FT_Vector *p_advance );
+
+/**
+ * Stores copies of a glyph and of its outline (which may be NULL).
+ */
+void GlyphCachePut( glyph_cache_t *, const glyph_cache_key_t *,
+                    FT_Glyph p_glyph, FT_Glyph p_outline,
+                    const FT_Vector *p_advance );
+
+void GlyphCacheGetStats( const glyph_cache_t *, text_cache_stats_t * );
+
+line_cache_t *LineCacheNew( size_t i_max_bytes );
+void LineCacheDelete( line_cache_t * );
+
+/**
+ * Looks a laid out text block up.
+ *
+ * \param i_hash hash of everything the layout depends on [IN]
+ * \param p_textblock the text block, its styles are referenced by the
+ * returned lines [IN]
+ * \return VLC_SUCCESS on hit
+ */
+int LineCacheGet( line_cache_t *, uint64_t i_hash,
+                  const layout_text_block_t *p_textblock,
+                  line_desc_t **pp_lines, FT_BBox *p_bbox,
+                  int *pi_max_face_height );
+
+/**
+ * Stores a copy of the lines of a text block without ruby.
+ */
+void LineCachePut( line_cache_t *, uint64_t i_hash,
+                   const layout_text_block_t *p_textblock,
+                   const line_desc_t *p_lines, const FT_BBox *p_bbox,
+                   int i_max_face_height );
+
+void LineCacheGetStats( const line_cache_t *, text_cache_stats_t * );
+
+#endif
@@ -64,6 +64,7 @@
 
 #include "freetype.h"
 #include "text_layout.h"
+#include "text_cache.h"
 #include "platform_fonts.h"
 
 /* Win32 */
@@ -130,6 +131,7 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_cache_key_t cache_key;
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -1055,12 +1057,15 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
-        if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+        const bool b_outline = p_sys->p_stroker
+                            && (p_style->i_style_flags & STYLE_OUTLINE);
+        int i_radius = 0;
+        if( b_outline )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
@@ -1117,39 +1122,59 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            glyph_cache_key_t *p_key = &p_bitmaps->cache_key;
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_style_flags = p_style->i_style_flags
+                                 & ( STYLE_BOLD | STYLE_ITALIC | STYLE_OUTLINE );
+            p_key->i_outline_radius = i_radius;
+            p_key->i_kind = GLYPH_CACHE_OUTLINES;
+            p_key->i_x = p_key->i_y = 0;
+
+            FT_Vector advance;
+            if( GlyphCacheGet( p_sys->p_glyph_cache, p_key, &p_bitmaps->p_glyph,
+                               &p_bitmaps->p_outline, &advance ) )
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+                if( ( p_style->i_style_flags & STYLE_BOLD )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( ( p_style->i_style_flags & STYLE_ITALIC )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                p_bitmaps->p_outline = 0;
+                if( b_outline )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_filter->p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                advance = p_face->glyph->advance;
+                GlyphCachePut( p_sys->p_glyph_cache, p_key, p_bitmaps->p_glyph,
+                               p_bitmaps->p_outline, &advance );
             }
 
+#undef SKIP_GLYPH
+
+            p_bitmaps->p_shadow = 0;
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
         }
 
@@ -1160,6 +1185,42 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
     return VLC_SUCCESS;
 }
 
+/**
+ * Converts a glyph to a bitmap at the pen position. The bitmaps only depend
+ * on the subpixel part of the position: they are cached for it, and moved by
+ * the integer part.
+ *
+ * \return a new bitmap glyph, the source is kept, NULL on error
+ */
+static FT_Glyph RenderGlyph( filter_t *p_filter, FT_Glyph p_source,
+                             glyph_cache_key_t key, int i_kind,
+                             const FT_Vector *p_pen )
+{
+    glyph_cache_t *p_cache = p_filter->p_sys->p_glyph_cache;
+    FT_Vector origin = { .x = p_pen->x & 63, .y = p_pen->y & 63 };
+    FT_Glyph p_bitmap;
+
+    /* Bitmap fonts are neither converted nor moved */
+    if( p_source->format == FT_GLYPH_FORMAT_BITMAP )
+        return FT_Glyph_Copy( p_source, &p_bitmap ) ? NULL : p_bitmap;
+
+    key.i_kind = i_kind;
+    key.i_x = origin.x;
+    key.i_y = origin.y;
+    if( GlyphCacheGet( p_cache, &key, &p_bitmap, NULL, NULL ) )
+    {
+        p_bitmap = p_source;
+        if( FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL, &origin, 0 ) )
+            return NULL;
+        GlyphCachePut( p_cache, &key, p_bitmap, NULL, NULL );
+    }
+    /* FreeType leaves empty bitmaps at 0,0 for FixGlyph() to place */
+    if( ((FT_BitmapGlyph)p_bitmap)->bitmap.rows )
+        ShiftGlyph( (FT_BitmapGlyph)p_bitmap, FT_FLOOR( p_pen->x ),
+                    FT_FLOOR( p_pen->y ) );
+    return p_bitmap;
+}
+
 static int LayoutLine( filter_t *p_filter,
                        paragraph_t *p_paragraph,
                        int i_first_char, int i_last_char,
@@ -1256,23 +1317,27 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
-                p_bitmaps->p_shadow = 0;
-            else
+            p_bitmaps->p_shadow = RenderGlyph( p_filter, p_bitmaps->p_shadow,
+                                               p_bitmaps->cache_key,
+                                               GLYPH_CACHE_SHADOW, &pen_shadow );
+            if( p_bitmaps->p_shadow )
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
                                    &p_bitmaps->shadow_bbox );
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            FT_Glyph p_glyph = RenderGlyph( p_filter, p_bitmaps->p_glyph,
+                                            p_bitmaps->cache_key,
+                                            GLYPH_CACHE_GLYPH, &pen_new );
+            FT_Done_Glyph( p_bitmaps->p_glyph );
+            p_bitmaps->p_glyph = p_glyph;
+            if( !p_glyph )
             {
-                FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
                     FT_Done_Glyph( p_bitmaps->p_outline );
                 if( p_bitmaps->p_shadow )
                     FT_Done_Glyph( p_bitmaps->p_shadow );
+                p_bitmaps->p_outline = p_bitmaps->p_shadow = 0;
                 continue;
             }
             else
@@ -1281,13 +1346,12 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
-            {
-                FT_Done_Glyph( p_bitmaps->p_outline );
-                p_bitmaps->p_outline = 0;
-            }
-            else
+            FT_Glyph p_outline = RenderGlyph( p_filter, p_bitmaps->p_outline,
+                                              p_bitmaps->cache_key,
+                                              GLYPH_CACHE_OUTLINE, &pen_new );
+            FT_Done_Glyph( p_bitmaps->p_outline );
+            p_bitmaps->p_outline = p_outline;
+            if( p_outline )
                 FT_Glyph_Get_CBox( p_bitmaps->p_outline, ft_glyph_bbox_pixels,
                                    &p_bitmaps->outline_bbox );
         }
@@ -1735,11 +1799,119 @@ static int LayoutRubyText( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
+static uint64_t HashBytes( uint64_t i_hash, const void *p_data, size_t i_size )
+{
+    const uint8_t *p = p_data;
+
+    /* FNV-1a */
+    for( size_t i = 0; i < i_size; i++ )
+        i_hash = ( i_hash ^ p[i] ) * UINT64_C(0x100000001b3);
+    return i_hash;
+}
+
+#define HASH_VALUE( h, v ) HashBytes( h, &(v), sizeof(v) )
+
+static uint64_t HashString( uint64_t i_hash, const char *psz )
+{
+    return psz ? HashBytes( i_hash, psz, strlen( psz ) + 1 )
+               : HashBytes( i_hash, "", 0 );
+}
+
+static uint64_t HashStyle( uint64_t i_hash, const text_style_t *p_style )
+{
+    i_hash = HashString( i_hash, p_style->psz_fontname );
+    i_hash = HashString( i_hash, p_style->psz_monofontname );
+    i_hash = HASH_VALUE( i_hash, p_style->i_features );
+    i_hash = HASH_VALUE( i_hash, p_style->i_style_flags );
+    i_hash = HASH_VALUE( i_hash, p_style->f_font_relsize );
+    i_hash = HASH_VALUE( i_hash, p_style->i_font_size );
+    i_hash = HASH_VALUE( i_hash, p_style->i_font_color );
+    i_hash = HASH_VALUE( i_hash, p_style->i_font_alpha );
+    i_hash = HASH_VALUE( i_hash, p_style->i_spacing );
+    i_hash = HASH_VALUE( i_hash, p_style->i_outline_color );
+    i_hash = HASH_VALUE( i_hash, p_style->i_outline_alpha );
+    i_hash = HASH_VALUE( i_hash, p_style->i_outline_width );
+    i_hash = HASH_VALUE( i_hash, p_style->i_shadow_color );
+    i_hash = HASH_VALUE( i_hash, p_style->i_shadow_alpha );
+    i_hash = HASH_VALUE( i_hash, p_style->i_shadow_width );
+    i_hash = HASH_VALUE( i_hash, p_style->i_background_color );
+    i_hash = HASH_VALUE( i_hash, p_style->i_background_alpha );
+    i_hash = HASH_VALUE( i_hash, p_style->i_karaoke_background_color );
+    i_hash = HASH_VALUE( i_hash, p_style->i_karaoke_background_alpha );
+    i_hash = HASH_VALUE( i_hash, p_style->e_wrapinfo );
+    return i_hash;
+}
+
+/**
+ * Hashes everything the layout of a text block depends on, for the line
+ * cache. The karaoke durations only matter through the highlighted
+ * characters, so that karaoke lines are laid out again only when that
+ * changes.
+ */
+static uint64_t HashTextBlock( filter_t *p_filter,
+                               const layout_text_block_t *p_textblock )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    uint64_t i_hash = UINT64_C(0xcbf29ce484222325);
+    int64_t i_value;
+
+    i_hash = HASH_VALUE( i_hash, p_textblock->i_count );
+    i_hash = HashBytes( i_hash, p_textblock->p_uchars,
+                        p_textblock->i_count * sizeof( *p_textblock->p_uchars ) );
+    for( size_t i = 0; i < p_textblock->i_count; i++ )
+    {
+        /* consecutive characters mostly share their style */
+        if( i > 0 && p_textblock->pp_styles[i] == p_textblock->pp_styles[i - 1] )
+            i_hash = HashBytes( i_hash, "=", 1 );
+        else
+            i_hash = HashStyle( i_hash, p_textblock->pp_styles[i] );
+    }
+    if( p_textblock->pi_k_durations )
+    {
+        int64_t i_elapsed  = var_GetInteger( p_filter, "spu-elapsed" ) / 1000;
+        for( size_t i = 0; i < p_textblock->i_count; i++ )
+        {
+            bool b_bar = p_textblock->pi_k_durations[ i ] >= i_elapsed;
+            i_hash = HASH_VALUE( i_hash, b_bar );
+        }
+    }
+
+    i_hash = HASH_VALUE( i_hash, p_textblock->b_balanced );
+    i_hash = HASH_VALUE( i_hash, p_textblock->b_grid );
+    i_hash = HASH_VALUE( i_hash, p_textblock->i_max_width );
+    i_hash = HASH_VALUE( i_hash, p_textblock->i_max_height );
+
+    /* Sizes, faces and options */
+    i_hash = HASH_VALUE( i_hash, p_sys->i_scale );
+    i_hash = HASH_VALUE( i_hash, p_sys->p_face );
+    i_hash = HASH_VALUE( i_hash, p_filter->fmt_out.video.i_height );
+    i_value = var_InheritInteger( p_filter, "freetype-outline-thickness" );
+    i_hash = HASH_VALUE( i_hash, i_value );
+    i_value = var_InheritInteger( p_filter, "freetype-text-direction" );
+    i_hash = HASH_VALUE( i_hash, i_value );
+
+    return i_hash ? i_hash : 1;
+}
+
+#undef HASH_VALUE
+
 int LayoutTextBlock( filter_t *p_filter,
                      const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox,
                      int *pi_max_face_height )
 {
+    filter_sys_t *p_sys = p_filter->p_sys;
+    uint64_t i_hash = 0;
+
+    /* Ruby blocks are laid out with their own lines */
+    if( !p_textblock->pp_ruby )
+    {
+        i_hash = HashTextBlock( p_filter, p_textblock );
+        if( LineCacheGet( p_sys->p_line_cache, i_hash, p_textblock,
+                          pp_lines, p_bbox, pi_max_face_height ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
+
     line_desc_t *p_first_line = 0;
     line_desc_t **pp_line = &p_first_line;
     size_t i_paragraph_start = 0;
@@ -1847,6 +2019,10 @@ int LayoutTextBlock( filter_t *p_filter,
     *pi_max_face_height = i_max_face_height;
     *pp_lines = p_first_line;
     *p_bbox = bbox;
+
+    if( i_hash )
+        LineCachePut( p_sys->p_line_cache, i_hash, p_textblock,
+                      p_first_line, &bbox, i_max_face_height );
     return VLC_SUCCESS;
 }
 
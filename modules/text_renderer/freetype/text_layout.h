@@ -31,6 +31,9 @@
  * Text shaping and layout
  */
 
+#ifndef VLC_FREETYPE_TEXT_LAYOUT_H
+#define VLC_FREETYPE_TEXT_LAYOUT_H
+
 #include "freetype.h"
 
 typedef struct ruby_block_t ruby_block_t;
@@ -108,3 +111,5 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+#endif
@@ -33,9 +33,18 @@
 #include <vlc_common.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_filter.h>
 #include <assert.h>
 
 #include "copy.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+
+/* Minimum number of lines of a band, and maximum number of bands */
+#define COPY_BAND_LINES 64
+#define COPY_MAX_BANDS  16
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
                       unsigned height, int bitshift);
@@ -54,25 +63,66 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
 
 int CopyInitCache(copy_cache_t *cache, unsigned width)
 {
+    cache->slices = NULL;
+    cache->band_count = 0;
+    cache->bands = NULL;
 #ifdef CAN_COMPILE_SSE2
     cache->size = __MAX((width + 0x3f) & ~ 0x3f, 16384);
     cache->buffer = aligned_alloc(64, cache->size);
     if (!cache->buffer)
         return VLC_EGENERIC;
 #else
-    (void) cache; (void) width;
+    (void) width;
 #endif
     return VLC_SUCCESS;
 }
 
+int CopyInitCacheThreads(copy_cache_t *cache, vlc_object_t *obj,
+                         unsigned width, unsigned threads)
+{
+    if (CopyInitCache(cache, width))
+        return VLC_EGENERIC;
+
+    /* the copies are bound by the memory bandwidth, which a few threads
+     * are enough to saturate */
+    if (threads == 0)
+        threads = __MIN(vlc_GetCPUCount(), 4);
+    if (threads > COPY_MAX_BANDS)
+        threads = COPY_MAX_BANDS;
+    if (threads < 2)
+        return VLC_SUCCESS;
+
+    cache->bands = malloc(threads * sizeof(*cache->bands));
+    if (unlikely(cache->bands == NULL))
+        goto error;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        if (CopyInitCache(&cache->bands[i], width))
+            goto error;
+        cache->band_count++;
+    }
+
+    cache->slices = filter_NewSlices(obj, threads);
+    return VLC_SUCCESS;
+
+error:
+    CopyCleanCache(cache);
+    return VLC_EGENERIC;
+}
+
 void CopyCleanCache(copy_cache_t *cache)
 {
+    filter_DeleteSlices(cache->slices);
+    cache->slices = NULL;
+    for (unsigned i = 0; i < cache->band_count; i++)
+        CopyCleanCache(&cache->bands[i]);
+    free(cache->bands);
+    cache->bands = NULL;
+    cache->band_count = 0;
 #ifdef CAN_COMPILE_SSE2
     aligned_free(cache->buffer);
     cache->buffer = NULL;
     cache->size   = 0;
-#else
-    (void) cache;
 #endif
 }
 
@@ -131,6 +181,64 @@ void CopyCleanCache(copy_cache_t *cache)
 # define vlc_CPU_SSSE3() (0)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static inline __m256i AVX2_Shift(__m256i v, int bitshift, __m128i count)
+{
+    if (bitshift > 0)
+        return _mm256_srl_epi16(v, count);
+    if (bitshift < 0)
+        return _mm256_sll_epi16(v, count);
+    return v;
+}
+
+/* Same as CopyFromUswc() with 32-byte streaming loads */
+VLC_AVX2
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    const __m128i count = _mm_cvtsi32_si128(bitshift > 0 ? bitshift
+                                                         : -bitshift);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f;
+        unsigned x = 0;
+
+        if (width >= 32) {
+            if (unaligned) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)src);
+                _mm256_storeu_si256((__m256i *)dst,
+                                    AVX2_Shift(v, bitshift, count));
+                x = unaligned;
+            }
+            for (; x+127 < width; x += 128) {
+                const __m256i *s = (const __m256i *)&src[x];
+                __m256i *d = (__m256i *)&dst[x];
+                __m256i v0 = _mm256_stream_load_si256(s + 0);
+                __m256i v1 = _mm256_stream_load_si256(s + 1);
+                __m256i v2 = _mm256_stream_load_si256(s + 2);
+                __m256i v3 = _mm256_stream_load_si256(s + 3);
+                _mm256_storeu_si256(d + 0, AVX2_Shift(v0, bitshift, count));
+                _mm256_storeu_si256(d + 1, AVX2_Shift(v1, bitshift, count));
+                _mm256_storeu_si256(d + 2, AVX2_Shift(v2, bitshift, count));
+                _mm256_storeu_si256(d + 3, AVX2_Shift(v3, bitshift, count));
+            }
+        }
+        if (x < width)
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift);
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    _mm_mfence();
+}
 #endif
 
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
@@ -144,6 +252,12 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)dst & 0x0f) == 0 && (dst_pitch & 0x0f) == 0);
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyFromUswc(dst, dst_pitch, src, src_pitch,
+                                 width, height, bitshift);
+#endif
+
     asm volatile ("mfence");
 
 #define SSE_USWC_COPY(shiftstr16, shiftstr64) \
@@ -197,7 +311,7 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
             SSE_USWC_COPY(COPY16_SHIFTR("$4"), COPY64_SHIFTR("$4"))
             break;
         case -4:
-            SSE_USWC_COPY(COPY16_SHIFTL("$2"), COPY64_SHIFTL("$2"))
+            SSE_USWC_COPY(COPY16_SHIFTL("$4"), COPY64_SHIFTL("$4"))
             break;
         default:
             vlc_assert_unreachable();
@@ -639,29 +753,98 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
     }
 }
 
-void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
-                unsigned height, const copy_cache_t *cache)
+typedef void (*copy_fn)(picture_t *, const uint8_t *[], const size_t [],
+                        unsigned, int, const copy_cache_t *);
+
+struct copy_job
 {
-    assert(dst);
-    assert(src); assert(src_pitch);
-    assert(height);
+    copy_fn             copy;
+    picture_t          *dst;
+    const uint8_t     **src;
+    const size_t       *src_pitch;
+    unsigned            src_planes;
+    unsigned            height;
+    int                 bitshift;
+    const copy_cache_t *cache;
+};
+
+/* Copies a band of lines, starting on an even line so that 4:2:0 chroma
+ * lines are not shared between bands */
+static void CopyBand(void *opaque, unsigned band, unsigned bands)
+{
+    const struct copy_job *job = opaque;
+    int first, end;
+
+    filter_GetSliceLines((job->height + 1) / 2, band, bands, &first, &end);
+    first *= 2;
+    end = __MIN(2 * end, (int)job->height);
+    if (first >= end)
+        return;
 
+    const uint8_t *src[3];
+    for (unsigned i = 0; i < job->src_planes; i++)
+        src[i] = job->src[i] + (i > 0 ? first / 2 : first) * job->src_pitch[i];
+
+    picture_t dst = *job->dst;
+    for (int i = 0; i < dst.i_planes; i++)
+        dst.p[i].p_pixels += (i > 0 ? first / 2 : first) * dst.p[i].i_pitch;
+
+    job->copy(&dst, src, job->src_pitch, end - first, job->bitshift,
+              &job->cache->bands[band]);
+}
+
+static void CopyBands(copy_fn copy, picture_t *dst, const uint8_t *src[],
+                      const size_t src_pitch[], unsigned src_planes,
+                      unsigned height, int bitshift, const copy_cache_t *cache)
+{
+    const unsigned bands = __MIN(cache->band_count, height / COPY_BAND_LINES);
+
+    if (bands < 2)
+    {
+        copy(dst, src, src_pitch, height, bitshift, cache);
+        return;
+    }
+
+    struct copy_job job = {
+        .copy = copy, .dst = dst, .src = src, .src_pitch = src_pitch,
+        .src_planes = src_planes, .height = height, .bitshift = bitshift,
+        .cache = cache,
+    };
+    filter_RunSlices(cache->slices, CopyBand, &job, bands);
+}
+
+static void DoCopyPacked(picture_t *dst, const uint8_t *src[],
+                         const size_t src_pitch[], unsigned height,
+                         int bitshift, const copy_cache_t *cache)
+{
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE4_1())
-        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                             src[0], src_pitch[0],
                              cache->buffer, cache->size, height, 0);
 #else
     (void) cache;
 #endif
-        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
                   height, 0);
 }
 
-void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
-                      const size_t src_pitch[static 2], unsigned height,
-                      const copy_cache_t *cache)
+void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
+                unsigned height, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    assert(dst);
+    assert(src); assert(src_pitch);
+    assert(height);
+
+    CopyBands(DoCopyPacked, dst, &src, &src_pitch, 1, height, 0, cache);
+}
+
+static void DoCopy420_SP_to_SP(picture_t *dst, const uint8_t *src[],
+                               const size_t src_pitch[], unsigned height,
+                               int bitshift, const copy_cache_t *cache)
+{
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
@@ -675,6 +858,14 @@ void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
               src[1], src_pitch[1], height/2, 0);
 }
 
+void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                      const size_t src_pitch[static 2], unsigned height,
+                      const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    CopyBands(DoCopy420_SP_to_SP, dst, src, src_pitch, 2, height, 0, cache);
+}
+
 #define SPLIT_PLANES(type, pitch_den) do { \
     for (unsigned y = 0; y < height; y++) { \
         for (unsigned x = 0; x < src_pitch / pitch_den; x++) { \
@@ -731,11 +922,11 @@ static void SplitPlanes16(uint8_t *dstu, size_t dstu_pitch,
         SPLIT_PLANES_SHIFTL(uint16_t, 4, (-bitshift) & 0xf);
 }
 
-void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                     const size_t src_pitch[static 2], unsigned height,
-                     const copy_cache_t *cache)
+static void DoCopy420_SP_to_P(picture_t *dst, const uint8_t *src[],
+                              const size_t src_pitch[], unsigned height,
+                              int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
@@ -750,13 +941,18 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                 src[1], src_pitch[1], height/2);
 }
 
-void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                        const size_t src_pitch[static 2], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                     const size_t src_pitch[static 2], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_2PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(DoCopy420_SP_to_P, dst, src, src_pitch, 2, height, 0, cache);
+}
 
+static void DoCopy420_16_SP_to_P(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
+{
 #ifdef CAN_COMPILE_SSE3
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -771,6 +967,16 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                   src[1], src_pitch[1], height/2, bitshift);
 }
 
+void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                        const size_t src_pitch[static 2], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(DoCopy420_16_SP_to_P, dst, src, src_pitch, 2, height, bitshift,
+              cache);
+}
+
 #define INTERLEAVE_UV() do { \
     for ( unsigned int line = 0; line < copy_lines; line++ ) { \
         for ( unsigned int col = 0; col < copy_pitch; col++ ) { \
@@ -807,11 +1013,11 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
     } \
 }while(0)
 
-void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                     const size_t src_pitch[static 3], unsigned height,
-                     const copy_cache_t *cache)
+static void DoCopy420_P_to_SP(picture_t *dst, const uint8_t *src[],
+                              const size_t src_pitch[], unsigned height,
+                              int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_3PLANES;
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
@@ -835,12 +1041,18 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     INTERLEAVE_UV();
 }
 
-void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                        const size_t src_pitch[static 3], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                     const size_t src_pitch[static 3], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(DoCopy420_P_to_SP, dst, src, src_pitch, 3, height, 0, cache);
+}
+
+static void DoCopy420_16_P_to_SP(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
+{
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -870,11 +1082,21 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
         INTERLEAVE_UV_SHIFTL((-bitshift) & 0xf);
 }
 
-void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
-                    const size_t src_pitch[static 3], unsigned height,
-                    const copy_cache_t *cache)
+void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                        const size_t src_pitch[static 3], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(DoCopy420_16_P_to_SP, dst, src, src_pitch, 3, height, bitshift,
+              cache);
+}
+
+static void DoCopy420_P_to_P(picture_t *dst, const uint8_t *src[],
+                             const size_t src_pitch[], unsigned height,
+                             int bitshift, const copy_cache_t *cache)
+{
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_P(dst, src, src_pitch, height, cache);
@@ -890,6 +1112,14 @@ void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
                src[2], src_pitch[2], height / 2, 0);
 }
 
+void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                    const size_t src_pitch[static 3], unsigned height,
+                    const copy_cache_t *cache)
+{
+    ASSERT_3PLANES;
+    CopyBands(DoCopy420_P_to_P, dst, src, src_pitch, 3, height, 0, cache);
+}
+
 int picture_UpdatePlanes(picture_t *picture, uint8_t *data, unsigned pitch)
 {
     /* fill in buffer info in first plane */
@@ -983,6 +1213,7 @@ static const struct test_conv convs[] = {
 };
 #define NB_CONVS ARRAY_SIZE(convs)
 
+#ifndef COPY_BENCH
 struct test_size
 {
     int i_width;
@@ -1095,7 +1326,92 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     }
     return picture_NewFromResource(fmt, &rsc);
 }
+#endif
+
+static void conv_run(const struct test_dst *test_dst, picture_t *dst,
+                     picture_t *src, const copy_cache_t *cache)
+{
+    const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                      src->p[U_PLANE].p_pixels,
+                                      src->p[V_PLANE].p_pixels };
+    const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                       src->p[U_PLANE].i_pitch,
+                                       src->p[V_PLANE].i_pitch };
+
+    if (test_dst->bitshift == 0)
+        test_dst->conv(dst, src_planes, src_pitches,
+                       src->format.i_visible_height, cache);
+    else
+        test_dst->conv16(dst, src_planes, src_pitches,
+                         src->format.i_visible_height, test_dst->bitshift,
+                         cache);
+}
+
+static int cache_init(copy_cache_t *cache, unsigned width, bool threaded)
+{
+    /* more bands than CPUs is fine, it still checks the band splitting */
+    return threaded ? CopyInitCacheThreads(cache, NULL, width, 4)
+                    : CopyInitCache(cache, width);
+}
+
+#ifdef COPY_BENCH
+/* Throughput of each conversion in 4K, single and multi-threaded */
+int main(void)
+{
+    const unsigned width = 3840, height = 2160, runs = 20;
+
+    for (size_t i = 0; i < NB_CONVS; ++i)
+    {
+        const struct test_conv *conv = &convs[i];
+        const vlc_chroma_description_t *src_dsc =
+            vlc_fourcc_GetChromaDescription(conv->src_chroma);
+
+        video_format_t fmt;
+        video_format_Init(&fmt, 0);
+        video_format_Setup(&fmt, conv->src_chroma, width, height,
+                           width, height, 1, 1);
+        picture_t *src = picture_NewFromFormat(&fmt);
+        assert(src);
+
+        size_t bytes = 0;
+        for (int p = 0; p < src->i_planes; p++)
+            bytes += src->p[p].i_visible_pitch * src->p[p].i_visible_lines;
+
+        for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+        {
+            const struct test_dst *test_dst = &conv->dsts[f];
+            fmt.i_chroma = test_dst->chroma;
+            picture_t *dst = picture_NewFromFormat(&fmt);
+            assert(dst);
+
+            double mbps[2];
+            for (int threaded = 0; threaded < 2; threaded++)
+            {
+                copy_cache_t cache;
+                int ret = cache_init(&cache, width * src_dsc->pixel_size,
+                                     threaded);
+                assert(ret == VLC_SUCCESS);
+
+                conv_run(test_dst, dst, src, &cache); /* warm up */
+                mtime_t start = mdate();
+                for (unsigned r = 0; r < runs; r++)
+                    conv_run(test_dst, dst, src, &cache);
+                mtime_t elapsed = __MAX(mdate() - start, 1);
+                mbps[threaded] = (double)bytes * runs / elapsed;
+                CopyCleanCache(&cache);
+            }
+            fprintf(stderr, "bench: %4.4s -> %4.4s: %7.1f MB/s, "
+                    "%7.1f MB/s threaded\n",
+                    (const char *) &conv->src_chroma,
+                    (const char *) &test_dst->chroma, mbps[0], mbps[1]);
+            picture_Release(dst);
+        }
+        picture_Release(src);
+    }
+    return 0;
+}
 
+#else
 int main(void)
 {
     alarm(10);
@@ -1130,49 +1446,42 @@ int main(void)
             assert(src);
             piccheck(src, src_dsc, true);
 
-            copy_cache_t cache;
-            int ret = CopyInitCache(&cache, src->format.i_width
-                                    * src_dsc->pixel_size);
-            assert(ret == VLC_SUCCESS);
-
-            for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+            for (int threaded = 0; threaded < 2; threaded++)
             {
-                const struct test_dst *test_dst= &conv->dsts[f];
-
-                const vlc_chroma_description_t *dst_dsc =
-                    vlc_fourcc_GetChromaDescription(test_dst->chroma);
-                assert(dst_dsc);
-                fmt.i_chroma = test_dst->chroma;
-                picture_t *dst = picture_NewFromFormat(&fmt);
-                assert(dst);
-
-                const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
-                                                  src->p[U_PLANE].p_pixels,
-                                                  src->p[V_PLANE].p_pixels };
-                const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
-                                                   src->p[U_PLANE].i_pitch,
-                                                   src->p[V_PLANE].i_pitch };
-
-                fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s\n",
-                        size->i_width, size->i_height,
-                        size->i_visible_width, size->i_visible_height,
-                        (const char *) &src->format.i_chroma,
-                        (const char *) &dst->format.i_chroma);
-                if (test_dst->bitshift == 0)
-                    test_dst->conv(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, &cache);
-                else
-                    test_dst->conv16(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, test_dst->bitshift,
-                                   &cache);
-                piccheck(dst, dst_dsc, false);
-                picture_Release(dst);
+                copy_cache_t cache;
+                int ret = cache_init(&cache, src->format.i_width
+                                     * src_dsc->pixel_size, threaded);
+                assert(ret == VLC_SUCCESS);
+
+                for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+                {
+                    const struct test_dst *test_dst= &conv->dsts[f];
+
+                    const vlc_chroma_description_t *dst_dsc =
+                        vlc_fourcc_GetChromaDescription(test_dst->chroma);
+                    assert(dst_dsc);
+                    fmt.i_chroma = test_dst->chroma;
+                    picture_t *dst = picture_NewFromFormat(&fmt);
+                    assert(dst);
+
+                    fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s%s\n",
+                            size->i_width, size->i_height,
+                            size->i_visible_width, size->i_visible_height,
+                            (const char *) &src->format.i_chroma,
+                            (const char *) &dst->format.i_chroma,
+                            threaded ? " (threaded)" : "");
+                    conv_run(test_dst, dst, src, &cache);
+                    piccheck(dst, dst_dsc, false);
+                    picture_Release(dst);
+                }
+                CopyCleanCache(&cache);
             }
             picture_Release(src);
-            CopyCleanCache(&cache);
         }
     }
+
     return 0;
 }
 
 #endif
+#endif
@@ -26,14 +26,25 @@
 
 #include <assert.h>
 
-typedef struct {
+typedef struct copy_cache_t copy_cache_t;
+
+struct copy_cache_t {
 # ifdef CAN_COMPILE_SSE2
     uint8_t *buffer;
     size_t  size;
 # endif
-} copy_cache_t;
+    /* band-parallel copies, see CopyInitCacheThreads() */
+    struct filter_slices_t *slices;
+    unsigned                band_count;
+    copy_cache_t           *bands; /* one cache per band */
+};
 
 int  CopyInitCache(copy_cache_t *cache, unsigned width);
+
+/* Like CopyInitCache() but the copies of large pictures are split into bands
+ * of lines processed by up to threads threads (0 for an automatic value). */
+int  CopyInitCacheThreads(copy_cache_t *cache, vlc_object_t *obj,
+                          unsigned width, unsigned threads);
 void CopyCleanCache(copy_cache_t *cache);
 
 /* YUVY/RGB copies */
@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * yuv_simd.c : AVX2 and NEON YUV to RGB/packed YUV video converter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "yuv_simd.h"
+
+static int  Open (vlc_object_t *);
+static void Close(vlc_object_t *);
+
+vlc_module_begin ()
+    set_description (N_("AVX2/NEON video chroma YUV->RGB/YUY2"))
+    set_capability ("video converter", 260)
+    set_callbacks (Open, Close)
+vlc_module_end ()
+
+struct filter_sys_t
+{
+    yuv_simd_convert_t convert;
+    yuv_simd_coefs_t   coefs;
+    bool               swap_uv; /* YV12, NV21 */
+};
+
+static picture_t *Filter (filter_t *filter, picture_t *src)
+{
+    filter_sys_t *sys = filter->p_sys;
+    picture_t *dst = filter_NewPicture (filter);
+
+    if (dst != NULL)
+    {
+        sys->convert (dst->p, src->p, filter->fmt_in.video.i_visible_width,
+                      filter->fmt_in.video.i_visible_height, sys->swap_uv,
+                      &sys->coefs);
+        picture_CopyProperties (dst, src);
+    }
+    picture_Release (src);
+    return dst;
+}
+
+static int GetOutput (const video_format_t *fmt, enum yuv_simd_out *out)
+{
+    switch (fmt->i_chroma)
+    {
+        case VLC_CODEC_RGB32:
+            if (fmt->i_gmask != 0x0000ff00 || fmt->i_bmask == fmt->i_rmask)
+                return VLC_EGENERIC;
+            if (fmt->i_rmask == 0x000000ff && fmt->i_bmask == 0x00ff0000)
+                *out = YUV_SIMD_OUT_RGBA;
+            else
+            if (fmt->i_rmask == 0x00ff0000 && fmt->i_bmask == 0x000000ff)
+                *out = YUV_SIMD_OUT_BGRA;
+            else
+                return VLC_EGENERIC;
+            break;
+        case VLC_CODEC_RGBA:
+            *out = YUV_SIMD_OUT_RGBA;
+            break;
+        case VLC_CODEC_BGRA:
+            *out = YUV_SIMD_OUT_BGRA;
+            break;
+        case VLC_CODEC_YUYV:
+            *out = YUV_SIMD_OUT_YUYV;
+            break;
+        case VLC_CODEC_UYVY:
+            *out = YUV_SIMD_OUT_UYVY;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    const video_format_t *fmt_in = &filter->fmt_in.video;
+    const video_format_t *fmt_out = &filter->fmt_out.video;
+
+    const enum yuv_simd_isa isa = yuv_simd_GetISA ();
+    if (isa == YUV_SIMD_ISA_C)
+        return VLC_EGENERIC;
+
+    /* the converters process the visible area */
+    if ((fmt_in->i_visible_width != fmt_out->i_visible_width)
+     || (fmt_in->i_visible_height != fmt_out->i_visible_height)
+     || (fmt_in->orientation != fmt_out->orientation))
+        return VLC_EGENERIC;
+
+    /* the coefficients are for limited range */
+    if (fmt_in->b_color_range_full)
+        return VLC_EGENERIC;
+
+    enum yuv_simd_in in;
+    bool swap_uv = false;
+
+    switch (fmt_in->i_chroma)
+    {
+        case VLC_CODEC_YV12:
+            swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+            in = YUV_SIMD_IN_I420;
+            break;
+        case VLC_CODEC_NV21:
+            swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_NV12:
+            in = YUV_SIMD_IN_NV12;
+            break;
+        case VLC_CODEC_P010:
+            in = YUV_SIMD_IN_P010;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    enum yuv_simd_out out;
+    if (GetOutput (fmt_out, &out))
+        return VLC_EGENERIC;
+
+    yuv_simd_convert_t convert = yuv_simd_Get (in, out, isa);
+    if (convert == NULL)
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = malloc (sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->convert = convert;
+    sys->swap_uv = swap_uv;
+
+    video_color_space_t space = fmt_in->space;
+    if (space == COLOR_SPACE_UNDEF)
+        space = fmt_in->i_height > 576 ? COLOR_SPACE_BT709
+                                       : COLOR_SPACE_BT601;
+    yuv_simd_GetCoefs (&sys->coefs, space);
+
+    filter->p_sys = sys;
+    filter->pf_video_filter = Filter;
+    return VLC_SUCCESS;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    free (filter->p_sys);
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * yuv_simd.h : AVX2 and NEON YUV to RGB/packed YUV converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOCHROMA_YUV_SIMD_H_
+#define VLC_VIDEOCHROMA_YUV_SIMD_H_
+
+/* 4:2:0 source layouts */
+enum yuv_simd_in
+{
+    YUV_SIMD_IN_I420, /* 8-bit planar (also YV12, with swapped chroma) */
+    YUV_SIMD_IN_NV12, /* 8-bit semi-planar (also NV21) */
+    YUV_SIMD_IN_P010, /* 16-bit semi-planar, 10 significant high bits */
+    YUV_SIMD_IN_COUNT
+};
+
+/* destination layouts, in memory byte order */
+enum yuv_simd_out
+{
+    YUV_SIMD_OUT_RGBA,
+    YUV_SIMD_OUT_BGRA,
+    YUV_SIMD_OUT_YUYV,
+    YUV_SIMD_OUT_UYVY,
+    YUV_SIMD_OUT_COUNT
+};
+
+enum yuv_simd_isa
+{
+    YUV_SIMD_ISA_C,    /* reference, also used for the end of lines */
+    YUV_SIMD_ISA_AVX2,
+    YUV_SIMD_ISA_NEON,
+};
+
+/* Limited range YUV to RGB matrix, luma in Q14, chroma in Q13 */
+typedef struct
+{
+    int16_t y, rv, gu, gv, bu;
+} yuv_simd_coefs_t;
+
+void yuv_simd_GetCoefs(yuv_simd_coefs_t *, video_color_space_t);
+
+/* Converts the visible area of src into dst->p[0]. With odd dimensions, the
+ * last column and row use the last chroma samples, and packed YUV rows end
+ * with a whole pixel pair. swap_uv selects YV12 and NV21 chroma order. */
+typedef void (*yuv_simd_convert_t)(plane_t *dst, const plane_t *src,
+                                   unsigned width, unsigned height,
+                                   bool swap_uv, const yuv_simd_coefs_t *);
+
+/* Returns the best instruction set available on this CPU */
+enum yuv_simd_isa yuv_simd_GetISA(void);
+
+/* Returns NULL if the instruction set was not compiled in */
+yuv_simd_convert_t yuv_simd_Get(enum yuv_simd_in, enum yuv_simd_out,
+                                enum yuv_simd_isa);
+
+#endif
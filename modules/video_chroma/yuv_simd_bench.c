@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * yuv_simd_bench.c : benchmark of the SIMD YUV converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Prints the throughput of each converter, in C and with the best
+ * instruction set of this CPU. yuv_simd_test.c checks their output.
+ *
+ * Usage: chroma_yuv_simd_bench [width height] (default 1920x1080)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_bench.h>
+
+#include "yuv_simd.h"
+
+static const char *const in_names[YUV_SIMD_IN_COUNT] = {
+    "I420", "NV12", "P010",
+};
+static const char *const out_names[YUV_SIMD_OUT_COUNT] = {
+    "RGBA", "BGRA", "YUYV", "UYVY",
+};
+
+typedef struct
+{
+    plane_t  src[3];
+    plane_t  dst;
+    uint8_t *buf[4];
+} bench_pic_t;
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static int Alloc(bench_pic_t *pic, enum yuv_simd_in in,
+                 unsigned width, unsigned height)
+{
+    const unsigned bpp = in == YUV_SIMD_IN_P010 ? 2 : 1;
+    /* padding so that lines can be read and written past the width */
+    const unsigned pitch = (width + 64) * bpp;
+    const unsigned planes = in == YUV_SIMD_IN_I420 ? 3 : 2;
+    unsigned seed = 1;
+
+    memset(pic, 0, sizeof(*pic));
+    for (unsigned i = 0; i < planes; i++)
+    {
+        plane_t *p = &pic->src[i];
+
+        p->i_pitch = in == YUV_SIMD_IN_I420 && i > 0 ? pitch / 2 : pitch;
+        p->i_lines = i > 0 ? height / 2 : height;
+        pic->buf[i] = malloc(p->i_pitch * p->i_lines);
+        if (pic->buf[i] == NULL)
+            return -1;
+        p->p_pixels = pic->buf[i];
+
+        for (int j = 0; j < p->i_pitch * p->i_lines; j++)
+            p->p_pixels[j] = rnd(&seed);
+        /* keep the 10 significant bits only */
+        if (bpp == 2)
+            for (int j = 0; j < p->i_pitch * p->i_lines; j += 2)
+                p->p_pixels[j] &= 0xc0;
+    }
+
+    pic->dst.i_pitch = (width + 64) * 4;
+    pic->dst.i_lines = height;
+    pic->buf[3] = malloc(pic->dst.i_pitch * height);
+    if (pic->buf[3] == NULL)
+        return -1;
+    pic->dst.p_pixels = pic->buf[3];
+    return 0;
+}
+
+static void Free(bench_pic_t *pic)
+{
+    for (int i = 0; i < 4; i++)
+        free(pic->buf[i]);
+}
+
+struct bench
+{
+    yuv_simd_convert_t convert;
+    plane_t dst;
+    const bench_pic_t *pic;
+    unsigned width, height;
+    const yuv_simd_coefs_t *k;
+};
+
+static void BenchRun(void *opaque)
+{
+    struct bench *b = opaque;
+
+    b->convert(&b->dst, b->pic->src, b->width, b->height, false, b->k);
+}
+
+static double Bench(yuv_simd_convert_t convert, const bench_pic_t *pic,
+                    unsigned width, unsigned height,
+                    const yuv_simd_coefs_t *k)
+{
+    struct bench b = { convert, pic->dst, pic, width, height, k };
+
+    return (double)width * height * vlc_bench_Run(BenchRun, &b, CLOCK_FREQ / 5);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned width = 1920, height = 1080;
+    if (argc > 2)
+    {
+        width = atoi(argv[1]) & ~1;
+        height = atoi(argv[2]) & ~1;
+    }
+    if (width == 0 || height == 0)
+        return 1;
+
+    const enum yuv_simd_isa isa = yuv_simd_GetISA();
+    yuv_simd_coefs_t k;
+    yuv_simd_GetCoefs(&k, COLOR_SPACE_BT709);
+
+    printf("%ux%u, Mpix/s for C and %s\n", width, height,
+           isa == YUV_SIMD_ISA_AVX2 ? "AVX2" :
+           isa == YUV_SIMD_ISA_NEON ? "NEON" : "C");
+
+    for (int in = 0; in < YUV_SIMD_IN_COUNT; in++)
+    {
+        bench_pic_t pic;
+
+        if (Alloc(&pic, in, width, height))
+        {
+            Free(&pic);
+            return 1;
+        }
+
+        for (int out = 0; out < YUV_SIMD_OUT_COUNT; out++)
+        {
+            yuv_simd_convert_t ref = yuv_simd_Get(in, out, YUV_SIMD_ISA_C);
+            yuv_simd_convert_t simd = yuv_simd_Get(in, out, isa);
+
+            double c = Bench(ref, &pic, width, height, &k);
+            double s = Bench(simd, &pic, width, height, &k);
+            printf("%s->%s: %8.1f %8.1f (x%.1f)\n", in_names[in],
+                   out_names[out], c, s, s / c);
+        }
+        Free(&pic);
+    }
+    return 0;
+}
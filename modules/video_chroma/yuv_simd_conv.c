@@ -0,0 +1,624 @@
+/*****************************************************************************
+ * yuv_simd_conv.c : AVX2 and NEON YUV to RGB/packed YUV converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#include "yuv_simd.h"
+
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define YUV_SIMD_AVX2
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define YUV_SIMD_NEON
+#endif
+
+/*
+ * All the implementations compute the same integer arithmetic, so that they
+ * are bit-exact with each other:
+ *  - samples are normalized to 16-bit: (Y - 16) << 7 and (C - 128) << 8 for
+ *    8-bit sources, the same scale for 10-bit ones,
+ *  - products keep the high 16 bits ((a * c) >> 16), which gives 5 fractional
+ *    bits with Q14 luma and Q13 chroma coefficients,
+ *  - packed YUV from P010 rounds to 8-bit.
+ */
+
+void yuv_simd_GetCoefs(yuv_simd_coefs_t *k, video_color_space_t space)
+{
+    k->y = 19077; /* 255/219 */
+    switch (space)
+    {
+        case COLOR_SPACE_BT601:
+            k->rv = 13075; k->gu = -3209; k->gv = -6660; k->bu = 16525;
+            break;
+        case COLOR_SPACE_BT2020:
+            k->rv = 13752; k->gu = -1535; k->gv = -5328; k->bu = 17545;
+            break;
+        default:
+            k->rv = 14686; k->gu = -1747; k->gv = -4366; k->bu = 17305;
+            break;
+    }
+}
+
+typedef struct
+{
+    uint8_t       *dst;
+    const uint8_t *y;
+    const uint8_t *u; /* interleaved chroma for semi-planar layouts */
+    const uint8_t *v;
+} yuv_row_t;
+
+static inline bool IsRGB(enum yuv_simd_out out)
+{
+    return out == YUV_SIMD_OUT_RGBA || out == YUV_SIMD_OUT_BGRA;
+}
+
+/*****************************************************************************
+ * C
+ *****************************************************************************/
+static inline int MulHi(int a, int c)
+{
+    return (a * c) >> 16;
+}
+
+static inline uint8_t Round8(unsigned s)
+{
+    s = (s + 128) >> 8;
+    return s > 255 ? 255 : s;
+}
+
+/* Normalized samples of pixel x */
+static inline void LoadC(enum yuv_simd_in in, const yuv_row_t *row, unsigned x,
+                  bool swap, int *y, int *u, int *v)
+{
+    const unsigned c = x / 2;
+
+    switch (in)
+    {
+        case YUV_SIMD_IN_I420:
+            *y = (row->y[x] << 7) - 2048;
+            *u = (row->u[c] << 8) - 32768;
+            *v = (row->v[c] << 8) - 32768;
+            break;
+        case YUV_SIMD_IN_NV12:
+            *y = (row->y[x] << 7) - 2048;
+            *u = (row->u[2 * c + swap] << 8) - 32768;
+            *v = (row->u[2 * c + !swap] << 8) - 32768;
+            break;
+        default:
+        {
+            const uint16_t *py = (const uint16_t *)row->y;
+            const uint16_t *puv = (const uint16_t *)row->u;
+            *y = (py[x] >> 1) - 2048;
+            *u = puv[2 * c + swap] - 32768;
+            *v = puv[2 * c + !swap] - 32768;
+            break;
+        }
+    }
+}
+
+/* 8-bit samples of the pixel pair starting at x. At the end of a row of odd
+ * width, there is no second pixel: the first one is repeated. */
+static inline void LoadC8(enum yuv_simd_in in, const yuv_row_t *row, unsigned x,
+                   unsigned width, bool swap, uint8_t y[2], uint8_t *u,
+                   uint8_t *v)
+{
+    const unsigned c = x / 2;
+    const unsigned x1 = x + 1 < width ? x + 1 : x;
+
+    switch (in)
+    {
+        case YUV_SIMD_IN_I420:
+            y[0] = row->y[x];
+            y[1] = row->y[x1];
+            *u = row->u[c];
+            *v = row->v[c];
+            break;
+        case YUV_SIMD_IN_NV12:
+            y[0] = row->y[x];
+            y[1] = row->y[x1];
+            *u = row->u[2 * c + swap];
+            *v = row->u[2 * c + !swap];
+            break;
+        default:
+        {
+            const uint16_t *py = (const uint16_t *)row->y;
+            const uint16_t *puv = (const uint16_t *)row->u;
+            y[0] = Round8(py[x]);
+            y[1] = Round8(py[x1]);
+            *u = Round8(puv[2 * c + swap]);
+            *v = Round8(puv[2 * c + !swap]);
+            break;
+        }
+    }
+}
+
+/* Converts pixels [x, width) of a row, x being even. The packed YUV outputs
+ * are written by whole pixel pairs, so up to width rounded up to even. */
+static inline void RowC(enum yuv_simd_in in, enum yuv_simd_out out,
+                 const yuv_row_t *row, unsigned x, unsigned width,
+                 bool swap, const yuv_simd_coefs_t *k)
+{
+    if (IsRGB(out))
+    {
+        const int ri = out == YUV_SIMD_OUT_RGBA ? 0 : 2;
+
+        for (; x < width; x++)
+        {
+            int y, u, v;
+            LoadC(in, row, x, swap, &y, &u, &v);
+
+            y = MulHi(y, k->y) + 16;
+            uint8_t *p = &row->dst[4 * x];
+            p[ri]     = clip_uint8_vlc((y + MulHi(v, k->rv)) >> 5);
+            p[1]      = clip_uint8_vlc((y + MulHi(u, k->gu) + MulHi(v, k->gv)) >> 5);
+            p[2 - ri] = clip_uint8_vlc((y + MulHi(u, k->bu)) >> 5);
+            p[3]      = 0xff;
+        }
+    }
+    else
+    {
+        const int yi = out == YUV_SIMD_OUT_YUYV ? 0 : 1;
+
+        for (; x < width; x += 2)
+        {
+            uint8_t y[2], u, v;
+            LoadC8(in, row, x, width, swap, y, &u, &v);
+
+            uint8_t *p = &row->dst[2 * x];
+            p[yi]     = y[0];
+            p[1 - yi] = u;
+            p[yi + 2] = y[1];
+            p[3 - yi] = v;
+        }
+    }
+}
+
+/* Calls the SIMD row function then finishes the row in C */
+#define CONVERT_ROWS(isa) \
+    for (unsigned j = 0; j < height; j++) \
+    { \
+        yuv_row_t row = { \
+            .dst = dst->p_pixels + j * dst->i_pitch, \
+            .y = src[0].p_pixels + j * src[0].i_pitch, \
+            .u = src[1].p_pixels + (j / 2) * src[1].i_pitch, \
+        }; \
+        if (in == YUV_SIMD_IN_I420) \
+        { \
+            /* swap the planes instead of the samples */ \
+            row.v = src[2].p_pixels + (j / 2) * src[2].i_pitch; \
+            if (swap) \
+            { \
+                const uint8_t *t = row.u; row.u = row.v; row.v = t; \
+            } \
+        } \
+        unsigned x = Row##isa(in, out, &row, width, \
+                              in != YUV_SIMD_IN_I420 && swap, k); \
+        RowC(in, out, &row, x, width, in != YUV_SIMD_IN_I420 && swap, k); \
+    }
+
+#define CONVERTER(isa, target, i, o) \
+target static void Convert_##isa##_##i##_##o(plane_t *dst, const plane_t *src, \
+                                             unsigned width, unsigned height, \
+                                             bool swap, \
+                                             const yuv_simd_coefs_t *k) \
+{ \
+    const enum yuv_simd_in in = YUV_SIMD_IN_##i; \
+    const enum yuv_simd_out out = YUV_SIMD_OUT_##o; \
+    CONVERT_ROWS(isa) \
+}
+
+#define CONVERTERS(isa, target) \
+    CONVERTER(isa, target, I420, RGBA) CONVERTER(isa, target, I420, BGRA) \
+    CONVERTER(isa, target, I420, YUYV) CONVERTER(isa, target, I420, UYVY) \
+    CONVERTER(isa, target, NV12, RGBA) CONVERTER(isa, target, NV12, BGRA) \
+    CONVERTER(isa, target, NV12, YUYV) CONVERTER(isa, target, NV12, UYVY) \
+    CONVERTER(isa, target, P010, RGBA) CONVERTER(isa, target, P010, BGRA) \
+    CONVERTER(isa, target, P010, YUYV) CONVERTER(isa, target, P010, UYVY) \
+    static const yuv_simd_convert_t converters_##isa[YUV_SIMD_IN_COUNT] \
+                                                   [YUV_SIMD_OUT_COUNT] = { \
+        { Convert_##isa##_I420_RGBA, Convert_##isa##_I420_BGRA, \
+          Convert_##isa##_I420_YUYV, Convert_##isa##_I420_UYVY }, \
+        { Convert_##isa##_NV12_RGBA, Convert_##isa##_NV12_BGRA, \
+          Convert_##isa##_NV12_YUYV, Convert_##isa##_NV12_UYVY }, \
+        { Convert_##isa##_P010_RGBA, Convert_##isa##_P010_BGRA, \
+          Convert_##isa##_P010_YUYV, Convert_##isa##_P010_UYVY }, \
+    };
+
+/* the C converter leaves the whole row to RowC() */
+static inline unsigned RowC0(enum yuv_simd_in in, enum yuv_simd_out out,
+                             const yuv_row_t *row, unsigned width, bool swap,
+                             const yuv_simd_coefs_t *k)
+{
+    VLC_UNUSED(in); VLC_UNUSED(out); VLC_UNUSED(row); VLC_UNUSED(width);
+    VLC_UNUSED(swap); VLC_UNUSED(k);
+    return 0;
+}
+
+CONVERTERS(C0, )
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef YUV_SIMD_AVX2
+# define AVX2_INLINE VLC_AVX2 static inline __attribute__((always_inline))
+
+AVX2_INLINE __m256i Avx2MulHi(__m256i a, int16_t c)
+{
+    return _mm256_mulhi_epi16(a, _mm256_set1_epi16(c));
+}
+
+/* Duplicates the U (even) or V (odd) 16-bit lanes over pixel pairs */
+# define AVX2_DUP_EVEN(uv) \
+    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv, 0xa0), 0xa0)
+# define AVX2_DUP_ODD(uv) \
+    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv, 0xf5), 0xf5)
+
+/* Loads 16 normalized pixels */
+AVX2_INLINE void Avx2Load16(enum yuv_simd_in in, const yuv_row_t *row,
+                            unsigned x, bool swap,
+                            __m256i *y, __m256i *u, __m256i *v)
+{
+    const __m256i bias = _mm256_set1_epi16(2048);
+    const __m256i sign = _mm256_set1_epi16(-32768);
+    __m256i uu, vv;
+
+    if (in == YUV_SIMD_IN_P010)
+    {
+        __m256i yy = _mm256_loadu_si256((const __m256i *)(row->y + 2 * x));
+        __m256i uv = _mm256_loadu_si256((const __m256i *)(row->u + 2 * x));
+
+        *y = _mm256_sub_epi16(_mm256_srli_epi16(yy, 1), bias);
+        uu = AVX2_DUP_EVEN(uv);
+        vv = AVX2_DUP_ODD(uv);
+    }
+    else
+    {
+        __m256i yy = _mm256_cvtepu8_epi16(
+                        _mm_loadu_si128((const __m128i *)(row->y + x)));
+
+        *y = _mm256_sub_epi16(_mm256_slli_epi16(yy, 7), bias);
+        if (in == YUV_SIMD_IN_I420)
+        {
+            __m128i u8 = _mm_loadl_epi64((const __m128i *)(row->u + x / 2));
+            __m128i v8 = _mm_loadl_epi64((const __m128i *)(row->v + x / 2));
+            uu = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8));
+            vv = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8));
+        }
+        else
+        {
+            __m256i uv = _mm256_cvtepu8_epi16(
+                            _mm_loadu_si128((const __m128i *)(row->u + x)));
+            uu = AVX2_DUP_EVEN(uv);
+            vv = AVX2_DUP_ODD(uv);
+        }
+        uu = _mm256_slli_epi16(uu, 8);
+        vv = _mm256_slli_epi16(vv, 8);
+    }
+    uu = _mm256_xor_si256(uu, sign);
+    vv = _mm256_xor_si256(vv, sign);
+
+    *u = swap ? vv : uu;
+    *v = swap ? uu : vv;
+}
+
+AVX2_INLINE void Avx2StoreRGBA(uint8_t *p, __m256i r, __m256i g, __m256i b)
+{
+    const __m256i a = _mm256_set1_epi16(0xff);
+    __m256i rb = _mm256_packus_epi16(r, b); /* r0-7 b0-7 | r8-15 b8-15 */
+    __m256i ga = _mm256_packus_epi16(g, a);
+    __m256i rg = _mm256_unpacklo_epi8(rb, ga);
+    __m256i ba = _mm256_unpackhi_epi8(rb, ga);
+    __m256i p0 = _mm256_unpacklo_epi16(rg, ba); /* pixels 0-3 | 8-11 */
+    __m256i p1 = _mm256_unpackhi_epi16(rg, ba); /* pixels 4-7 | 12-15 */
+
+    _mm256_storeu_si256((__m256i *)p, _mm256_permute2x128_si256(p0, p1, 0x20));
+    _mm256_storeu_si256((__m256i *)(p + 32),
+                        _mm256_permute2x128_si256(p0, p1, 0x31));
+}
+
+/* 8-bit from P010 with rounding, 32 samples in order */
+AVX2_INLINE __m256i Avx2Round8(const uint8_t *p)
+{
+    const __m256i r = _mm256_set1_epi16(128);
+    __m256i a = _mm256_loadu_si256((const __m256i *)p);
+    __m256i b = _mm256_loadu_si256((const __m256i *)(p + 32));
+
+    a = _mm256_srli_epi16(_mm256_adds_epu16(a, r), 8);
+    b = _mm256_srli_epi16(_mm256_adds_epu16(b, r), 8);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+}
+
+AVX2_INLINE unsigned RowAVX2(enum yuv_simd_in in, enum yuv_simd_out out,
+                             const yuv_row_t *row, unsigned width, bool swap,
+                             const yuv_simd_coefs_t *k)
+{
+    unsigned x = 0;
+
+    if (IsRGB(out))
+    {
+        const __m256i round = _mm256_set1_epi16(16);
+
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256i y, u, v;
+            Avx2Load16(in, row, x, swap, &y, &u, &v);
+
+            y = _mm256_add_epi16(Avx2MulHi(y, k->y), round);
+            __m256i r = _mm256_add_epi16(y, Avx2MulHi(v, k->rv));
+            __m256i g = _mm256_add_epi16(_mm256_add_epi16(y, Avx2MulHi(u, k->gu)),
+                                         Avx2MulHi(v, k->gv));
+            __m256i b = _mm256_add_epi16(y, Avx2MulHi(u, k->bu));
+            r = _mm256_srai_epi16(r, 5);
+            g = _mm256_srai_epi16(g, 5);
+            b = _mm256_srai_epi16(b, 5);
+
+            if (out == YUV_SIMD_OUT_RGBA)
+                Avx2StoreRGBA(&row->dst[4 * x], r, g, b);
+            else
+                Avx2StoreRGBA(&row->dst[4 * x], b, g, r);
+        }
+    }
+    else
+    {
+        const __m256i swap_mask = _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+        for (; x + 32 <= width; x += 32)
+        {
+            __m256i y, uv;
+
+            if (in == YUV_SIMD_IN_P010)
+            {
+                y  = Avx2Round8(row->y + 2 * x);
+                uv = Avx2Round8(row->u + 2 * x);
+            }
+            else
+            {
+                y = _mm256_loadu_si256((const __m256i *)(row->y + x));
+                if (in == YUV_SIMD_IN_I420)
+                {
+                    __m128i u = _mm_loadu_si128((const __m128i *)(row->u + x / 2));
+                    __m128i v = _mm_loadu_si128((const __m128i *)(row->v + x / 2));
+                    uv = _mm256_inserti128_si256(
+                            _mm256_castsi128_si256(_mm_unpacklo_epi8(u, v)),
+                            _mm_unpackhi_epi8(u, v), 1);
+                }
+                else
+                    uv = _mm256_loadu_si256((const __m256i *)(row->u + x));
+            }
+            if (swap)
+                uv = _mm256_shuffle_epi8(uv, swap_mask);
+
+            /* pixels 0-7 | 16-23 and 8-15 | 24-31 */
+            __m256i lo, hi;
+            if (out == YUV_SIMD_OUT_YUYV)
+            {
+                lo = _mm256_unpacklo_epi8(y, uv);
+                hi = _mm256_unpackhi_epi8(y, uv);
+            }
+            else
+            {
+                lo = _mm256_unpacklo_epi8(uv, y);
+                hi = _mm256_unpackhi_epi8(uv, y);
+            }
+            _mm256_storeu_si256((__m256i *)&row->dst[2 * x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&row->dst[2 * x + 32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+    }
+    return x;
+}
+
+CONVERTERS(AVX2, VLC_AVX2)
+#endif
+
+/*****************************************************************************
+ * NEON (AArch64)
+ *****************************************************************************/
+#ifdef YUV_SIMD_NEON
+static inline int16x8_t NeonMulHi(int16x8_t a, int16_t c)
+{
+    return vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(a), c), 16),
+                        vshrn_n_s32(vmull_high_n_s16(a, c), 16));
+}
+
+static inline int16x8_t NeonNormY8(uint16x8_t y)
+{
+    return vsubq_s16(vreinterpretq_s16_u16(vshlq_n_u16(y, 7)),
+                     vdupq_n_s16(2048));
+}
+
+static inline int16x8_t NeonNormC(uint16x8_t c)
+{
+    return vreinterpretq_s16_u16(veorq_u16(c, vdupq_n_u16(0x8000)));
+}
+
+/* Loads 16 normalized pixels, as two halves */
+static inline void NeonLoad16(enum yuv_simd_in in, const yuv_row_t *row,
+                              unsigned x, bool swap, int16x8_t y[2],
+                              int16x8_t u[2], int16x8_t v[2])
+{
+    uint16x8_t uu, vv;
+
+    if (in == YUV_SIMD_IN_P010)
+    {
+        const uint16_t *py = (const uint16_t *)row->y + x;
+        const int16x8_t bias = vdupq_n_s16(2048);
+        y[0] = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(py), 1)),
+                         bias);
+        y[1] = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(py + 8), 1)),
+                         bias);
+
+        uint16x8x2_t uv = vld2q_u16((const uint16_t *)row->u + x);
+        uu = uv.val[swap];
+        vv = uv.val[!swap];
+    }
+    else
+    {
+        uint8x16_t yy = vld1q_u8(row->y + x);
+        y[0] = NeonNormY8(vmovl_u8(vget_low_u8(yy)));
+        y[1] = NeonNormY8(vmovl_high_u8(yy));
+
+        uint8x8_t u8, v8;
+        if (in == YUV_SIMD_IN_I420)
+        {
+            u8 = vld1_u8(row->u + x / 2);
+            v8 = vld1_u8(row->v + x / 2);
+        }
+        else
+        {
+            uint8x8x2_t uv = vld2_u8(row->u + x);
+            u8 = uv.val[swap];
+            v8 = uv.val[!swap];
+        }
+        uu = vshlq_n_u16(vmovl_u8(u8), 8);
+        vv = vshlq_n_u16(vmovl_u8(v8), 8);
+    }
+
+    u[0] = NeonNormC(vzip1q_u16(uu, uu));
+    u[1] = NeonNormC(vzip2q_u16(uu, uu));
+    v[0] = NeonNormC(vzip1q_u16(vv, vv));
+    v[1] = NeonNormC(vzip2q_u16(vv, vv));
+}
+
+static inline unsigned RowNEON(enum yuv_simd_in in, enum yuv_simd_out out,
+                               const yuv_row_t *row, unsigned width, bool swap,
+                               const yuv_simd_coefs_t *k)
+{
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        if (IsRGB(out))
+        {
+            int16x8_t y[2], u[2], v[2];
+            uint8x8_t r[2], g[2], b[2];
+
+            NeonLoad16(in, row, x, swap, y, u, v);
+            for (int i = 0; i < 2; i++)
+            {
+                int16x8_t l = vaddq_s16(NeonMulHi(y[i], k->y), vdupq_n_s16(16));
+                r[i] = vqmovun_s16(vshrq_n_s16(
+                            vaddq_s16(l, NeonMulHi(v[i], k->rv)), 5));
+                g[i] = vqmovun_s16(vshrq_n_s16(
+                            vaddq_s16(vaddq_s16(l, NeonMulHi(u[i], k->gu)),
+                                      NeonMulHi(v[i], k->gv)), 5));
+                b[i] = vqmovun_s16(vshrq_n_s16(
+                            vaddq_s16(l, NeonMulHi(u[i], k->bu)), 5));
+            }
+
+            uint8x16x4_t px;
+            px.val[out == YUV_SIMD_OUT_RGBA ? 0 : 2] = vcombine_u8(r[0], r[1]);
+            px.val[1] = vcombine_u8(g[0], g[1]);
+            px.val[out == YUV_SIMD_OUT_RGBA ? 2 : 0] = vcombine_u8(b[0], b[1]);
+            px.val[3] = vdupq_n_u8(0xff);
+            vst4q_u8(&row->dst[4 * x], px);
+        }
+        else
+        {
+            uint8x8_t ye, yo, u, v;
+
+            if (in == YUV_SIMD_IN_P010)
+            {
+                uint16x8x2_t yy = vld2q_u16((const uint16_t *)row->y + x);
+                uint16x8x2_t uv = vld2q_u16((const uint16_t *)row->u + x);
+                ye = vqrshrn_n_u16(yy.val[0], 8);
+                yo = vqrshrn_n_u16(yy.val[1], 8);
+                u = vqrshrn_n_u16(uv.val[swap], 8);
+                v = vqrshrn_n_u16(uv.val[!swap], 8);
+            }
+            else
+            {
+                uint8x8x2_t yy = vld2_u8(row->y + x);
+                ye = yy.val[0];
+                yo = yy.val[1];
+                if (in == YUV_SIMD_IN_I420)
+                {
+                    u = vld1_u8(row->u + x / 2);
+                    v = vld1_u8(row->v + x / 2);
+                }
+                else
+                {
+                    uint8x8x2_t uv = vld2_u8(row->u + x);
+                    u = uv.val[swap];
+                    v = uv.val[!swap];
+                }
+            }
+
+            uint8x8x4_t px;
+            if (out == YUV_SIMD_OUT_YUYV)
+            {
+                px.val[0] = ye; px.val[1] = u; px.val[2] = yo; px.val[3] = v;
+            }
+            else
+            {
+                px.val[0] = u; px.val[1] = ye; px.val[2] = v; px.val[3] = yo;
+            }
+            vst4_u8(&row->dst[2 * x], px);
+        }
+    }
+    return x;
+}
+
+CONVERTERS(NEON, )
+#endif
+
+enum yuv_simd_isa yuv_simd_GetISA(void)
+{
+#ifdef YUV_SIMD_AVX2
+    if (vlc_CPU_AVX2())
+        return YUV_SIMD_ISA_AVX2;
+#endif
+#ifdef YUV_SIMD_NEON
+    if (vlc_CPU_ARM64_NEON())
+        return YUV_SIMD_ISA_NEON;
+#endif
+    return YUV_SIMD_ISA_C;
+}
+
+yuv_simd_convert_t yuv_simd_Get(enum yuv_simd_in in, enum yuv_simd_out out,
+                                enum yuv_simd_isa isa)
+{
+    switch (isa)
+    {
+        case YUV_SIMD_ISA_C:
+            return converters_C0[in][out];
+#ifdef YUV_SIMD_AVX2
+        case YUV_SIMD_ISA_AVX2:
+            return converters_AVX2[in][out];
+#endif
+#ifdef YUV_SIMD_NEON
+        case YUV_SIMD_ISA_NEON:
+            return converters_NEON[in][out];
+#endif
+        default:
+            return NULL;
+    }
+}
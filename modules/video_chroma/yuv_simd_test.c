@@ -0,0 +1,204 @@
+/*****************************************************************************
+ * yuv_simd_test.c : check of the SIMD YUV converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the SIMD converters of this CPU give the same output as the C
+ * reference on random pictures, with widths that are not a multiple of the
+ * vector size, odd or below one vector, so that the C code finishes the
+ * rows. Pictures of odd dimensions must also match the top left of the same
+ * picture converted one pixel wider and higher: the last column and row use
+ * the last chroma samples.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "yuv_simd.h"
+
+static const char *const in_names[YUV_SIMD_IN_COUNT] = {
+    "I420", "NV12", "P010",
+};
+static const char *const out_names[YUV_SIMD_OUT_COUNT] = {
+    "RGBA", "BGRA", "YUYV", "UYVY",
+};
+
+typedef struct
+{
+    plane_t  src[3];
+    plane_t  dst;
+    uint8_t *buf[4];
+} test_pic_t;
+
+static unsigned rnd(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static int Alloc(test_pic_t *pic, enum yuv_simd_in in,
+                 unsigned width, unsigned height)
+{
+    const unsigned bpp = in == YUV_SIMD_IN_P010 ? 2 : 1;
+    /* padding so that lines can be read and written past the width */
+    const unsigned pitch = (width + 64) * bpp;
+    const unsigned planes = in == YUV_SIMD_IN_I420 ? 3 : 2;
+    unsigned seed = 1;
+
+    memset(pic, 0, sizeof(*pic));
+    for (unsigned i = 0; i < planes; i++)
+    {
+        plane_t *p = &pic->src[i];
+
+        p->i_pitch = in == YUV_SIMD_IN_I420 && i > 0 ? pitch / 2 : pitch;
+        p->i_lines = i > 0 ? (height + 1) / 2 : height;
+        pic->buf[i] = malloc(p->i_pitch * p->i_lines);
+        if (pic->buf[i] == NULL)
+            return -1;
+        p->p_pixels = pic->buf[i];
+
+        for (int j = 0; j < p->i_pitch * p->i_lines; j++)
+            p->p_pixels[j] = rnd(&seed);
+        /* keep the 10 significant bits only */
+        if (bpp == 2)
+            for (int j = 0; j < p->i_pitch * p->i_lines; j += 2)
+                p->p_pixels[j] &= 0xc0;
+    }
+
+    pic->dst.i_pitch = (width + 64) * 4;
+    pic->dst.i_lines = height;
+    pic->buf[3] = malloc(pic->dst.i_pitch * height);
+    if (pic->buf[3] == NULL)
+        return -1;
+    pic->dst.p_pixels = pic->buf[3];
+    return 0;
+}
+
+static void Free(test_pic_t *pic)
+{
+    for (int i = 0; i < 4; i++)
+        free(pic->buf[i]);
+}
+
+/* Compares the pixels of a row converted at an odd width with the same row
+ * converted one pixel wider */
+static void CompareCrop(enum yuv_simd_out out, const uint8_t *crop,
+                        const uint8_t *full, unsigned width)
+{
+    if (out <= YUV_SIMD_OUT_BGRA)
+    {
+        assert(memcmp(crop, full, width * 4) == 0);
+        return;
+    }
+
+    /* the last pair has its first luma sample twice */
+    const unsigned yi = out == YUV_SIMD_OUT_YUYV ? 0 : 1;
+    const unsigned last = (width - 1) * 2;
+
+    assert(memcmp(crop, full, last) == 0);
+    assert(crop[last + yi] == full[last + yi]);
+    assert(crop[last + 1 - yi] == full[last + 1 - yi]);
+    assert(crop[last + 3 - yi] == full[last + 3 - yi]);
+    assert(crop[last + 2 + yi] == crop[last + yi]);
+}
+
+static void test_convert(enum yuv_simd_in in, enum yuv_simd_out out,
+                         yuv_simd_convert_t ref, yuv_simd_convert_t simd,
+                         const yuv_simd_coefs_t *k,
+                         unsigned width, unsigned height)
+{
+    const unsigned bytes = out <= YUV_SIMD_OUT_BGRA ? 4 : 2;
+    /* packed YUV is written by whole pixel pairs */
+    const unsigned size = (out <= YUV_SIMD_OUT_BGRA ? width
+                                                    : (width + 1) & ~1) * bytes;
+    test_pic_t a, b;
+
+    /* one more pixel and row, for the reference converted one pixel wider */
+    assert(Alloc(&a, in, width + 1, height + 1) == 0);
+    assert(Alloc(&b, in, width + 1, height + 1) == 0);
+
+    for (int swap = 0; swap < 2; swap++)
+    {
+        printf("%s->%s%s %ux%u\n", in_names[in], out_names[out],
+               swap ? " (swapped)" : "", width, height);
+        memset(a.dst.p_pixels, 0, a.dst.i_pitch * (height + 1));
+        memset(b.dst.p_pixels, 0, b.dst.i_pitch * (height + 1));
+        ref(&a.dst, a.src, width, height, swap, k);
+        simd(&b.dst, b.src, width, height, swap, k);
+
+        for (unsigned j = 0; j < height; j++)
+        {
+            const uint8_t *pa = &a.dst.p_pixels[j * a.dst.i_pitch];
+            const uint8_t *pb = &b.dst.p_pixels[j * b.dst.i_pitch];
+
+            assert(memcmp(pa, pb, size) == 0);
+            /* nothing must be written past the width */
+            assert(pb[size] == 0);
+        }
+        /* nor past the height */
+        for (unsigned i = 0; i < size; i++)
+            assert(b.dst.p_pixels[height * b.dst.i_pitch + i] == 0);
+
+        if (((width | height) & 1) == 0)
+            continue;
+
+        ref(&a.dst, a.src, (width + 1) & ~1, (height + 1) & ~1, swap, k);
+        for (unsigned j = 0; j < height; j++)
+        {
+            const uint8_t *pa = &a.dst.p_pixels[j * a.dst.i_pitch];
+            const uint8_t *pb = &b.dst.p_pixels[j * b.dst.i_pitch];
+
+            if (width & 1)
+                CompareCrop(out, pb, pa, width);
+            else
+                assert(memcmp(pa, pb, size) == 0);
+        }
+    }
+    Free(&a);
+    Free(&b);
+}
+
+int main(void)
+{
+    const enum yuv_simd_isa isa = yuv_simd_GetISA();
+    yuv_simd_coefs_t k;
+    yuv_simd_GetCoefs(&k, COLOR_SPACE_BT709);
+
+    static const unsigned sizes[][2] = {
+        { 1918, 8 }, { 1917, 9 }, { 7, 5 }, { 1, 1 },
+    };
+
+    for (int in = 0; in < YUV_SIMD_IN_COUNT; in++)
+        for (int out = 0; out < YUV_SIMD_OUT_COUNT; out++)
+            for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+                test_convert(in, out, yuv_simd_Get(in, out, YUV_SIMD_ISA_C),
+                             yuv_simd_Get(in, out, isa), &k,
+                             sizes[i][0], sizes[i][1]);
+    return 0;
+}
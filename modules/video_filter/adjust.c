@@ -124,6 +124,7 @@ struct filter_sys_t
                                int, int );
     int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
                                     int, int, int );
+    filter_slices_t *slices;
 };
 
 /*****************************************************************************
@@ -204,6 +205,8 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, "brightness-threshold",
                                              AdjustCallback, p_sys );
 
+    p_sys->slices = filter_NewSlices( p_filter, 0 );
+
     return VLC_SUCCESS;
 }
 
@@ -223,9 +226,121 @@ static void Destroy( vlc_object_t *p_this )
     var_DelCallback( p_filter, "brightness-threshold",
                                              AdjustCallback, p_sys );
 
+    filter_DeleteSlices( p_sys->slices );
+
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Luma lookup on the Y plane of planar YUV
+ *****************************************************************************/
+static void PlanarLuma16( const plane_t *p_in_plane, plane_t *p_out_plane,
+                          const int *pi_luma )
+{
+    uint16_t *p_in, *p_in_end, *p_line_end;
+    uint16_t *p_out;
+    p_in = (uint16_t *) p_in_plane->p_pixels;
+    p_in_end = p_in + p_in_plane->i_visible_lines
+        * (p_in_plane->i_pitch >> 1) - 8;
+
+    p_out = (uint16_t *) p_out_plane->p_pixels;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + (p_in_plane->i_visible_pitch >> 1) - 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_line_end += 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_in += (p_in_plane->i_pitch >> 1)
+            - (p_in_plane->i_visible_pitch >> 1);
+        p_out += (p_out_plane->i_pitch >> 1)
+            - (p_out_plane->i_visible_pitch >> 1);
+    }
+}
+
+static void PlanarLuma8( const plane_t *p_in_plane, plane_t *p_out_plane,
+                         const int *pi_luma )
+{
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+    p_in = p_in_plane->p_pixels;
+    p_in_end = p_in + p_in_plane->i_visible_lines
+             * p_in_plane->i_pitch - 8;
+
+    p_out = p_out_plane->p_pixels;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + p_in_plane->i_visible_pitch - 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_line_end += 8;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out++ = pi_luma[ *p_in++ ];
+        }
+
+        p_in += p_in_plane->i_pitch
+              - p_in_plane->i_visible_pitch;
+        p_out += p_out_plane->i_pitch
+               - p_out_plane->i_visible_pitch;
+    }
+}
+
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    const int *pi_luma;
+    bool b_16bit;
+    int i_y_offset;
+    int (*pf_process)( picture_t *, picture_t *, int, int, int, int, int );
+    int i_sin, i_cos, i_sat, i_x, i_y;
+    atomic_bool b_error;
+} adjust_job_t;
+
+static void PlanarSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    adjust_job_t *job = opaque;
+    picture_t in, out;
+
+    picture_SliceView( &in, job->p_pic, i_slice, i_slices );
+    picture_SliceView( &out, job->p_outpic, i_slice, i_slices );
+
+    if( job->b_16bit )
+        PlanarLuma16( &in.p[Y_PLANE], &out.p[Y_PLANE], job->pi_luma );
+    else
+        PlanarLuma8( &in.p[Y_PLANE], &out.p[Y_PLANE], job->pi_luma );
+
+    /* Currently no errors are implemented in the function, if any are added
+     * check them here */
+    job->pf_process( &in, &out, job->i_sin, job->i_cos, job->i_sat,
+                     job->i_x, job->i_y );
+}
+
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
@@ -318,108 +433,84 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     }
 
     /*
-     * Do the Y plane
+     * Do the U and V planes
      */
-    if ( b_16bit )
-    {
-        uint16_t *p_in, *p_in_end, *p_line_end;
-        uint16_t *p_out;
-        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
 
-        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
+    int i_sin = sinf(f_hue) * f_max;
+    int i_cos = cosf(f_hue) * f_max;
 
-        for( ; p_in < p_in_end ; )
+    /* pow(2, (bpp * 2) - 1) */
+    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
+    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
+
+    adjust_job_t job = {
+        .p_pic = p_pic, .p_outpic = p_outpic,
+        .pi_luma = pi_luma, .b_16bit = b_16bit,
+        .pf_process = ( i_sat > i_range ) ? p_sys->pf_process_sat_hue_clip
+                                          : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    filter_RunSlices( p_sys->slices, PlanarSlice, &job, 0 );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ * Luma lookup on packed YUV, every other byte from i_y_offset
+ *****************************************************************************/
+static void PackedLuma( const plane_t *p_in_plane, plane_t *p_out_plane,
+                        int i_y_offset, const int *pi_luma )
+{
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+
+    p_in = p_in_plane->p_pixels + i_y_offset;
+    p_in_end = p_in + p_in_plane->i_visible_lines * p_in_plane->i_pitch - 8 * 4;
+
+    p_out = p_out_plane->p_pixels + i_y_offset;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + p_in_plane->i_visible_pitch - 8 * 4;
+
+        for( ; p_in < p_line_end ; )
         {
-            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
-                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
-            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
-                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
+            /* Do 8 pixels at a time */
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
         }
-    }
-    else
-    {
-        uint8_t *p_in, *p_in_end, *p_line_end;
-        uint8_t *p_out;
-        p_in = p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                 * p_pic->p[Y_PLANE].i_pitch - 8;
 
-        p_out = p_outpic->p[Y_PLANE].p_pixels;
+        p_line_end += 8 * 4;
 
-        for( ; p_in < p_in_end ; )
+        for( ; p_in < p_line_end ; )
         {
-            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += p_pic->p[Y_PLANE].i_pitch
-                  - p_pic->p[Y_PLANE].i_visible_pitch;
-            p_out += p_outpic->p[Y_PLANE].i_pitch
-                   - p_outpic->p[Y_PLANE].i_visible_pitch;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
         }
-    }
 
-    /*
-     * Do the U and V planes
-     */
+        p_in += p_in_plane->i_pitch - p_in_plane->i_visible_pitch;
+        p_out += p_out_plane->i_pitch - p_out_plane->i_visible_pitch;
+    }
+}
 
-    int i_sin = sinf(f_hue) * f_max;
-    int i_cos = cosf(f_hue) * f_max;
+static void PackedSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    adjust_job_t *job = opaque;
+    picture_t in, out;
 
-    /* pow(2, (bpp * 2) - 1) */
-    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
-    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
+    picture_SliceView( &in, job->p_pic, i_slice, i_slices );
+    picture_SliceView( &out, job->p_outpic, i_slice, i_slices );
 
-    if ( i_sat > i_range )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+    PackedLuma( &in.p[0], &out.p[0], job->i_y_offset, job->pi_luma );
 
-    return CopyInfoAndRelease( p_outpic, p_pic );
+    if( job->pf_process( &in, &out, job->i_sin, job->i_cos, job->i_sat,
+                         job->i_x, job->i_y ) != VLC_SUCCESS )
+        atomic_store( &job->b_error, true );
 }
 
 /*****************************************************************************
@@ -431,12 +522,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
     int i_y_offset, i_u_offset, i_v_offset;
 
-    int i_pitch, i_visible_pitch;
-
     double  f_hue;
     double  f_gamma;
     int32_t i_cont, i_lum;
@@ -446,9 +533,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
     if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                              &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
     {
@@ -514,43 +598,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p->p_pixels + i_y_offset;
-    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_y_offset;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + i_visible_pitch - 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_line_end += 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_in += i_pitch - p_pic->p->i_visible_pitch;
-        p_out += i_pitch - p_outpic->p->i_visible_pitch;
-    }
-
     /*
      * Do the U and V planes
      */
@@ -561,31 +608,25 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
     i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
 
-    if ( i_sat > 256 )
+    adjust_job_t job = {
+        .p_pic = p_pic, .p_outpic = p_outpic,
+        .pi_luma = pi_luma, .i_y_offset = i_y_offset,
+        .pf_process = ( i_sat > 256 ) ? p_sys->pf_process_sat_hue_clip
+                                      : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    atomic_init( &job.b_error, false );
+    filter_RunSlices( p_sys->slices, PackedSlice, &job, 0 );
+
+    if( atomic_load( &job.b_error ) )
     {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                             i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
-    }
-    else
-    {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
+        /* Currently only one error can happen in the function, but if there
+         * will be more of them, this message must go away */
+        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+        picture_Release( p_outpic );
+        picture_Release( p_pic );
+        return NULL;
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -33,6 +33,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
+#include "blend_simd.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -40,9 +41,14 @@
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SIMD_TEXT N_("Use SIMD blending")
+#define SIMD_LONGTEXT N_("Use the vectorized blending of the most common " \
+    "formats when the CPU supports it (mostly useful for benchmarking).")
+
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_capability("video blending", 100)
+    add_bool("blend-simd", true, SIMD_TEXT, SIMD_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -625,11 +631,140 @@ static const struct {
 #undef YUV
 };
 
+/*****************************************************************************
+ * SIMD rows (see blend_simd.c) for the most common cases
+ *****************************************************************************/
+typedef bool (*blend_simd_function_t)(const blend_simd_t *simd,
+                                      const CPicture &dst_data,
+                                      const CPicture &src_data,
+                                      unsigned width, unsigned height,
+                                      int alpha);
+
+class CPictureSimd : public CPicture {
+public:
+    CPictureSimd(const CPicture &cfg) : CPicture(cfg)
+    {
+    }
+    /* Returns the sample of the pixel (x + dx, y + dy) in the plane */
+    template <unsigned rx, unsigned ry>
+    uint8_t *getPixel(unsigned plane, unsigned dx, unsigned dy,
+                      unsigned bytes = 1) const
+    {
+        const plane_t *p = &picture->p[plane];
+        return &p->p_pixels[(y + dy) / ry * p->i_pitch +
+                            (x + dx) / rx * bytes];
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
+};
+
+/* YUVA onto 4:2:0, planar (semi_planar false) or not */
+template <bool semi_planar, bool swap_uv>
+bool BlendSimdYUV420(const blend_simd_t *simd,
+                     const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const CPictureSimd dst(dst_data);
+    const CPictureSimd src(src_data);
+    /* the chroma is blended from the source pixels of even coordinates in
+     * the destination */
+    const unsigned dx0 = dst.getX() % 2;
+    const unsigned chroma_width = width > dx0 ? (width - dx0 + 1) / 2 : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *a = src.getPixel<1,1>(3, 0, y);
+
+        simd->plane(dst.getPixel<1,1>(0, 0, y), src.getPixel<1,1>(0, 0, y),
+                    a, width, alpha);
+        if ((dst.getY() + y) % 2 != 0 || chroma_width == 0)
+            continue;
+
+        const uint8_t *u = src.getPixel<1,1>(1, dx0, y);
+        const uint8_t *v = src.getPixel<1,1>(2, dx0, y);
+        if (semi_planar) {
+            simd->uv(dst.getPixel<2,2>(1, dx0, y, 2),
+                     swap_uv ? v : u, swap_uv ? u : v, a + dx0,
+                     chroma_width, alpha);
+        } else {
+            simd->plane_sub2(dst.getPixel<2,2>(swap_uv ? 2 : 1, dx0, y),
+                             u, a + dx0, chroma_width, alpha);
+            simd->plane_sub2(dst.getPixel<2,2>(swap_uv ? 1 : 2, dx0, y),
+                             v, a + dx0, chroma_width, alpha);
+        }
+    }
+    return true;
+}
+
+/* YUVA (yuva true) or RGBA onto 32-bit RGB */
+template <bool yuva>
+bool BlendSimdRGB32(const blend_simd_t *simd,
+                    const CPicture &dst_data, const CPicture &src_data,
+                    unsigned width, unsigned height, int alpha)
+{
+#ifdef WORDS_BIGENDIAN
+    VLC_UNUSED(simd); VLC_UNUSED(dst_data); VLC_UNUSED(src_data);
+    VLC_UNUSED(width); VLC_UNUSED(height); VLC_UNUSED(alpha);
+    return false;
+#else
+    const video_format_t *fmt = dst_data.getFormat();
+    if ((fmt->i_lrshift | fmt->i_lgshift | fmt->i_lbshift) % 8 != 0)
+        return false;
+
+    const blend_simd_rgb_t rgb = {
+        (uint8_t)(fmt->i_lrshift / 8),
+        (uint8_t)(fmt->i_lgshift / 8),
+        (uint8_t)(fmt->i_lbshift / 8),
+    };
+    if (rgb.r > 3 || rgb.g > 3 || rgb.b > 3 ||
+        rgb.r == rgb.g || rgb.g == rgb.b || rgb.b == rgb.r)
+        return false;
+
+    const CPictureSimd dst(dst_data);
+    const CPictureSimd src(src_data);
+
+    for (unsigned y = 0; y < height; y++) {
+        uint8_t *d = dst.getPixel<1,1>(0, 0, y, 4);
+
+        if (yuva)
+            simd->rgb_yuva(d, src.getPixel<1,1>(0, 0, y),
+                           src.getPixel<1,1>(1, 0, y),
+                           src.getPixel<1,1>(2, 0, y),
+                           src.getPixel<1,1>(3, 0, y), width, &rgb, alpha);
+        else
+            simd->rgb_rgba(d, src.getPixel<1,1>(0, 0, y, 4), width,
+                           &rgb, alpha);
+    }
+    return true;
+#endif
+}
+
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_simd_function_t blend;
+} blends_simd[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendSimdYUV420<false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendSimdYUV420<false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendSimdYUV420<false, true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendSimdYUV420<true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendSimdYUV420<true,  true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_YUVA, BlendSimdRGB32<true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendSimdRGB32<false> },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), simd(NULL), blend_simd(NULL)
     {
     }
-    blend_function_t blend;
+    blend_function_t      blend;
+    const blend_simd_t    *simd;
+    blend_simd_function_t blend_simd;
 };
 
 /**
@@ -657,13 +792,17 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_simd &&
+        sys->blend_simd(sys->simd, dst_data, src_data, width, height, alpha))
+        return;
+    sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -685,6 +824,16 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    const enum blend_simd_isa isa = blend_simd_GetISA();
+    if (isa != BLEND_SIMD_ISA_C && var_InheritBool(filter, "blend-simd")) {
+        for (size_t i = 0; i < sizeof(blends_simd) / sizeof(*blends_simd); i++) {
+            if (blends_simd[i].src == src && blends_simd[i].dst == dst) {
+                sys->simd       = blend_simd_Get(isa);
+                sys->blend_simd = blends_simd[i].blend;
+            }
+        }
+    }
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
@@ -0,0 +1,412 @@
+/*****************************************************************************
+ * blend_simd.c : SSE4.1, AVX2 and NEON alpha blending rows
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "filter_picture.h"
+#include "blend_simd.h"
+
+#if defined(HAVE_SSE4_1_INTRINSICS)
+# include <smmintrin.h>
+# define BLEND_SIMD_SSE4_1
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define BLEND_SIMD_AVX2
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BLEND_SIMD_NEON
+#endif
+
+/* Same fixed point conversion as yuv_to_rgb() */
+#define BLEND_SCALEBITS 10
+#define BLEND_ONE_HALF  (1 << (BLEND_SCALEBITS - 1))
+#define BLEND_FIX(x)    ((int) ((x) * (1 << BLEND_SCALEBITS) + 0.5))
+#define BLEND_FIX_Y     BLEND_FIX(255.0/219.0)
+#define BLEND_FIX_RV    BLEND_FIX(1.40200*255.0/224.0)
+#define BLEND_FIX_GU    BLEND_FIX(0.34414*255.0/224.0)
+#define BLEND_FIX_GV    BLEND_FIX(0.71414*255.0/224.0)
+#define BLEND_FIX_BU    BLEND_FIX(1.77200*255.0/224.0)
+
+/*****************************************************************************
+ * C reference
+ *****************************************************************************/
+static inline unsigned div255(unsigned v)
+{
+    /* the same approximation as blend.cpp */
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static inline void merge(uint8_t *dst, unsigned src, unsigned f)
+{
+    *dst = div255((255 - f) * (*dst) + src * f);
+}
+
+static void PlaneC(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                   unsigned n, unsigned alpha)
+{
+    for (unsigned i = 0; i < n; i++)
+        merge(&dst[i], src[i], div255(alpha * a[i]));
+}
+
+static void PlaneSub2C(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                       unsigned n, unsigned alpha)
+{
+    for (unsigned i = 0; i < n; i++)
+        merge(&dst[i], src[2 * i], div255(alpha * a[2 * i]));
+}
+
+static void UVC(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                const uint8_t *a, unsigned n, unsigned alpha)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned f = div255(alpha * a[2 * i]);
+
+        merge(&dst[2 * i],     u[2 * i], f);
+        merge(&dst[2 * i + 1], v[2 * i], f);
+    }
+}
+
+static void RgbRgbaC(uint8_t *dst, const uint8_t *src, unsigned n,
+                     const blend_simd_rgb_t *rgb, unsigned alpha)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const uint8_t *s = &src[4 * i];
+        uint8_t *d = &dst[4 * i];
+        const unsigned f = div255(alpha * s[3]);
+
+        merge(&d[rgb->r], s[0], f);
+        merge(&d[rgb->g], s[1], f);
+        merge(&d[rgb->b], s[2], f);
+    }
+}
+
+static void RgbYuvaC(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                     const uint8_t *v, const uint8_t *a, unsigned n,
+                     const blend_simd_rgb_t *rgb, unsigned alpha)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        uint8_t *d = &dst[4 * i];
+        const unsigned f = div255(alpha * a[i]);
+        int r, g, b;
+
+        yuv_to_rgb(&r, &g, &b, y[i], u[i], v[i]);
+        merge(&d[rgb->r], r, f);
+        merge(&d[rgb->g], g, f);
+        merge(&d[rgb->b], b, f);
+    }
+}
+
+static const blend_simd_t blend_C0 = {
+    PlaneC, PlaneSub2C, UVC, RgbRgbaC, RgbYuvaC,
+};
+
+/* Byte shuffles from 4 RGBA pixels to the destination layout, for the
+ * colour (ms) and the opacity (ma); the fourth byte is left untouched. */
+static inline void GetMasks(const blend_simd_rgb_t *rgb,
+                            uint8_t ms[16], uint8_t ma[16])
+{
+    memset(ms, 0x80, 16);
+    memset(ma, 0x80, 16);
+    for (unsigned p = 0; p < 16; p += 4)
+    {
+        ms[p + rgb->r] = p;
+        ms[p + rgb->g] = p + 1;
+        ms[p + rgb->b] = p + 2;
+        ma[p + rgb->r] = ma[p + rgb->g] = ma[p + rgb->b] = p + 3;
+    }
+}
+
+/*****************************************************************************
+ * SSE4.1 and AVX2
+ *****************************************************************************/
+#if defined(BLEND_SIMD_SSE4_1) || defined(BLEND_SIMD_AVX2)
+# define VB __m128i
+# define VW __m128i
+# define VD __m128i
+#endif
+
+#ifdef BLEND_SIMD_SSE4_1
+# define W 16
+# define VB_LOAD(p)    _mm_loadu_si128((const __m128i *)(p))
+# define VB_STORE(p,v) _mm_storeu_si128((__m128i *)(p), v)
+# define VB_MASK(p)    VB_LOAD(p)
+# define VB_SPLIT(v,lo,hi) do { \
+    lo = _mm_unpacklo_epi8(v, _mm_setzero_si128()); \
+    hi = _mm_unpackhi_epi8(v, _mm_setzero_si128()); } while (0)
+# define VB_JOIN(lo,hi)    _mm_packus_epi16(lo, hi)
+# define VB_EVEN(v0,v1) \
+    _mm_packus_epi16(_mm_and_si128(v0, _mm_set1_epi16(0xff)), \
+                     _mm_and_si128(v1, _mm_set1_epi16(0xff)))
+# define VB_SHUFFLE(v,m)   _mm_shuffle_epi8(v, m)
+# define VB_ZIP(a,b,lo,hi) do { \
+    lo = _mm_unpacklo_epi8(a, b); hi = _mm_unpackhi_epi8(a, b); } while (0)
+# define VB_ZIP16(a,b,lo,hi) do { \
+    lo = _mm_unpacklo_epi16(a, b); hi = _mm_unpackhi_epi16(a, b); } while (0)
+# define VB_ORDER4(p0,p1,p2,p3)
+# define VB_AS_VW(v)  (v)
+# define VW_AS_VB(v)  (v)
+# define VW_SET1(x)   _mm_set1_epi16(x)
+# define VW_ADD       _mm_add_epi16
+# define VW_SUB       _mm_sub_epi16
+# define VW_MUL       _mm_mullo_epi16
+# define VW_AND       _mm_and_si128
+# define VW_OR        _mm_or_si128
+# define VW_SRL       _mm_srli_epi16
+# define VW_SLL       _mm_slli_epi16
+# define VW_SPLIT(v,lo,hi) do { \
+    lo = _mm_unpacklo_epi16(v, _mm_setzero_si128()); \
+    hi = _mm_unpackhi_epi16(v, _mm_setzero_si128()); } while (0)
+# define VW_JOIN(lo,hi)    _mm_packs_epi32(lo, hi)
+# define VD_SET1      _mm_set1_epi32
+# define VD_ADD       _mm_add_epi32
+# define VD_SUB       _mm_sub_epi32
+# define VD_MUL       _mm_mullo_epi32
+# define VD_SRA       _mm_srai_epi32
+# define RENAME(a)    a ## _SSE4_1
+# define VLC_TARGET   VLC_SSE4_1
+# include "blend_simd_template.h"
+# undef VLC_TARGET
+# undef RENAME
+# undef VD_SRA
+# undef VD_MUL
+# undef VD_SUB
+# undef VD_ADD
+# undef VD_SET1
+# undef VW_JOIN
+# undef VW_SPLIT
+# undef VW_SLL
+# undef VW_SRL
+# undef VW_OR
+# undef VW_AND
+# undef VW_MUL
+# undef VW_SUB
+# undef VW_ADD
+# undef VW_SET1
+# undef VW_AS_VB
+# undef VB_AS_VW
+# undef VB_ORDER4
+# undef VB_ZIP16
+# undef VB_ZIP
+# undef VB_SHUFFLE
+# undef VB_EVEN
+# undef VB_JOIN
+# undef VB_SPLIT
+# undef VB_MASK
+# undef VB_STORE
+# undef VB_LOAD
+# undef W
+#endif
+
+#ifdef BLEND_SIMD_AVX2
+# undef VB
+# undef VW
+# undef VD
+# define VB __m256i
+# define VW __m256i
+# define VD __m256i
+# define W 32
+# define VB_LOAD(p)    _mm256_loadu_si256((const __m256i *)(p))
+# define VB_STORE(p,v) _mm256_storeu_si256((__m256i *)(p), v)
+# define VB_MASK(p) \
+    _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(p)))
+/* unpacks and packs work within 128-bit lanes, but undo each other */
+# define VB_SPLIT(v,lo,hi) do { \
+    lo = _mm256_unpacklo_epi8(v, _mm256_setzero_si256()); \
+    hi = _mm256_unpackhi_epi8(v, _mm256_setzero_si256()); } while (0)
+# define VB_JOIN(lo,hi)    _mm256_packus_epi16(lo, hi)
+# define VB_EVEN(v0,v1) _mm256_permute4x64_epi64( \
+    _mm256_packus_epi16(_mm256_and_si256(v0, _mm256_set1_epi16(0xff)), \
+                        _mm256_and_si256(v1, _mm256_set1_epi16(0xff))), 0xd8)
+# define VB_SHUFFLE(v,m)   _mm256_shuffle_epi8(v, m)
+# define VB_ZIP(a,b,lo,hi) do { \
+    lo = _mm256_unpacklo_epi8(a, b); hi = _mm256_unpackhi_epi8(a, b); } while (0)
+# define VB_ZIP16(a,b,lo,hi) do { \
+    lo = _mm256_unpacklo_epi16(a, b); hi = _mm256_unpackhi_epi16(a, b); } while (0)
+/* pixels 0-3|16-19, 4-7|20-23, 8-11|24-27, 12-15|28-31 after the zips */
+# define VB_ORDER4(p0,p1,p2,p3) do { \
+    VB q0_ = _mm256_permute2x128_si256(p0, p1, 0x20); \
+    VB q1_ = _mm256_permute2x128_si256(p2, p3, 0x20); \
+    VB q2_ = _mm256_permute2x128_si256(p0, p1, 0x31); \
+    VB q3_ = _mm256_permute2x128_si256(p2, p3, 0x31); \
+    p0 = q0_; p1 = q1_; p2 = q2_; p3 = q3_; } while (0)
+# define VB_AS_VW(v)  (v)
+# define VW_AS_VB(v)  (v)
+# define VW_SET1(x)   _mm256_set1_epi16(x)
+# define VW_ADD       _mm256_add_epi16
+# define VW_SUB       _mm256_sub_epi16
+# define VW_MUL       _mm256_mullo_epi16
+# define VW_AND       _mm256_and_si256
+# define VW_OR        _mm256_or_si256
+# define VW_SRL       _mm256_srli_epi16
+# define VW_SLL       _mm256_slli_epi16
+# define VW_SPLIT(v,lo,hi) do { \
+    lo = _mm256_unpacklo_epi16(v, _mm256_setzero_si256()); \
+    hi = _mm256_unpackhi_epi16(v, _mm256_setzero_si256()); } while (0)
+# define VW_JOIN(lo,hi)    _mm256_packs_epi32(lo, hi)
+# define VD_SET1      _mm256_set1_epi32
+# define VD_ADD       _mm256_add_epi32
+# define VD_SUB       _mm256_sub_epi32
+# define VD_MUL       _mm256_mullo_epi32
+# define VD_SRA       _mm256_srai_epi32
+# define RENAME(a)    a ## _AVX2
+# define VLC_TARGET   VLC_AVX2
+# include "blend_simd_template.h"
+# undef VLC_TARGET
+# undef RENAME
+# undef VD_SRA
+# undef VD_MUL
+# undef VD_SUB
+# undef VD_ADD
+# undef VD_SET1
+# undef VW_JOIN
+# undef VW_SPLIT
+# undef VW_SLL
+# undef VW_SRL
+# undef VW_OR
+# undef VW_AND
+# undef VW_MUL
+# undef VW_SUB
+# undef VW_ADD
+# undef VW_SET1
+# undef VW_AS_VB
+# undef VB_AS_VW
+# undef VB_ORDER4
+# undef VB_ZIP16
+# undef VB_ZIP
+# undef VB_SHUFFLE
+# undef VB_EVEN
+# undef VB_JOIN
+# undef VB_SPLIT
+# undef VB_MASK
+# undef VB_STORE
+# undef VB_LOAD
+# undef W
+#endif
+
+#if defined(BLEND_SIMD_SSE4_1) || defined(BLEND_SIMD_AVX2)
+# undef VB
+# undef VW
+# undef VD
+#endif
+
+/*****************************************************************************
+ * NEON (AArch64)
+ *****************************************************************************/
+#ifdef BLEND_SIMD_NEON
+# define W 16
+# define VB uint8x16_t
+# define VW uint16x8_t
+# define VD int32x4_t
+# define VB_LOAD(p)    vld1q_u8(p)
+# define VB_STORE(p,v) vst1q_u8(p, v)
+# define VB_MASK(p)    vld1q_u8(p)
+# define VB_SPLIT(v,lo,hi) do { \
+    lo = vmovl_u8(vget_low_u8(v)); hi = vmovl_high_u8(v); } while (0)
+# define VB_JOIN(lo,hi) \
+    vcombine_u8(vqmovun_s16(vreinterpretq_s16_u16(lo)), \
+                vqmovun_s16(vreinterpretq_s16_u16(hi)))
+# define VB_EVEN(v0,v1)    vuzp1q_u8(v0, v1)
+# define VB_SHUFFLE(v,m)   vqtbl1q_u8(v, m)
+# define VB_ZIP(a,b,lo,hi) do { \
+    lo = vzip1q_u8(a, b); hi = vzip2q_u8(a, b); } while (0)
+# define VB_ZIP16(a,b,lo,hi) do { \
+    lo = vreinterpretq_u8_u16(vzip1q_u16(vreinterpretq_u16_u8(a), \
+                                         vreinterpretq_u16_u8(b))); \
+    hi = vreinterpretq_u8_u16(vzip2q_u16(vreinterpretq_u16_u8(a), \
+                                         vreinterpretq_u16_u8(b))); } while (0)
+# define VB_ORDER4(p0,p1,p2,p3)
+# define VB_AS_VW(v)  vreinterpretq_u16_u8(v)
+# define VW_AS_VB(v)  vreinterpretq_u8_u16(v)
+# define VW_SET1(x)   vdupq_n_u16(x)
+# define VW_ADD       vaddq_u16
+# define VW_SUB       vsubq_u16
+# define VW_MUL       vmulq_u16
+# define VW_AND       vandq_u16
+# define VW_OR        vorrq_u16
+# define VW_SRL       vshrq_n_u16
+# define VW_SLL       vshlq_n_u16
+# define VW_SPLIT(v,lo,hi) do { \
+    lo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))); \
+    hi = vreinterpretq_s32_u32(vmovl_high_u16(v)); } while (0)
+# define VW_JOIN(lo,hi) \
+    vreinterpretq_u16_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)))
+# define VD_SET1      vdupq_n_s32
+# define VD_ADD       vaddq_s32
+# define VD_SUB       vsubq_s32
+# define VD_MUL       vmulq_s32
+# define VD_SRA       vshrq_n_s32
+# define RENAME(a)    a ## _NEON
+# define VLC_TARGET
+# include "blend_simd_template.h"
+#endif
+
+enum blend_simd_isa blend_simd_GetISA(void)
+{
+#ifdef BLEND_SIMD_AVX2
+    if (vlc_CPU_AVX2())
+        return BLEND_SIMD_ISA_AVX2;
+#endif
+#ifdef BLEND_SIMD_SSE4_1
+    if (vlc_CPU_SSE4_1())
+        return BLEND_SIMD_ISA_SSE4_1;
+#endif
+#ifdef BLEND_SIMD_NEON
+    if (vlc_CPU_ARM64_NEON())
+        return BLEND_SIMD_ISA_NEON;
+#endif
+    return BLEND_SIMD_ISA_C;
+}
+
+const blend_simd_t *blend_simd_Get(enum blend_simd_isa isa)
+{
+    switch (isa)
+    {
+        case BLEND_SIMD_ISA_C:
+            return &blend_C0;
+#ifdef BLEND_SIMD_SSE4_1
+        case BLEND_SIMD_ISA_SSE4_1:
+            return &blend_SSE4_1;
+#endif
+#ifdef BLEND_SIMD_AVX2
+        case BLEND_SIMD_ISA_AVX2:
+            return &blend_AVX2;
+#endif
+#ifdef BLEND_SIMD_NEON
+        case BLEND_SIMD_ISA_NEON:
+            return &blend_NEON;
+#endif
+        default:
+            return NULL;
+    }
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * blend_simd.h : SSE4.1, AVX2 and NEON alpha blending rows
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOFILTER_BLEND_SIMD_H_
+#define VLC_VIDEOFILTER_BLEND_SIMD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each row function blends n samples with the same result as the C++
+ * templates of blend.cpp: the per sample opacity is div255(alpha * a), and
+ * each destination sample becomes div255((255 - a) * dst + a * src).
+ */
+
+enum blend_simd_isa
+{
+    BLEND_SIMD_ISA_C,    /* reference, also used for the end of rows */
+    BLEND_SIMD_ISA_SSE4_1,
+    BLEND_SIMD_ISA_AVX2,
+    BLEND_SIMD_ISA_NEON,
+};
+
+/* Byte offsets of the red, green and blue samples in a 32-bit pixel */
+typedef struct
+{
+    uint8_t r, g, b;
+} blend_simd_rgb_t;
+
+typedef struct
+{
+    /* Planar samples: dst[i] with src[i] and a[i] */
+    void (*plane)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                  unsigned n, unsigned alpha);
+    /* Horizontally subsampled chroma: dst[i] with src[2i] and a[2i] */
+    void (*plane_sub2)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                       unsigned n, unsigned alpha);
+    /* n interleaved chroma pairs: dst[2i] with u[2i], dst[2i+1] with v[2i],
+     * both with a[2i] */
+    void (*uv)(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+               const uint8_t *a, unsigned n, unsigned alpha);
+    /* 32-bit RGB pixels from RGBA ones */
+    void (*rgb_rgba)(uint8_t *dst, const uint8_t *src, unsigned n,
+                     const blend_simd_rgb_t *, unsigned alpha);
+    /* 32-bit RGB pixels from YUVA planes, converted as yuv_to_rgb() does */
+    void (*rgb_yuva)(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                     const uint8_t *v, const uint8_t *a, unsigned n,
+                     const blend_simd_rgb_t *, unsigned alpha);
+} blend_simd_t;
+
+/* Returns the best instruction set available on this CPU */
+enum blend_simd_isa blend_simd_GetISA(void);
+
+/* Returns NULL if the instruction set was not compiled in */
+const blend_simd_t *blend_simd_Get(enum blend_simd_isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * blend_simd_template.h : alpha blending rows on SIMD intrinsics
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Same computations as the C rows of blend_simd.c, W bytes at a time.
+ * Bytes are widened to 16-bit lanes for the blending (the largest sum is
+ * 65280) and to 32-bit lanes for the YUV to RGB conversion.
+ *
+ * The includer defines:
+ *  W                   bytes per vector
+ *  VB, VW, VD          vectors of bytes, 16-bit and 32-bit signed lanes
+ *  VB_LOAD(p), VB_STORE(p,v)
+ *  VB_MASK(p)          16 bytes pattern repeated in the whole vector
+ *  VB_SPLIT(v,lo,hi)   widen bytes to 16-bit lanes
+ *  VB_JOIN(lo,hi)      narrow (saturating) back, inverse of VB_SPLIT
+ *  VB_EVEN(v0,v1)      the even bytes of v0 then v1, in memory order
+ *  VB_SHUFFLE(v,m)     byte permutation within 16 bytes, 0 if m & 0x80
+ *  VB_ZIP(a,b,lo,hi)   interleave bytes
+ *  VB_ZIP16(a,b,lo,hi) interleave pairs of bytes
+ *  VB_ORDER4(p0,p1,p2,p3) put pixels zipped twice back in memory order
+ *  VB_AS_VW(v), VW_AS_VB(v) reinterpretations
+ *  VW_SET1, VW_ADD, VW_SUB, VW_MUL, VW_AND, VW_OR, VW_SRL(v,n), VW_SLL(v,n)
+ *  VW_SPLIT(v,lo,hi)   widen to 32-bit lanes
+ *  VW_JOIN(lo,hi)      narrow (saturating) back, inverse of VW_SPLIT
+ *  VD_SET1, VD_ADD, VD_SUB, VD_MUL, VD_SRA(v,n)
+ *  RENAME(a), VLC_TARGET
+ */
+
+VLC_TARGET
+static inline VW RENAME(Div255)(VW v)
+{
+    return VW_SRL(VW_ADD(VW_ADD(VW_SRL(v, 8), v), VW_SET1(1)), 8);
+}
+
+VLC_TARGET
+static inline VW RENAME(MergeW)(VW d, VW s, VW a, VW k)
+{
+    a = RENAME(Div255)(VW_MUL(a, k));
+    return RENAME(Div255)(VW_ADD(VW_MUL(VW_SUB(VW_SET1(255), a), d),
+                                 VW_MUL(s, a)));
+}
+
+/* Blends s onto d with the opacities a scaled by the global alpha k */
+VLC_TARGET
+static inline VB RENAME(Merge)(VB d, VB s, VB a, VW k)
+{
+    VW dl, dh, sl, sh, al, ah;
+
+    VB_SPLIT(d, dl, dh);
+    VB_SPLIT(s, sl, sh);
+    VB_SPLIT(a, al, ah);
+    return VB_JOIN(RENAME(MergeW)(dl, sl, al, k),
+                   RENAME(MergeW)(dh, sh, ah, k));
+}
+
+VLC_TARGET
+static void RENAME(Plane)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                          unsigned n, unsigned alpha)
+{
+    const VW k = VW_SET1(alpha);
+    unsigned x;
+
+    for (x = 0; x + W <= n; x += W)
+        VB_STORE(&dst[x], RENAME(Merge)(VB_LOAD(&dst[x]), VB_LOAD(&src[x]),
+                                        VB_LOAD(&a[x]), k));
+    if (x < n)
+        PlaneC(&dst[x], &src[x], &a[x], n - x, alpha);
+}
+
+VLC_TARGET
+static void RENAME(PlaneSub2)(uint8_t *dst, const uint8_t *src,
+                              const uint8_t *a, unsigned n, unsigned alpha)
+{
+    const VW k = VW_SET1(alpha);
+    unsigned x;
+
+    /* the last odd sample may be past the end of the source */
+    for (x = 0; x + W < n; x += W)
+    {
+        VB s = VB_EVEN(VB_LOAD(&src[2 * x]), VB_LOAD(&src[2 * x + W]));
+        VB m = VB_EVEN(VB_LOAD(&a[2 * x]), VB_LOAD(&a[2 * x + W]));
+
+        VB_STORE(&dst[x], RENAME(Merge)(VB_LOAD(&dst[x]), s, m, k));
+    }
+    if (x < n)
+        PlaneSub2C(&dst[x], &src[2 * x], &a[2 * x], n - x, alpha);
+}
+
+VLC_TARGET
+static void RENAME(UV)(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                       const uint8_t *a, unsigned n, unsigned alpha)
+{
+    const VW k = VW_SET1(alpha);
+    const VW low = VW_SET1(0xff);
+    unsigned x;
+
+    /* x counts pairs, W / 2 of them per vector */
+    for (x = 0; x + W / 2 < n; x += W / 2)
+    {
+        VW u16 = VB_AS_VW(VB_LOAD(&u[2 * x]));
+        VW v16 = VB_AS_VW(VB_LOAD(&v[2 * x]));
+        VW a16 = VB_AS_VW(VB_LOAD(&a[2 * x]));
+        VB s = VW_AS_VB(VW_OR(VW_AND(u16, low), VW_SLL(v16, 8)));
+        VB m = VW_AS_VB(VW_OR(VW_AND(a16, low), VW_SLL(a16, 8)));
+
+        VB_STORE(&dst[2 * x],
+                 RENAME(Merge)(VB_LOAD(&dst[2 * x]), s, m, k));
+    }
+    if (x < n)
+        UVC(&dst[2 * x], &u[2 * x], &v[2 * x], &a[2 * x], n - x, alpha);
+}
+
+VLC_TARGET
+static void RENAME(RgbRgba)(uint8_t *dst, const uint8_t *src, unsigned n,
+                            const blend_simd_rgb_t *rgb, unsigned alpha)
+{
+    const VW k = VW_SET1(alpha);
+    uint8_t ms[16], ma[16];
+    unsigned x;
+
+    GetMasks(rgb, ms, ma);
+    const VB mask_s = VB_MASK(ms);
+    const VB mask_a = VB_MASK(ma);
+
+    for (x = 0; x + W / 4 <= n; x += W / 4)
+    {
+        VB px = VB_LOAD(&src[4 * x]);
+
+        VB_STORE(&dst[4 * x],
+                 RENAME(Merge)(VB_LOAD(&dst[4 * x]), VB_SHUFFLE(px, mask_s),
+                               VB_SHUFFLE(px, mask_a), k));
+    }
+    if (x < n)
+        RgbRgbaC(&dst[4 * x], &src[4 * x], n - x, rgb, alpha);
+}
+
+VLC_TARGET
+static inline void RENAME(ConvD)(VD y, VD u, VD v, VD *r, VD *g, VD *b)
+{
+    const VD half = VD_SET1(BLEND_ONE_HALF);
+    VD cb = VD_SUB(u, VD_SET1(128));
+    VD cr = VD_SUB(v, VD_SET1(128));
+
+    y = VD_MUL(VD_SUB(y, VD_SET1(16)), VD_SET1(BLEND_FIX_Y));
+    *r = VD_SRA(VD_ADD(y, VD_ADD(VD_MUL(cr, VD_SET1(BLEND_FIX_RV)), half)),
+                BLEND_SCALEBITS);
+    *g = VD_SRA(VD_ADD(y, VD_SUB(VD_SUB(half,
+                                        VD_MUL(cb, VD_SET1(BLEND_FIX_GU))),
+                                 VD_MUL(cr, VD_SET1(BLEND_FIX_GV)))),
+                BLEND_SCALEBITS);
+    *b = VD_SRA(VD_ADD(y, VD_ADD(VD_MUL(cb, VD_SET1(BLEND_FIX_BU)), half)),
+                BLEND_SCALEBITS);
+}
+
+VLC_TARGET
+static inline void RENAME(ConvW)(VW y, VW u, VW v, VW *r, VW *g, VW *b)
+{
+    VD y0, y1, u0, u1, v0, v1, r0, r1, g0, g1, b0, b1;
+
+    VW_SPLIT(y, y0, y1);
+    VW_SPLIT(u, u0, u1);
+    VW_SPLIT(v, v0, v1);
+    RENAME(ConvD)(y0, u0, v0, &r0, &g0, &b0);
+    RENAME(ConvD)(y1, u1, v1, &r1, &g1, &b1);
+    *r = VW_JOIN(r0, r1);
+    *g = VW_JOIN(g0, g1);
+    *b = VW_JOIN(b0, b1);
+}
+
+VLC_TARGET
+static void RENAME(RgbYuva)(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                            const uint8_t *v, const uint8_t *a, unsigned n,
+                            const blend_simd_rgb_t *rgb, unsigned alpha)
+{
+    const VW k = VW_SET1(alpha);
+    uint8_t ms[16], ma[16];
+    unsigned x;
+
+    GetMasks(rgb, ms, ma);
+    const VB mask_s = VB_MASK(ms);
+    const VB mask_a = VB_MASK(ma);
+
+    for (x = 0; x + W <= n; x += W)
+    {
+        VW yl, yh, ul, uh, vl, vh, rl, rh, gl, gh, bl, bh;
+
+        VB_SPLIT(VB_LOAD(&y[x]), yl, yh);
+        VB_SPLIT(VB_LOAD(&u[x]), ul, uh);
+        VB_SPLIT(VB_LOAD(&v[x]), vl, vh);
+        RENAME(ConvW)(yl, ul, vl, &rl, &gl, &bl);
+        RENAME(ConvW)(yh, uh, vh, &rh, &gh, &bh);
+
+        /* RGBA pixels, as the source of RgbRgba() */
+        VB rg_lo, rg_hi, ba_lo, ba_hi, p[4];
+        VB_ZIP(VB_JOIN(rl, rh), VB_JOIN(gl, gh), rg_lo, rg_hi);
+        VB_ZIP(VB_JOIN(bl, bh), VB_LOAD(&a[x]), ba_lo, ba_hi);
+        VB_ZIP16(rg_lo, ba_lo, p[0], p[1]);
+        VB_ZIP16(rg_hi, ba_hi, p[2], p[3]);
+        VB_ORDER4(p[0], p[1], p[2], p[3]);
+
+        for (int i = 0; i < 4; i++)
+        {
+            uint8_t *d = &dst[4 * x + i * W];
+
+            VB_STORE(d, RENAME(Merge)(VB_LOAD(d), VB_SHUFFLE(p[i], mask_s),
+                                      VB_SHUFFLE(p[i], mask_a), k));
+        }
+    }
+    if (x < n)
+        RgbYuvaC(&dst[4 * x], &y[x], &u[x], &v[x], &a[x], n - x, rgb, alpha);
+}
+
+static const blend_simd_t RENAME(blend) = {
+    RENAME(Plane),
+    RENAME(PlaneSub2),
+    RENAME(UV),
+    RENAME(RgbRgba),
+    RENAME(RgbYuva),
+};
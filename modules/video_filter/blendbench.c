@@ -56,18 +56,27 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_TEXT N_("Alpha of the blended image")
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
+#define WIDTH_TEXT N_("Width of the generated images")
+#define WIDTH_LONGTEXT N_("Width of the random images used when no image " \
+                          "file is given")
+
+#define HEIGHT_TEXT N_("Height of the generated images")
+#define HEIGHT_LONGTEXT N_("Height of the random images used when no image " \
+                           "file is given")
+
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded " \
+                                "in, all the supported ones if empty")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
 
 #define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+                                 " in, all the supported ones if empty")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -79,29 +88,53 @@ vlc_module_begin ()
     set_capability( "video filter", 0 )
 
     set_section( N_("Benchmarking"), NULL )
-    add_integer( CFG_PREFIX "loops", 1000, LOOPS_TEXT,
+    add_integer( CFG_PREFIX "loops", 100, LOOPS_TEXT,
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_integer( CFG_PREFIX "width", 1280, WIDTH_TEXT,
+              WIDTH_LONGTEXT, false )
+    add_integer( CFG_PREFIX "height", 720, HEIGHT_TEXT,
+              HEIGHT_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
                   BASE_IMAGE_LONGTEXT, false )
-    add_string( CFG_PREFIX "base-chroma", "I420", BASE_CHROMA_TEXT,
+    add_string( CFG_PREFIX "base-chroma", "", BASE_CHROMA_TEXT,
               BASE_CHROMA_LONGTEXT, false )
 
     set_section( N_("Blend image"), NULL )
     add_loadfile( CFG_PREFIX "blend-image", NULL, BLEND_IMAGE_TEXT,
                   BLEND_IMAGE_LONGTEXT, false )
-    add_string( CFG_PREFIX "blend-chroma", "YUVA", BLEND_CHROMA_TEXT,
+    add_string( CFG_PREFIX "blend-chroma", "", BLEND_CHROMA_TEXT,
               BLEND_CHROMA_LONGTEXT, false )
 
     set_callbacks( Create, Destroy )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
+};
+
+/* Every destination and source chroma of the blend module */
+static const vlc_fourcc_t p_base_chromas[] = {
+    VLC_CODEC_RGB15, VLC_CODEC_RGB16, VLC_CODEC_RGB24, VLC_CODEC_RGB32,
+    VLC_CODEC_RGBA, VLC_CODEC_BGRA,
+    VLC_CODEC_YV9, VLC_CODEC_I410, VLC_CODEC_I411,
+    VLC_CODEC_YV12, VLC_CODEC_NV12, VLC_CODEC_NV21, VLC_CODEC_J420,
+    VLC_CODEC_I420, VLC_CODEC_I420_9L, VLC_CODEC_I420_10L,
+    VLC_CODEC_I420_9B, VLC_CODEC_I420_10B,
+    VLC_CODEC_J422, VLC_CODEC_I422, VLC_CODEC_I422_9L, VLC_CODEC_I422_10L,
+    VLC_CODEC_I422_16L, VLC_CODEC_I422_9B, VLC_CODEC_I422_10B,
+    VLC_CODEC_I422_16B,
+    VLC_CODEC_J444, VLC_CODEC_I444, VLC_CODEC_I444_9L, VLC_CODEC_I444_10L,
+    VLC_CODEC_I444_16L, VLC_CODEC_I444_9B, VLC_CODEC_I444_10B,
+    VLC_CODEC_I444_16B,
+    VLC_CODEC_YUYV, VLC_CODEC_UYVY, VLC_CODEC_YVYU, VLC_CODEC_VYUY,
+};
+static const vlc_fourcc_t p_blend_chromas[] = {
+    VLC_CODEC_YUVA, VLC_CODEC_RGBA, VLC_CODEC_YUVP,
 };
 
 /*****************************************************************************
@@ -111,6 +144,7 @@ struct filter_sys_t
 {
     bool b_done;
     int i_loops, i_alpha;
+    unsigned i_width, i_height;
 
     picture_t *p_base_image;
     picture_t *p_blend_image;
@@ -146,6 +180,191 @@ static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
     return VLC_SUCCESS;
 }
 
+static unsigned blendbench_Rand( unsigned *p_seed )
+{
+    *p_seed = *p_seed * 1103515245 + 12345;
+    return *p_seed >> 16;
+}
+
+/**
+ * Creates a picture of random content. A third of the alpha values are
+ * fully transparent and a third fully opaque, as in usual subpictures.
+ */
+static picture_t *blendbench_NewImage( vlc_fourcc_t i_chroma,
+                                       unsigned i_width, unsigned i_height )
+{
+    video_format_t fmt;
+    video_palette_t palette;
+    unsigned i_seed = i_chroma;
+
+    video_format_Init( &fmt, i_chroma );
+    fmt.i_width  = fmt.i_visible_width  = i_width;
+    fmt.i_height = fmt.i_visible_height = i_height;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+    video_format_FixRgb( &fmt );
+
+    if( i_chroma == VLC_CODEC_YUVP )
+    {
+        palette.i_entries = 256;
+        for( int i = 0; i < 256; i++ )
+            for( int j = 0; j < 4; j++ )
+                palette.palette[i][j] = blendbench_Rand( &i_seed );
+        fmt.p_palette = &palette;
+    }
+
+    picture_t *p_pic = picture_NewFromFormat( &fmt );
+    if( p_pic == NULL )
+        return NULL;
+    /* the picture format keeps the palette pointer */
+    p_pic->format.p_palette = NULL;
+    if( i_chroma == VLC_CODEC_YUVP )
+    {
+        p_pic->format.p_palette = malloc( sizeof(palette) );
+        if( p_pic->format.p_palette == NULL )
+        {
+            picture_Release( p_pic );
+            return NULL;
+        }
+        *p_pic->format.p_palette = palette;
+    }
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+        const bool b_alpha = i == A_PLANE || i_chroma == VLC_CODEC_RGBA;
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                unsigned v = blendbench_Rand( &i_seed );
+                /* alpha of RGBA is every fourth byte */
+                if( b_alpha && ( i_chroma != VLC_CODEC_RGBA || x % 4 == 3 ) )
+                    v = ( v % 3 == 0 ) ? 0 : ( v % 3 == 1 ) ? 255 : v >> 8;
+                p->p_pixels[y * p->i_pitch + x] = v;
+            }
+    }
+    return p_pic;
+}
+
+static void blendbench_DeleteImage( picture_t *p_pic )
+{
+    if( p_pic->format.i_chroma == VLC_CODEC_YUVP )
+        free( p_pic->format.p_palette );
+    picture_Release( p_pic );
+}
+
+static bool blendbench_Equal( const picture_t *p_a, const picture_t *p_b )
+{
+    for( int i = 0; i < p_a->i_planes; i++ )
+    {
+        const plane_t *a = &p_a->p[i], *b = &p_b->p[i];
+
+        for( int y = 0; y < a->i_visible_lines; y++ )
+            if( memcmp( &a->p_pixels[y * a->i_pitch],
+                        &b->p_pixels[y * b->i_pitch], a->i_visible_pitch ) )
+                return false;
+    }
+    return true;
+}
+
+/**
+ * Blends p_blend_image i_loops times onto a copy of p_base_image to measure
+ * the speed, then once onto a fresh copy, left in p_result. p_base_image is
+ * not modified.
+ *
+ * \return the speed in pixels per second, 0 on error
+ */
+static double blendbench_Run( filter_t *p_filter, picture_t *p_base_image,
+                              picture_t *p_blend_image, bool b_simd,
+                              picture_t *p_result )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_blend;
+
+    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_blend )
+        return 0.;
+    p_blend->fmt_out.video = p_base_image->format;
+    p_blend->fmt_in.video = p_blend_image->format;
+    var_Create( p_blend, "blend-simd", VLC_VAR_BOOL );
+    var_SetBool( p_blend, "blend-simd", b_simd );
+    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
+    if( !p_blend->p_module )
+    {
+        vlc_object_release( p_blend );
+        return 0.;
+    }
+
+    /* Time on p_result, the base picture is shared by the C and SIMD runs */
+    picture_CopyPixels( p_result, p_base_image );
+    mtime_t time = mdate();
+    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    {
+        p_blend->pf_video_blend( p_blend,
+                                 p_result, p_blend_image,
+                                 0, 0, p_sys->i_alpha );
+    }
+    time = mdate() - time;
+
+    picture_CopyPixels( p_result, p_base_image );
+    p_blend->pf_video_blend( p_blend, p_result, p_blend_image,
+                             0, 0, p_sys->i_alpha );
+
+    module_unneed( p_blend, p_blend->p_module );
+    vlc_object_release( p_blend );
+
+    return (double) p_sys->i_loops / __MAX(time, 1) * 1000000 *
+           p_blend_image->format.i_visible_width *
+           p_blend_image->format.i_visible_height;
+}
+
+/**
+ * Benchmarks the C and SIMD blendings of one pair of chromas, and checks
+ * that they give the same result.
+ *
+ * \return VLC_EGENERIC if the results differ
+ */
+static int blendbench_Pair( filter_t *p_filter, picture_t *p_base_image,
+                            picture_t *p_blend_image )
+{
+    const vlc_fourcc_t i_base = p_base_image->format.i_chroma;
+    const vlc_fourcc_t i_blend = p_blend_image->format.i_chroma;
+    picture_t *p_c = picture_NewFromFormat( &p_base_image->format );
+    picture_t *p_simd = picture_NewFromFormat( &p_base_image->format );
+    int i_ret = VLC_SUCCESS;
+
+    if( p_c == NULL || p_simd == NULL )
+        goto end;
+
+    double f_c = blendbench_Run( p_filter, p_base_image, p_blend_image,
+                                 false, p_c );
+    double f_simd = blendbench_Run( p_filter, p_base_image, p_blend_image,
+                                    true, p_simd );
+    if( f_c <= 0. || f_simd <= 0. )
+    {
+        msg_Dbg( p_filter, "%4.4s on %4.4s: not supported",
+                 (const char *)&i_blend, (const char *)&i_base );
+        goto end;
+    }
+
+    if( !blendbench_Equal( p_c, p_simd ) )
+    {
+        msg_Err( p_filter, "%4.4s on %4.4s: C and SIMD blending differ",
+                 (const char *)&i_blend, (const char *)&i_base );
+        i_ret = VLC_EGENERIC;
+    }
+    msg_Info( p_filter, "%4.4s on %4.4s: %8.1f Mpixels/s, SIMD %8.1f"
+              " Mpixels/s (x%.1f)", (const char *)&i_blend,
+              (const char *)&i_base, f_c / 1000000, f_simd / 1000000,
+              f_simd / f_c );
+end:
+    if( p_c )
+        picture_Release( p_c );
+    if( p_simd )
+        picture_Release( p_simd );
+    return i_ret;
+}
+
 /*****************************************************************************
  * Create: allocates video thread output method
  *****************************************************************************/
@@ -163,6 +382,8 @@ static int Create( vlc_object_t *p_this )
 
     p_sys = p_filter->p_sys;
     p_sys->b_done = false;
+    p_sys->p_base_image = NULL;
+    p_sys->p_blend_image = NULL;
 
     p_filter->pf_video_filter = Filter;
 
@@ -175,39 +396,51 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
+    p_sys->i_width = __MAX( var_CreateGetInteger( p_filter,
+                                                  CFG_PREFIX "width" ), 2 );
+    p_sys->i_height = __MAX( var_CreateGetInteger( p_filter,
+                                                   CFG_PREFIX "height" ), 2 );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
     p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
         VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
     free( psz_temp );
-    free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
-    {
-        free( p_sys );
-        return i_ret;
-    }
-
     psz_temp = var_CreateGetStringCommand( p_filter,
                                            CFG_PREFIX "blend-chroma" );
     p_sys->i_blend_chroma = !psz_temp || strlen( psz_temp ) != 4
         ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
-
     free( psz_temp );
-    free( psz_cmd );
 
-    if( i_ret != VLC_SUCCESS )
+    /* Without image files, random images of every chroma are generated */
+    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
+    if( psz_cmd && *psz_cmd )
     {
-        picture_Release( p_sys->p_base_image );
-        free( p_sys );
+        i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
+                                      p_sys->i_base_chroma, psz_cmd, "Base" );
+        if( i_ret != VLC_SUCCESS )
+        {
+            free( psz_cmd );
+            free( p_sys );
+            return i_ret;
+        }
+    }
+    free( psz_cmd );
 
-        return VLC_EGENERIC;
+    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
+    if( psz_cmd && *psz_cmd )
+    {
+        i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image,
+                                      p_sys->i_blend_chroma, psz_cmd, "Blend" );
+        if( i_ret != VLC_SUCCESS )
+        {
+            free( psz_cmd );
+            if( p_sys->p_base_image )
+                picture_Release( p_sys->p_base_image );
+            free( p_sys );
+            return VLC_EGENERIC;
+        }
     }
+    free( psz_cmd );
 
     return VLC_SUCCESS;
 }
@@ -220,8 +453,11 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    if( p_sys->p_base_image )
+        picture_Release( p_sys->p_base_image );
+    if( p_sys->p_blend_image )
+        picture_Release( p_sys->p_blend_image );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -230,47 +466,52 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
+    unsigned i_pairs = 0, i_errors = 0;
 
     if( p_sys->b_done )
         return p_pic;
 
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
-    {
-        picture_Release( p_pic );
-        vlc_object_release( p_blend );
-        return NULL;
-    }
-
-    mtime_t time = mdate();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    for( size_t i = 0; i < ARRAY_SIZE(p_base_chromas); i++ )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
+        if( p_sys->i_base_chroma && !p_sys->p_base_image &&
+            p_sys->i_base_chroma != p_base_chromas[i] )
+            continue;
+        picture_t *p_base = p_sys->p_base_image;
+        if( p_base == NULL )
+            p_base = blendbench_NewImage( p_base_chromas[i], p_sys->i_width,
+                                          p_sys->i_height );
+        if( p_base == NULL )
+            continue;
+
+        for( size_t j = 0; j < ARRAY_SIZE(p_blend_chromas); j++ )
+        {
+            if( p_sys->i_blend_chroma && !p_sys->p_blend_image &&
+                p_sys->i_blend_chroma != p_blend_chromas[j] )
+                continue;
+            picture_t *p_blend = p_sys->p_blend_image;
+            if( p_blend == NULL )
+                p_blend = blendbench_NewImage( p_blend_chromas[j],
+                                               p_sys->i_width,
+                                               p_sys->i_height );
+            if( p_blend == NULL )
+                continue;
+
+            if( blendbench_Pair( p_filter, p_base, p_blend ) )
+                i_errors++;
+            i_pairs++;
+
+            if( p_blend == p_sys->p_blend_image )
+                break;
+            blendbench_DeleteImage( p_blend );
+        }
+
+        if( p_base == p_sys->p_base_image )
+            break;
+        blendbench_DeleteImage( p_base );
     }
-    time = mdate() - time;
-
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
 
-    module_unneed( p_blend, p_blend->p_module );
-
-    vlc_object_release( p_blend );
+    msg_Info( p_filter, "Blended %u pairs of chromas, %u mismatches",
+              i_pairs, i_errors );
 
     p_sys->b_done = true;
     return p_pic;
@@ -47,6 +47,83 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef void (*yadif_line_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                             uint8_t *next, int w, int prefs, int mrefs,
+                             int parity, int mode);
+
+typedef struct
+{
+    yadif_line_t filter;
+    picture_t *p_dst;
+    picture_t *p_prev;
+    picture_t *p_cur;
+    picture_t *p_next;
+    int i_field;
+    int i_parity;
+    int i_pixel_size;
+} yadif_job_t;
+
+/* Renders the lines of one band of every plane */
+static void YadifSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    const yadif_job_t *job = opaque;
+    const int yadif_parity = job->i_parity;
+
+    for( int n = 0; n < job->p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &job->p_prev->p[n];
+        const plane_t *curp  = &job->p_cur->p[n];
+        const plane_t *nextp = &job->p_next->p[n];
+        plane_t *dstp        = &job->p_dst->p[n];
+        /* the line filters take a width in pixels */
+        const int w = dstp->i_visible_pitch / job->i_pixel_size;
+
+        int first, end;
+        filter_GetSliceLines( dstp->i_visible_lines, i_slice, i_slices,
+                              &first, &end );
+        if( first < 1 )
+            first = 1;
+        if( end > dstp->i_visible_lines - 1 )
+            end = dstp->i_visible_lines - 1;
+
+        for( int y = first; y < end; y++ )
+        {
+            if( (y % 2) == job->i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                job->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                             &prevp->p_pixels[y * prevp->i_pitch],
+                             &curp->p_pixels[y * curp->i_pitch],
+                             &nextp->p_pixels[y * nextp->i_pitch],
+                             w,
+                             y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                             y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                             yadif_parity,
+                             mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == dstp->i_visible_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -109,74 +186,61 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        yadif_line_t filter;
 
-#if defined(HAVE_YADIF_SSSE3)
-        if( vlc_CPU_SSSE3() )
-            filter = yadif_filter_line_ssse3;
+        if( p_sys->chroma->pixel_size == 2 )
+        {
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter = yadif_filter_line_16bit_avx2;
+            else
+#endif
+#if defined(HAVE_YADIF_NEON)
+                filter = yadif_filter_line_16bit_neon;
+#else
+                filter = yadif_filter_line_c_16bit;
+#endif
+        }
         else
+        {
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter = yadif_filter_line_avx2;
+            else
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+            if( vlc_CPU_SSSE3() )
+                filter = yadif_filter_line_ssse3;
+            else
 #endif
 #if defined(HAVE_YADIF_SSE2)
-        if( vlc_CPU_SSE2() )
-            filter = yadif_filter_line_sse2;
-        else
+            if( vlc_CPU_SSE2() )
+                filter = yadif_filter_line_sse2;
+            else
 #endif
 #if defined(HAVE_YADIF_MMX)
-        if( vlc_CPU_MMX() )
-            filter = yadif_filter_line_mmx;
-        else
+            if( vlc_CPU_MMX() )
+                filter = yadif_filter_line_mmx;
+            else
+#endif
+#if defined(HAVE_YADIF_NEON)
+                filter = yadif_filter_line_neon;
+#else
+                filter = yadif_filter_line_c;
 #endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
-        {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
         }
 
+        yadif_job_t job = {
+            .filter = filter,
+            .p_dst = p_dst, .p_prev = p_prev, .p_cur = p_cur, .p_next = p_next,
+            .i_field = i_field,
+            .i_parity = yadif_parity,
+            .i_pixel_size = p_sys->chroma->pixel_size,
+        };
+        /* Output lines only depend on the input pictures, so the bands of
+         * all the planes are independent */
+        filter_RunSlices( p_sys->slices, YadifSlice, &job, 0 );
+
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
         return VLC_SUCCESS;
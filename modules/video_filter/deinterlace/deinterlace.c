@@ -527,6 +527,11 @@ notsupp:
     char *psz_mode = var_InheritString( p_filter, FILTER_CFG_PREFIX "mode" );
     SetFilterMethod( p_filter, psz_mode, packed );
 
+    p_sys->slices = NULL;
+    if( p_sys->context.pf_render_ordered == RenderYadif ||
+        p_sys->context.pf_render_single_pic == RenderYadifSingle )
+        p_sys->slices = filter_NewSlices( p_filter, 0 );
+
     IVTCClearState( p_filter );
 
 #if defined(CAN_COMPILE_C_ALTIVEC)
@@ -650,5 +655,6 @@ void Close( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
 
     Flush( p_filter );
+    filter_DeleteSlices( p_filter->p_sys->slices );
     free( p_filter->p_sys );
 }
@@ -78,6 +78,9 @@ struct filter_sys_t
 
     struct deinterlace_ctx   context;
 
+    /** Band-parallel rendering, for the algorithms supporting it (Yadif) */
+    struct filter_slices_t  *slices;
+
     /* Algorithm-specific substructures */
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
@@ -151,3 +151,176 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================= AVX2 =================
+#include <immintrin.h>
+#define HAVE_YADIF_AVX2
+#define VLC_TARGET VLC_AVX2
+#define V_T __m256i
+#define V_M __m256i
+#define V_AND(m,n)   _mm256_and_si256(m, n)
+#define V_SEL(m,a,b) _mm256_blendv_epi8(b, a, m)
+#define V_ZERO       _mm256_setzero_si256()
+/* keep the low half of each 128-bit lane after packing */
+#define V_STORE_PACKED(p,v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm256_castsi256_si128(_mm256_permute4x64_epi64(v, 0xd8)))
+
+#define pixel_t uint8_t
+#define STEP 16
+#define V_LOAD(p)    _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define V_STORE(p,v) V_STORE_PACKED(p, _mm256_packus_epi16(v, v))
+#define V_ADD        _mm256_add_epi16
+#define V_SUB        _mm256_sub_epi16
+#define V_ABS        _mm256_abs_epi16
+#define V_MIN        _mm256_min_epi16
+#define V_MAX        _mm256_max_epi16
+#define V_SRA1(a)    _mm256_srai_epi16(a, 1)
+#define V_GT         _mm256_cmpgt_epi16
+#define V_ONE        _mm256_set1_epi16(1)
+#define V_TAIL       yadif_filter_line_c
+#define RENAME(a) a ## _avx2
+#include "yadif_simd_template.h"
+#undef pixel_t
+#undef STEP
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_ABS
+#undef V_MIN
+#undef V_MAX
+#undef V_SRA1
+#undef V_GT
+#undef V_ONE
+#undef V_TAIL
+#undef RENAME
+
+#define pixel_t uint16_t
+#define STEP 8
+#define V_LOAD(p)    _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define V_STORE(p,v) V_STORE_PACKED(p, _mm256_packus_epi32(v, v))
+#define V_ADD        _mm256_add_epi32
+#define V_SUB        _mm256_sub_epi32
+#define V_ABS        _mm256_abs_epi32
+#define V_MIN        _mm256_min_epi32
+#define V_MAX        _mm256_max_epi32
+#define V_SRA1(a)    _mm256_srai_epi32(a, 1)
+#define V_GT         _mm256_cmpgt_epi32
+#define V_ONE        _mm256_set1_epi32(1)
+#define V_TAIL       yadif_filter_line_c_16bit
+#define RENAME(a) a ## _16bit_avx2
+#include "yadif_simd_template.h"
+#undef pixel_t
+#undef STEP
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_ABS
+#undef V_MIN
+#undef V_MAX
+#undef V_SRA1
+#undef V_GT
+#undef V_ONE
+#undef V_TAIL
+#undef RENAME
+
+#undef V_STORE_PACKED
+#undef V_ZERO
+#undef V_SEL
+#undef V_AND
+#undef V_M
+#undef V_T
+#undef VLC_TARGET
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+// ================= NEON =================
+#include <arm_neon.h>
+#define HAVE_YADIF_NEON
+#define VLC_TARGET
+
+#define pixel_t uint8_t
+#define STEP 8
+#define V_T int16x8_t
+#define V_M uint16x8_t
+#define V_LOAD(p)    vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)))
+#define V_STORE(p,v) vst1_u8(p, vqmovun_s16(v))
+#define V_ADD        vaddq_s16
+#define V_SUB        vsubq_s16
+#define V_ABS        vabsq_s16
+#define V_MIN        vminq_s16
+#define V_MAX        vmaxq_s16
+#define V_SRA1(a)    vshrq_n_s16(a, 1)
+#define V_GT         vcgtq_s16
+#define V_AND        vandq_u16
+#define V_SEL        vbslq_s16
+#define V_ZERO       vdupq_n_s16(0)
+#define V_ONE        vdupq_n_s16(1)
+#define V_TAIL       yadif_filter_line_c
+#define RENAME(a) a ## _neon
+#include "yadif_simd_template.h"
+#undef pixel_t
+#undef STEP
+#undef V_T
+#undef V_M
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_ABS
+#undef V_MIN
+#undef V_MAX
+#undef V_SRA1
+#undef V_GT
+#undef V_AND
+#undef V_SEL
+#undef V_ZERO
+#undef V_ONE
+#undef V_TAIL
+#undef RENAME
+
+#define pixel_t uint16_t
+#define STEP 4
+#define V_T int32x4_t
+#define V_M uint32x4_t
+#define V_LOAD(p)    vreinterpretq_s32_u32(vmovl_u16(vld1_u16(p)))
+#define V_STORE(p,v) vst1_u16(p, vqmovun_s32(v))
+#define V_ADD        vaddq_s32
+#define V_SUB        vsubq_s32
+#define V_ABS        vabsq_s32
+#define V_MIN        vminq_s32
+#define V_MAX        vmaxq_s32
+#define V_SRA1(a)    vshrq_n_s32(a, 1)
+#define V_GT         vcgtq_s32
+#define V_AND        vandq_u32
+#define V_SEL        vbslq_s32
+#define V_ZERO       vdupq_n_s32(0)
+#define V_ONE        vdupq_n_s32(1)
+#define V_TAIL       yadif_filter_line_c_16bit
+#define RENAME(a) a ## _16bit_neon
+#include "yadif_simd_template.h"
+#undef pixel_t
+#undef STEP
+#undef V_T
+#undef V_M
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_ABS
+#undef V_MIN
+#undef V_MAX
+#undef V_SRA1
+#undef V_GT
+#undef V_AND
+#undef V_SEL
+#undef V_ZERO
+#undef V_ONE
+#undef V_TAIL
+#undef RENAME
+
+#undef VLC_TARGET
+#endif
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * yadif_simd_template.h : Yadif line filter on SIMD intrinsics
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Same computation as the FILTER macro of yadif.h, STEP pixels at a time.
+ * Pixels are widened to signed lanes wide enough for the sums, so the result
+ * is bit-exact with the C version.
+ *
+ * The includer defines:
+ *  pixel_t          uint8_t or uint16_t
+ *  STEP             pixels per iteration
+ *  V_T, V_M         vector and mask types
+ *  V_LOAD(p)        load STEP pixels from p and widen them
+ *  V_STORE(p,v)     narrow (saturating) and store STEP pixels to p
+ *  V_ADD, V_SUB, V_ABS, V_MIN, V_MAX, V_SRA1 (>> 1)
+ *  V_GT(a,b)        mask of a > b
+ *  V_AND(m,n)       mask and
+ *  V_SEL(m,a,b)     m ? a : b
+ *  V_ZERO, V_ONE    constant vectors
+ *  V_TAIL           C line function for the remaining pixels
+ *  RENAME(a), VLC_TARGET
+ */
+
+#define SIMD_LD(p, off) V_LOAD(&(p)[x + (off)])
+#define SIMD_SCORE(j) \
+    V_ADD(V_ADD(V_ABS(V_SUB(SIMD_LD(cur, mrefs - 1 + (j)), SIMD_LD(cur, prefs - 1 - (j)))), \
+                V_ABS(V_SUB(SIMD_LD(cur, mrefs     + (j)), SIMD_LD(cur, prefs     - (j))))), \
+                V_ABS(V_SUB(SIMD_LD(cur, mrefs + 1 + (j)), SIMD_LD(cur, prefs + 1 - (j)))))
+#define SIMD_PRED(j) V_SRA1(V_ADD(SIMD_LD(cur, mrefs + (j)), SIMD_LD(cur, prefs - (j))))
+#define SIMD_CHECK(m, j) \
+    { \
+        V_T score = SIMD_SCORE(j); \
+        m = V_AND(m, V_GT(spatial_score, score)); \
+        spatial_score = V_SEL(m, score, spatial_score); \
+        spatial_pred = V_SEL(m, SIMD_PRED(j), spatial_pred); \
+    }
+
+VLC_TARGET
+static void RENAME(yadif_filter_line)(uint8_t *dst8, uint8_t *prev8,
+                                      uint8_t *cur8, uint8_t *next8,
+                                      int w, int prefs, int mrefs,
+                                      int parity, int mode)
+{
+    pixel_t *dst  = (pixel_t *)dst8;
+    pixel_t *prev = (pixel_t *)prev8;
+    pixel_t *cur  = (pixel_t *)cur8;
+    pixel_t *next = (pixel_t *)next8;
+    pixel_t *prev2 = parity ? prev : cur ;
+    pixel_t *next2 = parity ? cur  : next;
+    const int prefs_bytes = prefs, mrefs_bytes = mrefs;
+    int x;
+
+    prefs /= (int)sizeof(pixel_t);
+    mrefs /= (int)sizeof(pixel_t);
+
+    for( x = 0; x + STEP <= w; x += STEP )
+    {
+        V_T c  = SIMD_LD(cur, mrefs);
+        V_T e  = SIMD_LD(cur, prefs);
+        V_T p2 = SIMD_LD(prev2, 0);
+        V_T n2 = SIMD_LD(next2, 0);
+        V_T d  = V_SRA1(V_ADD(p2, n2));
+
+        V_T temporal_diff0 = V_ABS(V_SUB(p2, n2));
+        V_T temporal_diff1 = V_SRA1(V_ADD(V_ABS(V_SUB(SIMD_LD(prev, mrefs), c)),
+                                          V_ABS(V_SUB(SIMD_LD(prev, prefs), e))));
+        V_T temporal_diff2 = V_SRA1(V_ADD(V_ABS(V_SUB(SIMD_LD(next, mrefs), c)),
+                                          V_ABS(V_SUB(SIMD_LD(next, prefs), e))));
+        V_T diff = V_MAX(V_MAX(V_SRA1(temporal_diff0), temporal_diff1),
+                         temporal_diff2);
+
+        V_T spatial_pred  = V_SRA1(V_ADD(c, e));
+        V_T spatial_score = V_SUB(SIMD_SCORE(0), V_ONE);
+
+        /* the second direction is only tried if the first one was better */
+        V_M m = V_GT(V_ONE, V_ZERO);
+        SIMD_CHECK(m, -1) SIMD_CHECK(m, -2)
+        m = V_GT(V_ONE, V_ZERO);
+        SIMD_CHECK(m, 1) SIMD_CHECK(m, 2)
+
+        if( mode < 2 )
+        {
+            V_T b = V_SRA1(V_ADD(SIMD_LD(prev2, 2 * mrefs), SIMD_LD(next2, 2 * mrefs)));
+            V_T f = V_SRA1(V_ADD(SIMD_LD(prev2, 2 * prefs), SIMD_LD(next2, 2 * prefs)));
+            V_T de = V_SUB(d, e), dc = V_SUB(d, c);
+            V_T bc = V_SUB(b, c), fe = V_SUB(f, e);
+            V_T max = V_MAX(V_MAX(de, dc), V_MIN(bc, fe));
+            V_T min = V_MIN(V_MIN(de, dc), V_MAX(bc, fe));
+
+            diff = V_MAX(V_MAX(diff, min), V_SUB(V_ZERO, max));
+        }
+
+        /* diff >= 0 here, so this is the same clipping as in C */
+        spatial_pred = V_MIN(V_MAX(spatial_pred, V_SUB(d, diff)),
+                             V_ADD(d, diff));
+        V_STORE(&dst[x], spatial_pred);
+    }
+
+    if( x < w )
+        V_TAIL((uint8_t *)&dst[x], (uint8_t *)&prev[x], (uint8_t *)&cur[x],
+               (uint8_t *)&next[x], w - x, prefs_bytes, mrefs_bytes,
+               parity, mode);
+}
+
+#undef SIMD_CHECK
+#undef SIMD_PRED
+#undef SIMD_SCORE
+#undef SIMD_LD
@@ -163,3 +163,25 @@ static inline picture_t *CopyInfoAndRelease( picture_t *p_outpic, picture_t *p_i
 
     return p_outpic;
 }
+
+/**
+ * Restricts the planes of a picture to the lines of one band, so that
+ * functions processing whole pictures can be used from filter_RunSlices()
+ * callbacks. The view shares the pixels of p_pic: it must not be held,
+ * released nor outlive it.
+ */
+static inline void picture_SliceView( picture_t *p_view, const picture_t *p_pic,
+                                      unsigned i_slice, unsigned i_slices )
+{
+    memcpy( p_view, p_pic, sizeof(*p_view) );
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_view->p[i];
+        int i_first, i_end;
+
+        filter_GetSliceLines( p->i_visible_lines, i_slice, i_slices,
+                              &i_first, &i_end );
+        p->p_pixels += i_first * p->i_pitch;
+        p->i_lines = p->i_visible_lines = i_end - i_first;
+    }
+}
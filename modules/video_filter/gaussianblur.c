@@ -100,6 +100,8 @@ struct filter_sys_t
     type_t *pt_distribution;
     type_t *pt_buffer;
     type_t *pt_scale;
+
+    filter_slices_t *slices;
 };
 
 static void gaussianblur_InitDistribution( filter_sys_t *p_sys )
@@ -170,6 +172,7 @@ static int Create( vlc_object_t *p_this )
 
     p_filter->p_sys->pt_buffer = NULL;
     p_filter->p_sys->pt_scale = NULL;
+    p_filter->p_sys->slices = filter_NewSlices( p_filter, 0 );
 
     return VLC_SUCCESS;
 }
@@ -181,18 +184,134 @@ static void Destroy( vlc_object_t *p_this )
     free( p_filter->p_sys->pt_distribution );
     free( p_filter->p_sys->pt_buffer );
     free( p_filter->p_sys->pt_scale );
+    filter_DeleteSlices( p_filter->p_sys->slices );
 
     free( p_filter->p_sys );
 }
 
+typedef struct
+{
+    const type_t *pt_distribution;
+    int i_dim;
+    type_t *pt_buffer;
+    type_t *pt_scale;
+
+    const plane_t *p_in;
+    plane_t *p_out;
+    int x_factor;
+    int y_factor;
+} gaussianblur_job_t;
+
+static void ScaleSlice( void *opaque, unsigned slice, unsigned slices )
+{
+    const gaussianblur_job_t *job = opaque;
+    const type_t *pt_distribution = job->pt_distribution;
+    const int i_dim = job->i_dim;
+    type_t *pt_scale = job->pt_scale;
+    const int i_visible_lines = job->p_in->i_visible_lines;
+    const int i_visible_pitch = job->p_in->i_visible_pitch;
+    const int i_pitch = job->p_in->i_pitch;
+    int i_first, i_end;
+
+    filter_GetSliceLines( i_visible_lines, slice, slices, &i_first, &i_end );
+    for( int i_line = i_first; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+
+            for( int y = __MAX( -i_dim, -i_line );
+                 y <= __MIN( i_dim, i_visible_lines - i_line - 1 );
+                 y++ )
+            {
+                for( int x = __MAX( -i_dim, -i_col );
+                     x <= __MIN( i_dim, i_visible_pitch - i_col + 1 );
+                     x++ )
+                {
+                    t_value += pt_distribution[y+i_dim] *
+                               pt_distribution[x+i_dim];
+                }
+            }
+            pt_scale[i_line*i_pitch+i_col] = t_value;
+        }
+    }
+}
+
+static void HorizontalSlice( void *opaque, unsigned slice, unsigned slices )
+{
+    const gaussianblur_job_t *job = opaque;
+    const type_t *pt_distribution = job->pt_distribution;
+    const int i_dim = job->i_dim;
+    type_t *pt_buffer = job->pt_buffer;
+    const uint8_t *p_in = job->p_in->p_pixels;
+    const int i_visible_lines = job->p_in->i_visible_lines;
+    const int i_visible_pitch = job->p_in->i_visible_pitch;
+    const int i_in_pitch = job->p_in->i_pitch;
+    const int x_factor = job->x_factor;
+    int i_first, i_end;
+
+    filter_GetSliceLines( i_visible_lines, slice, slices, &i_first, &i_end );
+    for( int i_line = i_first; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                 x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                 x++ )
+            {
+                t_value += pt_distribution[x+i_dim] *
+                           p_in[c+(x>>x_factor)];
+            }
+            pt_buffer[c] = t_value;
+        }
+    }
+}
+
+/* Reads the horizontal pass result of neighbouring lines: must run once
+ * HorizontalSlice is done for the whole plane. */
+static void VerticalSlice( void *opaque, unsigned slice, unsigned slices )
+{
+    const gaussianblur_job_t *job = opaque;
+    const type_t *pt_distribution = job->pt_distribution;
+    const int i_dim = job->i_dim;
+    const type_t *pt_buffer = job->pt_buffer;
+    const type_t *pt_scale = job->pt_scale;
+    uint8_t *p_out = job->p_out->p_pixels;
+    const int i_out_pitch = job->p_out->i_pitch;
+    const int i_visible_lines = job->p_in->i_visible_lines;
+    const int i_visible_pitch = job->p_in->i_visible_pitch;
+    const int i_in_pitch = job->p_in->i_pitch;
+    const int x_factor = job->x_factor;
+    const int y_factor = job->y_factor;
+    int i_first, i_end;
+
+    filter_GetSliceLines( i_visible_lines, slice, slices, &i_first, &i_end );
+    for( int i_line = i_first; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                 y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                 y++ )
+            {
+                t_value += pt_distribution[y+i_dim] *
+                           pt_buffer[c+(y>>y_factor)*i_in_pitch];
+            }
+
+            const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
+            p_out[i_line * i_out_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
-    const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
-    type_t *pt_scale;
-    const type_t *pt_distribution = p_sys->pt_distribution;
 
     if( !p_pic ) return NULL;
 
@@ -209,87 +328,31 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                                p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
     }
 
-    pt_buffer = p_sys->pt_buffer;
+    gaussianblur_job_t job = {
+        .pt_distribution = p_sys->pt_distribution,
+        .i_dim = p_sys->i_dim,
+        .pt_buffer = p_sys->pt_buffer,
+    };
+
     if( !p_sys->pt_scale )
     {
-        const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
-        const int i_pitch = p_pic->p[Y_PLANE].i_pitch;
-
-        p_sys->pt_scale = xmalloc( i_visible_lines * i_pitch * sizeof( type_t ) );
-        pt_scale = p_sys->pt_scale;
-
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-
-                for( int y = __MAX( -i_dim, -i_line );
-                     y <= __MIN( i_dim, i_visible_lines - i_line - 1 );
-                     y++ )
-                {
-                    for( int x = __MAX( -i_dim, -i_col );
-                         x <= __MIN( i_dim, i_visible_pitch - i_col + 1 );
-                         x++ )
-                    {
-                        t_value += pt_distribution[y+i_dim] *
-                                   pt_distribution[x+i_dim];
-                    }
-                }
-                pt_scale[i_line*i_pitch+i_col] = t_value;
-            }
-        }
+        p_sys->pt_scale = xmalloc( p_pic->p[Y_PLANE].i_visible_lines *
+                                   p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
+        job.pt_scale = p_sys->pt_scale;
+        job.p_in = &p_pic->p[Y_PLANE];
+        filter_RunSlices( p_sys->slices, ScaleSlice, &job, 0 );
     }
 
-    pt_scale = p_sys->pt_scale;
+    job.pt_scale = p_sys->pt_scale;
     for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
+        job.p_in = &p_pic->p[i_plane];
+        job.p_out = &p_outpic->p[i_plane];
+        job.x_factor = p_pic->p[Y_PLANE].i_visible_pitch/job.p_in->i_visible_pitch-1;
+        job.y_factor = p_pic->p[Y_PLANE].i_visible_lines/job.p_in->i_visible_lines-1;
 
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
-
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+        filter_RunSlices( p_sys->slices, HorizontalSlice, &job, 0 );
+        filter_RunSlices( p_sys->slices, VerticalSlice, &job, 0 );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -108,6 +108,9 @@ struct filter_sys_t {
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    /* the blur buffer is per plane so that planes run in parallel */
+    uint16_t         *buf[PICTURE_PLANE_MAX];
+    filter_slices_t  *slices;
 };
 
 static int Open(vlc_object_t *object)
@@ -132,6 +135,8 @@ static int Open(vlc_object_t *object)
     var_AddCallback(filter, CFG_PREFIX "strength", Callback, NULL);
     var_AddCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     sys->cfg.buf = NULL;
+    for (int i = 0; i < PICTURE_PLANE_MAX; i++)
+        sys->buf[i] = NULL;
 
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
@@ -156,6 +161,8 @@ static int Open(vlc_object_t *object)
 #endif
         cfg->filter_line = filter_line_c;
 
+    sys->slices = filter_NewSlices(filter, chroma->plane_count);
+
     filter->p_sys           = sys;
     filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
@@ -168,11 +175,48 @@ static void Close(vlc_object_t *object)
 
     var_DelCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     var_DelCallback(filter, CFG_PREFIX "strength", Callback, NULL);
-    aligned_free(sys->cfg.buf);
+    filter_DeleteSlices(sys->slices);
+    for (int i = 0; i < PICTURE_PLANE_MAX; i++)
+        aligned_free(sys->buf[i]);
     vlc_mutex_destroy(&sys->lock);
     free(sys);
 }
 
+typedef struct
+{
+    filter_sys_t         *sys;
+    const video_format_t *fmt;
+    picture_t            *src;
+    picture_t            *dst;
+} gradfun_job_t;
+
+static void PlaneSlice(void *opaque, unsigned i, unsigned planes)
+{
+    gradfun_job_t *job = opaque;
+    filter_sys_t  *sys = job->sys;
+    const plane_t *srcp = &job->src->p[i];
+    plane_t       *dstp = &job->dst->p[i];
+
+    VLC_UNUSED(planes);
+
+    /* same parameters, private buffer */
+    struct vf_priv_s cfg = sys->cfg;
+    cfg.buf = sys->buf[i];
+
+    const vlc_chroma_description_t *chroma = sys->chroma;
+    int w = job->fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+    int h = job->fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+    int r = (cfg.radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+             cfg.radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+    r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+    if (__MIN(w, h) > 2 * r && cfg.buf) {
+        filter_plane(&cfg, dstp->p_pixels, srcp->p_pixels,
+                     w, h, dstp->i_pitch, srcp->i_pitch, r);
+    } else {
+        plane_CopyPixels(dstp, srcp);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -194,28 +238,16 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     cfg->thresh = (1 << 15) / strength;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = aligned_alloc(16,
+        for (int i = 0; i < dst->i_planes; i++) {
+            aligned_free(sys->buf[i]);
+            sys->buf[i] = aligned_alloc(16,
                                    (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
-    }
-
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
         }
     }
 
+    gradfun_job_t job = { .sys = sys, .fmt = fmt, .src = src, .dst = dst };
+    filter_RunSlices(sys->slices, PlaneSlice, &job, dst->i_planes);
+
     picture_CopyProperties(dst, src);
     picture_Release(src);
     return dst;
@@ -96,6 +96,10 @@ struct filter_sys_t
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
+
+    /* one line buffer per plane so that planes can be denoised in parallel */
+    int wmax;
+    filter_slices_t *slices;
 };
 
 /*****************************************************************************
@@ -138,7 +142,8 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
+    sys->wmax = wmax;
+    cfg->Line = malloc(3*wmax*sizeof(unsigned int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
@@ -155,6 +160,8 @@ static int Open(vlc_object_t *this)
     sys->luma_temp = var_CreateGetFloatCommand(filter, FILTER_PREFIX "luma-temp");
     sys->chroma_temp = var_CreateGetFloatCommand(filter, FILTER_PREFIX "chroma-temp");
 
+    sys->slices = filter_NewSlices(filter, 3);
+
     filter->p_sys = sys;
     filter->pf_video_filter = Filter;
 
@@ -180,6 +187,7 @@ static void Close(vlc_object_t *this)
     var_DelCallback( filter, FILTER_PREFIX "luma-temp", DenoiseCallback, sys );
     var_DelCallback( filter, FILTER_PREFIX "chroma-temp", DenoiseCallback, sys );
 
+    filter_DeleteSlices( sys->slices );
     vlc_mutex_destroy( &sys->coefs_mutex );
 
     for (int i = 0; i < 3; ++i) {
@@ -192,6 +200,30 @@ static void Close(vlc_object_t *this)
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+typedef struct
+{
+    filter_sys_t *sys;
+    picture_t *src;
+    picture_t *dst;
+} hqdn3d_job_t;
+
+static void PlaneSlice(void *opaque, unsigned plane, unsigned planes)
+{
+    hqdn3d_job_t *job = opaque;
+    filter_sys_t *sys = job->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    /* luma uses the first pair of coefficients, chroma the second one */
+    int *spat = cfg->Coefs[plane == 0 ? 0 : 2];
+    int *temp = cfg->Coefs[plane == 0 ? 1 : 3];
+
+    VLC_UNUSED(planes);
+    deNoise(job->src->p[plane].p_pixels, job->dst->p[plane].p_pixels,
+            cfg->Line + plane * sys->wmax, &cfg->Frame[plane],
+            sys->w[plane], sys->h[plane],
+            job->src->p[plane].i_pitch, job->dst->p[plane].i_pitch,
+            spat, spat, temp);
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -221,24 +253,10 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    /* The spatial filter is recursive along both axes, planes are
+     * independent though */
+    hqdn3d_job_t job = { .sys = sys, .src = src, .dst = dst };
+    filter_RunSlices(sys->slices, PlaneSlice, &job, 3);
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
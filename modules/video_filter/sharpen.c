@@ -92,6 +92,7 @@ static const char *const ppsz_filter_options[] = {
 struct filter_sys_t
 {
     atomic_int sigma;
+    filter_slices_t *slices;
 };
 
 /*****************************************************************************
@@ -119,6 +120,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->p_sys->slices = filter_NewSlices( p_filter, 0 );
 
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                    p_filter->p_cfg );
@@ -145,6 +147,7 @@ static void Destroy( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     var_DelCallback( p_filter, FILTER_PREFIX "sigma", SharpenCallback, p_sys );
+    filter_DeleteSlices( p_sys->slices );
     free( p_sys );
 }
 
@@ -159,24 +162,42 @@ static void Destroy( vlc_object_t *p_this )
 #define IS_YUV_420_10BITS(fmt) (fmt == VLC_CODEC_I420_10L ||    \
                                 fmt == VLC_CODEC_I420_10B)
 
-#define SHARPEN_FRAME(maxval, data_t)                                   \
+typedef struct
+{
+    const plane_t *p_src;
+    plane_t       *p_out;
+    int            sigma;
+} sharpen_job_t;
+
+#define SHARPEN_LINES(maxval, data_t)                                   \
     do                                                                  \
     {                                                                   \
         assert((maxval) >= 0);                                          \
-        data_t *restrict p_src = (data_t *)p_pic->p[Y_PLANE].p_pixels;  \
-        data_t *restrict p_out = (data_t *)p_outpic->p[Y_PLANE].p_pixels; \
+        const data_t *restrict p_src = (const data_t *)job->p_src->p_pixels; \
+        data_t *restrict p_out = (data_t *)job->p_out->p_pixels;        \
         const unsigned data_sz = sizeof(data_t);                        \
-        const int i_src_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int i_out_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_filter->p_sys->sigma);         \
-                                                                        \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        const int i_src_line_len = job->p_src->i_pitch / data_sz;       \
+        const int i_out_line_len = job->p_out->i_pitch / data_sz;       \
+        const unsigned i_visible_lines = job->p_src->i_visible_lines;   \
+        const unsigned i_visible_pitch = job->p_src->i_visible_pitch;   \
+        const unsigned i_visible_width = i_visible_pitch / data_sz;     \
+        const int sigma = job->sigma;                                   \
+        int first, end;                                                 \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        filter_GetSliceLines(i_visible_lines, slice, slices, &first, &end); \
+        for( unsigned i = first; i < (unsigned)end; i++ )               \
         {                                                               \
+            /* borders are copied */                                    \
+            if( i == 0 || i == i_visible_lines - 1 )                    \
+            {                                                           \
+                memcpy(&p_out[i * i_out_line_len],                      \
+                       &p_src[i * i_src_line_len], i_visible_pitch);    \
+                continue;                                               \
+            }                                                           \
+                                                                        \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
-            for( unsigned j = data_sz; j < i_visible_pitch - 1; j++ )   \
+            for( unsigned j = 1; j < i_visible_width - 1; j++ )         \
             {                                                           \
                 const int line_idx_1 = (i - 1) * i_src_line_len;        \
                 const int line_idx_2 = i * i_src_line_len;              \
@@ -196,21 +217,33 @@ static void Destroy( vlc_object_t *p_this )
                 p_out[i * i_out_line_len + j] =                         \
                     VLC_CLIP( p_src[line_idx_2 + j] + pix, 0, maxval);  \
             }                                                           \
-            p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
-                p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
+            p_out[i * i_out_line_len + i_visible_width - 1] =           \
+                p_src[i * i_src_line_len + i_visible_width - 1];        \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void SharpenSlice8( void *opaque, unsigned slice, unsigned slices )
 {
-    picture_t *p_outpic;
+    const sharpen_job_t *job = opaque;
+    const int v1 = -1;
+    const int v2 = 3; /* 2^3 = 8 */
+
+    SHARPEN_LINES(255, uint8_t);
+}
+
+static void SharpenSlice16( void *opaque, unsigned slice, unsigned slices )
+{
+    const sharpen_job_t *job = opaque;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
-    const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
-    const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
+
+    SHARPEN_LINES(1023, uint16_t);
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_outpic;
 
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
@@ -219,10 +252,16 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    sharpen_job_t job = {
+        .p_src = &p_pic->p[Y_PLANE],
+        .p_out = &p_outpic->p[Y_PLANE],
+        .sigma = atomic_load(&p_sys->sigma),
+    };
+
     if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
+        filter_RunSlices( p_sys->slices, SharpenSlice8, &job, 0 );
     else
-        SHARPEN_FRAME(1023, uint16_t);
+        filter_RunSlices( p_sys->slices, SharpenSlice16, &job, 0 );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
     plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
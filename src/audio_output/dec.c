@@ -37,6 +37,8 @@
 #include "aout_internal.h"
 #include "libvlc.h"
 
+static void aout_DecResetSync (aout_owner_t *);
+
 /**
  * Creates an audio output
  */
@@ -107,8 +109,7 @@ error:
     }
 
 
-    owner->sync.end = VLC_TS_INVALID;
-    owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
+    aout_DecResetSync (owner);
     owner->sync.discontinuity = true;
     aout_OutputUnlock (p_aout);
 
@@ -168,8 +169,7 @@ static int aout_CheckReady (audio_output_t *aout)
         }
 
         msg_Dbg (aout, "restarting filters...");
-        owner->sync.end = VLC_TS_INVALID;
-        owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
+        aout_DecResetSync (owner);
 
         if (owner->mixer_format.i_format)
         {
@@ -205,12 +205,67 @@ void aout_RequestRestart (audio_output_t *aout, unsigned mode)
  * Buffer management
  */
 
-static void aout_StopResampling (audio_output_t *aout)
+/*
+ * Drift correction (see drift.h)
+ */
+
+/** Period of the drift statistics */
+#define AOUT_SYNC_REPORT_PERIOD (5 * CLOCK_FREQ)
+
+/**
+ * Resets the drift correction, for a new output or new filters.
+ */
+static void aout_DecResetSync (aout_owner_t *owner)
+{
+    owner->sync.end = VLC_TS_INVALID;
+    owner->sync.report = VLC_TS_INVALID;
+    aout_DriftReset (&owner->sync.drift);
+}
+
+/**
+ * Applies a resampling ratio correction.
+ */
+static void aout_DecSetResampling (audio_output_t *aout, double correction)
+{
+    aout_owner_t *owner = aout_owner (aout);
+    int change = aout_DriftResample (&owner->sync.drift, correction,
+                                     owner->input_format.i_rate);
+
+    if (change != 0)
+        aout_FiltersAdjustResampling (owner->filters, change);
+}
+
+/**
+ * Restarts the drift measurement after a discontinuity in the output.
+ * The correction falls back to the estimated clock drift.
+ */
+static void aout_DecUnlockSync (audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    aout_DriftUnlock (&owner->sync.drift);
+    if (aout_FiltersCanResample (owner->filters))
+        aout_DecSetResampling (aout, owner->sync.drift.clock);
+}
+
+static void aout_DecTrackDrift (audio_output_t *aout, mtime_t drift,
+                                mtime_t now)
 {
     aout_owner_t *owner = aout_owner (aout);
+    const aout_drift_t *d = &owner->sync.drift;
 
-    owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
-    aout_FiltersAdjustResampling (owner->filters, 0);
+    aout_DecSetResampling (aout, aout_DriftUpdate (&owner->sync.drift,
+                                                   drift, now));
+
+    if (now >= owner->sync.report)
+    {
+        msg_Dbg (aout, "clock drift: %+.1f ppm, correction: %+.1f ppm "
+                 "(%+d Hz), error: %+.2f ms", d->clock * 1e6,
+                 d->correction * 1e6, d->resampling, d->error * 1e3);
+        var_SetFloat (aout, "clock-drift", d->clock * 1e6);
+        var_SetFloat (aout, "clock-correction", d->correction * 1e6);
+        owner->sync.report = now + AOUT_SYNC_REPORT_PERIOD;
+    }
 }
 
 static void aout_DecSilence (audio_output_t *aout, mtime_t length, mtime_t pts)
@@ -237,13 +292,12 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
                                  int input_rate)
 {
     aout_owner_t *owner = aout_owner (aout);
-    mtime_t drift;
+    mtime_t drift, now;
 
     /**
      * Depending on the drift between the actual and intended playback times,
-     * the audio core may ignore the drift, trigger upsampling or downsampling,
-     * insert silence or even discard samples.
-     * Future VLC versions may instead adjust the input rate.
+     * the audio core adjusts the resampling ratio, inserts silence or even
+     * discards samples.
      *
      * The audio output plugin is responsible for estimating its actual
      * playback time, or rather the estimated time when the next sample will
@@ -257,7 +311,8 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
      */
     if (aout_OutputTimeGet (aout, &drift) != 0)
         return; /* nothing can be done if timing is unknown */
-    drift += mdate () - dec_pts;
+    now = mdate ();
+    drift += now - dec_pts;
 
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
@@ -276,14 +331,15 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
                      "flushing buffers", drift);
         aout_OutputFlush (aout, false);
 
-        aout_StopResampling (aout);
+        aout_DecUnlockSync (aout);
         owner->sync.end = VLC_TS_INVALID;
         owner->sync.discontinuity = true;
 
         /* Now the output might be too early... Recheck. */
         if (aout_OutputTimeGet (aout, &drift) != 0)
             return; /* nothing can be done if timing is unknown */
-        drift += mdate () - dec_pts;
+        now = mdate ();
+        drift += now - dec_pts;
     }
 
     /* Early audio output.
@@ -296,7 +352,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
                       "playing silence", drift);
         aout_DecSilence (aout, -drift, dec_pts);
 
-        aout_StopResampling (aout);
+        aout_DecUnlockSync (aout);
         owner->sync.discontinuity = true;
         drift = 0;
     }
@@ -304,51 +360,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
     if (!aout_FiltersCanResample(owner->filters))
         return;
 
-    /* Resampling */
-    if (drift > +AOUT_MAX_PTS_DELAY
-     && owner->sync.resamp_type != AOUT_RESAMPLING_UP)
-    {
-        msg_Warn (aout, "playback too late (%"PRId64"): up-sampling",
-                  drift);
-        owner->sync.resamp_type = AOUT_RESAMPLING_UP;
-        owner->sync.resamp_start_drift = +drift;
-    }
-    if (drift < -AOUT_MAX_PTS_ADVANCE
-     && owner->sync.resamp_type != AOUT_RESAMPLING_DOWN)
-    {
-        msg_Warn (aout, "playback too early (%"PRId64"): down-sampling",
-                  drift);
-        owner->sync.resamp_type = AOUT_RESAMPLING_DOWN;
-        owner->sync.resamp_start_drift = -drift;
-    }
-
-    if (owner->sync.resamp_type == AOUT_RESAMPLING_NONE)
-        return; /* Everything is fine. Nothing to do. */
-
-    if (llabs (drift) > 2 * owner->sync.resamp_start_drift)
-    {   /* If the drift is ever increasing, then something is seriously wrong.
-         * Cease resampling and hope for the best. */
-        msg_Warn (aout, "timing screwed (drift: %"PRId64" us): "
-                  "stopping resampling", drift);
-        aout_StopResampling (aout);
-        return;
-    }
-
-    /* Resampling has been triggered earlier. This checks if it needs to be
-     * increased or decreased. Resampling rate changes must be kept slow for
-     * the comfort of listeners. */
-    int adj = (owner->sync.resamp_type == AOUT_RESAMPLING_UP) ? +2 : -2;
-
-    if (2 * llabs (drift) <= owner->sync.resamp_start_drift)
-        /* If the drift has been reduced from more than half its initial
-         * value, then it is time to switch back the resampling direction. */
-        adj *= -1;
-
-    if (!aout_FiltersAdjustResampling (owner->filters, adj))
-    {   /* Everything is back to normal: stop resampling. */
-        owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
-        msg_Dbg (aout, "resampling stopped (drift: %"PRId64" us)", drift);
-    }
+    aout_DecTrackDrift (aout, drift, now);
 }
 
 /*****************************************************************************
@@ -441,6 +453,7 @@ void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
         else
             owner->sync.end += date;
     }
+    aout_DriftUnlock (&owner->sync.drift);
     if (owner->mixer_format.i_format)
         aout_OutputPause (aout, paused, date);
     aout_OutputUnlock (aout);
@@ -452,6 +465,7 @@ void aout_DecFlush (audio_output_t *aout, bool wait)
 
     aout_OutputLock (aout);
     owner->sync.end = VLC_TS_INVALID;
+    aout_DriftUnlock (&owner->sync.drift);
     if (owner->mixer_format.i_format)
     {
         if (wait)
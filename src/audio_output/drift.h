@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * drift.h : audio output clock drift correction loop
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_AOUT_DRIFT_H
+# define LIBVLC_AOUT_DRIFT_H 1
+
+# include <math.h>
+
+/*
+ * The drift between the output clock and the input clock is corrected by a
+ * phase-locked loop: a proportional-integral controller turns the (filtered)
+ * drift into a resampling ratio. Once locked, the integral term converges to
+ * the frequency error of the output clock, so the resampling follows it
+ * smoothly instead of swinging between up- and down-sampling.
+ *
+ * test/src/audio_output/drift.c simulates the loop against a drifting output.
+ */
+
+/** Proportional gain (per second) */
+# define AOUT_SYNC_KP 0.2
+/** Integral gain (per second squared), for a damping ratio of 0.7 */
+# define AOUT_SYNC_KI 0.02
+/** Time constant of the drift measurement filter (seconds) */
+# define AOUT_SYNC_SMOOTHING 0.5
+/** Drift below which the loop is locked and the clock estimate updated
+ * (larger drifts are left to the proportional term, avoiding wind-up) */
+# define AOUT_SYNC_LOCK_RANGE 0.01
+/** Maximum estimated clock drift (ratio) */
+# define AOUT_SYNC_MAX_CLOCK 0.001
+/** Maximum resampling correction (ratio) */
+# define AOUT_SYNC_MAX_CORRECTION 0.01
+
+typedef struct
+{
+    mtime_t date; /**< Date of the last drift measurement */
+    double error; /**< Filtered drift (seconds) */
+    double clock; /**< Estimated output clock drift (ratio) */
+    double correction; /**< Resampling ratio correction */
+    double dither; /**< Resampling (Hz) left over to the next buffer */
+    int resampling; /**< Resampling applied (Hz) */
+} aout_drift_t;
+
+/**
+ * Resets the loop, for a new output or new filters.
+ */
+static inline void aout_DriftReset (aout_drift_t *d)
+{
+    d->date = VLC_TS_INVALID;
+    d->error = 0.;
+    d->clock = 0.;
+    d->correction = 0.;
+    d->dither = 0.;
+    d->resampling = 0;
+}
+
+/**
+ * Restarts the drift measurement after a discontinuity in the output.
+ * The clock estimate is kept.
+ */
+static inline void aout_DriftUnlock (aout_drift_t *d)
+{
+    d->date = VLC_TS_INVALID;
+    d->error = 0.;
+}
+
+/**
+ * Feeds a drift measurement to the loop.
+ *
+ * \param drift how late the output plays (negative if early)
+ * \param now date of the measurement
+ * \return the resampling ratio correction to apply
+ */
+static inline double aout_DriftUpdate (aout_drift_t *d, mtime_t drift,
+                                       mtime_t now)
+{
+    const double error = (double)drift / CLOCK_FREQ;
+
+    if (d->date == VLC_TS_INVALID)
+        d->error = error;
+    else
+    {
+        /* Output delay reports are coarse: low-pass filter them */
+        double dt = (double)(now - d->date) / CLOCK_FREQ;
+
+        d->error += (error - d->error) * dt / (AOUT_SYNC_SMOOTHING + dt);
+
+        if (fabs (d->error) < AOUT_SYNC_LOCK_RANGE)
+        {
+            double clock = d->clock + AOUT_SYNC_KI * d->error * dt;
+
+            d->clock = VLC_CLIP(clock, -AOUT_SYNC_MAX_CLOCK,
+                                AOUT_SYNC_MAX_CLOCK);
+        }
+    }
+    d->date = now;
+
+    double correction = AOUT_SYNC_KP * d->error + d->clock;
+
+    return VLC_CLIP(correction, -AOUT_SYNC_MAX_CORRECTION,
+                    AOUT_SYNC_MAX_CORRECTION);
+}
+
+/**
+ * Converts a resampling ratio correction to a whole rate. The remainder is
+ * carried over to the next buffers: on average, the correction is exact.
+ *
+ * \param rate input sample rate
+ * \return the change of the resampling (Hz) to apply
+ */
+static inline int aout_DriftResample (aout_drift_t *d, double correction,
+                                      unsigned rate)
+{
+    double hz = correction * rate + d->dither;
+    int resampling = lround (hz);
+    int change = resampling - d->resampling;
+
+    d->correction = correction;
+    d->dither = hz - resampling;
+    d->resampling = resampling;
+    return change;
+}
+
+#endif /* !LIBVLC_AOUT_DRIFT_H */
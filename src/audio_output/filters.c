@@ -41,6 +41,7 @@
 
 #include <libvlc.h>
 #include "aout_internal.h"
+#include "../misc/block_pool.h"
 
 static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
                                const char *name, filter_owner_sys_t *owner,
@@ -343,9 +344,21 @@ static void aout_FiltersPipelineChangeViewpoint(filter_t *const *filters,
 }
 
 #define AOUT_MAX_FILTERS 10
+/* Buffers kept for the outputs of the filters, enough for a few buffers
+ * queued in the output for each filter */
+#define AOUT_FILTERS_POOL_SIZE 32
+
+struct aout_filter_owner
+{
+    const aout_request_vout_t *request_vout;
+    block_pool_t *pool;
+};
 
 struct aout_filters
 {
+    vlc_object_t *obj;
+    struct aout_filter_owner owner;
+
     filter_t *rate_filter; /**< The filter adjusting samples count
         (either the scaletempo filter or a resampler) */
     filter_t *resampler; /**< The resampler */
@@ -390,7 +403,8 @@ vout_thread_t *aout_filter_RequestVout (filter_t *filter, vout_thread_t *vout,
      * If you want to use visualization filters from another place, you will
      * need to add a new pf_aout_request_vout callback or store a pointer
      * to aout_request_vout_t inside filter_t (i.e. a level of indirection). */
-    const aout_request_vout_t *req = filter->owner.sys;
+    const struct aout_filter_owner *owner = filter->owner.sys;
+    const aout_request_vout_t *req = owner->request_vout;
     char *visual = var_InheritString (filter->obj.parent, "audio-visual");
     /* NOTE: Disable recycling to always close the filter vout because OpenGL
      * visualizations do not use this function to ask for a context. */
@@ -484,6 +498,33 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
     return ret;
 }
 
+static block_t *aout_FilterNewBuffer (filter_t *filter, size_t size)
+{
+    const struct aout_filter_owner *owner = filter->owner.sys;
+
+    return block_pool_Alloc (owner->pool, size);
+}
+
+/**
+ * Lets the filters take their output buffers from the pool of the chain.
+ */
+static void aout_FiltersSetOwner (aout_filters_t *filters)
+{
+    if (filters->owner.pool == NULL)
+        return;
+
+    for (unsigned i = 0; i < filters->count; i++)
+    {
+        filters->tab[i]->owner.sys = &filters->owner;
+        filters->tab[i]->owner.audio.buffer_new = aout_FilterNewBuffer;
+    }
+    if (filters->resampler != NULL)
+    {
+        filters->resampler->owner.sys = &filters->owner;
+        filters->resampler->owner.audio.buffer_new = aout_FilterNewBuffer;
+    }
+}
+
 #undef aout_FiltersNew
 /**
  * Sets a chain of audio filters up.
@@ -510,6 +551,9 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (unlikely(filters == NULL))
         return NULL;
 
+    filters->obj = obj;
+    filters->owner.request_vout = request_vout;
+    filters->owner.pool = block_pool_New(AOUT_FILTERS_POOL_SIZE);
     filters->rate_filter = NULL;
     filters->resampler = NULL;
     filters->resampling = 0;
@@ -537,6 +581,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
             }
             filters->count++;
         }
+        aout_FiltersSetOwner(filters);
         return filters;
     }
     if (aout_FormatNbChannels(outfmt) == 0)
@@ -626,7 +671,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         char *visual = var_InheritString (obj, "audio-visual");
         if (visual != NULL && strcasecmp (visual, "none"))
             AppendFilter(obj, "visualization", visual, filters,
-                         request_vout, &input_format, &output_format, NULL);
+                         &filters->owner, &input_format, &output_format, NULL);
         free (visual);
     }
 
@@ -653,12 +698,15 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (filters->rate_filter == NULL)
         filters->rate_filter = filters->resampler;
 
+    aout_FiltersSetOwner(filters);
     return filters;
 
 error:
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (request_vout != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    if (filters->owner.pool != NULL)
+        block_pool_Release (filters->owner.pool);
     free (filters);
     return NULL;
 }
@@ -679,6 +727,16 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (obj != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    if (filters->owner.pool != NULL)
+    {
+        block_pool_stats_t stats;
+
+        block_pool_GetStats (filters->owner.pool, &stats);
+        if (stats.allocated + stats.recycled > 0)
+            msg_Dbg (filters->obj, "filter buffers: %lu allocated, "
+                     "%lu recycled", stats.allocated, stats.recycled);
+        block_pool_Release (filters->owner.pool);
+    }
     free (filters);
 }
 
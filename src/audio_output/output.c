@@ -252,6 +252,10 @@ audio_output_t *aout_New (vlc_object_t *parent)
     var_Create (aout, "module-name", VLC_VAR_STRING);
     var_SetString (aout, "module-name", module_get_object(owner->module));
 
+    /* Drift correction statistics (in parts per million) */
+    var_Create (aout, "clock-drift", VLC_VAR_FLOAT);
+    var_Create (aout, "clock-correction", VLC_VAR_FLOAT);
+
     /*
      * Persistent audio output variables
      */
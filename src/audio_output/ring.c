@@ -0,0 +1,288 @@
+/*****************************************************************************
+ * ring.c : lock-free ring buffer for pull model audio outputs
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_atomic.h>
+
+/*
+ * Single producer, single consumer queue of frames. The positions are frame
+ * counters that wrap around; only the producer writes the write and flush
+ * positions, and only the consumer the read position.
+ *
+ * A flush moves the flush position to the write position. Both sides then
+ * consider the frames before it as read, so that the producer does not have
+ * to wait for the consumer. As the producer may overwrite them while they are
+ * being read, the consumer checks the flush position again after copying
+ * (like a sequence lock), and outputs silence if it changed.
+ */
+struct aout_ring
+{
+    atomic_size_t write;
+    atomic_size_t flush;
+    char pad[64]; /* keep the consumer position on another cache line */
+    atomic_size_t read;
+    atomic_bool paused;
+
+    size_t mask; /* capacity - 1, in frames */
+    unsigned frame_size;
+    unsigned channels;
+    unsigned sample_size;
+    int silence;
+    bool locked;
+    uint8_t *buf;
+};
+
+/* Whether position a is after position b */
+static inline bool After(size_t a, size_t b)
+{
+    return (ssize_t)(a - b) > 0;
+}
+
+aout_ring_t *aout_RingNew(const audio_sample_format_t *fmt, mtime_t duration)
+{
+    assert(AOUT_FMT_LINEAR(fmt));
+
+    if (fmt->i_bytes_per_frame == 0 || fmt->i_channels == 0
+     || fmt->i_bytes_per_frame % fmt->i_channels != 0 || duration <= 0)
+        return NULL;
+
+    uint64_t frames = (uint64_t)duration * fmt->i_rate / CLOCK_FREQ;
+    size_t capacity = 64;
+
+    while (capacity < frames)
+    {
+        if (capacity > SIZE_MAX / 2 / fmt->i_bytes_per_frame)
+            return NULL;
+        capacity *= 2;
+    }
+
+    aout_ring_t *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->buf = malloc(capacity * fmt->i_bytes_per_frame);
+    if (unlikely(ring->buf == NULL))
+    {
+        free(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->write, 0);
+    atomic_init(&ring->flush, 0);
+    atomic_init(&ring->read, 0);
+    atomic_init(&ring->paused, false);
+    ring->mask = capacity - 1;
+    ring->frame_size = fmt->i_bytes_per_frame;
+    ring->channels = fmt->i_channels;
+    ring->sample_size = fmt->i_bytes_per_frame / fmt->i_channels;
+    ring->silence = fmt->i_format == VLC_CODEC_U8 ? 0x80 : 0;
+    /* Touch the pages now rather than from the realtime callback, and keep
+     * them in memory if allowed */
+    memset(ring->buf, ring->silence, capacity * ring->frame_size);
+#ifdef HAVE_MMAP
+    ring->locked = mlock(ring->buf, capacity * ring->frame_size) == 0;
+#else
+    ring->locked = false;
+#endif
+    return ring;
+}
+
+void aout_RingDelete(aout_ring_t *ring)
+{
+#ifdef HAVE_MMAP
+    if (ring->locked)
+        munlock(ring->buf, (ring->mask + 1) * ring->frame_size);
+#endif
+    free(ring->buf);
+    free(ring);
+}
+
+size_t aout_RingPlay(aout_ring_t *ring, block_t *block)
+{
+    const size_t capacity = ring->mask + 1;
+    size_t w = atomic_load_explicit(&ring->write, memory_order_relaxed);
+    size_t r = atomic_load_explicit(&ring->read, memory_order_acquire);
+    size_t f = atomic_load_explicit(&ring->flush, memory_order_relaxed);
+
+    if (After(f, r))
+        r = f;
+
+    const size_t frames = block->i_buffer / ring->frame_size;
+    const size_t count = __MIN(frames, capacity - (w - r));
+    const uint8_t *src = block->p_buffer;
+
+    for (size_t done = 0; done < count;)
+    {
+        const size_t offset = (w + done) & ring->mask;
+        const size_t n = __MIN(count - done, capacity - offset);
+
+        memcpy(ring->buf + offset * ring->frame_size,
+               src + done * ring->frame_size, n * ring->frame_size);
+        done += n;
+    }
+
+    atomic_store_explicit(&ring->write, w + count, memory_order_release);
+    block_Release(block);
+    return frames - count;
+}
+
+void aout_RingFlush(aout_ring_t *ring)
+{
+    size_t w = atomic_load_explicit(&ring->write, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->flush, w, memory_order_relaxed);
+    /* Like a sequence lock writer: the data of the next aout_RingPlay()
+     * calls must not become visible before the new flush position */
+    atomic_thread_fence(memory_order_release);
+}
+
+void aout_RingPause(aout_ring_t *ring, bool paused)
+{
+    atomic_store_explicit(&ring->paused, paused, memory_order_relaxed);
+}
+
+size_t aout_RingCount(aout_ring_t *ring)
+{
+    size_t f = atomic_load_explicit(&ring->flush, memory_order_acquire);
+    size_t r = atomic_load_explicit(&ring->read, memory_order_acquire);
+    size_t w = atomic_load_explicit(&ring->write, memory_order_acquire);
+
+    if (After(f, r))
+        r = f;
+    return After(w, r) ? w - r : 0;
+}
+
+/* Copies frames out of the ring, to the frame offset done of the output */
+typedef void (*ring_copy_t)(const aout_ring_t *, void *dst, size_t done,
+                            const uint8_t *src, size_t frames);
+
+static void CopyInterleaved(const aout_ring_t *ring, void *dst, size_t done,
+                            const uint8_t *src, size_t frames)
+{
+    memcpy((uint8_t *)dst + done * ring->frame_size, src,
+           frames * ring->frame_size);
+}
+
+static void CopyPlanar(const aout_ring_t *ring, void *dst, size_t done,
+                       const uint8_t *src, size_t frames)
+{
+    void *const *planes = dst;
+    const unsigned size = ring->sample_size;
+
+    for (unsigned c = 0; c < ring->channels; c++)
+    {
+        uint8_t *p = (uint8_t *)planes[c] + done * size;
+        const uint8_t *s = src + c * size;
+
+        if (size == 4) /* constant size copies for float samples */
+            for (size_t i = 0; i < frames; i++)
+                memcpy(p + 4 * i, s + i * ring->frame_size, 4);
+        else
+            for (size_t i = 0; i < frames; i++)
+                memcpy(p + i * size, s + i * ring->frame_size, size);
+    }
+}
+
+static void Silence(const aout_ring_t *ring, void *dst, bool planar,
+                    size_t from, size_t frames)
+{
+    if (frames == 0)
+        return;
+
+    if (planar)
+    {
+        void *const *planes = dst;
+        for (unsigned c = 0; c < ring->channels; c++)
+            memset((uint8_t *)planes[c] + from * ring->sample_size,
+                   ring->silence, frames * ring->sample_size);
+    }
+    else
+        memset((uint8_t *)dst + from * ring->frame_size, ring->silence,
+               frames * ring->frame_size);
+}
+
+static size_t Read(aout_ring_t *ring, void *dst, bool planar, size_t frames)
+{
+    const ring_copy_t copy = planar ? CopyPlanar : CopyInterleaved;
+    const size_t capacity = ring->mask + 1;
+
+    if (atomic_load_explicit(&ring->paused, memory_order_relaxed))
+    {
+        Silence(ring, dst, planar, 0, frames);
+        return 0;
+    }
+
+    size_t w = atomic_load_explicit(&ring->write, memory_order_acquire);
+    size_t f = atomic_load_explicit(&ring->flush, memory_order_acquire);
+    size_t r = atomic_load_explicit(&ring->read, memory_order_relaxed);
+
+    if (After(f, r))
+        r = f;
+
+    size_t count = After(w, r) ? __MIN(frames, w - r) : 0;
+
+    for (size_t done = 0; done < count;)
+    {
+        const size_t offset = (r + done) & ring->mask;
+        const size_t n = __MIN(count - done, capacity - offset);
+
+        copy(ring, dst, done, ring->buf + offset * ring->frame_size, n);
+        done += n;
+    }
+
+    /* Check that the frames were not flushed (and overwritten) meanwhile */
+    atomic_thread_fence(memory_order_acquire);
+    size_t f2 = atomic_load_explicit(&ring->flush, memory_order_relaxed);
+    if (f2 != f)
+    {
+        count = 0;
+        r = f2;
+    }
+    else
+        r += count;
+
+    atomic_store_explicit(&ring->read, r, memory_order_release);
+    Silence(ring, dst, planar, count, frames - count);
+    return count;
+}
+
+size_t aout_RingRead(aout_ring_t *ring, void *buf, size_t frames)
+{
+    return Read(ring, buf, false, frames);
+}
+
+size_t aout_RingReadPlanar(aout_ring_t *ring, void *const *planes,
+                           size_t frames)
+{
+    return Read(ring, (void *)planes, true, frames);
+}
@@ -52,6 +52,10 @@
 #include "resource.h"
 
 #include "../video_output/vout_control.h"
+#include "../misc/block_pool.h"
+
+/* Audio buffers kept for reuse, enough for those queued in the output */
+#define DECODER_AUDIO_POOL_SIZE 32
 
 /*
  * Possibles values set in p_owner->reload atomic
@@ -88,6 +92,9 @@ struct decoder_owner_sys_t
     /* Current format in use by the output */
     es_format_t    fmt;
 
+    /* Recycled audio output buffers */
+    block_pool_t  *p_audio_pool;
+
     /* */
     bool           b_fmt_description;
     vlc_meta_t     *p_description;
@@ -402,6 +409,13 @@ static int aout_update_format( decoder_t *p_dec )
     return 0;
 }
 
+static block_t *aout_new_buffer( decoder_t *p_dec, size_t i_size )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    return block_pool_Alloc( p_owner->p_audio_pool, i_size );
+}
+
 static int vout_update_format( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -653,7 +667,9 @@ block_t *decoder_NewAudioBuffer( decoder_t *dec, int samples )
 
     size_t length = samples * dec->fmt_out.audio.i_bytes_per_frame
                             / dec->fmt_out.audio.i_frame_length;
-    block_t *block = block_Alloc( length );
+    block_t *block = dec->pf_aout_buffer_new != NULL
+                   ? dec->pf_aout_buffer_new( dec, length )
+                   : block_Alloc( length );
     if( likely(block != NULL) )
     {
         block->i_nb_samples = samples;
@@ -1716,6 +1732,13 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     /* Set buffers allocation callbacks for the decoders */
     p_dec->pf_aout_format_update = aout_update_format;
     p_dec->pf_vout_format_update = vout_update_format;
+    p_owner->p_audio_pool = NULL;
+    if( fmt->i_cat == AUDIO_ES && p_sout == NULL )
+    {
+        p_owner->p_audio_pool = block_pool_New( DECODER_AUDIO_POOL_SIZE );
+        if( p_owner->p_audio_pool != NULL )
+            p_dec->pf_aout_buffer_new = aout_new_buffer;
+    }
     p_dec->pf_vout_buffer_new = vout_new_buffer;
     p_dec->pf_spu_buffer_new  = spu_new_buffer;
     /* */
@@ -1843,6 +1866,16 @@ static void DeleteDecoder( decoder_t * p_dec )
         sout_InputDelete( p_owner->p_sout_input );
     }
 #endif
+    if( p_owner->p_audio_pool != NULL )
+    {
+        block_pool_stats_t stats;
+
+        block_pool_GetStats( p_owner->p_audio_pool, &stats );
+        if( stats.allocated + stats.recycled > 0 )
+            msg_Dbg( p_dec, "audio buffers: %lu allocated, %lu recycled",
+                     stats.allocated, stats.recycled );
+        block_pool_Release( p_owner->p_audio_pool );
+    }
     es_format_Clean( &p_owner->fmt );
 
     if( b_flush_spu )
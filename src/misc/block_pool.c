@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * block_pool.c: recycling of block buffers
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "block_pool.h"
+
+/* Same layout as block_Alloc() */
+#define BLOCK_POOL_ALIGN   32
+#define BLOCK_POOL_PADDING 32
+/* Buffer sizes are rounded up so that close sizes share buffers */
+#define BLOCK_POOL_GRANULARITY 4096
+
+struct block_pool
+{
+    vlc_mutex_t lock;
+    block_t    *free;     /**< released blocks, linked through p_next */
+    unsigned    free_count;
+    unsigned    max;
+    unsigned    refs;     /**< owner and blocks in use */
+    bool        released; /**< the owner released the pool */
+
+    unsigned long allocated;
+    unsigned long recycled;
+};
+
+typedef struct
+{
+    block_t       self;
+    block_pool_t *pool;
+    size_t        capacity; /**< largest payload size */
+} block_pool_block_t;
+
+static void block_pool_Destroy(block_pool_t *pool)
+{
+    while (pool->free != NULL)
+    {
+        block_t *block = pool->free;
+
+        pool->free = block->p_next;
+        free(block);
+    }
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/* Sets the block up for a payload of the given size */
+static void block_pool_Reset(block_pool_block_t *pb, size_t size)
+{
+    block_t *block = &pb->self;
+
+    block_Init(block, pb + 1, BLOCK_POOL_ALIGN + 2 * BLOCK_POOL_PADDING
+                              + pb->capacity);
+    block->p_buffer += BLOCK_POOL_PADDING + BLOCK_POOL_ALIGN - 1;
+    block->p_buffer = (void *)(((uintptr_t)block->p_buffer)
+                               & ~(BLOCK_POOL_ALIGN - 1));
+    block->i_buffer = size;
+}
+
+static void block_pool_BlockRelease(block_t *block)
+{
+    block_pool_block_t *pb = (block_pool_block_t *)block;
+    block_pool_t *pool = pb->pool;
+    bool destroy;
+
+    vlc_mutex_lock(&pool->lock);
+    if (!pool->released && pool->free_count < pool->max)
+    {
+        block->p_next = pool->free;
+        pool->free = block;
+        pool->free_count++;
+        block = NULL;
+    }
+    assert(pool->refs > 1 || pool->released);
+    destroy = --pool->refs == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    free(block);
+    if (destroy)
+        block_pool_Destroy(pool);
+}
+
+block_pool_t *block_pool_New(unsigned max)
+{
+    block_pool_t *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    pool->free = NULL;
+    pool->free_count = 0;
+    pool->max = max;
+    pool->refs = 1;
+    pool->released = false;
+    pool->allocated = 0;
+    pool->recycled = 0;
+    return pool;
+}
+
+void block_pool_Release(block_pool_t *pool)
+{
+    block_t *cached;
+    bool destroy;
+
+    vlc_mutex_lock(&pool->lock);
+    assert(!pool->released);
+    pool->released = true;
+    cached = pool->free;
+    pool->free = NULL;
+    pool->free_count = 0;
+    destroy = --pool->refs == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    while (cached != NULL)
+    {
+        block_t *next = cached->p_next;
+
+        free(cached);
+        cached = next;
+    }
+    if (destroy)
+        block_pool_Destroy(pool);
+}
+
+block_t *block_pool_Alloc(block_pool_t *pool, size_t size)
+{
+    block_pool_block_t *pb = NULL;
+
+    if (unlikely(size >> 27))
+        return NULL;
+
+    vlc_mutex_lock(&pool->lock);
+    for (block_t **pp = &pool->free; *pp != NULL; pp = &(*pp)->p_next)
+    {
+        block_pool_block_t *cached = (block_pool_block_t *)*pp;
+
+        if (cached->capacity >= size)
+        {
+            *pp = cached->self.p_next;
+            pool->free_count--;
+            pool->recycled++;
+            pb = cached;
+            break;
+        }
+    }
+    if (pb == NULL)
+        pool->allocated++;
+    pool->refs++;
+    vlc_mutex_unlock(&pool->lock);
+
+    if (pb == NULL)
+    {
+        const size_t capacity = (size + BLOCK_POOL_GRANULARITY - 1)
+                              & ~(size_t)(BLOCK_POOL_GRANULARITY - 1);
+
+        pb = malloc(sizeof (*pb) + BLOCK_POOL_ALIGN + 2 * BLOCK_POOL_PADDING
+                    + capacity);
+        if (unlikely(pb == NULL))
+        {
+            vlc_mutex_lock(&pool->lock);
+            bool destroy = --pool->refs == 0;
+            vlc_mutex_unlock(&pool->lock);
+            if (destroy)
+                block_pool_Destroy(pool);
+            return NULL;
+        }
+        pb->pool = pool;
+        pb->capacity = capacity;
+    }
+
+    block_pool_Reset(pb, size);
+    pb->self.pf_release = block_pool_BlockRelease;
+    return &pb->self;
+}
+
+void block_pool_GetStats(block_pool_t *pool, block_pool_stats_t *stats)
+{
+    vlc_mutex_lock(&pool->lock);
+    stats->allocated = pool->allocated;
+    stats->recycled = pool->recycled;
+    stats->cached = pool->free_count;
+    vlc_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * block_pool.h: recycling of block buffers
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_BLOCK_POOL_H
+#define LIBVLC_BLOCK_POOL_H 1
+
+#include <vlc_block.h>
+
+/**
+ * A block pool keeps the buffers of the blocks it allocated when they are
+ * released, and hands them out again for requests of the same or a smaller
+ * size. Blocks can be released from any thread, and may outlive the pool
+ * owner: the pool is destroyed once its owner and all its blocks have
+ * released it.
+ */
+typedef struct block_pool block_pool_t;
+
+typedef struct
+{
+    unsigned long allocated; /**< blocks allocated from the heap */
+    unsigned long recycled;  /**< blocks handed out again */
+    unsigned      cached;    /**< blocks kept for reuse */
+} block_pool_stats_t;
+
+/**
+ * Creates a pool keeping up to max released blocks.
+ */
+block_pool_t *block_pool_New(unsigned max);
+
+/**
+ * Releases the owner reference of the pool. Cached buffers are freed, and
+ * blocks still in use are freed on release.
+ */
+void block_pool_Release(block_pool_t *);
+
+/**
+ * Gets a block of the given payload size.
+ * \return a block to release with block_Release(), or NULL on error
+ */
+block_t *block_pool_Alloc(block_pool_t *, size_t size);
+
+void block_pool_GetStats(block_pool_t *, block_pool_stats_t *);
+
+#endif
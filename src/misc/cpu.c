@@ -135,13 +135,13 @@ static void vlc_CPU_init(void)
                    "cpuid\n\t" \
                    "xchgl %%ebx,%1\n\t" \
                    : "=a" (i_eax), "=r" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # else
 #  define cpuid(reg) \
      asm volatile ("cpuid\n\t" \
                    : "=a" (i_eax), "=b" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # endif
      /* Check if the OS really supports the requested instructions */
@@ -171,6 +171,7 @@ static void vlc_CPU_init(void)
 
     /* the CPU supports the CPUID instruction - get its level */
     cpuid( 0x00000000 );
+    const unsigned i_level = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -209,6 +210,24 @@ static void vlc_CPU_init(void)
             i_capabilities |= VLC_CPU_SSE4_1;
         if (i_ecx & 0x00100000)
             i_capabilities |= VLC_CPU_SSE4_2;
+
+        /* AVX needs the OS to save the YMM registers (OSXSAVE + XCR0) */
+        if ((i_ecx & 0x18000000) == 0x18000000)
+        {
+            uint32_t xcr0, xcr0_hi;
+            asm volatile (".byte 0x0f, 0x01, 0xd0\n\t" /* xgetbv */
+                          : "=a" (xcr0), "=d" (xcr0_hi) : "c" (0));
+            if ((xcr0 & 0x6) == 0x6)
+            {
+                i_capabilities |= VLC_CPU_AVX;
+                if (i_level >= 7)
+                {
+                    cpuid( 0x00000007 );
+                    if (i_ebx & 0x00000020)
+                        i_capabilities |= VLC_CPU_AVX2;
+                }
+            }
+        }
     }
 
     /* test for additional capabilities */
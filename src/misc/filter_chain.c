@@ -28,6 +28,7 @@
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
+#include <vlc_picture_pool.h>
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
@@ -40,8 +41,18 @@ typedef struct chained_filter_t
     struct chained_filter_t *prev, *next;
     vlc_mouse_t *mouse;
     picture_t *pending;
+    /* Output pictures of intermediate filters */
+    picture_pool_t *pool;
+    video_format_t pool_fmt;
+    unsigned pool_size;
 } chained_filter_t;
 
+/* Initial and maximum number of pictures in the pool of an intermediate
+ * filter. The pool grows if the next filters hold more pictures, and the
+ * pictures are allocated from the heap beyond the maximum. */
+#define CHAIN_POOL_MIN 3
+#define CHAIN_POOL_MAX 16
+
 /* Only use this with filter objects from _this_ C module */
 static inline chained_filter_t *chained(filter_t *filter)
 {
@@ -67,6 +78,8 @@ struct filter_chain_t
  * Local prototypes
  */
 static void FilterDeletePictures( picture_t * );
+static void FilterPoolDelete( chained_filter_t * );
+static int FilterPoolNew( chained_filter_t *, unsigned );
 
 static filter_chain_t *filter_chain_NewInner( const filter_owner_t *callbacks,
     const char *cap, const char *conv_cap, bool fmt_out_change,
@@ -106,12 +119,41 @@ filter_chain_t *filter_chain_New( vlc_object_t *obj, const char *cap,
     return filter_chain_NewInner( &callbacks, cap, NULL, false, NULL, cat );
 }
 
+/** Gets an output picture from the pool of an intermediate filter */
+static picture_t *FilterPoolGet( chained_filter_t *chained )
+{
+    const video_format_t *fmt = &chained->filter.fmt_out.video;
+
+    if( chained->pool != NULL
+     && !video_format_IsSimilar( &chained->pool_fmt, fmt ) )
+        FilterPoolDelete( chained );
+
+    if( chained->pool == NULL
+     && FilterPoolNew( chained, __MAX(chained->pool_size, CHAIN_POOL_MIN) ) )
+        return NULL;
+
+    picture_t *pic = picture_pool_Get( chained->pool );
+    if( pic == NULL && chained->pool_size < CHAIN_POOL_MAX )
+    {
+        /* All the pictures are held downstream: use a larger pool. The
+         * pictures of the current one are freed as they are released. */
+        unsigned size = __MIN(chained->pool_size + 2, CHAIN_POOL_MAX);
+
+        msg_Dbg( &chained->filter, "growing picture pool to %u", size );
+        if( FilterPoolNew( chained, size ) == VLC_SUCCESS )
+            pic = picture_pool_Get( chained->pool );
+    }
+    return pic;
+}
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
     if( chained(filter)->next != NULL )
     {
-        picture_t *pic = picture_NewFromFormat( &filter->fmt_out.video );
+        picture_t *pic = FilterPoolGet( chained(filter) );
+        if( pic == NULL )
+            pic = picture_NewFromFormat( &filter->fmt_out.video );
         if( pic == NULL )
             msg_Err( filter, "Failed to allocate picture" );
         return pic;
@@ -231,13 +273,21 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
         es_format_Copy( &chain->fmt_out, &filter->fmt_out );
     }
 
+    chained->pool = NULL;
+    chained->pool_size = 0;
+
     if( chain->last == NULL )
     {
         assert( chain->first == NULL );
         chain->first = chained;
     }
     else
+    {
         chain->last->next = chained;
+        /* The previous filter now outputs intermediate pictures */
+        if( chain->callbacks.video.buffer_new == filter_chain_VideoBufferNew )
+            FilterPoolNew( chain->last, CHAIN_POOL_MIN );
+    }
     chained->prev = chain->last;
     chain->last = chained;
     chained->next = NULL;
@@ -299,12 +349,16 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
     {
         assert( chained == chain->last );
         chain->last = chained->prev;
+        /* The new last filter outputs to the chain owner */
+        if( chain->last != NULL )
+            FilterPoolDelete( chain->last );
     }
 
     module_unneed( filter, filter->p_module );
 
     msg_Dbg( obj, "Filter %p removed from chain", (void *)filter );
     FilterDeletePictures( chained->pending );
+    FilterPoolDelete( chained );
 
     free( chained->mouse );
     es_format_Clean( &filter->fmt_out );
@@ -518,6 +572,34 @@ int filter_chain_MouseEvent( filter_chain_t *p_chain,
 }
 
 /* Helpers */
+static void FilterPoolDelete( chained_filter_t *chained )
+{
+    if( chained->pool == NULL )
+        return;
+
+    /* Pictures still in use are freed when they are released */
+    picture_pool_Release( chained->pool );
+    video_format_Clean( &chained->pool_fmt );
+    chained->pool = NULL;
+}
+
+static int FilterPoolNew( chained_filter_t *chained, unsigned size )
+{
+    const video_format_t *fmt = &chained->filter.fmt_out.video;
+
+    FilterPoolDelete( chained );
+    chained->pool_size = size;
+
+    if( fmt->i_chroma == 0 || fmt->i_width == 0 || fmt->i_height == 0 )
+        return VLC_EGENERIC;
+
+    chained->pool = picture_pool_NewFromFormat( fmt, size );
+    if( chained->pool == NULL )
+        return VLC_ENOMEM;
+    video_format_Copy( &chained->pool_fmt, fmt );
+    return VLC_SUCCESS;
+}
+
 static void FilterDeletePictures( picture_t *picture )
 {
     while( picture )
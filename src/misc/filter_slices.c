@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * filter_slices.c : slice-parallel processing for video filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+
+#define SLICES_MAX_THREADS 16
+
+struct filter_slices_t
+{
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;    /* new job or quit, for workers */
+    vlc_cond_t      done;    /* all bands of the job finished */
+
+    /* current job */
+    filter_slice_cb cb;
+    void           *opaque;
+    unsigned        slices;
+    unsigned        next;    /* next band to process */
+    unsigned        pending; /* bands not finished yet */
+
+    bool            quit;
+    unsigned        threads;
+    vlc_thread_t    thread[];
+};
+
+/* Processes bands until there is none left. Called with the lock held. */
+static void RunBands( filter_slices_t *pool )
+{
+    while( pool->next < pool->slices )
+    {
+        const unsigned slice = pool->next++;
+        filter_slice_cb cb = pool->cb;
+        void *opaque = pool->opaque;
+        const unsigned slices = pool->slices;
+
+        vlc_mutex_unlock( &pool->lock );
+        cb( opaque, slice, slices );
+        vlc_mutex_lock( &pool->lock );
+
+        assert( pool->pending > 0 );
+        if( --pool->pending == 0 )
+            vlc_cond_signal( &pool->done );
+    }
+}
+
+static void *Thread( void *data )
+{
+    filter_slices_t *pool = data;
+
+    vlc_mutex_lock( &pool->lock );
+    while( !pool->quit )
+    {
+        if( pool->next < pool->slices )
+            RunBands( pool );
+        else
+            vlc_cond_wait( &pool->wait, &pool->lock );
+    }
+    vlc_mutex_unlock( &pool->lock );
+    return NULL;
+}
+
+#undef filter_NewSlices
+filter_slices_t *filter_NewSlices( vlc_object_t *obj, unsigned threads )
+{
+    unsigned cpus = vlc_GetCPUCount();
+    if( threads == 0 || threads > cpus )
+        threads = cpus;
+    if( threads > SLICES_MAX_THREADS )
+        threads = SLICES_MAX_THREADS;
+    /* the caller processes bands too */
+    if( threads > 0 )
+        threads--;
+
+    filter_slices_t *pool = malloc( sizeof(*pool)
+                                    + threads * sizeof(pool->thread[0]) );
+    if( unlikely(pool == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &pool->lock );
+    vlc_cond_init( &pool->wait );
+    vlc_cond_init( &pool->done );
+    pool->cb = NULL;
+    pool->opaque = NULL;
+    pool->slices = 0;
+    pool->next = 0;
+    pool->pending = 0;
+    pool->quit = false;
+    pool->threads = 0;
+
+    for( unsigned i = 0; i < threads; i++ )
+    {
+        if( vlc_clone( &pool->thread[i], Thread, pool,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            msg_Warn( obj, "cannot start filter thread %u", i );
+            break;
+        }
+        pool->threads++;
+    }
+
+    msg_Dbg( obj, "using %u threads for slice processing", pool->threads + 1 );
+    return pool;
+}
+
+void filter_RunSlices( filter_slices_t *pool, filter_slice_cb cb,
+                       void *opaque, unsigned slices )
+{
+    if( pool == NULL )
+    {
+        if( slices == 0 )
+            slices = 1;
+        for( unsigned i = 0; i < slices; i++ )
+            cb( opaque, i, slices );
+        return;
+    }
+
+    if( slices == 0 )
+        slices = pool->threads + 1;
+
+    vlc_mutex_lock( &pool->lock );
+    assert( pool->pending == 0 );
+    pool->cb = cb;
+    pool->opaque = opaque;
+    pool->slices = slices;
+    pool->next = 0;
+    pool->pending = slices;
+    vlc_cond_broadcast( &pool->wait );
+
+    RunBands( pool );
+    while( pool->pending > 0 )
+        vlc_cond_wait( &pool->done, &pool->lock );
+
+    pool->slices = 0;
+    pool->next = 0;
+    vlc_mutex_unlock( &pool->lock );
+}
+
+void filter_DeleteSlices( filter_slices_t *pool )
+{
+    if( pool == NULL )
+        return;
+
+    vlc_mutex_lock( &pool->lock );
+    pool->quit = true;
+    vlc_cond_broadcast( &pool->wait );
+    vlc_mutex_unlock( &pool->lock );
+
+    for( unsigned i = 0; i < pool->threads; i++ )
+        vlc_join( pool->thread[i], NULL );
+
+    vlc_cond_destroy( &pool->done );
+    vlc_cond_destroy( &pool->wait );
+    vlc_mutex_destroy( &pool->lock );
+    free( pool );
+}
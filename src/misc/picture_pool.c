@@ -48,6 +48,7 @@ struct picture_pool_t {
     unsigned long long available;
     atomic_ushort      refs;
     unsigned short     picture_count;
+    picture_t **spare; /* released clones, kept for reuse, one per picture */
     picture_t  *picture[];
 };
 
@@ -56,6 +57,8 @@ static void picture_pool_Destroy(picture_pool_t *pool)
     if (atomic_fetch_sub(&pool->refs, 1) != 1)
         return;
 
+    for (unsigned i = 0; i < pool->picture_count; i++)
+        free(pool->spare[i]);
     vlc_cond_destroy(&pool->wait);
     vlc_mutex_destroy(&pool->lock);
     aligned_free(pool);
@@ -76,14 +79,14 @@ static void picture_pool_ReleasePicture(picture_t *clone)
     unsigned offset = sys & (POOL_MAX - 1);
     picture_t *picture = pool->picture[offset];
 
-    free(clone);
-
     if (pool->pic_unlock != NULL)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
     vlc_mutex_lock(&pool->lock);
     assert(!(pool->available & (1ULL << offset)));
+    assert(pool->spare[offset] == NULL);
+    pool->spare[offset] = clone;
     pool->available |= 1ULL << offset;
     vlc_cond_signal(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -96,6 +99,28 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 {
     picture_t *picture = pool->picture[offset];
     uintptr_t sys = ((uintptr_t)pool) + offset;
+    picture_t *clone = pool->spare[offset];
+
+    if (clone != NULL) {
+        /* Reuse the clone of the previous Get() of this picture. It is reset
+         * to the state picture_NewFromResource() would give a new one. */
+        picture_priv_t *priv = (picture_priv_t *)clone;
+
+        pool->spare[offset] = NULL;
+        memset(clone, 0, sizeof (*clone));
+        clone->format = picture->format;
+        for (int i = 0; i < picture->i_planes; i++)
+            clone->p[i] = picture->p[i];
+        clone->i_planes = picture->i_planes;
+        clone->i_nb_fields = 2;
+        clone->p_sys = picture->p_sys;
+        atomic_init(&priv->gc.refs, 1);
+        priv->gc.destroy = picture_pool_ReleasePicture;
+        priv->gc.opaque = (void *)sys;
+        picture_Hold(picture);
+        return clone;
+    }
+
     picture_resource_t res = {
         .p_sys = picture->p_sys,
         .pf_destroy = picture_pool_ReleasePicture,
@@ -107,7 +132,7 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
         res.p[i].i_pitch = picture->p[i].i_pitch;
     }
 
-    picture_t *clone = picture_NewFromResource(&picture->format, &res);
+    clone = picture_NewFromResource(&picture->format, &res);
     if (likely(clone != NULL)) {
         ((picture_priv_t *)clone)->gc.opaque = (void *)sys;
         picture_Hold(picture);
@@ -121,7 +146,8 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         return NULL;
 
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + cfg->picture_count * sizeof (picture_t *);
+    size_t size = sizeof (*pool)
+                + 2 * cfg->picture_count * sizeof (picture_t *);
 
     size += (-size) & (POOL_MAX - 1);
     pool = aligned_alloc(POOL_MAX, size);
@@ -140,6 +166,9 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->picture_count = cfg->picture_count;
     memcpy(pool->picture, cfg->picture,
            cfg->picture_count * sizeof (picture_t *));
+    pool->spare = pool->picture + cfg->picture_count;
+    for (unsigned i = 0; i < cfg->picture_count; i++)
+        pool->spare[i] = NULL;
     pool->canceled = false;
     return pool;
 }
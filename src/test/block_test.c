@@ -30,6 +30,8 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 
+#include "../misc/block_pool.h"
+
 static const char text[] =
     "This is a test!\n"
     "This file can be deleted safely!\n";
@@ -86,11 +88,52 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_pool (void)
+{
+    block_pool_t *pool = block_pool_New (2);
+    block_pool_stats_t stats;
+    assert (pool != NULL);
+
+    block_t *a = block_pool_Alloc (pool, sizeof (text));
+    block_t *b = block_pool_Alloc (pool, 2 * sizeof (text));
+    assert (a != NULL && b != NULL);
+    assert (a->i_buffer == sizeof (text));
+    memcpy (a->p_buffer, text, sizeof (text));
+    block_Release (a);
+    block_Release (b);
+
+    /* Released buffers are handed out again */
+    for (int i = 0; i < 10; i++)
+    {
+        a = block_pool_Alloc (pool, sizeof (text));
+        assert (a != NULL);
+        block_Release (a);
+    }
+    block_pool_GetStats (pool, &stats);
+    assert (stats.allocated == 2);
+    assert (stats.recycled == 10);
+    assert (stats.cached == 2);
+
+    /* Pooled blocks can be reallocated like any other */
+    a = block_pool_Alloc (pool, sizeof (text));
+    memcpy (a->p_buffer, text, sizeof (text));
+    a = block_Realloc (a, 200, 1 << 16);
+    assert (a != NULL);
+    assert (!memcmp (a->p_buffer + 200, text, sizeof (text)));
+
+    /* Blocks may outlive the pool owner */
+    b = block_pool_Alloc (pool, sizeof (text));
+    block_pool_Release (pool);
+    block_Release (b);
+    block_Release (a);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_pool ();
     return 0;
 }
 
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * present.c : vsync aware presentation scheduling
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+
+#include "present.h"
+
+/* A display call lasting this long waited for a refresh */
+#define VOUT_PRESENT_BLOCKED      (2000)
+/* Supported refresh rates, from 250 Hz down to 10 Hz */
+#define VOUT_PRESENT_PERIOD_MIN   (4000)
+#define VOUT_PRESENT_PERIOD_MAX   (100000)
+/* Longest interval between two returns used for the estimate */
+#define VOUT_PRESENT_INTERVAL_MAX (500000)
+/* Consecutive returns off the model before it is dropped */
+#define VOUT_PRESENT_OUTLIERS     (16)
+/* Number of lost models before the display is deemed unsynchronised */
+#define VOUT_PRESENT_FAILURES     (3)
+
+static mtime_t FloorDiv(mtime_t a, mtime_t b)
+{
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+/* Returns the refresh closest to the date */
+static mtime_t NearestVsync(const vout_present_t *present, mtime_t date)
+{
+    const mtime_t period = present->period;
+
+    return present->vsync +
+           FloorDiv(date - present->vsync + period / 2, period) * period;
+}
+
+/* Finds the largest interval of which all the measured ones are multiples,
+ * within the jitter tolerance. Returns 0 if there is none. */
+static mtime_t EstimatePeriod(const mtime_t *interval, unsigned count)
+{
+    mtime_t min = INT64_MAX;
+
+    for (unsigned i = 0; i < count; i++)
+        min = __MIN(min, interval[i]);
+
+    for (unsigned n = 1; n <= 4; n++) {
+        const mtime_t candidate = min / n;
+        if (candidate < VOUT_PRESENT_PERIOD_MIN)
+            break;
+
+        mtime_t sum = 0, multiples = 0;
+        for (unsigned i = 0; i < count; i++) {
+            sum       += interval[i];
+            multiples += (interval[i] + candidate / 2) / candidate;
+        }
+
+        /* The shortest interval is off by the jitter of the returns, which
+         * adds up over the longer ones: check them against the average */
+        const mtime_t period = sum / multiples;
+        unsigned i;
+        for (i = 0; i < count; i++) {
+            const mtime_t k = (interval[i] + period / 2) / period;
+            if (llabs(interval[i] - k * period) > period / 8)
+                break;
+        }
+        if (i == count)
+            return period <= VOUT_PRESENT_PERIOD_MAX ? period : 0;
+    }
+    return 0;
+}
+
+static void DropModel(vout_present_t *present)
+{
+    present->period         = 0;
+    present->vsync          = VLC_TS_INVALID;
+    present->locked         = false;
+    present->outliers       = 0;
+    present->interval_count = 0;
+}
+
+void vout_present_Init(vout_present_t *present)
+{
+    memset(present, 0, sizeof(*present));
+    DropModel(present);
+    present->last = VLC_TS_INVALID;
+}
+
+void vout_present_Reset(vout_present_t *present)
+{
+    present->last = VLC_TS_INVALID;
+}
+
+mtime_t vout_present_GetTarget(const vout_present_t *present, mtime_t date)
+{
+    if (!present->locked)
+        return date;
+    return NearestVsync(present, date);
+}
+
+mtime_t vout_present_GetWakeup(const vout_present_t *present, mtime_t date)
+{
+    if (!present->locked)
+        return date;
+    return NearestVsync(present, date) - present->period / 2;
+}
+
+static void AddLateness(vout_present_t *present, mtime_t late)
+{
+    unsigned bucket;
+
+    if (late < 0) {
+        bucket = 0;
+    } else {
+        /* [0,1) ms, then powers of two */
+        bucket = 1;
+        for (mtime_t ms = late / 1000; ms > 0 && bucket < VOUT_PRESENT_BUCKETS - 1; ms >>= 1)
+            bucket++;
+    }
+    present->histogram[bucket]++;
+
+    const mtime_t missed = present->period > 0 ? present->period / 2 : 20000;
+    if (late >= missed)
+        present->missed++;
+
+    present->count++;
+    present->late_sum += late;
+    if (late > present->late_max)
+        present->late_max = late;
+}
+
+void vout_present_Displayed(vout_present_t *present, mtime_t target,
+                            mtime_t start, mtime_t end)
+{
+    if (target > VLC_TS_INVALID)
+        AddLateness(present, end - target);
+
+    /* Only the returns of displays waiting for a refresh give its date */
+    if (end - start < VOUT_PRESENT_BLOCKED ||
+        present->failures >= VOUT_PRESENT_FAILURES)
+        return;
+
+    if (present->last > VLC_TS_INVALID) {
+        const mtime_t interval = end - present->last;
+        if (interval > 0 && interval <= VOUT_PRESENT_INTERVAL_MAX)
+            present->interval[present->interval_count++ % VOUT_PRESENT_SAMPLES] = interval;
+    }
+    present->last = end;
+
+    /* Follow the phase of the refreshes */
+    if (present->locked) {
+        const mtime_t vsync = NearestVsync(present, end);
+        const mtime_t error = end - vsync;
+
+        if (llabs(error) <= present->period / 8) {
+            present->vsync    = vsync + error / 8;
+            present->outliers = 0;
+        } else if (++present->outliers >= VOUT_PRESENT_OUTLIERS) {
+            DropModel(present);
+            present->failures++;
+            return;
+        }
+    }
+
+    /* Estimate the period again every few samples */
+    if (present->interval_count < VOUT_PRESENT_SAMPLES ||
+        present->interval_count % (VOUT_PRESENT_SAMPLES / 4) != 0)
+        return;
+
+    const mtime_t period = EstimatePeriod(present->interval,
+                                          VOUT_PRESENT_SAMPLES);
+    if (period <= 0)
+        return;
+
+    if (!present->locked ||
+        llabs(period - present->period) > present->period / 8) {
+        present->vsync  = end;
+        present->locked = true;
+    }
+    present->period = period;
+}
+
+void vout_present_Dump(vlc_object_t *obj, const vout_present_t *present)
+{
+    if (present->count == 0)
+        return;
+
+    if (present->locked)
+        msg_Dbg(obj, "display refresh period %"PRId64" us", present->period);
+    else
+        msg_Dbg(obj, "display not synchronised on its refreshes");
+
+    msg_Dbg(obj, "%u pictures displayed, %u missed their refresh, "
+            "lateness average %"PRId64" us, max %"PRId64" us",
+            present->count, present->missed,
+            present->late_sum / present->count, present->late_max);
+
+    const unsigned *h = present->histogram;
+    msg_Dbg(obj, "lateness histogram: early %u, <1 ms %u, <2 ms %u, "
+            "<4 ms %u, <8 ms %u, <16 ms %u, <32 ms %u, <64 ms %u, "
+            "<128 ms %u, more %u", h[0], h[1], h[2], h[3], h[4], h[5], h[6],
+            h[7], h[8], h[9]);
+}
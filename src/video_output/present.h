@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * present.h : vsync aware presentation scheduling
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_VOUT_PRESENT_H
+#define LIBVLC_VOUT_PRESENT_H
+
+/*
+ * Most displays wait for the vertical synchronisation when a picture is
+ * displayed. Waiting for the picture date before displaying it then shows
+ * it on the first refresh after that date, which differs from one picture
+ * to the next when the dates are close to refreshes (judder, e.g. 24 fps
+ * on a 60 Hz screen).
+ *
+ * The scheduler models the refresh clock from the dates at which the
+ * display returns, and targets the refresh closest to each picture date.
+ * Pictures are then handed to the display half a refresh early. Displays
+ * which are not synchronised keep being scheduled on the picture dates.
+ *
+ * test/src/video_output/present.c runs it against simulated displays.
+ */
+
+#define VOUT_PRESENT_SAMPLES (32) /* display intervals of the period estimate */
+#define VOUT_PRESENT_BUCKETS (10) /* lateness histogram buckets */
+
+typedef struct {
+    /* Refresh clock model */
+    mtime_t  period;      /**< refresh interval, 0 if unknown */
+    mtime_t  vsync;       /**< date of a past refresh */
+    bool     locked;      /**< the display is synchronised on the model */
+    unsigned outliers;    /**< consecutive returns off the model */
+    unsigned failures;    /**< number of times the model was lost */
+
+    /* Display return dates */
+    mtime_t  last;
+    mtime_t  interval[VOUT_PRESENT_SAMPLES];
+    unsigned interval_count;
+
+    /* Lateness of the displayed pictures against their targets, the
+     * first bucket counts the early ones, then [0,1), [1,2), [2,4) ms... */
+    unsigned histogram[VOUT_PRESENT_BUCKETS];
+    unsigned missed;      /**< pictures displayed a refresh late or more */
+    unsigned count;
+    mtime_t  late_max;
+    mtime_t  late_sum;
+} vout_present_t;
+
+void vout_present_Init(vout_present_t *);
+
+/**
+ * Forgets the last display date, after a discontinuity (flush, pause).
+ */
+void vout_present_Reset(vout_present_t *);
+
+/**
+ * Returns the date at which a picture of the given date should be shown.
+ */
+mtime_t vout_present_GetTarget(const vout_present_t *, mtime_t date);
+
+/**
+ * Returns the date at which a picture of the given date should be given
+ * to the display.
+ */
+mtime_t vout_present_GetWakeup(const vout_present_t *, mtime_t date);
+
+/**
+ * Updates the model and the statistics after a picture was displayed.
+ *
+ * \param target the date returned by vout_present_GetTarget()
+ * \param start date at which the display was called
+ * \param end date at which the display returned
+ */
+void vout_present_Displayed(vout_present_t *, mtime_t target,
+                            mtime_t start, mtime_t end);
+
+/**
+ * Logs the refresh model and the lateness histogram.
+ */
+void vout_present_Dump(vlc_object_t *, const vout_present_t *);
+
+#endif
@@ -1170,12 +1170,17 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (delay < 1000)
         msg_Warn(vout, "picture is late (%lld ms)", delay / 1000);
 #endif
-    if (!is_forced)
-        mwait(todisplay->date);
+    mtime_t target = VLC_TS_INVALID;
+    if (!is_forced) {
+        target = vout_present_GetTarget(&sys->present, todisplay->date);
+        mwait(vout_present_GetWakeup(&sys->present, todisplay->date));
+    }
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
     vout_display_Display(vd, todisplay, subpic);
+    vout_present_Displayed(&sys->present, target,
+                           vout->p->displayed.date, mdate());
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
@@ -1202,7 +1207,9 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
     bool drop_next_frame = frame_by_frame;
     mtime_t date_next = VLC_TS_INVALID;
     if (!paused && vout->p->displayed.next) {
-        date_next = vout->p->displayed.next->date - render_delay;
+        date_next = vout_present_GetTarget(&vout->p->present,
+                                           vout->p->displayed.next->date)
+                    - render_delay;
         if (date_next /* + 0 FIXME */ <= date)
             drop_next_frame = true;
     }
@@ -1304,6 +1311,7 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
 
         ThreadFilterFlush(vout, false);
     } else {
+        vout_present_Reset(&vout->p->present);
         vout->p->step.timestamp = VLC_TS_INVALID;
         vout->p->step.last      = VLC_TS_INVALID;
     }
@@ -1336,6 +1344,7 @@ static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
 
     picture_fifo_Flush(vout->p->decoder_fifo, date, below);
     vout_FilterFlush(vout->p->display.vd);
+    vout_present_Reset(&vout->p->present);
 }
 
 static void ThreadStep(vout_thread_t *vout, mtime_t *duration)
@@ -1488,6 +1497,7 @@ static void ThreadExecuteViewpoint(vout_thread_t *vout,
 static int ThreadStart(vout_thread_t *vout, vout_display_state_t *state)
 {
     vlc_mouse_Init(&vout->p->mouse);
+    vout_present_Init(&vout->p->present);
     vout->p->decoder_fifo = picture_fifo_New();
     vout->p->decoder_pool = NULL;
     vout->p->display_pool = NULL;
@@ -1567,6 +1577,8 @@ error:
 
 static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 {
+    vout_present_Dump(VLC_OBJECT(vout), &vout->p->present);
+
     if (vout->p->spu_blend)
         filter_DeleteBlend(vout->p->spu_blend);
 
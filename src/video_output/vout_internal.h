@@ -34,6 +34,7 @@
 #include "snapshot.h"
 #include "statistic.h"
 #include "chrono.h"
+#include "present.h"
 
 /* It should be high enough to absorbe jitter due to difficult picture(s)
  * to decode but not too high as memory is not that cheap.
@@ -136,6 +137,7 @@ struct vout_thread_sys_t
     picture_pool_t  *decoder_pool;
     picture_fifo_t  *decoder_fifo;
     vout_chrono_t   render;           /**< picture render time estimator */
+    vout_present_t  present;          /**< presentation scheduler */
 };
 
 /* TODO to move them to vlc_vout.h */
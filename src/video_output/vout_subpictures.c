@@ -55,17 +55,69 @@
 typedef struct {
     subpicture_t *subpicture;
     bool          reject;
+    bool          prerendered;   /**< text already rendered ahead of time */
+    bool          prerendering;  /**< owned by the pre-rendering thread */
 } spu_heap_entry_t;
 
 typedef struct {
     spu_heap_entry_t entry[VOUT_MAX_SUBPICTURES];
 } spu_heap_t;
 
+/* Cache of scaled/converted regions, shared by all the subpictures */
+#define SPU_CACHE_ENTRIES (8)
+#define SPU_CACHE_BYTES   (64 << 20)
+
+typedef struct {
+    uint64_t     hash;                        /**< source pixels and palette */
+    vlc_fourcc_t src_chroma;
+    unsigned     src_width;
+    unsigned     src_height;
+    unsigned     src_visible_width;
+    unsigned     src_visible_height;
+    vlc_fourcc_t dst_chroma;                 /**< 0 if the chroma is kept */
+    unsigned     dst_width;
+    unsigned     dst_height;
+} spu_cache_key_t;
+
+typedef struct {
+    spu_cache_key_t key;
+    picture_t       *source;       /**< copy of the source, checked on hits */
+    video_palette_t palette;                      /**< palette of the source */
+    picture_t       *picture;                 /**< scaled picture, or NULL */
+    size_t          size;
+    unsigned        used;                                   /**< LRU stamp */
+} spu_cache_entry_t;
+
+typedef struct {
+    spu_cache_entry_t entry[SPU_CACHE_ENTRIES];
+    size_t            size;
+    unsigned          clock;
+} spu_cache_t;
+
+/* Text subtitles starting within this delay are rendered ahead of time */
+#define SPU_PRERENDER_DELAY   (2 * CLOCK_FREQ)
+#define SPU_PRERENDER_CHROMAS (16)
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     vlc_object_t *input;
 
     spu_heap_t   heap;
+    spu_cache_t  cache;
+
+    /* Rendering of the upcoming text subtitles, with its own text renderer */
+    struct {
+        vlc_thread_t   thread;
+        bool           alive;
+        bool           dead;
+        bool           reload;     /**< the text renderer must be reloaded */
+        vlc_cond_t     wait;       /**< signaled when there may be work */
+        vlc_cond_t     done;       /**< signaled after each subpicture */
+        mtime_t        date;       /**< last subtitle render date, 0 if none */
+        video_format_t fmt_src;
+        video_format_t fmt_dst;
+        vlc_fourcc_t   chroma_list[SPU_PRERENDER_CHROMAS + 1];
+    } prerender;
 
     int channel;             /**< number of subpicture channels registered */
     filter_t *text;                              /**< text renderer module */
@@ -106,8 +158,10 @@ static void SpuHeapInit(spu_heap_t *heap)
     for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
         spu_heap_entry_t *e = &heap->entry[i];
 
-        e->subpicture = NULL;
-        e->reject     = false;
+        e->subpicture   = NULL;
+        e->reject       = false;
+        e->prerendered  = false;
+        e->prerendering = false;
     }
 }
 
@@ -119,8 +173,9 @@ static int SpuHeapPush(spu_heap_t *heap, subpicture_t *subpic)
         if (e->subpicture)
             continue;
 
-        e->subpicture = subpic;
-        e->reject     = false;
+        e->subpicture  = subpic;
+        e->reject      = false;
+        e->prerendered = false;
         return VLC_SUCCESS;
     }
     return VLC_EGENERIC;
@@ -150,6 +205,21 @@ static int SpuHeapDeleteSubpicture(spu_heap_t *heap, subpicture_t *subpic)
     return VLC_EGENERIC;
 }
 
+/* Tells if a subpicture being pre-rendered is needed by the display now */
+static bool SpuHeapIsPrerenderingDue(const spu_heap_t *heap,
+                                     mtime_t render_subtitle_date)
+{
+    for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
+        const spu_heap_entry_t *e = &heap->entry[i];
+
+        if (e->prerendering &&
+            (e->reject || !render_subtitle_date ||
+             e->subpicture->i_start <= render_subtitle_date))
+            return true;
+    }
+    return false;
+}
+
 static void SpuHeapClean(spu_heap_t *heap)
 {
     for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
@@ -159,6 +229,199 @@ static void SpuHeapClean(spu_heap_t *heap)
     }
 }
 
+/*****************************************************************************
+ * scaled region cache
+ *****************************************************************************/
+static void SpuCacheInit(spu_cache_t *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+static void SpuCacheDeleteAt(spu_cache_t *cache, int index)
+{
+    spu_cache_entry_t *e = &cache->entry[index];
+
+    if (e->picture) {
+        picture_Release(e->source);
+        picture_Release(e->picture);
+        cache->size -= e->size;
+    }
+    e->source  = NULL;
+    e->picture = NULL;
+}
+
+static void SpuCacheClean(spu_cache_t *cache)
+{
+    for (int i = 0; i < SPU_CACHE_ENTRIES; i++)
+        SpuCacheDeleteAt(cache, i);
+}
+
+/**
+ * Computes the key identifying the result of scaling a region to the given
+ * size. The region content is hashed, so that identical regions coming from
+ * different subpictures (or rendered again from the same text) share it.
+ *
+ * \return false if the region cannot be cached
+ */
+static bool SpuCacheKey(spu_cache_key_t *key, const subpicture_region_t *region,
+                        vlc_fourcc_t dst_chroma,
+                        unsigned dst_width, unsigned dst_height)
+{
+    const video_format_t *fmt = &region->fmt;
+    const picture_t *picture = region->p_picture;
+
+    /* Only the top left visible lines of each plane are hashed */
+    if (fmt->i_x_offset != 0 || fmt->i_y_offset != 0)
+        return false;
+
+    memset(key, 0, sizeof(*key));
+    key->src_chroma         = fmt->i_chroma;
+    key->src_width          = fmt->i_width;
+    key->src_height         = fmt->i_height;
+    key->src_visible_width  = fmt->i_visible_width;
+    key->src_visible_height = fmt->i_visible_height;
+    key->dst_chroma         = dst_chroma;
+    key->dst_width          = dst_width;
+    key->dst_height         = dst_height;
+
+    /* FNV-1a on 64-bit words, folding the high bits back after each
+     * multiply so that they cannot cancel out between words */
+    uint64_t hash = UINT64_C(14695981039346656037);
+#define SPU_HASH(v) do { \
+        hash = (hash ^ (v)) * UINT64_C(1099511628211); \
+        hash ^= hash >> 29; \
+    } while (0)
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++) {
+            const uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            int x = 0;
+
+            for (; x + 8 <= p->i_visible_pitch; x += 8) {
+                uint64_t v;
+                memcpy(&v, &line[x], sizeof(v));
+                SPU_HASH(v);
+            }
+            for (; x < p->i_visible_pitch; x++)
+                SPU_HASH(line[x]);
+        }
+    }
+    if (fmt->i_chroma == VLC_CODEC_YUVP && fmt->p_palette) {
+        const video_palette_t *palette = fmt->p_palette;
+
+        SPU_HASH(palette->i_entries);
+        for (int i = 0; i < palette->i_entries; i++)
+            for (int j = 0; j < 4; j++)
+                SPU_HASH(palette->palette[i][j]);
+    }
+#undef SPU_HASH
+    key->hash = hash;
+    return true;
+}
+
+/* Tells if the cached source has the same pixels and palette as the region */
+static bool SpuCacheIsSource(const spu_cache_entry_t *e,
+                             const subpicture_region_t *region)
+{
+    const picture_t *picture = region->p_picture;
+
+    if (e->source->i_planes != picture->i_planes)
+        return false;
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *a = &e->source->p[i];
+        const plane_t *b = &picture->p[i];
+
+        if (a->i_visible_lines != b->i_visible_lines ||
+            a->i_visible_pitch != b->i_visible_pitch)
+            return false;
+        for (int y = 0; y < b->i_visible_lines; y++)
+            if (memcmp(&a->p_pixels[y * a->i_pitch],
+                       &b->p_pixels[y * b->i_pitch], b->i_visible_pitch))
+                return false;
+    }
+    if (region->fmt.i_chroma == VLC_CODEC_YUVP && region->fmt.p_palette) {
+        const video_palette_t *palette = region->fmt.p_palette;
+
+        if (e->palette.i_entries != palette->i_entries ||
+            memcmp(e->palette.palette, palette->palette,
+                   palette->i_entries * sizeof(palette->palette[0])))
+            return false;
+    }
+    return true;
+}
+
+static picture_t *SpuCacheGet(spu_cache_t *cache, const spu_cache_key_t *key,
+                              const subpicture_region_t *region)
+{
+    for (int i = 0; i < SPU_CACHE_ENTRIES; i++) {
+        spu_cache_entry_t *e = &cache->entry[i];
+
+        if (e->picture && !memcmp(&e->key, key, sizeof(*key)) &&
+            SpuCacheIsSource(e, region)) {
+            e->used = ++cache->clock;
+            return picture_Hold(e->picture);
+        }
+    }
+    return NULL;
+}
+
+static void SpuCachePut(spu_cache_t *cache, const spu_cache_key_t *key,
+                        const subpicture_region_t *region, picture_t *picture)
+{
+    size_t size = 0;
+    for (int i = 0; i < picture->i_planes; i++)
+        size += (size_t)picture->p[i].i_pitch * picture->p[i].i_lines;
+    for (int i = 0; i < region->p_picture->i_planes; i++)
+        size += (size_t)region->p_picture->p[i].i_pitch *
+                region->p_picture->p[i].i_lines;
+    if (size > SPU_CACHE_BYTES)
+        return;
+
+    picture_t *source = picture_NewFromFormat(&region->p_picture->format);
+    if (!source)
+        return;
+    picture_CopyPixels(source, region->p_picture);
+
+    /* Evict the least recently used entries until it fits */
+    for (;;) {
+        int victim = -1;
+
+        for (int i = 0; i < SPU_CACHE_ENTRIES; i++) {
+            const spu_cache_entry_t *e = &cache->entry[i];
+
+            if (!e->picture) {
+                if (cache->size + size <= SPU_CACHE_BYTES) {
+                    victim = i;
+                    break;
+                }
+                continue;
+            }
+            if (victim < 0 || e->used < cache->entry[victim].used)
+                victim = i;
+        }
+        assert(victim >= 0);
+
+        spu_cache_entry_t *e = &cache->entry[victim];
+        if (e->picture) {
+            SpuCacheDeleteAt(cache, victim);
+            continue;
+        }
+
+        e->key     = *key;
+        e->source  = source;
+        if (region->fmt.i_chroma == VLC_CODEC_YUVP && region->fmt.p_palette)
+            e->palette = *region->fmt.p_palette;
+        else
+            e->palette.i_entries = 0;
+        e->picture = picture_Hold(picture);
+        e->size    = size;
+        e->used    = ++cache->clock;
+        cache->size += size;
+        return;
+    }
+}
+
 static void FilterRelease(filter_t *filter)
 {
     if (filter->p_module)
@@ -283,6 +546,130 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
     *rerender_text = var_GetBool(text, "text-rerender");
 }
 
+/**
+ * Renders the text regions of a subpicture before it is displayed.
+ *
+ * The regions are left as SpuRenderRegion() would have left them after
+ * their first display, so that the display only has to blend them. Text
+ * needing to be rendered again over time (karaoke) is left to the display.
+ */
+static void SpuPrerenderSubpicture(filter_t *text, subpicture_t *subpic,
+                                   const video_format_t *fmt_src,
+                                   const video_format_t *fmt_dst,
+                                   const vlc_fourcc_t *chroma_list)
+{
+    subpicture_Update(subpic, fmt_src, fmt_dst, subpic->i_start);
+
+    if (!text || !text->p_module)
+        return;
+    if (subpic->i_original_picture_width  <= 0 ||
+        subpic->i_original_picture_height <= 0)
+        return;
+
+    text->fmt_out.video.i_width          =
+    text->fmt_out.video.i_visible_width  = subpic->i_original_picture_width;
+    text->fmt_out.video.i_height         =
+    text->fmt_out.video.i_visible_height = subpic->i_original_picture_height;
+
+    for (subpicture_region_t *region = subpic->p_region;
+         region != NULL; region = region->p_next) {
+        if (region->fmt.i_chroma != VLC_CODEC_TEXT || !region->p_text)
+            continue;
+
+        const video_format_t fmt_original = region->fmt;
+
+        var_SetInteger(text, "spu-elapsed", 0);
+        var_SetBool(text, "text-rerender", false);
+        text->pf_render(text, region, region, chroma_list);
+
+        if (var_GetBool(text, "text-rerender")) {
+            if (region->p_picture) {
+                picture_Release(region->p_picture);
+                region->p_picture = NULL;
+            }
+            if (region->p_private) {
+                subpicture_region_private_Delete(region->p_private);
+                region->p_private = NULL;
+            }
+            region->fmt = fmt_original;
+        }
+    }
+}
+
+/* Returns the next subtitle to pre-render, the first one to be displayed */
+static spu_heap_entry_t *SpuPrerenderNext(spu_private_t *sys)
+{
+    const mtime_t date = sys->prerender.date;
+    spu_heap_entry_t *next = NULL;
+
+    if (date <= 0)
+        return NULL;
+
+    for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
+        spu_heap_entry_t *e = &sys->heap.entry[i];
+        const subpicture_t *subpic = e->subpicture;
+
+        if (!subpic || e->reject || e->prerendered || !subpic->b_subtitle)
+            continue;
+        if (subpic->i_start <= date ||
+            subpic->i_start > date + SPU_PRERENDER_DELAY)
+            continue;
+        if (!next || subpic->i_start < next->subpicture->i_start)
+            next = e;
+    }
+    return next;
+}
+
+static void *SpuPrerenderThread(void *data)
+{
+    spu_t *spu = data;
+    spu_private_t *sys = spu->p;
+    filter_t *text = NULL;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;) {
+        spu_heap_entry_t *entry = NULL;
+
+        while (!sys->prerender.dead &&
+               (entry = SpuPrerenderNext(sys)) == NULL)
+            vlc_cond_wait(&sys->prerender.wait, &sys->lock);
+        if (sys->prerender.dead)
+            break;
+
+        /* The display leaves the entry alone until it is rendered */
+        entry->prerendering = true;
+
+        subpicture_t  *subpic  = entry->subpicture;
+        video_format_t fmt_src = sys->prerender.fmt_src;
+        video_format_t fmt_dst = sys->prerender.fmt_dst;
+        vlc_fourcc_t   chroma_list[SPU_PRERENDER_CHROMAS + 1];
+        memcpy(chroma_list, sys->prerender.chroma_list, sizeof(chroma_list));
+
+        /* Loaded with the lock held, as the attachments of the input are
+         * read when the renderer is opened */
+        if (sys->prerender.reload && text) {
+            FilterRelease(text);
+            text = NULL;
+        }
+        sys->prerender.reload = false;
+        if (!text)
+            text = SpuRenderCreateAndLoadText(spu);
+        vlc_mutex_unlock(&sys->lock);
+
+        SpuPrerenderSubpicture(text, subpic, &fmt_src, &fmt_dst, chroma_list);
+
+        vlc_mutex_lock(&sys->lock);
+        entry->prerendering = false;
+        entry->prerendered  = true;
+        vlc_cond_broadcast(&sys->prerender.done);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    if (text)
+        FilterRelease(text);
+    return NULL;
+}
+
 /**
  * A few scale functions helpers.
  */
@@ -827,7 +1214,18 @@ static void SpuRenderRegion(spu_t *spu,
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
-            picture_t *picture = region->p_picture;
+            /* The same content may have been scaled for another region */
+            spu_cache_key_t key;
+            const bool cacheable =
+                SpuCacheKey(&key, region,
+                            using_palette || convert_chroma ? chroma_list[0] : 0,
+                            dst_width, dst_height);
+            picture_t *picture = cacheable ? SpuCacheGet(&sys->cache, &key, region)
+                                           : NULL;
+            if (picture)
+                goto scaled;
+
+            picture = region->p_picture;
             picture_Hold(picture);
 
             /* Convert YUVP to YUVA/RGBA first for better scaling quality */
@@ -875,6 +1273,9 @@ static void SpuRenderRegion(spu_t *spu,
                     msg_Err(spu, "scaling failed");
             }
 
+            if (picture && cacheable && picture != region->p_picture)
+                SpuCachePut(&sys->cache, &key, region, picture);
+scaled:
             /* */
             if (picture) {
                 region->p_private = subpicture_region_private_New(&picture->format);
@@ -1292,6 +1693,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     vlc_mutex_init(&sys->lock);
 
     SpuHeapInit(&sys->heap);
+    SpuCacheInit(&sys->cache);
 
     sys->text = NULL;
     sys->scale = NULL;
@@ -1326,6 +1728,21 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->last_sort_date = -1;
     sys->vout = vout;
 
+    /* Text subtitles are rendered ahead of time, at a low priority */
+    sys->prerender.dead   = false;
+    sys->prerender.reload = false;
+    sys->prerender.date   = 0;
+    sys->prerender.chroma_list[0] = 0;
+    video_format_Init(&sys->prerender.fmt_src, 0);
+    video_format_Init(&sys->prerender.fmt_dst, 0);
+    vlc_cond_init(&sys->prerender.wait);
+    vlc_cond_init(&sys->prerender.done);
+    sys->prerender.alive = !vlc_clone(&sys->prerender.thread,
+                                      SpuPrerenderThread, spu,
+                                      VLC_THREAD_PRIORITY_LOW);
+    if (!sys->prerender.alive)
+        msg_Warn(spu, "cannot render the subtitles ahead of time");
+
     return spu;
 }
 
@@ -1338,6 +1755,16 @@ void spu_Destroy(spu_t *spu)
 {
     spu_private_t *sys = spu->p;
 
+    if (sys->prerender.alive) {
+        vlc_mutex_lock(&sys->lock);
+        sys->prerender.dead = true;
+        vlc_cond_signal(&sys->prerender.wait);
+        vlc_mutex_unlock(&sys->lock);
+        vlc_join(sys->prerender.thread, NULL);
+    }
+    vlc_cond_destroy(&sys->prerender.wait);
+    vlc_cond_destroy(&sys->prerender.done);
+
     if (sys->text)
         FilterRelease(sys->text);
 
@@ -1365,6 +1792,7 @@ void spu_Destroy(spu_t *spu)
 
     /* Destroy all remaining subpictures */
     SpuHeapClean(&sys->heap);
+    SpuCacheClean(&sys->cache);
 
     vlc_mutex_destroy(&sys->lock);
 
@@ -1390,6 +1818,7 @@ void spu_Attach(spu_t *spu, vlc_object_t *input, bool attach)
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
+        spu->p->prerender.reload = true;
 
         vlc_mutex_unlock(&spu->p->lock);
     } else {
@@ -1506,6 +1935,7 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
         subpicture_Delete(subpic);
         return;
     }
+    vlc_cond_signal(&sys->prerender.wait);
     vlc_mutex_unlock(&sys->lock);
 }
 
@@ -1569,6 +1999,29 @@ subpicture_t *spu_Render(spu_t *spu,
 
     vlc_mutex_lock(&sys->lock);
 
+    /* Give the pre-rendering thread the current rendering parameters */
+    if (sys->prerender.alive) {
+        sys->prerender.date    = render_subtitle_date;
+        sys->prerender.fmt_src = *fmt_src;
+        sys->prerender.fmt_src.p_palette = NULL;
+        sys->prerender.fmt_dst = *fmt_dst;
+        sys->prerender.fmt_dst.p_palette = NULL;
+
+        size_t chroma_count = 0;
+        while (chroma_count < SPU_PRERENDER_CHROMAS &&
+               chroma_list[chroma_count] != 0) {
+            sys->prerender.chroma_list[chroma_count] = chroma_list[chroma_count];
+            chroma_count++;
+        }
+        sys->prerender.chroma_list[chroma_count] = 0;
+        vlc_cond_signal(&sys->prerender.wait);
+
+        /* Subpictures being rendered ahead of time are not selected or
+         * deleted; wait for those which are needed now */
+        while (SpuHeapIsPrerenderingDue(&sys->heap, render_subtitle_date))
+            vlc_cond_wait(&sys->prerender.done, &sys->lock);
+    }
+
     unsigned int subpicture_count;
     subpicture_t *subpicture_array[VOUT_MAX_SUBPICTURES];
 
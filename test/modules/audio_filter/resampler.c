@@ -0,0 +1,247 @@
+/*****************************************************************************
+ * resampler.c: audio resamplers test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Resamples the same signal with every available resampler, and prints
+ * their speed and the signal to noise ratio of their output:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_audio_filter_resampler
+ * $ ./test_modules_audio_filter_resampler
+ */
+
+#define CHANNELS   2
+#define FREQUENCY  1000.
+#define DURATION   10 /* seconds */
+#define BLOCK_SIZE 1024 /* frames */
+
+static const char *resamplers[] =
+{
+    "bandlimited_resampler",
+    "speex_resampler",
+    "soxr",
+    "samplerate",
+    "ugly_resampler",
+};
+
+static const struct
+{
+    unsigned in, out;
+    int drift; /* changes of the input rate, as done by the audio output */
+} cases[] =
+{
+    { 44100, 48000,   0 },
+    { 48000, 44100,   0 },
+    { 48000, 48048,   0 },
+    { 48000, 48000, 240 },
+    { 384000, 4000,   0 }, /* steps over more samples than the filter */
+};
+
+/* Power of the output against the difference with the closest sine of the
+ * test frequency, in dB */
+static double SignalToNoise(const float *p, size_t frames, double freq)
+{
+    double ss = 0., cc = 0., sc = 0., xs = 0., xc = 0.;
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        const double s = sin(2. * M_PI * freq * i);
+        const double c = cos(2. * M_PI * freq * i);
+        const double x = p[i * CHANNELS];
+
+        ss += s * s; cc += c * c; sc += s * c;
+        xs += x * s; xc += x * c;
+    }
+
+    const double det = ss * cc - sc * sc;
+    const double a = (xs * cc - xc * sc) / det;
+    const double b = (xc * ss - xs * sc) / det;
+    double signal = 0., noise = 0.;
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        const double ref = a * sin(2. * M_PI * freq * i)
+                         + b * cos(2. * M_PI * freq * i);
+        const double err = p[i * CHANNELS] - ref;
+
+        signal += ref * ref;
+        noise += err * err;
+    }
+    return noise > 0. ? 10. * log10(signal / noise) : INFINITY;
+}
+
+/* Largest difference between two consecutive output samples */
+static double MaxStep(const float *p, size_t frames)
+{
+    double max = 0.;
+
+    for (size_t i = 1; i < frames; i++)
+        max = fmax(max, fabs(p[i * CHANNELS] - p[(i - 1) * CHANNELS]));
+    return max;
+}
+
+static size_t Append(float *p_out, size_t i_out, size_t i_max, block_t *block)
+{
+    for (block_t *next; block != NULL; block = next)
+    {
+        next = block->p_next;
+
+        size_t frames = __MIN(block->i_nb_samples, i_max - i_out);
+        memcpy(p_out + i_out * CHANNELS, block->p_buffer,
+               frames * CHANNELS * sizeof (float));
+        i_out += frames;
+        block_Release(block);
+    }
+    return i_out;
+}
+
+static void test_resampler(vlc_object_t *parent, const char *name,
+                           unsigned in_rate, unsigned out_rate, int drift)
+{
+    filter_t *filter = vlc_object_create(parent, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = in_rate;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+    filter->fmt_out.audio.i_rate = out_rate;
+
+    /* The built-in resampler must always be there */
+    const bool b_builtin = strcmp(name, "bandlimited_resampler") == 0;
+
+    filter->p_module = module_need(filter, "audio resampler", name, true);
+    if (filter->p_module == NULL)
+    {
+        printf("%-22s %5u -> %5u: not available\n", name, in_rate, out_rate);
+        assert(!b_builtin);
+        vlc_object_release(filter);
+        return;
+    }
+
+    const size_t in_frames = in_rate * DURATION;
+    const size_t out_max = 2 * out_rate * DURATION;
+    float *p_out = malloc(out_max * CHANNELS * sizeof (float));
+    assert(p_out != NULL);
+
+    size_t i_out = 0;
+    mtime_t elapsed = 0;
+
+    for (size_t i_in = 0; i_in < in_frames; i_in += BLOCK_SIZE)
+    {
+        block_t *block = block_Alloc(BLOCK_SIZE * CHANNELS * sizeof (float));
+        assert(block != NULL);
+
+        float *p = (float *)block->p_buffer;
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            const float v = .5f * sinf(2. * M_PI * FREQUENCY * (i_in + i) / in_rate);
+            for (unsigned c = 0; c < CHANNELS; c++)
+                *(p++) = v;
+        }
+        block->i_nb_samples = BLOCK_SIZE;
+        block->i_pts = VLC_TS_0 + i_in * CLOCK_FREQ / in_rate;
+
+        /* Speed up and slow down the input for one second out of three */
+        int adjust = 0;
+        if (drift != 0 && (i_in / in_rate) % 3 != 0)
+            adjust = (i_in / in_rate) % 3 == 1 ? drift : -drift;
+
+        filter->fmt_in.audio.i_rate = in_rate + adjust;
+        mtime_t start = mdate();
+        block = filter->pf_audio_filter(filter, block);
+        elapsed += mdate() - start;
+        filter->fmt_in.audio.i_rate = in_rate;
+
+        i_out = Append(p_out, i_out, out_max, block);
+    }
+    if (filter->pf_audio_drain != NULL)
+        i_out = Append(p_out, i_out, out_max, filter->pf_audio_drain(filter));
+
+    /* Leave the filter delays out of the measure */
+    const size_t margin = out_rate / 10;
+    const double snr = i_out > 2 * margin
+        ? SignalToNoise(p_out + margin * CHANNELS, i_out - 2 * margin,
+                        FREQUENCY / out_rate)
+        : 0.;
+    const double step = i_out > 2 * margin
+        ? MaxStep(p_out + margin * CHANNELS, i_out - 2 * margin) : 0.;
+    /* Largest step of the sine, sped up by the drift */
+    const double max_step = 2. * M_PI * .5 * FREQUENCY
+                          * (in_rate + abs(drift)) / in_rate / out_rate;
+    const double speed = elapsed > 0 ? (double)DURATION * CLOCK_FREQ / elapsed
+                                     : INFINITY;
+
+    printf("%-22s %5u -> %5u%s: %7zu frames, %6.1f dB, step %.2f, "
+           "%7.1fx realtime\n", name, in_rate, out_rate, drift ? " (drift)" : "",
+           i_out, snr, step / max_step, speed);
+
+    if (b_builtin)
+    {
+        const double expected = (double)out_rate * in_frames / in_rate;
+
+        assert(fabs(i_out - expected) < expected / 100.);
+        if (drift == 0)
+            assert(snr > 60.);
+        /* The rate changes must not make the output jump */
+        assert(step < 1.1 * max_step);
+    }
+
+    free(p_out);
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *p_libvlc = libvlc_new(0, NULL);
+    assert(p_libvlc != NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(resamplers); j++)
+            test_resampler(VLC_OBJECT(p_libvlc->p_libvlc_int), resamplers[j],
+                           cases[i].in, cases[i].out, cases[i].drift);
+
+    libvlc_release(p_libvlc);
+    return 0;
+}
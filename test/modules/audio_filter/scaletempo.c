@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * scaletempo.c: audio tempo scaler test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Plays a stereo sine in opposite phase on both channels at 1.5x, and checks
+ * that the overlap search keeps the strides in phase: at this frequency, the
+ * input skipped between two strides is half a period off, so blending them
+ * without moving cancels the signal out.
+ */
+
+#define CHANNELS   2
+#define RATE       48000
+#define SCALE      1.5
+#define STRIDE     1440 /* frames, the default 30 ms */
+/* 19.5 periods per input stride */
+#define FREQUENCY  (RATE * 19.5 / (STRIDE * SCALE))
+#define DURATION   4 /* seconds */
+#define BLOCK_SIZE 1024 /* frames */
+
+static size_t Append(float *p_out, size_t i_out, size_t i_max, block_t *block)
+{
+    if (block == NULL)
+        return i_out;
+
+    size_t frames = __MIN(block->i_nb_samples, i_max - i_out);
+    memcpy(p_out + i_out * CHANNELS, block->p_buffer,
+           frames * CHANNELS * sizeof (float));
+    block_Release(block);
+    return i_out + frames;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *p_libvlc = libvlc_new(0, NULL);
+    assert(p_libvlc != NULL);
+
+    filter_t *filter = vlc_object_create(p_libvlc->p_libvlc_int,
+                                         sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+
+    filter->p_module = module_need(filter, "audio filter", "scaletempo", true);
+    assert(filter->p_module != NULL);
+
+    const size_t out_max = RATE * DURATION;
+    float *p_out = malloc(out_max * CHANNELS * sizeof (float));
+    assert(p_out != NULL);
+    size_t i_out = 0;
+
+    for (size_t i_in = 0; i_in < SCALE * RATE * DURATION; i_in += BLOCK_SIZE)
+    {
+        block_t *block = block_Alloc(BLOCK_SIZE * CHANNELS * sizeof (float));
+        assert(block != NULL);
+
+        float *p = (float *)block->p_buffer;
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            const float v = .5f * sinf(2. * M_PI * FREQUENCY * (i_in + i) / RATE);
+            *(p++) = v;
+            *(p++) = -v;
+        }
+        block->i_nb_samples = BLOCK_SIZE;
+        block->i_pts = VLC_TS_0 + i_in * CLOCK_FREQ / RATE;
+
+        /* The audio output changes the input rate to change the tempo */
+        filter->fmt_in.audio.i_rate = RATE * SCALE;
+        i_out = Append(p_out, i_out, out_max, filter->pf_audio_filter(filter, block));
+    }
+    assert(i_out > RATE);
+
+    /* The peak of each period must stay at the amplitude of the input */
+    const size_t period = RATE / FREQUENCY + 1;
+    float min_peak = 1.f;
+    for (size_t start = RATE / 10; start + period < i_out; start += period / 4)
+    {
+        float peak = 0.f;
+        for (size_t i = start; i < start + period; i++)
+        {
+            assert(p_out[i * CHANNELS] == -p_out[i * CHANNELS + 1]);
+            peak = __MAX(peak, fabsf(p_out[i * CHANNELS]));
+        }
+        min_peak = __MIN(min_peak, peak);
+    }
+    printf("scaletempo %.1fx: %zu frames, lowest peak %.3f\n", SCALE, i_out,
+           min_peak);
+    assert(min_peak > .45f);
+
+    free(p_out);
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+    libvlc_release(p_libvlc);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * drift.c: audio output clock drift correction simulation
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <vlc_common.h>
+#include "../../libvlc/test.h"
+#include "../../../src/audio_output/drift.h"
+
+/*
+ * Runs the drift correction loop against a simulated output, on a virtual
+ * clock: the decoder sends a buffer every BUFFER frames of input time, the
+ * output plays at a rate off by the given ratio, and reports its delay with
+ * some jitter. The loop must lock, then hold the drift, and estimate the
+ * clock offset of the output.
+ */
+
+#define RATE     48000
+#define BUFFER   1024 /* frames */
+#define DURATION 300  /* seconds */
+
+struct result
+{
+    double lock;  /* time from which the drift stays within 1 ms */
+    double hold;  /* largest drift after LOCK_TIME */
+    double clock; /* final clock drift estimate */
+};
+
+#define LOCK_TIME 60. /* seconds */
+
+static void simulate(double offset, double initial, double jitter,
+                     struct result *res)
+{
+    const double out_rate = RATE * (1. + offset);
+    /* 200 ms queued in the output, and the first buffer late by initial */
+    double queue = .2 * out_rate;
+    double now = 0., pts = .2 - initial;
+    unsigned seed = 1;
+    aout_drift_t d;
+
+    aout_DriftReset(&d);
+    res->lock = -1.;
+    res->hold = 0.;
+
+    while (now < DURATION)
+    {
+        const double drift = now + queue / out_rate - pts;
+
+        /* Output delay reports are coarse */
+        seed = seed * 1103515245 + 12345;
+        const double noise = (double)((seed >> 16) & 0x7fff) / 0x4000 - 1.;
+        const mtime_t reported = (drift + noise * jitter) * CLOCK_FREQ;
+
+        double correction = aout_DriftUpdate(&d, reported, now * CLOCK_FREQ);
+        aout_DriftResample(&d, correction, RATE);
+        assert(d.resampling >= -RATE / 100 && d.resampling <= RATE / 100);
+
+        /* The resampler takes the input as if it had the corrected rate */
+        queue += (double)BUFFER * RATE / (RATE + d.resampling);
+
+        if (fabs(drift) > .001)
+            res->lock = -1.;
+        else if (res->lock < 0.)
+            res->lock = now;
+        if (now > LOCK_TIME)
+            res->hold = fmax(res->hold, fabs(drift));
+
+        now += (double)BUFFER / RATE;
+        pts += (double)BUFFER / RATE;
+        queue -= out_rate * BUFFER / RATE;
+        assert(queue > 0.);
+    }
+    res->clock = d.clock;
+}
+
+static void test_offset(double offset)
+{
+    struct result res;
+
+    simulate(offset, .05, .003, &res);
+    printf("%+.0f ppm: locked after %.1f s, drift then within %.3f ms, "
+           "clock %+.1f ppm\n", offset * 1e6, res.lock, res.hold * 1e3,
+           res.clock * 1e6);
+
+    assert(res.lock >= 0. && res.lock < 40.);
+    assert(res.hold < .0003);
+    /* The correction compensates the offset: opposite sign */
+    assert(fabs(res.clock + offset) < 20e-6);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_offset(100e-6);
+    test_offset(-100e-6);
+    test_offset(10e-6);
+    return 0;
+}
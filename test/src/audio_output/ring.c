@@ -0,0 +1,187 @@
+/*****************************************************************************
+ * ring.c: audio output ring buffer unit test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_atomic.h>
+#include "../../libvlc/test.h"
+
+/* Every frame holds its (non zero) index in both channels, so that the
+ * consumer can check the order of the frames and that none is torn */
+#define FRAMES 2000000
+
+static audio_sample_format_t fmt = {
+    .i_format = VLC_CODEC_S32N,
+    .i_rate = 48000,
+    .i_physical_channels = AOUT_CHANS_STEREO,
+};
+
+static block_t *MakeBlock(int32_t first, size_t frames)
+{
+    block_t *block = block_Alloc(frames * 2 * sizeof (int32_t));
+    assert(block != NULL);
+
+    int32_t *p = (int32_t *)block->p_buffer;
+    for (size_t i = 0; i < frames; i++)
+        p[2 * i] = p[2 * i + 1] = first + i;
+    block->i_nb_samples = frames;
+    return block;
+}
+
+static void test_sequential(void)
+{
+    aout_ring_t *ring = aout_RingNew(&fmt, CLOCK_FREQ / 100); /* 480 frames */
+    int32_t buf[2 * 1024], left[1024], right[1024];
+    void *const planes[] = { left, right };
+
+    assert(ring != NULL);
+    assert(aout_RingCount(ring) == 0);
+    assert(aout_RingRead(ring, buf, 16) == 0);
+    for (unsigned i = 0; i < 32; i++)
+        assert(buf[i] == 0);
+
+    /* 512 frames fit, the rest is dropped */
+    assert(aout_RingPlay(ring, MakeBlock(1, 300)) == 0);
+    assert(aout_RingPlay(ring, MakeBlock(301, 300)) == 88);
+    assert(aout_RingCount(ring) == 512);
+
+    assert(aout_RingRead(ring, buf, 100) == 100);
+    for (unsigned i = 0; i < 100; i++)
+        assert(buf[2 * i] == (int32_t)i + 1 && buf[2 * i + 1] == buf[2 * i]);
+
+    /* Paused: silence, and the frames are kept */
+    aout_RingPause(ring, true);
+    assert(aout_RingRead(ring, buf, 10) == 0 && buf[0] == 0 && buf[19] == 0);
+    aout_RingPause(ring, false);
+
+    /* Planar, with wrap around and underrun */
+    assert(aout_RingPlay(ring, MakeBlock(513, 100)) == 0);
+    assert(aout_RingReadPlanar(ring, planes, 600) == 512);
+    for (unsigned i = 0; i < 512; i++)
+        assert(left[i] == (int32_t)i + 101 && right[i] == left[i]);
+    for (unsigned i = 512; i < 600; i++)
+        assert(left[i] == 0 && right[i] == 0);
+    assert(aout_RingCount(ring) == 0);
+
+    /* Flush: the frames played before are discarded, not the next ones */
+    assert(aout_RingPlay(ring, MakeBlock(1000, 400)) == 0);
+    aout_RingFlush(ring);
+    assert(aout_RingCount(ring) == 0);
+    assert(aout_RingPlay(ring, MakeBlock(2000, 500)) == 0);
+    assert(aout_RingCount(ring) == 500);
+    assert(aout_RingRead(ring, buf, 1024) == 500);
+    assert(buf[0] == 2000 && buf[2 * 499] == 2499 && buf[2 * 500] == 0);
+
+    aout_RingDelete(ring);
+}
+
+static aout_ring_t *ring;
+static atomic_bool done;
+static atomic_uint flushes;
+
+static void *Consumer(void *data)
+{
+    int32_t buf[2 * 256];
+    int32_t last = 0;
+    unsigned jumps = 0, seed = 1;
+
+    (void) data;
+    for (;;)
+    {
+        bool end = atomic_load(&done);
+        size_t frames = 1 + (seed = seed * 1103515245 + 12345) % 256;
+        size_t count = aout_RingRead(ring, buf, frames);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            assert(buf[2 * i] == buf[2 * i + 1]);
+            assert(buf[2 * i] > last);
+            if (buf[2 * i] != last + 1)
+                jumps++;
+            last = buf[2 * i];
+        }
+        for (size_t i = count; i < frames; i++)
+            assert(buf[2 * i] == 0 && buf[2 * i + 1] == 0);
+
+        if (end && aout_RingCount(ring) == 0)
+            break;
+        if (count < frames)
+            mwait(mdate() + CLOCK_FREQ / 1000);
+    }
+
+    /* Frames may only be skipped by a flush */
+    assert(jumps <= atomic_load(&flushes));
+    assert(last == FRAMES);
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    vlc_thread_t th;
+    unsigned seed = 2, blocks = 0;
+
+    ring = aout_RingNew(&fmt, CLOCK_FREQ / 20);
+    assert(ring != NULL);
+    atomic_init(&done, false);
+    atomic_init(&flushes, 0);
+    assert(vlc_clone(&th, Consumer, NULL, VLC_THREAD_PRIORITY_LOW) == 0);
+
+    for (int32_t first = 1; first <= FRAMES;)
+    {
+        size_t frames = 1 + (seed = seed * 1103515245 + 12345) % 300;
+
+        frames = __MIN(frames, (size_t)(FRAMES - first + 1));
+        /* Wait for space rather than drop */
+        while (aout_RingCount(ring) + frames > 2048)
+            mwait(mdate() + CLOCK_FREQ / 1000);
+        assert(aout_RingPlay(ring, MakeBlock(first, frames)) == 0);
+        first += frames;
+
+        if (++blocks % 500 == 0 && first <= FRAMES)
+        {
+            atomic_fetch_add(&flushes, 1);
+            aout_RingFlush(ring);
+        }
+    }
+
+    atomic_store(&done, true);
+    vlc_join(th, NULL);
+    aout_RingDelete(ring);
+}
+
+int main(void)
+{
+    test_init();
+
+    aout_FormatPrepare(&fmt);
+    test_sequential();
+    test_threads();
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * present.c: video output presentation scheduler test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include "../../libvlc/test.h"
+#include "../../../src/video_output/present.c"
+
+/*
+ * Plays pictures through the scheduler on a simulated display, on a virtual
+ * clock. A synchronised display returns on its next refresh, some jitter
+ * after it; an unsynchronised one returns at once. Once the scheduler has
+ * locked on the refreshes, each picture must be shown on the refresh
+ * closest to its date.
+ */
+
+struct display
+{
+    mtime_t vsync;   /* date of a refresh */
+    mtime_t period;  /* refresh interval, 0 if the display does not wait */
+    mtime_t jitter;  /* largest delay of the returns after the refresh */
+    unsigned seed;
+};
+
+static mtime_t Display(struct display *d, mtime_t start)
+{
+    if (d->period == 0)
+        return start + 300;
+
+    const mtime_t k = FloorDiv(start - d->vsync, d->period) + 1;
+
+    d->seed = d->seed * 1103515245 + 12345;
+    return d->vsync + k * d->period
+           + ((d->seed >> 16) & 0x7fff) % (d->jitter + 1);
+}
+
+/* Refresh of the display closest to the date */
+static mtime_t Nearest(const struct display *d, mtime_t date)
+{
+    return d->vsync + FloorDiv(date - d->vsync + d->period / 2, d->period)
+                      * d->period;
+}
+
+struct result
+{
+    int      lock;     /* picture from which the scheduler was locked */
+    unsigned off_slot; /* pictures not shown on the closest refresh */
+    unsigned missed;   /* pictures a refresh late or more after */
+};
+
+/* Plays count pictures, interval apart, from first */
+static void play(vout_present_t *p, struct display *d, mtime_t *now,
+                 mtime_t first, mtime_t interval, unsigned count,
+                 struct result *res)
+{
+    unsigned missed = 0;
+
+    res->lock = -1;
+    res->off_slot = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const mtime_t date = first + i * interval;
+        const mtime_t target = vout_present_GetTarget(p, date);
+        const mtime_t wakeup = vout_present_GetWakeup(p, date);
+        const bool locked = p->locked;
+
+        if (locked)
+        {
+            /* a refresh slot, handed to the display half a refresh early */
+            assert(llabs(target - date) <= p->period / 2);
+            assert(target - wakeup == p->period / 2);
+            if (res->lock < 0)
+            {
+                res->lock = i;
+                missed = p->missed;
+            }
+        }
+        else
+        {
+            /* no model: scheduled on the picture date */
+            assert(target == date && wakeup == date);
+            res->lock = -1;
+        }
+
+        if (*now < wakeup)
+            *now = wakeup;
+        const mtime_t end = Display(d, *now);
+
+        /* Dates about halfway between two refreshes may go either way */
+        const mtime_t nearest = d->period > 0 ? Nearest(d, date) : date;
+        if (locked && llabs(date - nearest) < d->period / 2 - d->jitter - 100
+         && end - (end - d->vsync) % d->period != nearest)
+            res->off_slot++;
+
+        vout_present_Displayed(p, target, *now, end);
+        *now = end;
+    }
+    res->missed = p->missed - missed;
+}
+
+static void test_vsync(mtime_t period, mtime_t interval, mtime_t jitter)
+{
+    struct display d = { .vsync = 1000000, .period = period,
+                         .jitter = jitter, .seed = 1 };
+    vout_present_t p;
+    struct result res;
+    mtime_t now = d.vsync;
+
+    vout_present_Init(&p);
+    play(&p, &d, &now, d.vsync + 10 * period + period / 4, interval, 600,
+         &res);
+
+    printf("%.2f Hz, %.3f fps, jitter %"PRId64" us: locked after %d "
+           "pictures on %"PRId64" us, %u off their refresh, %u missed\n",
+           1e6 / period, 1e6 / interval, jitter, res.lock, p.period,
+           res.off_slot, res.missed);
+
+    assert(res.lock >= 0 && res.lock <= VOUT_PRESENT_SAMPLES + 16);
+    assert(llabs(p.period - period) <= period / 200);
+    assert(res.off_slot == 0);
+    assert(res.missed == 0);
+}
+
+static void test_rate_change(void)
+{
+    struct display d = { .vsync = 1000000, .period = 16666,
+                         .jitter = 500, .seed = 1 };
+    vout_present_t p;
+    struct result res;
+    mtime_t now = d.vsync;
+
+    vout_present_Init(&p);
+    play(&p, &d, &now, d.vsync + 100000 + d.period / 4, 41665, 200, &res);
+    assert(res.lock >= 0);
+
+    /* The display switches to 50 Hz: the scheduler must follow */
+    d.vsync = now + 3000;
+    d.period = 20000;
+    play(&p, &d, &now, d.vsync + 100000 + d.period / 4, 41667, 400, &res);
+
+    printf("switched to 50 Hz: %"PRId64" us period, %u pictures off their "
+           "refresh\n", p.period, res.off_slot);
+    assert(p.locked);
+    assert(llabs(p.period - 20000) <= 100);
+    /* a few pictures miss their refresh until the new period is known */
+    assert(res.off_slot <= 8);
+}
+
+static void test_unsynchronised(void)
+{
+    struct display d = { .vsync = 1000000, .period = 0 };
+    vout_present_t p;
+    struct result res;
+    mtime_t now = d.vsync;
+
+    vout_present_Init(&p);
+    play(&p, &d, &now, d.vsync + 100000, 41667, 300, &res);
+
+    printf("unsynchronised display: %s\n",
+           p.locked ? "locked" : "scheduled on the picture dates");
+    assert(!p.locked && res.lock < 0);
+    assert(p.count == 300);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_vsync(16666, 41665, 0);     /* 24p on 60 Hz, 3:2 */
+    test_vsync(16666, 41665, 1000);
+    test_vsync(16683, 41708, 500);   /* 23.976p on 59.94 Hz */
+    test_vsync(16666, 40000, 1000);  /* 25p on 60 Hz */
+    test_vsync(20000, 41667, 2000);  /* 24p on 50 Hz */
+    test_rate_change();
+    test_unsynchronised();
+    return 0;
+}